@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <type_traits>
 
 #if !defined(_MSC_VER)
@@ -41,6 +43,17 @@ public:
     virtual unsigned int Get_u32(size_t idx) const = 0;
     virtual unsigned short Get_u16(size_t idx) const = 0;
     virtual unsigned char Get_u8(size_t idx) const = 0;
+
+    /**
+     * Convert the elements [idx, idx + num) into the buffer, with a single virtual call for the whole range.
+     *
+     * @param idx Index of the first element
+     * @param num Number of elements
+     * @param dst Output buffer, holding at least num elements
+     */
+    virtual void GetRange_f(size_t idx, size_t num, float* dst) const = 0;
+    virtual void GetRange_d(size_t idx, size_t num, double* dst) const = 0;
+
     virtual ~Accessor() = default;
 };
 
@@ -48,7 +61,7 @@ public:
 /**
  * Implementation of an accessor into a strided array.
  */
-template <class T> class Accessor_Impl : public Accessor {
+template <class T> class Accessor_Impl final : public Accessor {
 public:
     Accessor_Impl(char const* ptr, size_t stride) : ptr_{ptr}, stride_{stride} {}
 
@@ -80,6 +93,17 @@ public:
         return static_cast<R>(Get<T>(idx));
     }
 
+    template <class R> void GetRange(size_t const idx, size_t const num, R* dst) const {
+        char const* base = ptr_ + idx * stride_;
+        if (std::is_same_v<T, R> && stride_ == sizeof(T)) {
+            std::memcpy(dst, base, num * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < num; ++i) {
+            dst[i] = static_cast<R>(*reinterpret_cast<T const*>(base + i * stride_));
+        }
+    }
+
     float Get_f(size_t idx) const override { return Get<float>(idx); }
 
     double Get_d(size_t idx) const override { return Get<double>(idx); }
@@ -92,6 +116,10 @@ public:
 
     unsigned char Get_u8(size_t idx) const override { return Get<unsigned char>(idx); }
 
+    void GetRange_f(size_t idx, size_t num, float* dst) const override { GetRange<float>(idx, num, dst); }
+
+    void GetRange_d(size_t idx, size_t num, double* dst) const override { GetRange<double>(idx, num, dst); }
+
     virtual ~Accessor_Impl() = default;
 
 private:
@@ -104,7 +132,7 @@ private:
  * Accessor class reporting const values, for instance globals.
  */
 template <class T>
-class Accessor_Val : public Accessor {
+class Accessor_Val final : public Accessor {
 public:
     Accessor_Val(T const val) : val_(val) {}
 
@@ -118,6 +146,12 @@ public:
 
     template <class R> R Get() const { return static_cast<R>(this->val_); }
 
+    template <class R> R Get(size_t const idx) const { return Get<R>(); }
+
+    template <class R> void GetRange(size_t const idx, size_t const num, R* dst) const {
+        std::fill_n(dst, num, Get<R>());
+    }
+
     float Get_f(size_t idx) const override { return Get<float>(); }
 
     double Get_d(size_t idx) const override { return Get<double>(); }
@@ -130,6 +164,10 @@ public:
 
     unsigned char Get_u8(size_t idx) const override { return Get<unsigned char>(); }
 
+    void GetRange_f(size_t idx, size_t num, float* dst) const override { GetRange<float>(idx, num, dst); }
+
+    void GetRange_d(size_t idx, size_t num, double* dst) const override { GetRange<double>(idx, num, dst); }
+
     virtual ~Accessor_Val() = default;
 
 private:
@@ -140,7 +178,7 @@ private:
 /**
  * Dummy accessor for an empty array;
  */
-class Accessor_0 : public Accessor {
+class Accessor_0 final : public Accessor {
 public:
     Accessor_0() = default;
 
@@ -164,6 +202,10 @@ public:
 
     unsigned char Get_u8(size_t idx) const override { return static_cast<unsigned char>(0); }
 
+    void GetRange_f(size_t idx, size_t num, float* dst) const override { std::fill_n(dst, num, 0.0f); }
+
+    void GetRange_d(size_t idx, size_t num, double* dst) const override { std::fill_n(dst, num, 0.0); }
+
     virtual ~Accessor_0() = default;
 
 private:
@@ -15,10 +15,12 @@
 #include "mmcore/param/ParamSlot.h"
 #include "mmcore/CalleeSlot.h"
 #include "mmcore/moldyn/MultiParticleDataCall.h"
+#include "mmcore/utility/MappedFile.h"
 #include "vislib/math/Cuboid.h"
 #include "vislib/sys/File.h"
 #include "vislib/RawStorage.h"
 #include "vislib/types.h"
+#include <vector>
 
 
 namespace megamol {
@@ -118,6 +120,7 @@ namespace moldyn {
              */
             inline void Clear(void) {
                 this->dat.EnforceSize(0);
+                this->mapped = NULL;
             }
 
             /**
@@ -128,10 +131,30 @@ namespace moldyn {
              * @param idx The zero-based index of the frame
              * @param size The size of the frame data in bytes
              * @param version File version (100 = standard, 101 with clusterInfos)
+             * @param decodedSize The decoded size of a compressed frame (version
+             *                    104) as stated by the file, or 0 if unknown
              *
              * @return True on success
              */
-            bool LoadFrame(vislib::sys::File *file, unsigned int idx, UINT64 size, unsigned int version);
+            bool LoadFrame(vislib::sys::File *file, unsigned int idx, UINT64 size, unsigned int version,
+                UINT64 decodedSize = 0);
+
+            /**
+             * Makes this object a view of a frame in a memory-mapped file.
+             * No data is copied; the mapping must outlive the use of the
+             * frame. Compressed frames (version 104) are decoded instead.
+             *
+             * @param data The mapped frame data
+             * @param idx The zero-based index of the frame
+             * @param size The size of the frame data in bytes
+             * @param version File version (100 = standard, 101 with clusterInfos)
+             * @param decodedSize The decoded size of a compressed frame (version
+             *                    104) as stated by the file, or 0 if unknown
+             *
+             * @return True on success
+             */
+            bool MapFrame(const char *data, unsigned int idx, UINT64 size, unsigned int version,
+                UINT64 decodedSize = 0);
 
             /**
              * Sets the data into the call
@@ -142,9 +165,26 @@ namespace moldyn {
 
         private:
 
+            /**
+             * Decodes a compressed frame (version 104) into 'dat', using the
+             * layout of version 103. The chunks of all lists are decoded in
+             * parallel.
+             *
+             * @param data The compressed frame data
+             * @param size The size of the compressed frame data in bytes
+             * @param decodedSize The expected decoded size in bytes, or 0 if
+             *                    unknown
+             *
+             * @return True on success, false if the frame data is corrupt
+             */
+            bool decode(const char *data, UINT64 size, UINT64 decodedSize);
+
             /** position data per type */
             vislib::RawStorage dat;
 
+            /** The frame data within the mapped file, or NULL if 'dat' is used */
+            const char *mapped;
+
             /** file version */
             unsigned int fileVersion;
 
@@ -197,6 +237,15 @@ namespace moldyn {
          */
         bool filenameChanged(param::ParamSlot& slot);
 
+        /**
+         * Callback receiving the update of the memory mapping parameter.
+         *
+         * @param slot The updated ParamSlot.
+         *
+         * @return Always 'true' to reset the dirty flag.
+         */
+        bool useMappingChanged(param::ParamSlot& slot);
+
         /**
          * Gets the data from the source.
          *
@@ -227,15 +276,27 @@ namespace moldyn {
         /** Override local bbox */
         param::ParamSlot overrideBBoxSlot;
 
+        /** Access the frames in a memory mapping of the file */
+        param::ParamSlot useMappingSlot;
+
         /** The slot for requesting data */
         CalleeSlot getData;
 
         /** The opened data file */
         vislib::sys::File *file;
 
+        /** The memory mapping of the data file, if used */
+        utility::MappedFile mappedFile;
+
         /** The frame index table */
         UINT64 *frameIdx;
 
+        /**
+         * The particle count and decoded size per frame from the footer of
+         * version 1.4 files, or empty if not available
+         */
+        std::vector<UINT64> frameStats;
+
         /** The data set bounding box */
         vislib::math::Cuboid<float> bbox;
 
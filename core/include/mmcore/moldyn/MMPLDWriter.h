@@ -108,10 +108,14 @@ namespace moldyn {
          *
          * @param file The output data file
          * @param data The data of the current frame
+         * @param outParticleCnt Receives the number of particles of the frame
+         * @param outDecodedSize Receives the size of the frame data after
+         *                       decoding, which is its size in version 1.3
          *
          * @return True on success
          */
-        bool writeFrame(vislib::sys::File& file, MultiParticleDataCall& data);
+        bool writeFrame(vislib::sys::File& file, MultiParticleDataCall& data, UINT64& outParticleCnt,
+            UINT64& outDecodedSize);
 
         /** The file name of the file to be written */
         param::ParamSlot filenameSlot;
@@ -119,6 +123,9 @@ namespace moldyn {
         /** The file format version to be written */
         param::ParamSlot versionSlot;
 
+        /** The encoding of the particle data (version 1.4 only) */
+        param::ParamSlot compressionSlot;
+
         /** The slot asking for data */
         CallerSlot dataSlot;
 
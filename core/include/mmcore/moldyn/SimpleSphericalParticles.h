@@ -568,6 +568,87 @@ public:
      */
     ParticleStore const& GetParticleStore() const { return *this->par_store_; }
 
+    /**
+     * Call the functor once with the concretely typed accessors for x, y, z and radius,
+     * i.e. f(x, y, z, r). As the accessor classes are final, element access within the
+     * functor is resolved statically and can be inlined, e.g.
+     *   parts.VisitVertexData([&](auto const& x, auto const& y, auto const& z, auto const& r) {
+     *       for (size_t i = 0; i < cnt; ++i) sum += x.Get_f(i);
+     *   });
+     *
+     * @param f The functor to call.
+     */
+    template <class F> void VisitVertexData(F&& f) const {
+        char const* p = reinterpret_cast<char const*>(this->vertPtr);
+        size_t const s = this->vertStride;
+        switch (this->vertDataType) {
+        case VERTDATA_DOUBLE_XYZ:
+            f(Accessor_Impl<double>(p, s), Accessor_Impl<double>(p + sizeof(double), s),
+                Accessor_Impl<double>(p + 2 * sizeof(double), s), Accessor_Val<float>(this->radius));
+            break;
+        case VERTDATA_FLOAT_XYZ:
+            f(Accessor_Impl<float>(p, s), Accessor_Impl<float>(p + sizeof(float), s),
+                Accessor_Impl<float>(p + 2 * sizeof(float), s), Accessor_Val<float>(this->radius));
+            break;
+        case VERTDATA_FLOAT_XYZR:
+            f(Accessor_Impl<float>(p, s), Accessor_Impl<float>(p + sizeof(float), s),
+                Accessor_Impl<float>(p + 2 * sizeof(float), s), Accessor_Impl<float>(p + 3 * sizeof(float), s));
+            break;
+        case VERTDATA_SHORT_XYZ:
+            f(Accessor_Impl<unsigned short>(p, s), Accessor_Impl<unsigned short>(p + sizeof(unsigned short), s),
+                Accessor_Impl<unsigned short>(p + 2 * sizeof(unsigned short), s), Accessor_Val<float>(this->radius));
+            break;
+        case VERTDATA_NONE:
+        default:
+            f(Accessor_0(), Accessor_0(), Accessor_0(), Accessor_Val<float>(this->radius));
+        }
+    }
+
+    /**
+     * Call the functor once with the concretely typed accessors for the colour channels,
+     * i.e. f(r, g, b, a). Intensities are reported in the r channel. See VisitVertexData.
+     *
+     * @param f The functor to call.
+     */
+    template <class F> void VisitColourData(F&& f) const {
+        char const* p = reinterpret_cast<char const*>(this->colPtr);
+        size_t const s = this->colStride;
+        switch (this->colDataType) {
+        case COLDATA_DOUBLE_I:
+            f(Accessor_Impl<double>(p, s), Accessor_0(), Accessor_0(), Accessor_0());
+            break;
+        case COLDATA_FLOAT_I:
+            f(Accessor_Impl<float>(p, s), Accessor_0(), Accessor_0(), Accessor_0());
+            break;
+        case COLDATA_FLOAT_RGB:
+            f(Accessor_Impl<float>(p, s), Accessor_Impl<float>(p + sizeof(float), s),
+                Accessor_Impl<float>(p + 2 * sizeof(float), s), Accessor_Val<float>(1.0f));
+            break;
+        case COLDATA_FLOAT_RGBA:
+            f(Accessor_Impl<float>(p, s), Accessor_Impl<float>(p + sizeof(float), s),
+                Accessor_Impl<float>(p + 2 * sizeof(float), s), Accessor_Impl<float>(p + 3 * sizeof(float), s));
+            break;
+        case COLDATA_UINT8_RGB:
+            f(Accessor_Impl<unsigned char>(p, s), Accessor_Impl<unsigned char>(p + sizeof(unsigned char), s),
+                Accessor_Impl<unsigned char>(p + 2 * sizeof(unsigned char), s), Accessor_Val<unsigned char>(255));
+            break;
+        case COLDATA_UINT8_RGBA:
+            f(Accessor_Impl<unsigned char>(p, s), Accessor_Impl<unsigned char>(p + sizeof(unsigned char), s),
+                Accessor_Impl<unsigned char>(p + 2 * sizeof(unsigned char), s),
+                Accessor_Impl<unsigned char>(p + 3 * sizeof(unsigned char), s));
+            break;
+        case COLDATA_USHORT_RGBA:
+            f(Accessor_Impl<unsigned short>(p, s), Accessor_Impl<unsigned short>(p + sizeof(unsigned short), s),
+                Accessor_Impl<unsigned short>(p + 2 * sizeof(unsigned short), s),
+                Accessor_Impl<unsigned short>(p + 3 * sizeof(unsigned short), s));
+            break;
+        case COLDATA_NONE:
+        default:
+            f(Accessor_Val<unsigned char>(this->col[0]), Accessor_Val<unsigned char>(this->col[1]),
+                Accessor_Val<unsigned char>(this->col[2]), Accessor_Val<unsigned char>(this->col[3]));
+        }
+    }
+
     /**
      * Disable NULL-checks in case we have an OpenGL-VAO
      * @param disable flag to disable/enable the checks
@@ -0,0 +1,118 @@
+/*
+ * MappedFile.h
+ *
+ * Copyright (C) 2019 by VISUS (Universitaet Stuttgart)
+ * Alle Rechte vorbehalten.
+ */
+
+#ifndef MEGAMOLCORE_MAPPEDFILE_H_INCLUDED
+#define MEGAMOLCORE_MAPPEDFILE_H_INCLUDED
+#if (defined(_MSC_VER) && (_MSC_VER > 1000))
+#pragma once
+#endif /* (defined(_MSC_VER) && (_MSC_VER > 1000)) */
+
+#include "mmcore/api/MegaMolCore.std.h"
+#include "vislib/String.h"
+#include "vislib/types.h"
+
+
+namespace megamol {
+namespace core {
+namespace utility {
+
+    /**
+     * Read-only memory mapping of a whole file. The mapped pages are held by
+     * the page cache of the operating system, and are thus shared between
+     * all processes mapping the same file.
+     */
+    class MEGAMOLCORE_API MappedFile {
+    public:
+
+        /** Ctor. */
+        MappedFile(void);
+
+        /** Dtor. */
+        ~MappedFile(void);
+
+        /**
+         * Maps the file into memory. A previously mapped file is unmapped.
+         *
+         * @param filename The path to the file.
+         *
+         * @return 'true' on success, 'false' if the file cannot be opened or
+         *         mapped, e.g. because the address space is too small.
+         */
+        bool Open(const vislib::TString& filename);
+
+        /** Unmaps the file, if mapped. */
+        void Close(void);
+
+        /**
+         * Answer the mapped file content.
+         *
+         * @return Pointer to the beginning of the file, or NULL if no file
+         *         is mapped.
+         */
+        inline const char *Data(void) const {
+            return this->data;
+        }
+
+        /**
+         * Answer whether a file is mapped.
+         *
+         * @return 'true' if a file is mapped.
+         */
+        inline bool IsOpen(void) const {
+            return (this->data != NULL);
+        }
+
+        /**
+         * Hints the operating system to read the given range ahead
+         * asynchronously. The range is clamped to the file size.
+         *
+         * @param offset The offset of the range in bytes.
+         * @param size The size of the range in bytes.
+         */
+        void Prefetch(UINT64 offset, UINT64 size) const;
+
+        /**
+         * Answer the size of the mapped file.
+         *
+         * @return The file size in bytes.
+         */
+        inline UINT64 Size(void) const {
+            return this->size;
+        }
+
+    private:
+
+        /** Forbidden copy ctor. */
+        MappedFile(const MappedFile& src);
+
+        /** Forbidden assignment operator. */
+        MappedFile& operator=(const MappedFile& rhs);
+
+        /** The mapped file content */
+        const char *data;
+
+        /** The file size in bytes */
+        UINT64 size;
+
+#ifdef _WIN32
+        /** The file handle */
+        void *fileHandle;
+
+        /** The mapping handle */
+        void *mappingHandle;
+#else /* _WIN32 */
+        /** The file descriptor */
+        int fileDescriptor;
+#endif /* _WIN32 */
+
+    };
+
+} /* end namespace utility */
+} /* end namespace core */
+} /* end namespace megamol */
+
+#endif /* MEGAMOLCORE_MAPPEDFILE_H_INCLUDED */
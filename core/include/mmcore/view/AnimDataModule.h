@@ -12,6 +12,10 @@
 #endif /* (defined(_MSC_VER) && (_MSC_VER > 1000)) */
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "mmcore/Module.h"
 #include "vislib/sys/CriticalSection.h"
@@ -64,7 +68,7 @@ namespace view {
              * @param owner The owning AnimDataModule
              */
             Frame(AnimDataModule& owner) : frame(0), owner(owner),
-                    state(STATE_INVALID) {
+                    state(STATE_INVALID), loadingIdx(0) {
                 // intentionally empty
             }
 
@@ -116,6 +120,9 @@ namespace view {
             /** the state of this frame */
             State state;
 
+            /** the index of the frame being loaded while in 'STATE_LOADING' */
+            unsigned int loadingIdx;
+
         };
 
         /**
@@ -172,7 +179,8 @@ namespace view {
          *                 exactly the requested idx, and not the closest
          *                 match.
          *
-         * @return The frame most suitable to the request.
+         * @return The frame most suitable to the request, or NULL if a
+         *         forced frame could not be loaded in time.
          */
         Frame * requestLockedFrame(unsigned int idx);
         Frame * requestLockedFrame(unsigned int idx, bool forceIdx);
@@ -193,6 +201,16 @@ namespace view {
          */
         void setFrameCount(unsigned int cnt);
 
+        /**
+         * Sets the number of loader threads prefetching frames concurrently.
+         * Only use more than one thread if 'loadFrame' is safe to be called
+         * concurrently for different frames. Must not be called after the
+         * frame cache has been initialised!
+         *
+         * @param cnt The number of loader threads. Must not be zero.
+         */
+        void setLoaderThreadCount(unsigned int cnt);
+
         /** frame is a friend to be able to call 'unlock' */
         friend class ::megamol::core::view::AnimDataModule::Frame;
 
@@ -200,12 +218,46 @@ namespace view {
 
         /**
          * The loader thread function.
+         */
+        void loaderFunction(void);
+
+        /**
+         * Searches the next frame along the predicted playback to be loaded.
+         * 'stateLock' must be held.
+         *
+         * @param outIdx Receives the index of the frame to be loaded.
+         * @param outDist Receives the playback distance of that frame.
+         *
+         * @return 'true' if a frame needs to be loaded, 'false' if all
+         *         frames within the prefetch window are cached or loading.
+         */
+        bool findFrameToLoad(unsigned int& outIdx, unsigned int& outDist) const;
+
+        /**
+         * Answer the distance of a frame along the predicted playback,
+         * starting at the last requested frame. Frames behind the playback
+         * or skipped by it are the farthest.
+         *
+         * @param idx The frame index.
          *
-         * @param userData Pointer to this object.
+         * @return The distance along the playback.
+         */
+        unsigned int playbackDistance(unsigned int idx) const;
+
+        /**
+         * Marks the cached frame most suitable to the request as in use.
+         * 'stateLock' must be held.
+         *
+         * @param idx The index of the frame requested.
          *
-         * @return The return value.
+         * @return The frame most suitable to the request, or NULL.
+         */
+        Frame * lockBestFrame(unsigned int idx);
+
+        /**
+         * Stops and joins all loader threads.
          */
-        static DWORD loaderFunction(void *userData);
+        void stopLoaders(void);
 
         /**
          * Unlocks the given frame
@@ -219,8 +271,14 @@ namespace view {
         /** The number of time frames of the dataset */
         unsigned int frameCnt;
 
-        /** The loading thread */
-        vislib::sys::Thread loader;
+        /** The loading threads */
+        std::vector<std::thread> loaders;
+
+        /** The number of loading threads to be started */
+        unsigned int loaderCnt;
+
+        /** The number of loading threads which did not exit yet */
+        std::atomic_uint runningLoaders;
 
         /** The frame cache */
         Frame **frameCache;
@@ -229,14 +287,25 @@ namespace view {
         unsigned int cacheSize;
 
         /** 
-         * The critical section to synchornise the state changes of the 
-         * cached frames. 
+         * The lock to synchornise the state changes of the cached frames. 
          */
-        vislib::sys::CriticalSection stateLock;
+        std::mutex stateLock;
+
+        /** Wakes the loaders on new requests and unlocked frames */
+        std::condition_variable loaderCondition;
+
+        /** Wakes threads waiting for a frame to become available */
+        std::condition_variable frameCondition;
 
         /** The frame number requested the last time 'requestLockedFrame' was called */
         unsigned int lastRequested;
 
+        /**
+         * The predicted playback step between consecutive requests. The sign
+         * is the playback direction.
+         */
+        int playbackStep;
+
 		/** TODO: The Mueller shalt document his stuff */
 		std::atomic_bool isRunning;
 #ifdef _WIN32
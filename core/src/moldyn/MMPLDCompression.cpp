@@ -0,0 +1,122 @@
+/*
+ * MMPLDCompression.cpp
+ *
+ * Copyright (C) 2019 by VISUS (Universitaet Stuttgart)
+ * Alle Rechte vorbehalten.
+ */
+
+#include "stdafx.h"
+#include "moldyn/MMPLDCompression.h"
+#include "zlib.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace megamol::core;
+
+
+/*
+ * moldyn::MMPLDCompression::EncodeChunk
+ */
+void moldyn::MMPLDCompression::EncodeChunk(const char *records, SIZE_T cnt, SIZE_T recordSize,
+        std::vector<char>& outChunk) {
+    const SIZE_T size = cnt * recordSize;
+
+    // group the bytes by significance, resulting in long runs of similar bytes
+    std::vector<char> shuffled(size);
+    for (SIZE_T i = 0; i < cnt; i++) {
+        for (SIZE_T b = 0; b < recordSize; b++) {
+            shuffled[b * cnt + i] = records[i * recordSize + b];
+        }
+    }
+
+    uLongf compressedSize = ::compressBound(static_cast<uLong>(size));
+    outChunk.resize(compressedSize);
+    if ((::compress2(reinterpret_cast<Bytef*>(outChunk.data()), &compressedSize,
+            reinterpret_cast<const Bytef*>(shuffled.data()), static_cast<uLong>(size), Z_BEST_SPEED) == Z_OK)
+            && (compressedSize < size)) {
+        outChunk.resize(compressedSize);
+    } else {
+        // the size tells the reader that the chunk is stored plainly
+        outChunk.assign(records, records + size);
+    }
+}
+
+
+/*
+ * moldyn::MMPLDCompression::DecodeChunk
+ */
+bool moldyn::MMPLDCompression::DecodeChunk(const char *chunk, UINT64 chunkSize, SIZE_T cnt, SIZE_T recordSize,
+        char *outRecords) {
+    const SIZE_T size = cnt * recordSize;
+
+    if (chunkSize == size) {
+        ::memcpy(outRecords, chunk, size);
+        return true;
+    }
+
+    std::vector<char> shuffled(size);
+    uLongf decompressedSize = static_cast<uLongf>(size);
+    if ((::uncompress(reinterpret_cast<Bytef*>(shuffled.data()), &decompressedSize,
+            reinterpret_cast<const Bytef*>(chunk), static_cast<uLong>(chunkSize)) != Z_OK)
+            || (decompressedSize != size)) {
+        return false;
+    }
+
+    for (SIZE_T i = 0; i < cnt; i++) {
+        for (SIZE_T b = 0; b < recordSize; b++) {
+            outRecords[i * recordSize + b] = shuffled[b * cnt + i];
+        }
+    }
+    return true;
+}
+
+
+/*
+ * moldyn::MMPLDCompression::Quantize
+ */
+void moldyn::MMPLDCompression::Quantize(const char *records, SIZE_T cnt, SIZE_T stride, const float *bounds,
+        char *outRecords) {
+    float scale[3];
+    for (int d = 0; d < 3; d++) {
+        const float extent = bounds[d + 3] - bounds[d];
+        scale[d] = (extent > 0.0f) ? (65535.0f / extent) : 0.0f;
+    }
+
+    const SIZE_T outStride = stride - 6;
+    for (SIZE_T i = 0; i < cnt; i++) {
+        float pos[3];
+        UINT16 q[3];
+        ::memcpy(pos, records + i * stride, 12);
+        for (int d = 0; d < 3; d++) {
+            const float v = std::floor((pos[d] - bounds[d]) * scale[d] + 0.5f);
+            q[d] = static_cast<UINT16>(std::min(std::max(v, 0.0f), 65535.0f));
+        }
+        ::memcpy(outRecords + i * outStride, q, 6);
+        ::memcpy(outRecords + i * outStride + 6, records + i * stride + 12, stride - 12);
+    }
+}
+
+
+/*
+ * moldyn::MMPLDCompression::Dequantize
+ */
+void moldyn::MMPLDCompression::Dequantize(const char *records, SIZE_T cnt, SIZE_T stride, const float *bounds,
+        char *outRecords) {
+    float step[3];
+    for (int d = 0; d < 3; d++) {
+        step[d] = (bounds[d + 3] - bounds[d]) / 65535.0f;
+    }
+
+    const SIZE_T inStride = stride - 6;
+    for (SIZE_T i = 0; i < cnt; i++) {
+        UINT16 q[3];
+        float pos[3];
+        ::memcpy(q, records + i * inStride, 6);
+        for (int d = 0; d < 3; d++) {
+            pos[d] = bounds[d] + static_cast<float>(q[d]) * step[d];
+        }
+        ::memcpy(outRecords + i * stride, pos, 12);
+        ::memcpy(outRecords + i * stride + 12, records + i * inStride + 6, stride - 12);
+    }
+}
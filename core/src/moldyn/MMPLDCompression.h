@@ -0,0 +1,98 @@
+/*
+ * MMPLDCompression.h
+ *
+ * Copyright (C) 2019 by VISUS (Universitaet Stuttgart)
+ * Alle Rechte vorbehalten.
+ */
+
+#ifndef MEGAMOLCORE_MMPLDCOMPRESSION_H_INCLUDED
+#define MEGAMOLCORE_MMPLDCOMPRESSION_H_INCLUDED
+#pragma once
+
+#include "vislib/types.h"
+#include <vector>
+
+
+namespace megamol {
+namespace core {
+namespace moldyn {
+
+    /**
+     * Encoding of the particle data of MMPLD 1.4 lists.
+     *
+     * Encoded lists are split into chunks of a fixed number of particles,
+     * which are compressed independently, and can thus be decoded in
+     * parallel. A chunk is stored with its bytes shuffled by significance
+     * and deflated, or plainly if that does not reduce its size.
+     */
+    class MMPLDCompression {
+    public:
+
+        /** The encodings of the particle data of a list */
+        enum Encoding {
+            ENCODING_RAW = 0,       //< data as in version 1.3
+            ENCODING_DEFLATE = 1,   //< shuffled and deflated chunks
+            ENCODING_QUANTIZED = 2  //< 16 bit positions relative to the list bounds, shuffled and deflated chunks
+        };
+
+        /** The number of particles per chunk written */
+        static const UINT32 ParticlesPerChunk = 1u << 16;
+
+        /**
+         * Encodes a chunk of records.
+         *
+         * @param records The records.
+         * @param cnt The number of records.
+         * @param recordSize The size of a record in bytes.
+         * @param outChunk Receives the encoded chunk.
+         */
+        static void EncodeChunk(const char *records, SIZE_T cnt, SIZE_T recordSize, std::vector<char>& outChunk);
+
+        /**
+         * Decodes a chunk of records.
+         *
+         * @param chunk The encoded chunk.
+         * @param chunkSize The size of the encoded chunk in bytes.
+         * @param cnt The number of records.
+         * @param recordSize The size of a record in bytes.
+         * @param outRecords Receives the records; must hold 'cnt * recordSize' bytes.
+         *
+         * @return 'true' on success, 'false' if the chunk is corrupt.
+         */
+        static bool DecodeChunk(const char *chunk, UINT64 chunkSize, SIZE_T cnt, SIZE_T recordSize, char *outRecords);
+
+        /**
+         * Quantizes the float positions at the beginning of each record to
+         * 16 bit per coordinate. The remainder of each record is copied.
+         *
+         * @param records The records.
+         * @param cnt The number of records.
+         * @param stride The size of a record in bytes, at least 12.
+         * @param bounds The bounds (min x, y, z, max x, y, z) of the positions.
+         * @param outRecords Receives the quantized records of 'stride - 6' bytes each.
+         */
+        static void Quantize(const char *records, SIZE_T cnt, SIZE_T stride, const float *bounds, char *outRecords);
+
+        /**
+         * Reverts 'Quantize'.
+         *
+         * @param records The quantized records of 'stride - 6' bytes each.
+         * @param cnt The number of records.
+         * @param stride The size of a dequantized record in bytes.
+         * @param bounds The bounds (min x, y, z, max x, y, z) of the positions.
+         * @param outRecords Receives the dequantized records.
+         */
+        static void Dequantize(const char *records, SIZE_T cnt, SIZE_T stride, const float *bounds, char *outRecords);
+
+    private:
+
+        /** Forbidden ctor. */
+        MMPLDCompression(void);
+
+    };
+
+} /* end namespace moldyn */
+} /* end namespace core */
+} /* end namespace megamol */
+
+#endif /* MEGAMOLCORE_MMPLDCOMPRESSION_H_INCLUDED */
@@ -16,6 +16,9 @@
 #include "vislib/sys/FastFile.h"
 #include "vislib/String.h"
 #include "vislib/sys/SystemInformation.h"
+#include "moldyn/MMPLDCompression.h"
+#include <cstring>
+#include <vector>
 
 using namespace megamol::core;
 
@@ -27,6 +30,57 @@ using namespace megamol::core;
 #define CACHE_SIZE_MAX 100000
 // factor multiplied to the frame size for estimating the overhead to the pure data.
 #define CACHE_FRAME_FACTOR 1.15f
+// number of frames in the cache if the file is memory-mapped. These frames do
+// not hold any data, but only limit how far the loader prefetches.
+#define CACHE_SIZE_MAPPED 16
+// number of loader threads if the file is memory-mapped, as frames are then
+// loaded without sharing the file handle
+#define LOADER_CNT_MAPPED 4
+
+namespace {
+
+    /** Answer a typed pointer into the frame data */
+    template<class T> inline const T *asAt(const char *data, SIZE_T offset) {
+        return reinterpret_cast<const T*>(data + offset);
+    }
+
+    /** Answer the size of a vertex of the given MMPLD type in bytes */
+    inline SIZE_T vertexSize(UINT8 type) {
+        switch (type) {
+            case 1: return 12;
+            case 2: return 16;
+            case 3: return 6;
+            case 4: return 24;
+            default: return 0;
+        }
+    }
+
+    /** Answer the size of a colour of the given MMPLD type in bytes */
+    inline SIZE_T colourSize(UINT8 type) {
+        switch (type) {
+            case 1: return 3;
+            case 2: return 4;
+            case 3: return 4;
+            case 4: return 12;
+            case 5: return 16;
+            case 6: return 8;
+            case 7: return 8;
+            default: return 0;
+        }
+    }
+
+    /** A contiguous part of a compressed frame to be decoded */
+    struct Segment {
+        const char *src;
+        UINT64 srcSize;
+        UINT64 dstOffset;
+        UINT8 encoding;
+        SIZE_T cnt;
+        SIZE_T recordSize;
+        float bounds[6];
+    };
+
+}
 
 /*****************************************************************************/
 
@@ -34,7 +88,7 @@ using namespace megamol::core;
  * moldyn::MMPLDDataSource::Frame::Frame
  */
 moldyn::MMPLDDataSource::Frame::Frame(view::AnimDataModule& owner)
-        : view::AnimDataModule::Frame(owner), dat() {
+        : view::AnimDataModule::Frame(owner), dat(), mapped(NULL) {
     // intentionally empty
 }
 
@@ -50,37 +104,199 @@ moldyn::MMPLDDataSource::Frame::~Frame() {
 /*
  * moldyn::MMPLDDataSource::Frame::LoadFrame
  */
-bool moldyn::MMPLDDataSource::Frame::LoadFrame(vislib::sys::File *file, unsigned int idx, UINT64 size, unsigned int version) {
+bool moldyn::MMPLDDataSource::Frame::LoadFrame(vislib::sys::File *file, unsigned int idx, UINT64 size, unsigned int version,
+        UINT64 decodedSize) {
     this->frame = idx;
     this->fileVersion = version;
+    this->mapped = NULL;
+    if (version == 104) {
+        vislib::RawStorage encoded(static_cast<SIZE_T>(size));
+        if (file->Read(encoded, size) != size) {
+            this->Clear();
+            return false;
+        }
+        return this->decode(encoded.As<char>(), size, decodedSize);
+    }
     this->dat.EnforceSize(static_cast<SIZE_T>(size));
     return (file->Read(this->dat, size) == size);
 }
 
 
+/*
+ * moldyn::MMPLDDataSource::Frame::MapFrame
+ */
+bool moldyn::MMPLDDataSource::Frame::MapFrame(const char *data, unsigned int idx, UINT64 size, unsigned int version,
+        UINT64 decodedSize) {
+    this->frame = idx;
+    this->fileVersion = version;
+    this->mapped = NULL;
+    if (version == 104) {
+        return this->decode(data, size, decodedSize);
+    }
+    this->dat.EnforceSize(0);
+    this->mapped = data;
+    return true;
+}
+
+
+/*
+ * moldyn::MMPLDDataSource::Frame::decode
+ */
+bool moldyn::MMPLDDataSource::Frame::decode(const char *data, UINT64 size, UINT64 decodedSize) {
+    std::vector<Segment> segments;
+    UINT64 p = 0;
+    UINT64 outSize = 0;
+
+    // copies the next 'n' bytes unchanged, merging with the previous copy
+    auto plain = [&](UINT64 n) -> bool {
+        if (n > size - p) return false;
+        if (!segments.empty() && (segments.back().encoding == MMPLDCompression::ENCODING_RAW)
+                && (segments.back().src + segments.back().srcSize == data + p)) {
+            segments.back().srcSize += n;
+        } else {
+            Segment seg;
+            seg.src = data + p;
+            seg.srcSize = n;
+            seg.dstOffset = outSize;
+            seg.encoding = MMPLDCompression::ENCODING_RAW;
+            seg.cnt = 0;
+            seg.recordSize = 0;
+            segments.push_back(seg);
+        }
+        p += n;
+        outSize += n;
+        return true;
+    };
+#define _ASSERT_DECODE(COND) if (!(COND)) { \
+        this->Clear(); \
+        return false; \
+    }
+
+    // the version 1.4 layout equals version 1.3, plus the encoding of each
+    // list, and the chunk table of encoded lists
+    _ASSERT_DECODE(plain(4));
+    UINT32 plc;
+    ::memcpy(&plc, data + p - 4, 4);
+    for (UINT32 i = 0; i < plc; i++) {
+        _ASSERT_DECODE(plain(2));
+        const UINT8 vrtType = *asAt<UINT8>(data, static_cast<SIZE_T>(p - 2));
+        const UINT8 colType = *asAt<UINT8>(data, static_cast<SIZE_T>(p - 1));
+        const SIZE_T stride = vertexSize(vrtType) + ((vrtType != 0) ? colourSize(colType) : 0);
+
+        UINT64 hdrSize = 8 + 24; // count and bounding box
+        if ((vrtType == 1) || (vrtType == 3) || (vrtType == 4)) hdrSize += 4;
+        if (colType == 0) {
+            hdrSize += 4;
+        } else if ((colType == 3) || (colType == 7)) {
+            hdrSize += 8;
+        }
+        _ASSERT_DECODE(plain(hdrSize));
+        UINT64 cnt;
+        ::memcpy(&cnt, data + p - 32, 8);
+
+        if (vrtType == 0) continue;
+
+        _ASSERT_DECODE((stride > 0) && (p < size));
+        const UINT8 encoding = *asAt<UINT8>(data, static_cast<SIZE_T>(p));
+        p++;
+
+        if (encoding == MMPLDCompression::ENCODING_RAW) {
+            _ASSERT_DECODE(cnt <= (size - p) / stride);
+            _ASSERT_DECODE(plain(cnt * stride));
+            continue;
+        }
+        _ASSERT_DECODE((encoding == MMPLDCompression::ENCODING_DEFLATE)
+            || ((encoding == MMPLDCompression::ENCODING_QUANTIZED) && ((vrtType == 1) || (vrtType == 2))));
+
+        Segment seg;
+        seg.encoding = encoding;
+        seg.recordSize = stride;
+        UINT32 ppc;
+        _ASSERT_DECODE(4 <= size - p);
+        ::memcpy(&ppc, data + p, 4);
+        p += 4;
+        _ASSERT_DECODE(ppc > 0);
+        if (encoding == MMPLDCompression::ENCODING_QUANTIZED) {
+            _ASSERT_DECODE(24 <= size - p);
+            ::memcpy(seg.bounds, data + p, 24);
+            p += 24;
+            seg.recordSize = stride - 6;
+        }
+
+        // every chunk has an entry in the chunk table, bounding the particle count
+        const UINT64 chunkCnt = cnt / ppc + ((cnt % ppc != 0) ? 1 : 0);
+        _ASSERT_DECODE(chunkCnt <= (size - p) / 8);
+        const char *chunkSizes = data + p;
+        p += chunkCnt * 8;
+        for (UINT64 c = 0; c < chunkCnt; c++) {
+            ::memcpy(&seg.srcSize, chunkSizes + c * 8, 8);
+            _ASSERT_DECODE(seg.srcSize <= size - p);
+            seg.src = data + p;
+            seg.dstOffset = outSize;
+            seg.cnt = static_cast<SIZE_T>(vislib::math::Min<UINT64>(ppc, cnt - c * ppc));
+            // deflate cannot compress by more than a factor of 1032
+            _ASSERT_DECODE(seg.cnt * seg.recordSize / 1032 < seg.srcSize);
+            segments.push_back(seg);
+            p += seg.srcSize;
+            outSize += seg.cnt * stride;
+        }
+    }
+
+    _ASSERT_DECODE((decodedSize == 0) || (outSize == decodedSize));
+    this->dat.EnforceSize(static_cast<SIZE_T>(outSize));
+    char *out = this->dat.As<char>();
+    const int segCnt = static_cast<int>(segments.size());
+    int failed = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : failed)
+    for (int s = 0; s < segCnt; s++) {
+        const Segment& seg = segments[s];
+        char *dst = out + seg.dstOffset;
+        if (seg.encoding == MMPLDCompression::ENCODING_RAW) {
+            ::memcpy(dst, seg.src, static_cast<SIZE_T>(seg.srcSize));
+        } else if (seg.encoding == MMPLDCompression::ENCODING_DEFLATE) {
+            if (!MMPLDCompression::DecodeChunk(seg.src, seg.srcSize, seg.cnt, seg.recordSize, dst)) failed++;
+        } else {
+            std::vector<char> quantized(seg.cnt * seg.recordSize);
+            if (MMPLDCompression::DecodeChunk(seg.src, seg.srcSize, seg.cnt, seg.recordSize, quantized.data())) {
+                MMPLDCompression::Dequantize(quantized.data(), seg.cnt, seg.recordSize + 6, seg.bounds, dst);
+            } else {
+                failed++;
+            }
+        }
+    }
+    _ASSERT_DECODE(failed == 0);
+
+#undef _ASSERT_DECODE
+
+    this->fileVersion = 103;
+    return true;
+}
+
+
 /*
  * moldyn::MMPLDDataSource::Frame::SetData
  */
 void moldyn::MMPLDDataSource::Frame::SetData(MultiParticleDataCall& call, vislib::math::Cuboid<float> const& bbox, bool overrideBBox) {
-    if (this->dat.IsEmpty()) {
+    if ((this->mapped == NULL) && this->dat.IsEmpty()) {
         call.SetParticleListCount(0);
         return;
     }
+    const char *data = (this->mapped != NULL) ? this->mapped : this->dat.As<char>();
 
     SIZE_T p = 0;
     float timestamp = static_cast<float>(call.FrameID());
     if (this->fileVersion == 102) {
-        timestamp = *this->dat.AsAt<float>(p);
+        timestamp = *asAt<float>(data, p);
         p += sizeof(float);
     }
-    UINT32 plc = *this->dat.AsAt<UINT32>(p);
+    UINT32 plc = *asAt<UINT32>(data, p);
     p += sizeof(UINT32);
     call.SetParticleListCount(plc);
     for (UINT32 i = 0; i < plc; i++) {
         MultiParticleDataCall::Particles &pts = call.AccessParticles(i);
 
-        UINT8 vrtType = *this->dat.AsAt<UINT8>(p); p += 1;
-        UINT8 colType = *this->dat.AsAt<UINT8>(p); p += 1;
+        UINT8 vrtType = *asAt<UINT8>(data, p); p += 1;
+        UINT8 colType = *asAt<UINT8>(data, p); p += 1;
         MultiParticleDataCall::Particles::VertexDataType vrtDatType;
         MultiParticleDataCall::Particles::ColourDataType colDatType;
         SIZE_T vrtSize = 0;
@@ -113,32 +329,32 @@ void moldyn::MMPLDDataSource::Frame::SetData(MultiParticleDataCall& call, vislib
         unsigned int stride = static_cast<unsigned int>(vrtSize + colSize);
 
         if ((vrtType == 1) || (vrtType == 3) || (vrtType == 4)) {
-            pts.SetGlobalRadius(*this->dat.AsAt<float>(p)); p += 4;
+            pts.SetGlobalRadius(*asAt<float>(data, p)); p += 4;
         } else {
             pts.SetGlobalRadius(0.05f);
         }
 
         if (colType == 0) {
-            pts.SetGlobalColour(*this->dat.AsAt<UINT8>(p),
-                *this->dat.AsAt<UINT8>(p + 1),
-                *this->dat.AsAt<UINT8>(p + 2));
+            pts.SetGlobalColour(*asAt<UINT8>(data, p),
+                *asAt<UINT8>(data, p + 1),
+                *asAt<UINT8>(data, p + 2));
             p += 4;
         } else {
             pts.SetGlobalColour(192, 192, 192);
             if (colType == 3 || colType == 7) {
                 pts.SetColourMapIndexValues(
-                    *this->dat.AsAt<float>(p),
-                    *this->dat.AsAt<float>(p + 4));
+                    *asAt<float>(data, p),
+                    *asAt<float>(data, p + 4));
                 p += 8;
             } else {
                 pts.SetColourMapIndexValues(0.0f, 1.0f);
             }
         }
 
-        pts.SetCount(*this->dat.AsAt<UINT64>(p)); p += 8;
+        pts.SetCount(*asAt<UINT64>(data, p)); p += 8;
 
         if (this->fileVersion == 103 && !overrideBBox) {
-            auto const box = this->dat.AsAt<float>(p);
+            auto const box = asAt<float>(data, p);
             vislib::math::Cuboid<float> bbox;
             bbox.Set(box[0], box[1], box[2], box[3], box[4], box[5]);
             pts.SetBBox(bbox);
@@ -147,18 +363,18 @@ void moldyn::MMPLDDataSource::Frame::SetData(MultiParticleDataCall& call, vislib
             pts.SetBBox(bbox);
         }
 
-        pts.SetVertexData(vrtDatType, this->dat.At(p), stride);
-        pts.SetColourData(colDatType, this->dat.At(p + vrtSize), stride);
+        pts.SetVertexData(vrtDatType, data + p, stride);
+        pts.SetColourData(colDatType, data + p + vrtSize, stride);
 
         p += static_cast<SIZE_T>(stride * pts.GetCount());
 
         if (this->fileVersion == 101) {
             // TODO: who deletes this?
             SimpleSphericalParticles::ClusterInfos *ci = new SimpleSphericalParticles::ClusterInfos();
-            ci->numClusters = *this->dat.AsAt<unsigned int>(p); p += sizeof(unsigned int);
-            ci->sizeofPlainData = *this->dat.AsAt<size_t>(p); p += sizeof(size_t);
+            ci->numClusters = *asAt<unsigned int>(data, p); p += sizeof(unsigned int);
+            ci->sizeofPlainData = *asAt<size_t>(data, p); p += sizeof(size_t);
             ci->plainData = (unsigned int*)malloc(ci->sizeofPlainData);
-            memcpy(ci->plainData, this->dat.At(p), ci->sizeofPlainData); p += ci->sizeofPlainData;
+            memcpy(ci->plainData, data + p, ci->sizeofPlainData); p += ci->sizeofPlainData;
             pts.SetClusterInfos(ci);
         }
     }
@@ -176,6 +392,7 @@ moldyn::MMPLDDataSource::MMPLDDataSource(void) : view::AnimDataModule(),
         limitMemorySlot("limitMemory", "Limits the memory cache size"),
         limitMemorySizeSlot("limitMemorySize", "Specifies the size limit (in MegaBytes) of the memory cache"),
         overrideBBoxSlot("overrideLocalBBox", "Override local bbox"),
+        useMappingSlot("useMemoryMapping", "Accesses the frames in a memory mapping of the file instead of copying them into the frame cache"),
         getData("getdata", "Slot to request data from this data source."),
         file(NULL), frameIdx(NULL), bbox(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f),
         clipbox(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f), data_hash(0) {
@@ -199,6 +416,10 @@ moldyn::MMPLDDataSource::MMPLDDataSource(void) : view::AnimDataModule(),
     this->overrideBBoxSlot << new param::BoolParam(false);
     this->MakeSlotAvailable(&this->overrideBBoxSlot);
 
+    this->useMappingSlot << new param::BoolParam(false);
+    this->useMappingSlot.SetUpdateCallback(&MMPLDDataSource::useMappingChanged);
+    this->MakeSlotAvailable(&this->useMappingSlot);
+
     this->getData.SetCallback("MultiParticleDataCall", "GetData", &MMPLDDataSource::getDataCallback);
     this->getData.SetCallback("MultiParticleDataCall", "GetExtent", &MMPLDDataSource::getExtentCallback);
     this->MakeSlotAvailable(&this->getData);
@@ -245,12 +466,23 @@ void moldyn::MMPLDDataSource::loadFrame(view::AnimDataModule::Frame *frame,
         f->Clear();
         return;
     }
+    ASSERT(idx < this->FrameCount());
+    const UINT64 decodedSize = this->frameStats.empty() ? 0 : this->frameStats[2 * idx + 1];
+    if (this->mappedFile.IsOpen()) {
+        // the frame is only a view, so just have the operating system read ahead
+        this->mappedFile.Prefetch(this->frameIdx[idx], this->frameIdx[idx + 1] - this->frameIdx[idx]);
+        if (!f->MapFrame(this->mappedFile.Data() + this->frameIdx[idx], idx,
+                this->frameIdx[idx + 1] - this->frameIdx[idx], this->fileVersion, decodedSize)) {
+            Log::DefaultLog.WriteMsg(Log::LEVEL_ERROR, "Unable to decode frame %d from MMPLD file\n", idx);
+        }
+        return;
+    }
     //printf("Requesting frame %u of %u frames\n", idx, this->FrameCount());
     //printf("Requesting frame %u of %u frames\n", idx, this->FrameCount());
     //Log::DefaultLog.WriteMsg(Log::LEVEL_INFO, "Requesting frame %u of %u frames\n", idx, this->FrameCount());
-    ASSERT(idx < this->FrameCount());
     this->file->Seek(this->frameIdx[idx]);
-    if (!f->LoadFrame(this->file, idx, this->frameIdx[idx + 1] - this->frameIdx[idx], this->fileVersion)) {
+    if (!f->LoadFrame(this->file, idx, this->frameIdx[idx + 1] - this->frameIdx[idx], this->fileVersion,
+            decodedSize)) {
         // failed
         Log::DefaultLog.WriteMsg(Log::LEVEL_ERROR, "Unable to read frame %d from MMPLD file\n", idx);
     }
@@ -262,6 +494,7 @@ void moldyn::MMPLDDataSource::loadFrame(view::AnimDataModule::Frame *frame,
  */
 void moldyn::MMPLDDataSource::release(void) {
     this->resetFrameCache();
+    this->mappedFile.Close();
     if (this->file != NULL) {
         vislib::sys::File *f = this->file;
         this->file = NULL;
@@ -269,6 +502,7 @@ void moldyn::MMPLDDataSource::release(void) {
         delete f;
     }
     ARY_SAFE_DELETE(this->frameIdx);
+    this->frameStats.clear();
 }
 
 
@@ -280,6 +514,9 @@ bool moldyn::MMPLDDataSource::filenameChanged(param::ParamSlot& slot) {
     using vislib::sys::Log;
     using vislib::sys::File;
     this->resetFrameCache();
+    this->mappedFile.Close();
+    this->frameStats.clear();
+    this->setLoaderThreadCount(1);
     this->bbox.Set(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f);
     this->clipbox = this->bbox;
     this->data_hash++;
@@ -320,7 +557,7 @@ bool moldyn::MMPLDDataSource::filenameChanged(param::ParamSlot& slot) {
     }
     unsigned short ver;
     _ASSERT_READFILE(&ver, 2);
-    if (ver < 100 || ver > 103) {
+    if (ver < 100 || ver > 104) {
         _ERROR_OUT("MMPLD file header version wrong");
     }
     this->fileVersion = ver;
@@ -340,9 +577,46 @@ bool moldyn::MMPLDDataSource::filenameChanged(param::ParamSlot& slot) {
     delete[] this->frameIdx;
     this->frameIdx = new UINT64[frmCnt + 1];
     _ASSERT_READFILE(this->frameIdx, 8 * (frmCnt + 1));
+
+    // version 1.4 has a footer with the particle count and the decoded size per frame
+    if (ver == 104) {
+        this->frameStats.resize(2 * static_cast<SIZE_T>(frmCnt));
+        if ((this->file->Seek(this->frameIdx[frmCnt]) != this->frameIdx[frmCnt])
+                || (this->file->Read(this->frameStats.data(), 16 * frmCnt) != 16 * frmCnt)) {
+            Log::DefaultLog.WriteMsg(Log::LEVEL_WARN, "Unable to read MMPLD frame index; estimating frame sizes");
+            this->frameStats.clear();
+        } else {
+            UINT64 particleCnt = 0;
+            for (UINT32 i = 0; i < frmCnt; i++) {
+                particleCnt += this->frameStats[2 * i];
+            }
+            this->GetCoreInstance()->Log().WriteMsg(Log::LEVEL_INFO,
+                "MMPLD file contains %llu particles in %u frames.\n",
+                static_cast<unsigned long long>(particleCnt), frmCnt);
+        }
+    }
+
+    if (this->useMappingSlot.Param<param::BoolParam>()->Value()) {
+        if (!this->mappedFile.Open(this->filename.Param<param::FilePathParam>()->Value())) {
+            Log::DefaultLog.WriteMsg(Log::LEVEL_WARN, "Unable to map MMPLD file into memory; reading frames instead");
+        } else if (this->frameIdx[frmCnt] > this->mappedFile.Size()) {
+            Log::DefaultLog.WriteMsg(Log::LEVEL_WARN, "MMPLD file is truncated; reading frames instead");
+            this->mappedFile.Close();
+        } else if (ver != 104) {
+            // compressed frames are decoded into the cache, which is thus sized as when reading
+            this->GetCoreInstance()->Log().WriteMsg(Log::LEVEL_INFO,
+                "Frame cache size set to %i (memory-mapped).\n", CACHE_SIZE_MAPPED);
+            this->setLoaderThreadCount(LOADER_CNT_MAPPED);
+            this->setFrameCount(frmCnt);
+            this->initFrameCache(CACHE_SIZE_MAPPED);
+            return true;
+        }
+    }
+
     double size = 0.0;
     for (UINT32 i = 0; i < frmCnt; i++) {
-        size += static_cast<double>(this->frameIdx[i + 1] - this->frameIdx[i]);
+        size += static_cast<double>(this->frameStats.empty()
+            ? (this->frameIdx[i + 1] - this->frameIdx[i]) : this->frameStats[2 * i + 1]);
     }
     size /= static_cast<double>(frmCnt);
     size *= CACHE_FRAME_FACTOR;
@@ -370,6 +644,9 @@ bool moldyn::MMPLDDataSource::filenameChanged(param::ParamSlot& slot) {
         this->GetCoreInstance()->Log().WriteMsg(vislib::sys::Log::LEVEL_INFO, msg);
     }
 
+    if (this->mappedFile.IsOpen()) {
+        this->setLoaderThreadCount(LOADER_CNT_MAPPED);
+    }
     this->setFrameCount(frmCnt);
     this->initFrameCache(cacheSize);
 
@@ -380,6 +657,18 @@ bool moldyn::MMPLDDataSource::filenameChanged(param::ParamSlot& slot) {
 }
 
 
+/*
+ * moldyn::MMPLDDataSource::useMappingChanged
+ */
+bool moldyn::MMPLDDataSource::useMappingChanged(param::ParamSlot& slot) {
+    if (this->file != NULL) {
+        // reopen the current file
+        this->filenameChanged(this->filename);
+    }
+    return true;
+}
+
+
 /*
  * moldyn::MMPLDDataSource::getDataCallback
  */
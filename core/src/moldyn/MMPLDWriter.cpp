@@ -11,10 +11,14 @@
 #include "mmcore/moldyn/MMPLDWriter.h"
 #include "mmcore/param/EnumParam.h"
 #include "mmcore/param/FilePathParam.h"
+#include "moldyn/MMPLDCompression.h"
 #include "vislib/String.h"
 #include "vislib/sys/FastFile.h"
 #include "vislib/sys/Log.h"
 #include "vislib/sys/Thread.h"
+#include <cfloat>
+#include <omp.h>
+#include <vector>
 
 using namespace megamol::core;
 
@@ -27,6 +31,7 @@ moldyn::MMPLDWriter::MMPLDWriter(void)
     : AbstractDataWriter()
     , filenameSlot("filename", "The path to the MMPLD file to be written")
     , versionSlot("version", "The file format version to be written")
+    , compressionSlot("compression", "The encoding of the particle data (version 1.4 only)")
     , dataSlot("data", "The slot requesting the data to be written") {
 
     this->filenameSlot << new param::FilePathParam("");
@@ -39,9 +44,17 @@ moldyn::MMPLDWriter::MMPLDWriter(void)
 #endif
     verPar->SetTypePair(102, "1.2");
     verPar->SetTypePair(103, "1.3");
+    verPar->SetTypePair(104, "1.4");
     this->versionSlot.SetParameter(verPar);
     this->MakeSlotAvailable(&this->versionSlot);
 
+    param::EnumParam* comprPar = new param::EnumParam(MMPLDCompression::ENCODING_RAW);
+    comprPar->SetTypePair(MMPLDCompression::ENCODING_RAW, "None");
+    comprPar->SetTypePair(MMPLDCompression::ENCODING_DEFLATE, "Deflate");
+    comprPar->SetTypePair(MMPLDCompression::ENCODING_QUANTIZED, "Quantized positions + Deflate (lossy)");
+    this->compressionSlot.SetParameter(comprPar);
+    this->MakeSlotAvailable(&this->compressionSlot);
+
     this->dataSlot.SetCompatibleCall<MultiParticleDataCallDescription>();
     this->MakeSlotAvailable(&this->dataSlot);
 }
@@ -155,6 +168,9 @@ bool moldyn::MMPLDWriter::run(void) {
         ASSERT_WRITEOUT(&frameOffset, 8);
     }
 
+    // per frame: number of particles and decoded size, written to the footer of version 1.4
+    std::vector<UINT64> frameStats(2 * frameCnt);
+
     mpdc->Unlock();
     for (UINT32 i = 0; i < frameCnt; i++) {
         frameOffset = static_cast<UINT64>(file.Tell());
@@ -188,7 +204,7 @@ bool moldyn::MMPLDWriter::run(void) {
             }
         } while (mpdc->FrameID() != i);
 
-        if (!this->writeFrame(file, *mpdc)) {
+        if (!this->writeFrame(file, *mpdc, frameStats[2 * i], frameStats[2 * i + 1])) {
             mpdc->Unlock();
             Log::DefaultLog.WriteMsg(Log::LEVEL_ERROR, "Cannot write data frame %u. Abort.\n", i);
             file.Close();
@@ -198,6 +214,10 @@ bool moldyn::MMPLDWriter::run(void) {
     }
 
     frameOffset = static_cast<UINT64>(file.Tell());
+    if (this->versionSlot.Param<param::EnumParam>()->Value() == 104) {
+        // the footer starts at the end offset of the last frame
+        ASSERT_WRITEOUT(frameStats.data(), frameStats.size() * 8);
+    }
     file.Seek(seekTable + frameCnt * 8);
     ASSERT_WRITEOUT(&frameOffset, 8);
 
@@ -227,7 +247,8 @@ bool moldyn::MMPLDWriter::getCapabilities(DataWriterCtrlCall& call) {
 /*
  * moldyn::MMPLDWriter::writeFrame
  */
-bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParticleDataCall& data) {
+bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParticleDataCall& data,
+    UINT64& outParticleCnt, UINT64& outDecodedSize) {
 #define ASSERT_WRITEOUT(A, S)                                                                                          \
     if (file.Write((A), (S)) != (S)) {                                                                                 \
         Log::DefaultLog.WriteMsg(Log::LEVEL_ERROR, "Write error %d", __LINE__);                                        \
@@ -238,6 +259,11 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
     uint8_t const alpha = 255;
     int ver = this->versionSlot.Param<param::EnumParam>()->Value();
 
+    // encoded lists are decoded to their version 1.3 layout
+    UINT64 const frameStart = static_cast<UINT64>(file.Tell());
+    INT64 decodedAdjust = 0;
+    outParticleCnt = 0;
+
     if (ver == 102) {
         float ts = data.GetTimeStamp();
         ASSERT_WRITEOUT(&ts, 4);
@@ -361,11 +387,105 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
         if (vt == 0) cnt = 0;
         ASSERT_WRITEOUT(&cnt, 8);
 
-        if (ver == 103) {
+        if (ver >= 103) {
             ASSERT_WRITEOUT(points.GetBBox().PeekBounds(), 24);
         }
 
         if (vt == 0) continue;
+        outParticleCnt += cnt;
+
+        UINT8 enc = MMPLDCompression::ENCODING_RAW;
+        if (ver == 104) {
+            enc = static_cast<UINT8>(this->compressionSlot.Param<param::EnumParam>()->Value());
+            if ((enc == MMPLDCompression::ENCODING_QUANTIZED) && (vt != 1) && (vt != 2)) {
+                enc = MMPLDCompression::ENCODING_DEFLATE; // only float positions are quantized
+            }
+            ASSERT_WRITEOUT(&enc, 1);
+            decodedAdjust -= 1;
+        }
+
+        // encoded lists are written in batches of chunks, which are compressed independently and in parallel,
+        // so that only a batch of records is held in memory; the chunk sizes are back-patched afterwards
+        UINT32 const ppc = MMPLDCompression::ParticlesPerChunk;
+        UINT64 encodedStart = 0, tableStart = 0, decodedSize = 0;
+        float bounds[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        std::vector<UINT64> chunkSizes;
+        SIZE_T chunkIdx = 0, batchFill = 0;
+        SIZE_T const batchSize = static_cast<SIZE_T>(std::max(omp_get_max_threads(), 1));
+        std::vector<std::vector<char>> batchRecords, batchQuantized, batchEncoded;
+        std::vector<SIZE_T> batchCnts;
+
+        if (enc != MMPLDCompression::ENCODING_RAW) {
+            encodedStart = static_cast<UINT64>(file.Tell());
+            ASSERT_WRITEOUT(&ppc, 4);
+
+            if (enc == MMPLDCompression::ENCODING_QUANTIZED) {
+                const unsigned char* pp = static_cast<const unsigned char*>(points.GetVertexData());
+                if (cnt > 0) {
+                    bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+                    bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+                }
+                for (UINT64 i = 0; i < cnt; ++i) {
+                    float pos[3];
+                    memcpy(pos, pp, 12);
+                    pp += vo;
+                    for (int d = 0; d < 3; ++d) {
+                        bounds[d] = std::min(bounds[d], pos[d]);
+                        bounds[d + 3] = std::max(bounds[d + 3], pos[d]);
+                    }
+                }
+                ASSERT_WRITEOUT(bounds, 24);
+            }
+
+            chunkSizes.resize(static_cast<SIZE_T>((cnt + ppc - 1) / ppc), 0);
+            tableStart = static_cast<UINT64>(file.Tell());
+            if (!chunkSizes.empty()) {
+                ASSERT_WRITEOUT(chunkSizes.data(), chunkSizes.size() * 8);
+            }
+
+            batchRecords.resize(batchSize);
+            batchQuantized.resize(batchSize);
+            batchEncoded.resize(batchSize);
+            batchCnts.resize(batchSize, 0);
+        }
+
+        // encodes and writes the filled chunks of the current batch
+        auto flushChunks = [&]() -> bool {
+#pragma omp parallel for schedule(dynamic)
+            for (int c = 0; c < static_cast<int>(batchFill); ++c) {
+                const char* records = batchRecords[c].data();
+                SIZE_T recordSize = batchRecords[c].size() / batchCnts[c];
+                if (enc == MMPLDCompression::ENCODING_QUANTIZED) {
+                    batchQuantized[c].resize(batchCnts[c] * (recordSize - 6));
+                    MMPLDCompression::Quantize(records, batchCnts[c], recordSize, bounds, batchQuantized[c].data());
+                    records = batchQuantized[c].data();
+                    recordSize -= 6;
+                }
+                MMPLDCompression::EncodeChunk(records, batchCnts[c], recordSize, batchEncoded[c]);
+            }
+            for (SIZE_T c = 0; c < batchFill; ++c) {
+                ASSERT_WRITEOUT(batchEncoded[c].data(), batchEncoded[c].size());
+                chunkSizes[chunkIdx++] = batchEncoded[c].size();
+                decodedSize += batchRecords[c].size();
+                batchRecords[c].clear();
+                batchCnts[c] = 0;
+            }
+            batchFill = 0;
+            return true;
+        };
+
+#define ASSERT_WRITEDATA(A, S)                                                                                         \
+    if (enc != MMPLDCompression::ENCODING_RAW) {                                                                       \
+        const char* d = reinterpret_cast<const char*>(A);                                                              \
+        batchRecords[batchFill].insert(batchRecords[batchFill].end(), d, d + (S));                                     \
+    } else {                                                                                                           \
+        ASSERT_WRITEOUT(A, S)                                                                                          \
+    }
+#define END_RECORD                                                                                                     \
+    if ((enc != MMPLDCompression::ENCODING_RAW) && (++batchCnts[batchFill] == ppc) && (++batchFill == batchSize)) {    \
+        if (!flushChunks()) return false;                                                                              \
+    }
+
         const unsigned char* vp = static_cast<const unsigned char*>(points.GetVertexData());
         const unsigned char* cp = static_cast<const unsigned char*>(points.GetColourData());
         if (vt == 4 && ct < 5) {
@@ -375,9 +495,10 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
                     auto col = points.GetGlobalColour();
                     uint16_t colNew[4] = {col[0] * 257, col[1] * 257, col[2] * 257, col[3] * 257};
                     for (UINT64 i = 0; i < cnt; ++i) {
-                        ASSERT_WRITEOUT(vp, vs);
+                        ASSERT_WRITEDATA(vp, vs);
                         vp += vo;
-                        ASSERT_WRITEOUT(colNew, 8);
+                        ASSERT_WRITEDATA(colNew, 8);
+                        END_RECORD
                     }
                 }
                 break;
@@ -385,14 +506,15 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
                 {
                     uint16_t colNew[4];
                     for (UINT64 i = 0; i < cnt; ++i) {
-                        ASSERT_WRITEOUT(vp, vs);
+                        ASSERT_WRITEDATA(vp, vs);
                         vp += vo;
                         colNew[0] = cp[0] * 257;
                         colNew[1] = cp[1] * 257;
                         colNew[2] = cp[2] * 257;
                         colNew[3] = 65535;
-                        ASSERT_WRITEOUT(colNew, 8);
+                        ASSERT_WRITEDATA(colNew, 8);
                         cp += co;
+                        END_RECORD
                     }
                 }
                 break;
@@ -400,39 +522,42 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
                 {
                     uint16_t colNew[4];
                     for (UINT64 i = 0; i < cnt; ++i) {
-                        ASSERT_WRITEOUT(vp, vs);
+                        ASSERT_WRITEDATA(vp, vs);
                         vp += vo;
                         colNew[0] = cp[0] * 257;
                         colNew[1] = cp[1] * 257;
                         colNew[2] = cp[2] * 257;
                         colNew[3] = cp[3] * 257;
-                        ASSERT_WRITEOUT(colNew, 8);
+                        ASSERT_WRITEDATA(colNew, 8);
                         cp += co;
+                        END_RECORD
                     }
                 }
                 break;
             case MultiParticleDataCall::Particles::COLDATA_FLOAT_I: {
                 double iNew;
                 for (UINT64 i = 0; i < cnt; ++i) {
-                    ASSERT_WRITEOUT(vp, vs);
+                    ASSERT_WRITEDATA(vp, vs);
                     vp += vo;
                     iNew = *(reinterpret_cast<const float *>(cp));
-                    ASSERT_WRITEOUT(&iNew, 8);
+                    ASSERT_WRITEDATA(&iNew, 8);
                     cp += co;
+                    END_RECORD
                 }
             } break;
             case MultiParticleDataCall::Particles::COLDATA_FLOAT_RGB: {
                 uint16_t colNew[4];
                 for (UINT64 i = 0; i < cnt; ++i) {
-                    ASSERT_WRITEOUT(vp, vs);
+                    ASSERT_WRITEDATA(vp, vs);
                     vp += vo;
                     const auto * col = reinterpret_cast<const float*>(cp);
                     colNew[0] = col[0] * 65535.0f;
                     colNew[1] = col[1] * 65535.0f;
                     colNew[2] = col[2] * 65535.0f;
                     colNew[3] = 65535.0f;
-                    ASSERT_WRITEOUT(colNew, 8);
+                    ASSERT_WRITEDATA(colNew, 8);
                     cp += co;
+                    END_RECORD
                 }
             } break;
             default:
@@ -442,17 +567,38 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
             }
         } else {
             for (UINT64 i = 0; i < cnt; i++) {
-                ASSERT_WRITEOUT(vp, vs);
+                ASSERT_WRITEDATA(vp, vs);
                 vp += vo;
                 if (ct != 0) {
-                    ASSERT_WRITEOUT(cp, cs);
+                    ASSERT_WRITEDATA(cp, cs);
                     // warning: this only works since only one format is 3 bytes long, the illegal ct = 1
                     if (cs == 3) { // the unaligned ct == 1, UINT8_RGB, will be silently upgraded to ct 2 / cs 4
-                        ASSERT_WRITEOUT(&alpha, 1);
+                        ASSERT_WRITEDATA(&alpha, 1);
                     }
                     cp += co;
                 }
+                END_RECORD
+            }
+        }
+#undef END_RECORD
+#undef ASSERT_WRITEDATA
+
+        if (enc != MMPLDCompression::ENCODING_RAW) {
+            if ((batchFill < batchSize) && (batchCnts[batchFill] > 0)) {
+                ++batchFill;
+            }
+            if ((batchFill > 0) && !flushChunks()) {
+                return false;
             }
+
+            UINT64 const encodedEnd = static_cast<UINT64>(file.Tell());
+            if (!chunkSizes.empty()) {
+                file.Seek(tableStart);
+                ASSERT_WRITEOUT(chunkSizes.data(), chunkSizes.size() * 8);
+                file.Seek(encodedEnd);
+            }
+
+            decodedAdjust += static_cast<INT64>(decodedSize) - static_cast<INT64>(encodedEnd - encodedStart);
         }
 #ifdef WITH_CLUSTERINFO
         if (ver == 101) {
@@ -470,6 +616,8 @@ bool moldyn::MMPLDWriter::writeFrame(vislib::sys::File& file, moldyn::MultiParti
 #endif
     }
 
+    outDecodedSize = static_cast<UINT64>(static_cast<INT64>(static_cast<UINT64>(file.Tell()) - frameStart) + decodedAdjust);
+
     return true;
 #undef ASSERT_WRITEOUT
 }
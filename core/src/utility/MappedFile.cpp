@@ -0,0 +1,174 @@
+/*
+ * MappedFile.cpp
+ *
+ * Copyright (C) 2019 by VISUS (Universitaet Stuttgart)
+ * Alle Rechte vorbehalten.
+ */
+
+#include "stdafx.h"
+#include "mmcore/utility/MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* !_WIN32 */
+
+#include <cstdint>
+
+using namespace megamol::core;
+
+
+/*
+ * utility::MappedFile::MappedFile
+ */
+utility::MappedFile::MappedFile(void) : data(NULL), size(0),
+#ifdef _WIN32
+        fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL) {
+#else /* _WIN32 */
+        fileDescriptor(-1) {
+#endif /* _WIN32 */
+    // intentionally empty
+}
+
+
+/*
+ * utility::MappedFile::~MappedFile
+ */
+utility::MappedFile::~MappedFile(void) {
+    this->Close();
+}
+
+
+#ifdef _WIN32
+
+/*
+ * utility::MappedFile::Open
+ */
+bool utility::MappedFile::Open(const vislib::TString& filename) {
+    this->Close();
+
+    this->fileHandle = ::CreateFile(filename.PeekBuffer(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (this->fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(this->fileHandle, &fileSize) || (fileSize.QuadPart <= 0)
+            || (static_cast<UINT64>(fileSize.QuadPart) > SIZE_MAX)) {
+        this->Close();
+        return false;
+    }
+
+    this->mappingHandle = ::CreateFileMapping(this->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (this->mappingHandle == NULL) {
+        this->Close();
+        return false;
+    }
+
+    this->data = static_cast<const char*>(::MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (this->data == NULL) {
+        this->Close();
+        return false;
+    }
+    this->size = static_cast<UINT64>(fileSize.QuadPart);
+
+    return true;
+}
+
+
+/*
+ * utility::MappedFile::Close
+ */
+void utility::MappedFile::Close(void) {
+    if (this->data != NULL) {
+        ::UnmapViewOfFile(this->data);
+        this->data = NULL;
+    }
+    if (this->mappingHandle != NULL) {
+        ::CloseHandle(this->mappingHandle);
+        this->mappingHandle = NULL;
+    }
+    if (this->fileHandle != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(this->fileHandle);
+        this->fileHandle = INVALID_HANDLE_VALUE;
+    }
+    this->size = 0;
+}
+
+
+/*
+ * utility::MappedFile::Prefetch
+ */
+void utility::MappedFile::Prefetch(UINT64 /*offset*/, UINT64 /*size*/) const {
+    // PrefetchVirtualMemory requires Windows 8, so we rely on the
+    // read-ahead of the memory manager instead.
+}
+
+#else /* _WIN32 */
+
+/*
+ * utility::MappedFile::Open
+ */
+bool utility::MappedFile::Open(const vislib::TString& filename) {
+    this->Close();
+
+    this->fileDescriptor = ::open(vislib::StringA(filename).PeekBuffer(), O_RDONLY);
+    if (this->fileDescriptor == -1) {
+        return false;
+    }
+
+    struct stat fileStatus;
+    if ((::fstat(this->fileDescriptor, &fileStatus) != 0) || (fileStatus.st_size <= 0)
+            || (static_cast<UINT64>(fileStatus.st_size) > SIZE_MAX)) {
+        this->Close();
+        return false;
+    }
+
+    void *mapping = ::mmap(NULL, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_SHARED,
+        this->fileDescriptor, 0);
+    if (mapping == MAP_FAILED) {
+        this->Close();
+        return false;
+    }
+    this->data = static_cast<const char*>(mapping);
+    this->size = static_cast<UINT64>(fileStatus.st_size);
+
+    return true;
+}
+
+
+/*
+ * utility::MappedFile::Close
+ */
+void utility::MappedFile::Close(void) {
+    if (this->data != NULL) {
+        ::munmap(const_cast<char*>(this->data), static_cast<size_t>(this->size));
+        this->data = NULL;
+    }
+    if (this->fileDescriptor != -1) {
+        ::close(this->fileDescriptor);
+        this->fileDescriptor = -1;
+    }
+    this->size = 0;
+}
+
+
+/*
+ * utility::MappedFile::Prefetch
+ */
+void utility::MappedFile::Prefetch(UINT64 offset, UINT64 size) const {
+    if ((this->data == NULL) || (offset >= this->size)) return;
+    if (size > this->size - offset) {
+        size = this->size - offset;
+    }
+
+    // madvise requires page-aligned addresses
+    const UINT64 pageSize = static_cast<UINT64>(::sysconf(_SC_PAGESIZE));
+    const UINT64 begin = offset - (offset % pageSize);
+    ::madvise(const_cast<char*>(this->data) + begin, static_cast<size_t>(offset + size - begin), MADV_WILLNEED);
+}
+
+#endif /* _WIN32 */
@@ -10,19 +10,24 @@
 #include "vislib/assert.h"
 #include "vislib/sys/Log.h"
 #include "vislib/sys/Thread.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 
 using namespace megamol::core;
 
 #define MM_ADM_COUNT_LOCKED_FRAMES
 
+// time after which waiting for a forced frame is given up
+#define MM_ADM_FORCED_FRAME_TIMEOUT std::chrono::seconds(30)
+
 
 /*
  * view::AnimDataModule::AnimDataModule
  */
 view::AnimDataModule::AnimDataModule(void) : Module(), frameCnt(0),
-        loader(loaderFunction), frameCache(NULL), cacheSize(0),
-        stateLock(), lastRequested(0) {
+        loaders(), loaderCnt(1), runningLoaders(0), frameCache(NULL), cacheSize(0),
+        stateLock(), lastRequested(0), playbackStep(1) {
     this->isRunning.store(false);
 }
 
@@ -35,10 +40,7 @@ view::AnimDataModule::~AnimDataModule(void) {
 
     Frame ** frames = this->frameCache;
 //    this->frameCache = NULL;
-    this->isRunning.store(false);
-    if (this->loader.IsRunning()) {
-        this->loader.Join();
-    }
+    this->stopLoaders();
     this->frameCache = NULL;
     if (frames != NULL) {
         for (unsigned int i = 0; i < this->cacheSize; i++) {
@@ -54,10 +56,13 @@ view::AnimDataModule::~AnimDataModule(void) {
  * view::AnimDataModule::initframeCache
  */
 void view::AnimDataModule::initFrameCache(unsigned int cacheSize) {
-    ASSERT(this->loader.IsRunning() == false);
+    ASSERT(this->runningLoaders.load() == 0);
     ASSERT(cacheSize > 0);
     ASSERT(this->frameCnt > 0);
 
+    // join loaders which terminated on their own
+    this->stopLoaders();
+
     if (cacheSize > this->frameCnt) {
         cacheSize = this->frameCnt; // because we don't need more
     }
@@ -87,10 +92,14 @@ void view::AnimDataModule::initFrameCache(unsigned int cacheSize) {
         this->loadFrame(this->frameCache[0], 0); // load first frame directly.
         this->frameCache[0]->state = Frame::STATE_AVAILABLE;
         this->lastRequested = 0;
+        this->playbackStep = 1;
 
         this->isRunning.store(true);
-        this->loader.Start(this);
-        vislib::sys::Thread::Sleep(250);
+        const unsigned int threadCnt = std::min(this->loaderCnt, this->cacheSize);
+        this->runningLoaders.store(threadCnt);
+        for (unsigned int i = 0; i < threadCnt; i++) {
+            this->loaders.emplace_back(&AnimDataModule::loaderFunction, this);
+        }
     } else {
         vislib::sys::Log::DefaultLog.WriteMsg(vislib::sys::Log::LEVEL_ERROR,
             "Unable to create frame data cache ('constructFrame' returned 'NULL').");
@@ -103,29 +112,39 @@ void view::AnimDataModule::initFrameCache(unsigned int cacheSize) {
  */
 view::AnimDataModule::Frame * view::AnimDataModule::requestLockedFrame(unsigned int idx) {
     Frame *retval = NULL;
-    int dist, minDist = this->frameCnt;
+    unsigned int clcf = 0;
     static bool deadlockwarning = true;
 
-    this->stateLock.Lock();
-    this->lastRequested = idx; // TODO: choose better caching strategy!!!
-    for (unsigned int i = 0; i < this->cacheSize; i++) {
-        if ((this->frameCache[i]->state == Frame::STATE_AVAILABLE)
-                || (this->frameCache[i]->state == Frame::STATE_INUSE)) {
-            // note: do not wrap distance around!
-            dist = labs(this->frameCache[i]->frame - idx);
-            if (dist == 0) {
-                retval = this->frameCache[i];
-                break;
-            } else if (dist < minDist) {
-                retval = this->frameCache[i];
-                minDist = dist;
+    {
+        std::lock_guard<std::mutex> lock(this->stateLock);
+
+        if (idx != this->lastRequested) {
+            // predict the playback from the step between the last two requests
+            long delta = static_cast<long>(idx) - static_cast<long>(this->lastRequested);
+            const long cnt = static_cast<long>(this->frameCnt);
+            if (2 * delta > cnt) {
+                delta -= cnt;
+            } else if (2 * delta < -cnt) {
+                delta += cnt;
+            }
+            if ((delta != 0) && (labs(delta) <= static_cast<long>(this->cacheSize))) {
+                this->playbackStep = static_cast<int>(delta);
+            } else {
+                // a jump: keep the direction, but not the speed
+                this->playbackStep = (this->playbackStep < 0) ? -1 : 1;
+            }
+            this->lastRequested = idx;
+            this->loaderCondition.notify_all();
+        }
+
+        retval = this->lockBestFrame(idx);
+
+        for (unsigned int i = 0; i < this->cacheSize; i++) {
+            if (this->frameCache[i]->state == Frame::STATE_INUSE) {
+                clcf++;
             }
         }
     }
-    if (retval != NULL) {
-        retval->state = Frame::STATE_INUSE;
-    }
-    this->stateLock.Unlock();
 
     if (deadlockwarning
 #if !(defined(DEBUG) || defined(_DEBUG))
@@ -133,13 +152,6 @@ view::AnimDataModule::Frame * view::AnimDataModule::requestLockedFrame(unsigned
             // streaming is required to handle this data set
 #endif /* !(defined(DEBUG) || defined(_DEBUG)) */
             ) {
-        unsigned int clcf = 0;
-        for (unsigned int i = 0; i < this->cacheSize; i++) {
-            if (this->frameCache[i]->state == Frame::STATE_INUSE) {
-                clcf++;
-            }
-        }
-
         //printf("======== %u frames locked\n", clcf);
 
         if ((clcf == this->cacheSize) && (this->cacheSize > 2)) {
@@ -158,23 +170,45 @@ view::AnimDataModule::Frame * view::AnimDataModule::requestLockedFrame(unsigned
  */
 view::AnimDataModule::Frame * view::AnimDataModule::requestLockedFrame(unsigned int idx, bool forceIdx) {
     Frame *f = this->requestLockedFrame(idx);
-    if ((f->FrameNumber() == idx) || (!forceIdx)) return f;
+    if (!forceIdx || ((f != NULL) && (f->FrameNumber() == idx))) return f;
     // wrong frame number and frame is forced
 
     // clamp idx
     if (idx >= this->frameCnt) {
         idx = this->frameCnt - 1;
-        f->Unlock();
-        f = this->requestLockedFrame(idx);
     }
 
+    auto isCached = [this, idx]() {
+        for (unsigned int i = 0; i < this->cacheSize; i++) {
+            if (((this->frameCache[i]->state == Frame::STATE_AVAILABLE)
+                    || (this->frameCache[i]->state == Frame::STATE_INUSE))
+                    && (this->frameCache[i]->frame == idx)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
     // wait for the new frame
-    while (idx != f->FrameNumber()) {
-        f->Unlock();
+    const auto deadline = std::chrono::steady_clock::now() + MM_ADM_FORCED_FRAME_TIMEOUT;
+    while ((f == NULL) || (idx != f->FrameNumber())) {
+        if (f != NULL) {
+            // do not block the cache while waiting
+            f->Unlock();
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            vislib::sys::Log::DefaultLog.WriteError("%s: frame %u could not be loaded in time",
+                this->FullName().PeekBuffer(), idx);
+            return NULL;
+        }
 
-        // HAZARD: This will wait for all eternity if the requested frame is never loaded
+        {
+            std::unique_lock<std::mutex> lock(this->stateLock);
+            // the timeout only guards against frames which are never loaded
+            this->frameCondition.wait_for(lock, std::chrono::milliseconds(100), isCached);
+        }
 
-        vislib::sys::Thread::Sleep(100); // time for the loader thread to load
         f = this->requestLockedFrame(idx);
     }
 
@@ -188,10 +222,7 @@ view::AnimDataModule::Frame * view::AnimDataModule::requestLockedFrame(unsigned
 void view::AnimDataModule::resetFrameCache(void) {
     Frame ** frames = this->frameCache;
 //    this->frameCache = NULL;
-    this->isRunning.store(false);
-    if (this->loader.IsRunning()) {
-        this->loader.Join();
-    }
+    this->stopLoaders();
     this->frameCache = NULL;
     if (frames != NULL) {
         for (unsigned int i = 0; i < this->cacheSize; i++) {
@@ -202,6 +233,7 @@ void view::AnimDataModule::resetFrameCache(void) {
     this->frameCnt = 0;
     this->cacheSize = 0;
     this->lastRequested = 0;
+    this->playbackStep = 1;
 }
 
 
@@ -209,150 +241,136 @@ void view::AnimDataModule::resetFrameCache(void) {
  * view::AnimDataModule::setFrameCount
  */
 void view::AnimDataModule::setFrameCount(unsigned int cnt) {
-    ASSERT(this->loader.IsRunning() == false);
+    ASSERT(this->runningLoaders.load() == 0);
     ASSERT(cnt > 0);
     this->frameCnt = cnt;
 }
 
 
+/*
+ * view::AnimDataModule::setLoaderThreadCount
+ */
+void view::AnimDataModule::setLoaderThreadCount(unsigned int cnt) {
+    ASSERT(this->runningLoaders.load() == 0);
+    ASSERT(cnt > 0);
+    this->loaderCnt = cnt;
+}
+
+
 /*
  * view::AnimDataModule::loaderFunction
  */
-DWORD view::AnimDataModule::loaderFunction(void *userData) {
-    AnimDataModule *This = static_cast<AnimDataModule*>(userData);
-    ASSERT(This != NULL);
-    unsigned int index, i, j, req;
+void view::AnimDataModule::loaderFunction(void) {
+    unsigned int index, dist, i, j;
 #ifdef _LOADING_REPORTING
     unsigned int l;
 #endif /* _LOADING_REPORTING */
     Frame *frame;
-    vislib::StringA fullName(This->FullName());
+    vislib::StringA fullName(this->FullName());
 
-    std::chrono::high_resolution_clock::duration accumDuration;
+    std::chrono::high_resolution_clock::duration accumDuration(0);
     unsigned int accumCount = 0;
     std::chrono::system_clock::time_point lastReportTime = std::chrono::system_clock::now();
     const std::chrono::system_clock::duration lastReportDistance = std::chrono::seconds(3);
 
-    while (This->isRunning.load()) {
-        // sleep to enforce thread changes
-        vislib::sys::Thread::Sleep(1);
-        if (!This->isRunning.load()) break;
+    std::unique_lock<std::mutex> lock(this->stateLock);
 
+    while (this->isRunning.load()) {
         // idea:
         //  1. search for the most important frame to be loaded.
         //  2. search for the best cached frame to be overwritten.
         //  3. load the frame
+        // Whenever there is nothing to do, sleep until a frame is requested,
+        // unlocked or loaded.
 
         // 1.
-        // Note: we do not need to lock here, because we won't change the frame
-        // state now, and the different states that can be set outside this
-        // thread are aquivalent for us.
-        index = req = This->lastRequested;
-        for (j = 0; j < This->cacheSize; j++) {
-            for (i = 0; i < This->cacheSize; i++) {
-                if (!This->isRunning.load()) break;
-                if (((This->frameCache[i]->state == Frame::STATE_AVAILABLE)
-                        || (This->frameCache[i]->state == Frame::STATE_INUSE)) 
-                        && (This->frameCache[i]->frame == index)) {
+        if (!this->findFrameToLoad(index, dist)) {
+            if (this->cacheSize >= this->frameCnt) {
+                for (i = 0; i < this->cacheSize; i++) {
+                    if ((this->frameCache[i]->state != Frame::STATE_AVAILABLE)
+                            && (this->frameCache[i]->state != Frame::STATE_INUSE)) {
+                        break;
+                    }
+                }
+                if (i >= this->cacheSize) {
+                    vislib::sys::Log::DefaultLog.WriteMsg(vislib::sys::Log::LEVEL_INFO,
+                        "All frames of the dataset loaded into cache. Terminating loading Thread.");
                     break;
                 }
             }
-            if (!This->isRunning.load()) break;
-            if (i >= This->cacheSize) {
-                break;
-            }
-            index = (index + 1) % This->frameCnt;
-        }
-        if (!This->isRunning.load()) break;
-        if (j >= This->cacheSize) {
-            if (j >= This->frameCnt) {
-                ASSERT(This->frameCnt == This->cacheSize);
-                vislib::sys::Log::DefaultLog.WriteMsg(vislib::sys::Log::LEVEL_INFO,
-                    "All frames of the dataset loaded into cache. Terminating loading Thread.");
-                break;
-            }
+            this->loaderCondition.wait(lock);
             continue;
         }
 
         // 2.
-        // Note: We now need to lock, because we must synchronise against 
-        // frames changing from 'STATE_AVAILABLE' to 'STATE_INUSE'.
-        This->stateLock.Lock();
-        // core idea: search for the frame with the largest distance to the requested frame
+        // core idea: search for the frame with the largest distance along the
+        // playback, which is farther away than the frame to be loaded
         frame = NULL; // the frame to be overwritten
-        j = 0; // the distance to the found frame to be overwritten
-        for (i = 0; i < This->cacheSize; i++) {
-            if (This->frameCache[i]->state == Frame::STATE_INVALID) {
-                frame = This->frameCache[i];
-                // j = UINT_MAX; // not required, since we instantly leave the loop
+        j = dist; // the distance to the found frame to be overwritten
+        for (i = 0; i < this->cacheSize; i++) {
+            if (this->frameCache[i]->state == Frame::STATE_INVALID) {
+                frame = this->frameCache[i];
 #ifdef _LOADING_REPORTING
                 l = i;
 #endif /* _LOADING_REPORTING */
                 break;
-            } else if (This->frameCache[i]->state == Frame::STATE_AVAILABLE) {
-                // distance to the frame[i];
-                long ld = static_cast<long>(This->frameCache[i]->frame) - static_cast<long>(req);
-                if (ld < 0) {
-                    if (ld < (static_cast<long>(This->frameCnt)) / 10) {
-                        ld += static_cast<long>(This->frameCnt);
-                        if (ld < 0) ld = 0; // should never happen
-                    } else {
-                        ld = -10 * ld;
-                    }
-                }
-
-                if (j < static_cast<unsigned int>(ld)) {
-                    frame = This->frameCache[i];
-                    j = static_cast<unsigned int>(ld);
+            } else if (this->frameCache[i]->state == Frame::STATE_AVAILABLE) {
+                const unsigned int d = this->playbackDistance(this->frameCache[i]->frame);
+                if (j < d) {
+                    frame = this->frameCache[i];
+                    j = d;
 #ifdef _LOADING_REPORTING
                     l = i;
 #endif /* _LOADING_REPORTING */
                 }
             }
-            if (!This->isRunning.load()) break;
         }
 
-        // 3.
-        if (frame != NULL) {
-            frame->state = Frame::STATE_LOADING;
-        }
         // if frame is NULL no suitable cache buffer found for loading. This is
         // mostly the case if the cache is too small or if the data source 
         // locks too much frames.
-        This->stateLock.Unlock();
+        if (frame == NULL) {
+            this->loaderCondition.wait(lock);
+            continue;
+        }
+
+        // 3.
+        frame->state = Frame::STATE_LOADING;
+        frame->loadingIdx = index;
+        lock.unlock();
 
-        if ((frame != NULL) && This->isRunning.load()) {
 #ifdef _LOADING_REPORTING
-            printf("Loading frame %i into cache %i\n", index, l);
+        printf("Loading frame %i into cache %i\n", index, l);
 #endif /* _LOADING_REPORTING */
 
-            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
 
-            This->loadFrame(frame, index);
+        this->loadFrame(frame, index);
 
-            std::chrono::high_resolution_clock::duration duration = std::chrono::high_resolution_clock::now() - start;
-            accumDuration += duration;
-            accumCount++;
+        std::chrono::high_resolution_clock::duration duration = std::chrono::high_resolution_clock::now() - start;
+        accumDuration += duration;
+        accumCount++;
 
-            std::chrono::system_clock::time_point reportTime = std::chrono::system_clock::now();
-            if ((reportTime - lastReportTime) > lastReportDistance) {
-                lastReportTime = reportTime;
-                if (accumCount > 0) {
-                    vislib::sys::Log::DefaultLog.WriteInfo(100, "[%s] Loading speed: %f ms/f (%u)",
-                        fullName.PeekBuffer(),
-                        1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(accumDuration).count() / static_cast<double>(accumCount),
-                        static_cast<unsigned int>(accumCount)
-                        );
-                }
+        std::chrono::system_clock::time_point reportTime = std::chrono::system_clock::now();
+        if ((reportTime - lastReportTime) > lastReportDistance) {
+            lastReportTime = reportTime;
+            if (accumCount > 0) {
+                vislib::sys::Log::DefaultLog.WriteInfo(100, "[%s] Loading speed: %f ms/f (%u)",
+                    fullName.PeekBuffer(),
+                    1000.0 * std::chrono::duration_cast<std::chrono::duration<double>>(accumDuration).count() / static_cast<double>(accumCount),
+                    static_cast<unsigned int>(accumCount)
+                    );
             }
-
-            // we no not need to lock here, because this transition from 
-            // 'STATE_LOADING' to 'STATE_AVAILABLE' is safe for the using 
-            // thread.
-            frame->state = Frame::STATE_AVAILABLE;
         }
+
+        lock.lock();
+        frame->state = Frame::STATE_AVAILABLE;
+        this->frameCondition.notify_all();
+        this->loaderCondition.notify_all();
     }
 
+    lock.unlock();
+
     if (accumCount > 0) {
         vislib::sys::Log::DefaultLog.WriteInfo(100, "[%s] Loading speed: %f ms/f (%u)",
             fullName.PeekBuffer(),
@@ -362,7 +380,124 @@ DWORD view::AnimDataModule::loaderFunction(void *userData) {
     }
 
     vislib::sys::Log::DefaultLog.WriteInfo("The loader thread is exiting.");
-    return 0;
+    this->runningLoaders--;
+}
+
+
+/*
+ * view::AnimDataModule::findFrameToLoad
+ */
+bool view::AnimDataModule::findFrameToLoad(unsigned int& outIdx, unsigned int& outDist) const {
+    const long cnt = static_cast<long>(this->frameCnt);
+    const long step = this->playbackStep;
+    const long stride = labs(step);
+
+    auto isCachedOrLoading = [this](unsigned int idx) {
+        for (unsigned int i = 0; i < this->cacheSize; i++) {
+            const Frame *f = this->frameCache[i];
+            if ((((f->state == Frame::STATE_AVAILABLE) || (f->state == Frame::STATE_INUSE)) && (f->frame == idx))
+                    || ((f->state == Frame::STATE_LOADING) && (f->loadingIdx == idx))) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // the prefetch window: as many frames along the playback as fit into the cache
+    for (long k = 0; (k < static_cast<long>(this->cacheSize)) && (k * stride < cnt); k++) {
+        long idx = (static_cast<long>(this->lastRequested) + k * step) % cnt;
+        if (idx < 0) idx += cnt;
+        if (!isCachedOrLoading(static_cast<unsigned int>(idx))) {
+            outIdx = static_cast<unsigned int>(idx);
+            outDist = static_cast<unsigned int>(k * stride);
+            return true;
+        }
+    }
+
+    // use empty cache slots for the frames skipped by the playback
+    bool hasEmptySlot = false;
+    for (unsigned int i = 0; i < this->cacheSize; i++) {
+        if (this->frameCache[i]->state == Frame::STATE_INVALID) {
+            hasEmptySlot = true;
+            break;
+        }
+    }
+    if (hasEmptySlot) {
+        const long dir = (step < 0) ? -1 : 1;
+        for (long k = 0; k < cnt; k++) {
+            long idx = (static_cast<long>(this->lastRequested) + k * dir) % cnt;
+            if (idx < 0) idx += cnt;
+            if (!isCachedOrLoading(static_cast<unsigned int>(idx))) {
+                outIdx = static_cast<unsigned int>(idx);
+                outDist = this->playbackDistance(outIdx);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+
+/*
+ * view::AnimDataModule::playbackDistance
+ */
+unsigned int view::AnimDataModule::playbackDistance(unsigned int idx) const {
+    const long cnt = static_cast<long>(this->frameCnt);
+    const long dir = (this->playbackStep < 0) ? -1 : 1;
+    const long stride = labs(this->playbackStep);
+
+    long dist = ((static_cast<long>(idx) - static_cast<long>(this->lastRequested)) * dir) % cnt;
+    if (dist < 0) dist += cnt;
+    if ((dist % stride) != 0) dist += cnt; // skipped by the playback
+    return static_cast<unsigned int>(dist);
+}
+
+
+/*
+ * view::AnimDataModule::lockBestFrame
+ */
+view::AnimDataModule::Frame * view::AnimDataModule::lockBestFrame(unsigned int idx) {
+    Frame *retval = NULL;
+    long dist, minDist = this->frameCnt;
+
+    for (unsigned int i = 0; i < this->cacheSize; i++) {
+        if ((this->frameCache[i]->state == Frame::STATE_AVAILABLE)
+                || (this->frameCache[i]->state == Frame::STATE_INUSE)) {
+            // note: do not wrap distance around!
+            dist = labs(static_cast<long>(this->frameCache[i]->frame) - static_cast<long>(idx));
+            if (dist == 0) {
+                retval = this->frameCache[i];
+                break;
+            } else if (dist < minDist) {
+                retval = this->frameCache[i];
+                minDist = dist;
+            }
+        }
+    }
+    if (retval != NULL) {
+        retval->state = Frame::STATE_INUSE;
+    }
+
+    return retval;
+}
+
+
+/*
+ * view::AnimDataModule::stopLoaders
+ */
+void view::AnimDataModule::stopLoaders(void) {
+    {
+        std::lock_guard<std::mutex> lock(this->stateLock);
+        this->isRunning.store(false);
+    }
+    this->loaderCondition.notify_all();
+    this->frameCondition.notify_all();
+
+    for (auto& loader : this->loaders) {
+        loader.join();
+    }
+    this->loaders.clear();
 }
 
 
@@ -372,7 +507,8 @@ DWORD view::AnimDataModule::loaderFunction(void *userData) {
 void view::AnimDataModule::unlock(view::AnimDataModule::Frame *frame) {
     ASSERT(&frame->owner == this);
     ASSERT(frame->state == Frame::STATE_INUSE);
-    this->stateLock.Lock();
+    std::lock_guard<std::mutex> lock(this->stateLock);
     frame->state = Frame::STATE_AVAILABLE;
-    this->stateLock.Unlock();
+    // the frame may now be overwritten
+    this->loaderCondition.notify_all();
 }
@@ -0,0 +1,838 @@
+/*
+ * main.cpp
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ *
+ * Headless benchmark for the flowvis pipeline, writing its measurements in JSON lines format.
+ */
+#include "stdafx.h"
+
+#include "critical_points.h"
+#include "implicit_topology_computation.h"
+#include "implicit_topology_file.h"
+#include "implicit_topology_results.h"
+#include "streamlines_cpu.h"
+#include "telemetry.h"
+#include "triangulation.h"
+
+#include "flowvis/integrator.h"
+
+#include "mmcore/utility/MappedFile.h"
+
+#include "vislib/String.h"
+
+#include "../cuda/streamlines.h"
+
+#include "Eigen/Dense"
+
+#include "tpf/data/tpf_grid.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef FLOWVIS_BENCHMARK_DATA_DIR
+#define FLOWVIS_BENCHMARK_DATA_DIR "data"
+#endif
+
+namespace
+{
+    using namespace megamol::flowvis;
+
+    using benchmark_clock = std::chrono::steady_clock;
+
+    /**
+    * Vector field on a regular grid, with the convergence structures used for the implicit topology
+    */
+    struct vector_field_t
+    {
+        std::string name;
+
+        std::array<unsigned int, 2> resolution;
+        std::array<float, 4> domain;
+
+        std::vector<float> positions;
+        std::vector<float> vectors;
+
+        std::vector<float> points;
+        std::vector<int> point_ids;
+    };
+
+    /**
+    * Benchmark settings
+    */
+    struct settings_t
+    {
+        std::string data_path = FLOWVIS_BENCHMARK_DATA_DIR;
+        std::vector<std::string> data_sets = { "buoyant_I", "buoyant_II" };
+        std::vector<unsigned int> resolutions = { 64, 128, 256 };
+
+        unsigned int repetitions = 5;
+        unsigned int num_integration_steps = 100;
+        unsigned int num_topology_integration_steps = 1000;
+        float refinement_factor = 0.25f;
+
+        std::string temporary_path = "flowvis_benchmark.tmp";
+        std::string output_path;
+
+        bool skip_implicit_topology = false;
+        bool verbose = false;
+    };
+
+    /**
+    * Print usage
+    *
+    * @param program    Program name
+    */
+    void print_usage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [options]" << std::endl << std::endl
+            << "Options:" << std::endl
+            << "  --data <path>                 Directory containing the data sets (default: " << FLOWVIS_BENCHMARK_DATA_DIR << ")" << std::endl
+            << "  --data-sets <a,b,...>         Data sets to use (default: buoyant_I,buoyant_II)" << std::endl
+            << "  --resolutions <a,b,...>       Resolutions to which the vector fields are resampled (default: 64,128,256)" << std::endl
+            << "  --repetitions <n>             Number of repetitions per measurement (default: 5)" << std::endl
+            << "  --steps <n>                   Number of integration steps for the integrators (default: 100)" << std::endl
+            << "  --topology-steps <n>          Number of integration steps for the implicit topology (default: 1000)" << std::endl
+            << "  --refinement-factor <f>       Refinement threshold relative to the cell size (default: 0.25)" << std::endl
+            << "  --skip-implicit-topology      Skip the implicit topology computation and result I/O" << std::endl
+            << "  --temp <file>                 Temporary file for result I/O (default: flowvis_benchmark.tmp)" << std::endl
+            << "  --output <file>               Output file (default: standard output)" << std::endl
+            << "  --verbose                     Write log of the implicit topology computation to standard error" << std::endl;
+    }
+
+    /**
+    * Split comma-separated list
+    *
+    * @param list       Comma-separated list
+    *
+    * @return Items
+    */
+    std::vector<std::string> split(const std::string& list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+            {
+                items.push_back(item);
+            }
+        }
+
+        return items;
+    }
+
+    /**
+    * Parse command line
+    *
+    * @param argc       Number of arguments
+    * @param argv       Arguments
+    *
+    * @return Settings
+    *
+    * @throws std::invalid_argument for invalid arguments
+    */
+    settings_t parse_arguments(const int argc, char** argv)
+    {
+        settings_t settings;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string argument(argv[i]);
+
+            auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc)
+                {
+                    throw std::invalid_argument("Missing value for argument " + argument);
+                }
+
+                return argv[++i];
+            };
+
+            if (argument == "--data")
+            {
+                settings.data_path = value();
+            }
+            else if (argument == "--data-sets")
+            {
+                settings.data_sets = split(value());
+            }
+            else if (argument == "--resolutions")
+            {
+                settings.resolutions.clear();
+
+                for (const auto& resolution : split(value()))
+                {
+                    settings.resolutions.push_back(static_cast<unsigned int>(std::stoul(resolution)));
+
+                    if (settings.resolutions.back() < 2)
+                    {
+                        throw std::invalid_argument("Resolution must be at least 2");
+                    }
+                }
+            }
+            else if (argument == "--repetitions")
+            {
+                settings.repetitions = std::max(static_cast<unsigned int>(std::stoul(value())), 1u);
+            }
+            else if (argument == "--steps")
+            {
+                settings.num_integration_steps = static_cast<unsigned int>(std::stoul(value()));
+            }
+            else if (argument == "--topology-steps")
+            {
+                settings.num_topology_integration_steps = static_cast<unsigned int>(std::stoul(value()));
+            }
+            else if (argument == "--refinement-factor")
+            {
+                settings.refinement_factor = std::stof(value());
+            }
+            else if (argument == "--skip-implicit-topology")
+            {
+                settings.skip_implicit_topology = true;
+            }
+            else if (argument == "--temp")
+            {
+                settings.temporary_path = value();
+            }
+            else if (argument == "--output")
+            {
+                settings.output_path = value();
+            }
+            else if (argument == "--verbose")
+            {
+                settings.verbose = true;
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown argument " + argument);
+            }
+        }
+
+        return settings;
+    }
+
+    /**
+    * Load vector field in the format of the vector field reader
+    *
+    * @param name       Name of the data set
+    * @param filename   Path to the vector field file
+    *
+    * @return Vector field without convergence structures
+    *
+    * @throws std::runtime_error if the file cannot be read
+    */
+    vector_field_t load_vector_field(const std::string& name, const std::string& filename)
+    {
+        megamol::core::utility::MappedFile file;
+
+        if (!file.Open(vislib::TString(filename.c_str())))
+        {
+            throw std::runtime_error("Unable to map vector field file '" + filename + "' into memory");
+        }
+
+        const auto file_size = static_cast<std::size_t>(file.Size());
+
+        struct header_t
+        {
+            unsigned int dimension, components;
+
+            unsigned int x_num;
+            float x_min, x_max;
+            unsigned int y_num;
+            float y_min, y_max;
+        } header;
+
+        if (file_size < sizeof(header_t))
+        {
+            throw std::runtime_error("Vector field file is too small '" + filename + "'");
+        }
+
+        std::memcpy(&header, file.Data(), sizeof(header_t));
+
+        const std::size_t num = static_cast<std::size_t>(header.x_num) * header.y_num;
+
+        if (header.dimension != 2 || header.components != 2 || header.x_num < 2 || header.y_num < 2
+            || file_size < sizeof(header_t) + num * 2 * sizeof(float))
+        {
+            throw std::runtime_error("Invalid vector field file '" + filename + "'");
+        }
+
+        vector_field_t field;
+        field.name = name;
+        field.resolution = { header.x_num, header.y_num };
+        field.domain = { header.x_min, header.y_min, header.x_max, header.y_max };
+
+        field.vectors.resize(num * 2);
+        std::memcpy(field.vectors.data(), file.Data() + sizeof(header_t), num * 2 * sizeof(float));
+
+        return field;
+    }
+
+    /**
+    * Load convergence points, stored as one comma-separated coordinate pair per line
+    *
+    * @param filename   Path to the file
+    * @param points     Output points
+    * @param point_ids  Output IDs of the points
+    *
+    * @return True if the file exists
+    */
+    bool load_points(const std::string& filename, std::vector<float>& points, std::vector<int>& point_ids)
+    {
+        std::ifstream file(filename);
+
+        if (!file.good())
+        {
+            return false;
+        }
+
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            const auto separator = line.find(',');
+
+            if (line.empty() || line.find('#') != std::string::npos || separator == std::string::npos)
+            {
+                continue;
+            }
+
+            points.push_back(std::stof(line.substr(0, separator)));
+            points.push_back(std::stof(line.substr(separator + 1)));
+
+            point_ids.push_back(static_cast<int>(point_ids.size()));
+        }
+
+        return true;
+    }
+
+    /**
+    * Resample vector field to a different resolution using bilinear interpolation
+    *
+    * @param original   Original vector field
+    * @param resolution Number of vectors per direction of the resampled field
+    *
+    * @return Resampled vector field, including the positions of its vectors
+    */
+    vector_field_t resample(const vector_field_t& original, const unsigned int resolution)
+    {
+        vector_field_t field;
+        field.name = original.name;
+        field.resolution = { resolution, resolution };
+        field.domain = original.domain;
+
+        const std::size_t num = static_cast<std::size_t>(resolution) * resolution;
+
+        field.positions.resize(num * 2);
+        field.vectors.resize(num * 2);
+
+        const float x_step = (field.domain[2] - field.domain[0]) / (resolution - 1);
+        const float y_step = (field.domain[3] - field.domain[1]) / (resolution - 1);
+
+        #pragma omp parallel for
+        for (long long y = 0; y < static_cast<long long>(resolution); ++y)
+        {
+            for (unsigned int x = 0; x < resolution; ++x)
+            {
+                const std::size_t xy = y * resolution + x;
+
+                // Position in the original grid
+                const float original_x = static_cast<float>(x) / (resolution - 1) * (original.resolution[0] - 1);
+                const float original_y = static_cast<float>(y) / (resolution - 1) * (original.resolution[1] - 1);
+
+                const auto left = std::min(static_cast<unsigned int>(original_x), original.resolution[0] - 2);
+                const auto bottom = std::min(static_cast<unsigned int>(original_y), original.resolution[1] - 2);
+
+                const float alpha = original_x - left;
+                const float beta = original_y - bottom;
+
+                const auto index = [&original](const unsigned int i, const unsigned int j) { return 2 * (static_cast<std::size_t>(j) * original.resolution[0] + i); };
+
+                for (std::size_t c = 0; c < 2; ++c)
+                {
+                    field.vectors[xy * 2 + c] =
+                        (1.0f - beta) * ((1.0f - alpha) * original.vectors[index(left, bottom) + c] + alpha * original.vectors[index(left + 1, bottom) + c]) +
+                        beta * ((1.0f - alpha) * original.vectors[index(left, bottom + 1) + c] + alpha * original.vectors[index(left + 1, bottom + 1) + c]);
+                }
+
+                field.positions[xy * 2 + 0] = field.domain[0] + x * x_step;
+                field.positions[xy * 2 + 1] = field.domain[1] + y * y_step;
+            }
+        }
+
+        return field;
+    }
+
+    /**
+    * Measure the run time of a function
+    *
+    * @param repetitions    Number of repetitions
+    * @param prepare        Function called before each measurement, which is not measured
+    * @param function       Function to measure
+    *
+    * @return Run times in milliseconds
+    */
+    template <typename prepare_t, typename function_t>
+    std::vector<double> measure(const unsigned int repetitions, prepare_t prepare, function_t function)
+    {
+        std::vector<double> durations;
+        durations.reserve(repetitions);
+
+        for (unsigned int repetition = 0; repetition < repetitions; ++repetition)
+        {
+            prepare();
+
+            const auto start = benchmark_clock::now();
+
+            function();
+
+            durations.push_back(telemetry::milliseconds(benchmark_clock::now() - start));
+        }
+
+        return durations;
+    }
+
+    template <typename function_t>
+    std::vector<double> measure(const unsigned int repetitions, function_t function)
+    {
+        return measure(repetitions, []() {}, function);
+    }
+
+    /**
+    * Record statistics of measured run times
+    *
+    * @param output     Output
+    * @param benchmark  Name of the benchmark
+    * @param field      Vector field used
+    * @param durations  Run times in milliseconds
+    * @param work       Amount of work per run, used to compute the throughput
+    * @param work_unit  Unit of the work
+    *
+    * @return Event for adding further values
+    */
+    telemetry::event record_measurements(telemetry& output, const std::string& benchmark, const vector_field_t& field,
+        std::vector<double> durations, const double work, const std::string& work_unit)
+    {
+        std::sort(durations.begin(), durations.end());
+
+        const auto median = durations.size() % 2 == 1 ? durations[durations.size() / 2]
+            : 0.5 * (durations[durations.size() / 2 - 1] + durations[durations.size() / 2]);
+
+        auto event = output.record("benchmark");
+
+        event.add("benchmark", benchmark)
+            .add("data_set", field.name)
+            .add("resolution", field.resolution[0])
+            .add("repetitions", durations.size())
+            .add("min_ms", durations.front())
+            .add("median_ms", median)
+            .add("mean_ms", std::accumulate(durations.begin(), durations.end(), 0.0) / durations.size())
+            .add("max_ms", durations.back())
+            .add("work", work)
+            .add("work_unit", work_unit)
+            .add("throughput_per_second", median > 0.0 ? work / (median / 1000.0) : 0.0);
+
+        return event;
+    }
+
+    /**
+    * Create grid for the integrators from the vector field
+    *
+    * @param field      Vector field
+    *
+    * @return Grid
+    */
+    tpf::data::grid<float, float, 2, 2> create_grid(const vector_field_t& field)
+    {
+        tpf::data::extent_t extent;
+        extent.push_back(std::make_pair(0ull, static_cast<std::size_t>(field.resolution[0] - 1)));
+        extent.push_back(std::make_pair(0ull, static_cast<std::size_t>(field.resolution[1] - 1)));
+
+        const Eigen::Vector2f origin(field.domain[0], field.domain[1]);
+        const Eigen::Vector2f cell_size((field.domain[2] - field.domain[0]) / (field.resolution[0] - 1),
+            (field.domain[3] - field.domain[1]) / (field.resolution[1] - 1));
+
+        tpf::data::grid_information<float>::array_type cell_coordinates(2), node_coordinates(2), cell_sizes(2);
+
+        for (std::size_t dimension = 0; dimension < 2; ++dimension)
+        {
+            cell_coordinates[dimension].resize(field.resolution[dimension]);
+            node_coordinates[dimension].resize(static_cast<std::size_t>(field.resolution[dimension]) + 1);
+            cell_sizes[dimension].resize(field.resolution[dimension]);
+
+            for (std::size_t element = 0; element < field.resolution[dimension]; ++element)
+            {
+                cell_sizes[dimension][element] = cell_size[dimension];
+                cell_coordinates[dimension][element] = origin[dimension] + element * cell_size[dimension];
+                node_coordinates[dimension][element] = origin[dimension] + (element - 0.5f) * cell_size[dimension];
+            }
+
+            node_coordinates[dimension][field.resolution[dimension]] =
+                origin[dimension] + (field.resolution[dimension] - 0.5f) * cell_size[dimension];
+        }
+
+        return tpf::data::grid<float, float, 2, 2>("vector_field", extent, field.vectors, std::move(cell_coordinates),
+            std::move(node_coordinates), std::move(cell_sizes));
+    }
+
+    /**
+    * Benchmark the integrators in flowvis/integrator.h, advecting a particle from each grid node
+    */
+    void benchmark_integrators(telemetry& output, const settings_t& settings, const vector_field_t& field)
+    {
+        const auto vector_field = create_grid(field);
+
+        const long long num_particles = static_cast<long long>(field.positions.size() / 2);
+
+        for (const auto method : { streamlines_cuda::integration_method::RUNGE_KUTTA_4, streamlines_cuda::integration_method::RUNGE_KUTTA_4_5 })
+        {
+            long long num_steps_performed = 0;
+
+            const auto durations = measure(settings.repetitions, [&]()
+            {
+                long long num_steps = 0;
+
+                #pragma omp parallel for schedule(dynamic, 64) reduction(+ : num_steps)
+                for (long long i = 0; i < num_particles; ++i)
+                {
+                    Eigen::Vector2f point(field.positions[i * 2 + 0], field.positions[i * 2 + 1]);
+                    float timestep = 0.01f;
+
+                    try
+                    {
+                        for (unsigned int step = 0; step < settings.num_integration_steps; ++step)
+                        {
+                            if (method == streamlines_cuda::integration_method::RUNGE_KUTTA_4)
+                            {
+                                advect_point_rk4<2>(vector_field, point, timestep, true);
+                            }
+                            else
+                            {
+                                advect_point_rk45<2>(vector_field, point, timestep, 0.000001f, true);
+                            }
+
+                            ++num_steps;
+                        }
+                    }
+                    catch (const std::exception&)
+                    {
+                        // Particle left the domain
+                    }
+                }
+
+                num_steps_performed = num_steps;
+            });
+
+            record_measurements(output, method == streamlines_cuda::integration_method::RUNGE_KUTTA_4 ? "integrator_rk4" : "integrator_rk45",
+                field, durations, static_cast<double>(num_steps_performed), "particle_steps")
+                .add("num_particles", num_particles);
+        }
+    }
+
+    /**
+    * Benchmark the stream line integration used for the implicit topology
+    */
+    void benchmark_streamlines(telemetry& output, const settings_t& settings, const vector_field_t& field)
+    {
+        const std::vector<float> lines;
+        const std::vector<int> line_ids;
+
+        const streamlines_cpu streamlines(field.resolution, field.domain, field.vectors, field.points, field.point_ids,
+            lines, line_ids, 0.01f, 0.000001f, streamlines_cuda::integration_method::RUNGE_KUTTA_4_5);
+
+        const std::size_t num_particles = field.positions.size() / 2;
+
+        std::vector<float> positions, labels, distances, terminations;
+
+        const auto durations = measure(settings.repetitions, [&]()
+        {
+            positions = field.positions;
+            labels.assign(num_particles, -1.0f);
+            distances.assign(num_particles, std::numeric_limits<float>::max());
+            terminations.assign(num_particles, 0.0f);
+        }, [&]()
+        {
+            streamlines.update_labels(positions, labels, distances, terminations, static_cast<int>(settings.num_integration_steps), 1.0f, 10000);
+        });
+
+        record_measurements(output, "streamlines_cpu", field, durations,
+            static_cast<double>(num_particles) * settings.num_integration_steps, "particle_steps")
+            .add("num_particles", num_particles)
+            .add("num_terminated", static_cast<std::size_t>(std::count_if(terminations.begin(), terminations.end(), [](float t) { return t != 0.0f; })));
+    }
+
+    /**
+    * Benchmark extraction of critical points
+    */
+    void benchmark_critical_points(telemetry& output, const settings_t& settings, const vector_field_t& field)
+    {
+        std::vector<std::pair<critical_points::type, Eigen::Vector2f>> extracted;
+        bool has_unhandled_case = false;
+
+        const auto durations = measure(settings.repetitions, [&]()
+        {
+            extracted = critical_points::extract_critical_points(field.resolution, field.positions, field.vectors, 0, has_unhandled_case);
+        });
+
+        record_measurements(output, "critical_points", field, durations,
+            static_cast<double>(field.resolution[0] - 1) * (field.resolution[1] - 1), "cells")
+            .add("num_critical_points", extracted.size())
+            .add("has_unhandled_case", has_unhandled_case);
+    }
+
+    /**
+    * Benchmark insertion into the triangulation, and its full and incremental export
+    */
+    void benchmark_triangulation(telemetry& output, const settings_t& settings, const vector_field_t& field)
+    {
+        // Refinement points in the cell centers
+        std::vector<triangulation::point_t> refinement_points;
+        refinement_points.reserve(static_cast<std::size_t>(field.resolution[0] - 1) * (field.resolution[1] - 1));
+
+        for (unsigned int y = 0; y < field.resolution[1] - 1; ++y)
+        {
+            for (unsigned int x = 0; x < field.resolution[0] - 1; ++x)
+            {
+                const std::size_t xy = static_cast<std::size_t>(y) * field.resolution[0] + x;
+
+                refinement_points.push_back(triangulation::point_t(
+                    field.positions[xy * 2 + 0] + 0.5f * (field.positions[2] - field.positions[0]),
+                    field.positions[xy * 2 + 1] + 0.5f * (field.positions[field.resolution[0] * 2 + 1] - field.positions[1])));
+            }
+        }
+
+        std::vector<double> durations_insert, durations_export, durations_insert_refined, durations_export_incremental;
+        std::size_t num_cells = 0, num_changed_cells = 0;
+
+        for (unsigned int repetition = 0; repetition < settings.repetitions; ++repetition)
+        {
+            auto start = benchmark_clock::now();
+            triangulation delaunay(field.positions);
+            durations_insert.push_back(telemetry::milliseconds(benchmark_clock::now() - start));
+
+            start = benchmark_clock::now();
+            num_cells = delaunay.export_grid().indices->size() / 3;
+            durations_export.push_back(telemetry::milliseconds(benchmark_clock::now() - start));
+
+            start = benchmark_clock::now();
+            delaunay.insert_points(refinement_points);
+            durations_insert_refined.push_back(telemetry::milliseconds(benchmark_clock::now() - start));
+
+            start = benchmark_clock::now();
+            num_changed_cells = delaunay.export_grid().changed_cells->size();
+            durations_export_incremental.push_back(telemetry::milliseconds(benchmark_clock::now() - start));
+        }
+
+        const auto num_points = static_cast<double>(field.positions.size() / 2);
+
+        record_measurements(output, "triangulation_insert", field, durations_insert, num_points, "points");
+        record_measurements(output, "triangulation_export", field, durations_export, static_cast<double>(num_cells), "cells");
+        record_measurements(output, "triangulation_insert_refined", field, durations_insert_refined,
+            static_cast<double>(refinement_points.size()), "points");
+        record_measurements(output, "triangulation_export_incremental", field, durations_export_incremental,
+            static_cast<double>(num_changed_cells), "changed_cells");
+    }
+
+    /**
+    * Benchmark the implicit topology computation, including grid refinement, and writing and reading its results
+    */
+    void benchmark_implicit_topology(telemetry& output, const settings_t& settings, const vector_field_t& field)
+    {
+        std::ostream null_stream(nullptr);
+        std::ostringstream computation_telemetry;
+
+        const float cell_size = std::min((field.domain[2] - field.domain[0]) / (field.resolution[0] - 1),
+            (field.domain[3] - field.domain[1]) / (field.resolution[1] - 1));
+
+        // Run computation
+        implicit_topology_results result;
+
+        const auto start = benchmark_clock::now();
+
+        {
+            implicit_topology_computation computation(settings.verbose ? std::cerr : null_stream, null_stream, computation_telemetry,
+                field.resolution, field.domain, field.positions, field.vectors, field.points, field.point_ids,
+                std::vector<float>(), std::vector<int>(), 0.01f, 0.000001f, streamlines_cuda::integration_method::RUNGE_KUTTA_4_5);
+
+            implicit_topology_computation::run_control_t run_control;
+            run_control.checkpoint_cycles = 0;
+            run_control.checkpoint_interval = std::chrono::seconds(0);
+            run_control.time_budget = std::chrono::seconds(0);
+
+            computation.start(settings.num_topology_integration_steps, settings.refinement_factor * cell_size, true,
+                cell_size, 10000, settings.num_topology_integration_steps, implicit_topology_computation::backend_t::CPU, run_control);
+
+            do
+            {
+                result = computation.get_results().get();
+            } while (!result.computation_state.finished);
+        }
+
+        const auto duration = telemetry::milliseconds(benchmark_clock::now() - start);
+
+        output.record("benchmark")
+            .add("benchmark", "implicit_topology")
+            .add("data_set", field.name)
+            .add("resolution", field.resolution[0])
+            .add("total_ms", duration)
+            .add("num_points", result.vertices->size() / 2)
+            .add("num_cells", result.indices->size() / 3);
+
+        // Forward the detailed measurements of the computation, e.g., for each grid refinement
+        std::istringstream telemetry_lines(computation_telemetry.str());
+        std::string line;
+
+        while (std::getline(telemetry_lines, line))
+        {
+            output.record("implicit_topology_telemetry")
+                .add("data_set", field.name)
+                .add("resolution", field.resolution[0])
+                .add_json("telemetry", line);
+        }
+
+        // Write and read results
+        for (const auto compression : { implicit_topology_file::compression_t::none, implicit_topology_file::compression_t::shuffle_deflate })
+        {
+            const std::string compression_name = compression == implicit_topology_file::compression_t::none ? "none" : "shuffle_deflate";
+
+            const auto durations_write = measure(settings.repetitions, [&]()
+            {
+                implicit_topology_file::write(settings.temporary_path, result, compression);
+            });
+
+            const auto file_size = static_cast<double>(std::ifstream(settings.temporary_path, std::ios_base::binary | std::ios_base::ate).tellg());
+
+            const auto durations_read = measure(settings.repetitions, [&]()
+            {
+                implicit_topology_results read_result;
+                implicit_topology_file::read(settings.temporary_path, read_result);
+            });
+
+            record_measurements(output, "result_write", field, durations_write, file_size, "bytes").add("compression", compression_name);
+            record_measurements(output, "result_read", field, durations_read, file_size, "bytes").add("compression", compression_name);
+        }
+
+        std::remove(settings.temporary_path.c_str());
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    settings_t settings;
+
+    try
+    {
+        settings = parse_arguments(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl << std::endl;
+        print_usage(argv[0]);
+
+        return 1;
+    }
+
+    std::ofstream output_file;
+
+    if (!settings.output_path.empty())
+    {
+        output_file.open(settings.output_path);
+
+        if (!output_file.good())
+        {
+            std::cerr << "Unable to open output file '" << settings.output_path << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    telemetry output(settings.output_path.empty() ? std::cout : output_file);
+
+#ifdef _OPENMP
+    const int num_threads = omp_get_max_threads();
+#else
+    const int num_threads = 1;
+#endif
+
+    output.record("configuration")
+        .add("data_path", settings.data_path)
+        .add("repetitions", settings.repetitions)
+        .add("num_integration_steps", settings.num_integration_steps)
+        .add("num_topology_integration_steps", settings.num_topology_integration_steps)
+        .add("refinement_factor", static_cast<double>(settings.refinement_factor))
+        .add("num_threads", num_threads);
+
+    try
+    {
+        for (const auto& data_set : settings.data_sets)
+        {
+            const std::string data_set_path = settings.data_path + "/" + data_set;
+
+            const auto original = load_vector_field(data_set, data_set_path + "/vector_field");
+
+            for (const auto resolution : settings.resolutions)
+            {
+                auto field = resample(original, resolution);
+
+                // Use the stored sinks and sources as convergence structures, or the critical points otherwise
+                if (!load_points(data_set_path + "/sinks_and_sources", field.points, field.point_ids))
+                {
+                    bool has_unhandled_case;
+
+                    for (const auto& critical_point : critical_points::extract_critical_points(field.resolution, field.positions, field.vectors, 0, has_unhandled_case))
+                    {
+                        field.points.push_back(critical_point.second[0]);
+                        field.points.push_back(critical_point.second[1]);
+                        field.point_ids.push_back(static_cast<int>(critical_point.first));
+                    }
+                }
+
+                benchmark_integrators(output, settings, field);
+                benchmark_streamlines(output, settings, field);
+                benchmark_critical_points(output, settings, field);
+                benchmark_triangulation(output, settings, field);
+
+                if (!settings.skip_implicit_topology)
+                {
+                    benchmark_implicit_topology(output, settings, field);
+                }
+
+                output.record("peak_memory")
+                    .add("data_set", field.name)
+                    .add("resolution", resolution)
+                    .add("peak_memory_bytes", telemetry::peak_memory());
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+
+        return 1;
+    }
+
+    return 0;
+}
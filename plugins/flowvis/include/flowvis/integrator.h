@@ -10,9 +10,101 @@
 
 #include "tpf/data/tpf_grid.h"
 
+#include <array>
+#include <cstddef>
+#include <vector>
+
 namespace megamol {
 namespace flowvis {
 
+/**
+ * Two-dimensional vector field on a uniform grid, whose vectors are located at the grid nodes
+ */
+struct uniform_vector_field_2d {
+    /** Number of vectors per direction */
+    std::array<unsigned int, 2> resolution;
+
+    /** Position of the first vector */
+    std::array<float, 2> origin;
+
+    /** Distance between neighboring vectors per direction */
+    std::array<float, 2> cell_size;
+
+    /** Vectors, stored interleaved (x, y) and row by row; not owned */
+    const float* vectors;
+};
+
+/**
+ * Particles stored as struct of arrays for batched advection
+ */
+struct particle_batch {
+    /** Particle positions */
+    std::vector<float> x;
+    std::vector<float> y;
+
+    /** (Adaptive) time step per particle */
+    std::vector<float> delta;
+
+    /** Particles are only advected while active, and are deactivated when leaving the domain */
+    std::vector<unsigned char> active;
+
+    /**
+     * Resize all arrays
+     *
+     * @param num_particles Number of particles
+     */
+    void resize(std::size_t num_particles) {
+        this->x.resize(num_particles);
+        this->y.resize(num_particles);
+        this->delta.resize(num_particles);
+        this->active.resize(num_particles);
+    }
+
+    /**
+     * Get number of particles
+     *
+     * @return Number of particles
+     */
+    std::size_t size() const { return this->x.size(); }
+};
+
+/**
+ * Create uniform vector field description from the positions and vectors as provided by the vector field call
+ *
+ * @param resolution Number of vectors per direction
+ * @param positions Positions of the vectors
+ * @param vectors Vectors, which have to outlive the returned description
+ *
+ * @return Vector field description
+ */
+uniform_vector_field_2d make_uniform_vector_field(const std::array<unsigned int, 2>& resolution,
+    const std::vector<float>& positions, const std::vector<float>& vectors);
+
+/**
+ * Runge-Kutta 4 for fixed step size, advecting all active particles of the batch at once.
+ * Particles leaving the domain spanned by the vector positions are deactivated and not moved.
+ *
+ * @param vector_field Vector field
+ * @param particles Particles to advect (will be modified)
+ * @param forward Forward integration if true, reverse integration otherwise
+ * @param parallel Distribute the particles among threads; disable when called from within a parallel region
+ */
+void advect_points_rk4(
+    const uniform_vector_field_2d& vector_field, particle_batch& particles, bool forward, bool parallel = true);
+
+/**
+ * Runge-Kutta-Fehlberg 4-5 for dynamic step size, advecting all active particles of the batch at once.
+ * Particles leaving the domain spanned by the vector positions are deactivated.
+ *
+ * @param vector_field Vector field
+ * @param particles Particles to advect, with their initial time steps; returns the adapted time steps
+ * @param max_error Maximum allowed error, exceeding leads to time step adaption
+ * @param forward Forward integration if true, reverse integration otherwise
+ * @param parallel Distribute the particles among threads; disable when called from within a parallel region
+ */
+void advect_points_rk45(const uniform_vector_field_2d& vector_field, particle_batch& particles, float max_error,
+    bool forward, bool parallel = true);
+
 /**
  * Runge-Kutta 4 for fixed step size
  *
@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "aabb_grid.h"
+
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+/**
+ * Check that the box is neither empty nor contains NaN or infinity
+ */
+bool is_valid(const megamol::flowvis::aabb_grid::box_t& box) {
+    return box.min().allFinite() && box.max().allFinite() && !box.isEmpty();
+}
+
+} // namespace
+
+namespace megamol {
+namespace flowvis {
+
+void aabb_grid::build(const std::vector<box_t>& boxes) {
+    this->boxes = boxes;
+
+    this->stamps.assign(boxes.size(), 0);
+    this->current_stamp = 0;
+
+    this->resolution = {0, 0, 0};
+
+    if (boxes.empty()) {
+        return;
+    }
+
+    // Compute grid extent and use the average box size as cell size
+    box_t extent;
+    Eigen::Vector3f average_size = Eigen::Vector3f::Zero();
+
+    std::size_t num_valid_boxes = 0;
+
+    for (const auto& box : boxes) {
+        if (is_valid(box)) {
+            extent.extend(box);
+            average_size += box.sizes();
+            ++num_valid_boxes;
+        }
+    }
+
+    if (num_valid_boxes == 0) {
+        this->boxes.clear();
+        return;
+    }
+
+    average_size /= static_cast<float>(num_valid_boxes);
+
+    const auto max_cells = 8 * boxes.size();
+
+    std::size_t num_cells = 1;
+
+    for (int dimension = 0; dimension < 3; ++dimension) {
+        const auto size = extent.sizes()[dimension];
+
+        if (size > 0.0f && average_size[dimension] > 0.0f) {
+            this->resolution[dimension] = static_cast<int>(std::min(static_cast<float>(max_cells),
+                std::max(1.0f, std::ceil(size / average_size[dimension]))));
+        } else {
+            this->resolution[dimension] = 1;
+        }
+
+        num_cells *= this->resolution[dimension];
+    }
+
+    // Limit the total number of cells in relation to the number of boxes
+    while (num_cells > max_cells) {
+        num_cells = 1;
+
+        for (int dimension = 0; dimension < 3; ++dimension) {
+            this->resolution[dimension] = std::max(1, this->resolution[dimension] / 2);
+            num_cells *= this->resolution[dimension];
+        }
+    }
+
+    this->origin = extent.min();
+
+    for (int dimension = 0; dimension < 3; ++dimension) {
+        const auto size = extent.sizes()[dimension];
+
+        this->inv_cell_size[dimension] = size > 0.0f ? this->resolution[dimension] / size : 0.0f;
+    }
+
+    // Count boxes per cell, and store their indices in cell order
+    this->cell_offsets.assign(num_cells + 1, 0);
+
+    std::array<int, 3> min_cell, max_cell;
+
+    for (std::size_t box_index = 0; box_index < boxes.size(); ++box_index) {
+        if (!is_valid(boxes[box_index]) || !get_cell_range(boxes[box_index], min_cell, max_cell)) {
+            continue;
+        }
+
+        for (int z = min_cell[2]; z <= max_cell[2]; ++z) {
+            for (int y = min_cell[1]; y <= max_cell[1]; ++y) {
+                for (int x = min_cell[0]; x <= max_cell[0]; ++x) {
+                    ++this->cell_offsets[(z * this->resolution[1] + y) * this->resolution[0] + x + 1];
+                }
+            }
+        }
+    }
+
+    for (std::size_t cell_index = 0; cell_index < num_cells; ++cell_index) {
+        this->cell_offsets[cell_index + 1] += this->cell_offsets[cell_index];
+    }
+
+    this->cell_entries.resize(this->cell_offsets.back());
+
+    std::vector<std::size_t> fill(this->cell_offsets.begin(), this->cell_offsets.end() - 1);
+
+    for (std::size_t box_index = 0; box_index < boxes.size(); ++box_index) {
+        if (!is_valid(boxes[box_index]) || !get_cell_range(boxes[box_index], min_cell, max_cell)) {
+            continue;
+        }
+
+        for (int z = min_cell[2]; z <= max_cell[2]; ++z) {
+            for (int y = min_cell[1]; y <= max_cell[1]; ++y) {
+                for (int x = min_cell[0]; x <= max_cell[0]; ++x) {
+                    this->cell_entries[fill[(z * this->resolution[1] + y) * this->resolution[0] + x]++] = box_index;
+                }
+            }
+        }
+    }
+}
+
+void aabb_grid::query(const box_t& box, std::vector<std::size_t>& candidates) {
+    candidates.clear();
+
+    std::array<int, 3> min_cell, max_cell;
+
+    if (this->boxes.empty() || !get_cell_range(box, min_cell, max_cell)) {
+        return;
+    }
+
+    ++this->current_stamp;
+
+    for (int z = min_cell[2]; z <= max_cell[2]; ++z) {
+        for (int y = min_cell[1]; y <= max_cell[1]; ++y) {
+            for (int x = min_cell[0]; x <= max_cell[0]; ++x) {
+                const auto cell_index = (z * this->resolution[1] + y) * this->resolution[0] + x;
+
+                for (auto entry = this->cell_offsets[cell_index]; entry < this->cell_offsets[cell_index + 1]; ++entry) {
+                    const auto box_index = this->cell_entries[entry];
+
+                    if (this->stamps[box_index] != this->current_stamp) {
+                        this->stamps[box_index] = this->current_stamp;
+
+                        if (this->boxes[box_index].intersects(box)) {
+                            candidates.push_back(box_index);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+}
+
+bool aabb_grid::get_cell_range(
+    const box_t& box, std::array<int, 3>& min_cell, std::array<int, 3>& max_cell) const {
+
+    for (int dimension = 0; dimension < 3; ++dimension) {
+        const auto min = (box.min()[dimension] - this->origin[dimension]) * this->inv_cell_size[dimension];
+        const auto max = (box.max()[dimension] - this->origin[dimension]) * this->inv_cell_size[dimension];
+
+        // Comparisons with NaN are false, rendering those boxes outside
+        if (!(max >= 0.0f && min <= static_cast<float>(this->resolution[dimension]))) {
+            return false;
+        }
+
+        const auto last_cell = static_cast<float>(this->resolution[dimension] - 1);
+
+        min_cell[dimension] = static_cast<int>(std::min(std::max(std::floor(min), 0.0f), last_cell));
+        max_cell[dimension] = static_cast<int>(std::min(std::max(std::floor(max), 0.0f), last_cell));
+    }
+
+    return true;
+}
+
+} // namespace flowvis
+} // namespace megamol
@@ -0,0 +1,74 @@
+/*
+ * aabb_grid.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include "Eigen/Dense"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace megamol {
+namespace flowvis {
+
+/**
+ * Uniform grid storing axis-aligned bounding boxes for finding candidates of overlap.
+ * The cell size is chosen according to the average box size, such that each box covers only few cells.
+ * Memory is kept when rebuilding, making it cheap to rebuild the grid for slightly changing boxes.
+ *
+ * @author Alexander Straub
+ */
+class aabb_grid {
+public:
+    using box_t = Eigen::AlignedBox3f;
+
+    /**
+     * (Re)build grid for the given boxes
+     *
+     * @param boxes Bounding boxes, identified by their index
+     */
+    void build(const std::vector<box_t>& boxes);
+
+    /**
+     * Find all boxes which overlap the given box, including those only touching it
+     *
+     * @param box Query box
+     * @param candidates Indices of the overlapping boxes in ascending order (will be overwritten)
+     */
+    void query(const box_t& box, std::vector<std::size_t>& candidates);
+
+private:
+    /**
+     * Get range of cells covered by the box, clamped to the grid
+     *
+     * @param box Box
+     * @param min_cell First cell per direction
+     * @param max_cell Last cell per direction
+     *
+     * @return False if the box does not overlap the grid
+     */
+    bool get_cell_range(const box_t& box, std::array<int, 3>& min_cell, std::array<int, 3>& max_cell) const;
+
+    /** Boxes stored in the grid */
+    std::vector<box_t> boxes;
+
+    /** Grid definition */
+    Eigen::Vector3f origin;
+    Eigen::Vector3f inv_cell_size;
+    std::array<int, 3> resolution;
+
+    /** Box indices per cell, stored consecutively with offsets per cell */
+    std::vector<std::size_t> cell_offsets;
+    std::vector<std::size_t> cell_entries;
+
+    /** Query stamps for reporting boxes covering multiple cells only once */
+    std::vector<std::size_t> stamps;
+    std::size_t current_stamp = 0;
+};
+
+} // namespace flowvis
+} // namespace megamol
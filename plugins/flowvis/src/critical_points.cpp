@@ -13,7 +13,11 @@
 
 #include "Eigen/Dense"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace megamol
 {
@@ -79,38 +83,12 @@ namespace megamol
 
                     const unsigned int boundary_layer = static_cast<unsigned int>(this->boundary.Param<core::param::IntParam>()->Value());
 
-                    for (unsigned int y = boundary_layer; y < get_vector_field->get_resolution()[1] - 1 - boundary_layer; ++y)
-                    {
-                        for (unsigned int x = boundary_layer; x < get_vector_field->get_resolution()[0] - 1 - boundary_layer; ++x)
-                        {
-                            const auto index_bottom_left = x + y * get_vector_field->get_resolution()[0];
-                            const auto index_bottom_right = x + 1 + y * get_vector_field->get_resolution()[0];
-                            const auto index_top_left = x + (y + 1) * get_vector_field->get_resolution()[0];
-                            const auto index_top_right = x + 1 + (y + 1) * get_vector_field->get_resolution()[0];
-
-                            const cell_t cell = {
-                                Eigen::Vector2f(vectors[index_bottom_left * 2 + 0], vectors[index_bottom_left * 2 + 1]),
-                                Eigen::Vector2f(vectors[index_bottom_right * 2 + 0], vectors[index_bottom_right * 2 + 1]),
-                                Eigen::Vector2f(vectors[index_top_left * 2 + 0], vectors[index_top_left * 2 + 1]),
-                                Eigen::Vector2f(vectors[index_top_right * 2 + 0], vectors[index_top_right * 2 + 1]),
-                                Eigen::Vector2f(positions[index_bottom_left * 2 + 0], positions[index_bottom_left * 2 + 1]),
-                                Eigen::Vector2f(positions[index_top_right * 2 + 0], positions[index_top_right * 2 + 1])
-                            };
-
-                            const auto critical_point = extract_critical_point(cell);
-
-                            if (critical_point.first != type::NONE && critical_point.first != type::UNHANDLED)
-                            {
-                                this->glyph_output.push_back(critical_point);
+                    this->glyph_output = extract_critical_points(get_vector_field->get_resolution(), positions, vectors, boundary_layer, has_unhandled_case);
 
-                                this->glyph_hash = static_cast<SIZE_T>(core::utility::DataHash(this->glyph_hash,
-                                    critical_point.first, critical_point.second[0], critical_point.second[1]));
-                            }
-                            else if (critical_point.first == type::UNHANDLED)
-                            {
-                                has_unhandled_case = true;
-                            }
-                        }
+                    for (const auto& critical_point : this->glyph_output)
+                    {
+                        this->glyph_hash = static_cast<SIZE_T>(core::utility::DataHash(this->glyph_hash,
+                            critical_point.first, critical_point.second[0], critical_point.second[1]));
                     }
 
                     if (has_unhandled_case)
@@ -143,7 +121,140 @@ namespace megamol
             return get_vector_field != nullptr && (*get_vector_field)(1);
         }
 
-        std::pair<critical_points::type, Eigen::Vector2f> critical_points::extract_critical_point(const cell_t& cell) const
+        std::vector<std::pair<critical_points::type, Eigen::Vector2f>> critical_points::extract_critical_points(const std::array<unsigned int, 2>& resolution,
+            const std::vector<float>& positions, const std::vector<float>& vectors, const unsigned int boundary_layer, bool& has_unhandled_case)
+        {
+            has_unhandled_case = false;
+
+            if (resolution[0] < 2 + 2 * boundary_layer || resolution[1] < 2 + 2 * boundary_layer)
+            {
+                return std::vector<std::pair<type, Eigen::Vector2f>>();
+            }
+
+            // Process tiles of rows in parallel, each storing its own results to retain the order of the serial scan
+            const unsigned int x_begin = boundary_layer;
+            const unsigned int x_end = resolution[0] - 1 - boundary_layer;
+            const unsigned int y_begin = boundary_layer;
+            const unsigned int y_end = resolution[1] - 1 - boundary_layer;
+
+            const unsigned int tile_rows = 16;
+            const unsigned int num_tiles = (y_end - y_begin + tile_rows - 1) / tile_rows;
+
+            std::vector<std::vector<std::pair<type, Eigen::Vector2f>>> tile_extracted(num_tiles);
+            std::vector<unsigned char> tile_has_unhandled_case(num_tiles, 0);
+
+            #pragma omp parallel for schedule(dynamic)
+            for (long long tile = 0; tile < static_cast<long long>(num_tiles); ++tile)
+            {
+                auto& extracted = tile_extracted[tile];
+                bool unhandled = false;
+
+                // Marching squares index of the x-component, and flag for a sign change of the y-component
+                std::vector<unsigned char> cell_signs(x_end - x_begin);
+                const unsigned char y_sign_change = 16;
+
+                const unsigned int tile_begin = y_begin + static_cast<unsigned int>(tile) * tile_rows;
+                const unsigned int tile_end = std::min(tile_begin + tile_rows, y_end);
+
+                for (unsigned int y = tile_begin; y < tile_end; ++y)
+                {
+                    // Cheap prefilter on the signs at the cell corners, vectorized over the row
+                    const float* bottom_row = vectors.data() + 2 * static_cast<std::size_t>(y) * resolution[0];
+                    const float* top_row = bottom_row + 2 * static_cast<std::size_t>(resolution[0]);
+                    unsigned char* signs = cell_signs.data();
+
+                    #pragma omp simd
+                    for (int x = static_cast<int>(x_begin); x < static_cast<int>(x_end); ++x)
+                    {
+                        const float bottom_left[2] = { bottom_row[2 * x + 0], bottom_row[2 * x + 1] };
+                        const float bottom_right[2] = { bottom_row[2 * x + 2], bottom_row[2 * x + 3] };
+                        const float top_left[2] = { top_row[2 * x + 0], top_row[2 * x + 1] };
+                        const float top_right[2] = { top_row[2 * x + 2], top_row[2 * x + 3] };
+
+                        const int marching_squares_index = (bottom_left[0] < 0.0f ? 1 : 0) + (bottom_right[0] < 0.0f ? 2 : 0)
+                            + (top_right[0] < 0.0f ? 4 : 0) + (top_left[0] < 0.0f ? 8 : 0);
+
+                        const bool all_positive = bottom_left[1] > 0.0f && bottom_right[1] > 0.0f && top_left[1] > 0.0f && top_right[1] > 0.0f;
+                        const bool all_negative = bottom_left[1] < 0.0f && bottom_right[1] < 0.0f && top_left[1] < 0.0f && top_right[1] < 0.0f;
+
+                        signs[x - x_begin] = static_cast<unsigned char>(marching_squares_index + ((all_positive || all_negative) ? 0 : y_sign_change));
+                    }
+
+                    // Full classification for the remaining cells
+                    for (unsigned int x = x_begin; x < x_end; ++x)
+                    {
+                        const int marching_squares_index = cell_signs[x - x_begin] & 15;
+
+                        const auto index_bottom_left = x + y * resolution[0];
+                        const auto index_bottom_right = x + 1 + y * resolution[0];
+                        const auto index_top_left = x + (y + 1) * resolution[0];
+                        const auto index_top_right = x + 1 + (y + 1) * resolution[0];
+
+                        if (marching_squares_index == 0)
+                        {
+                            continue;
+                        }
+                        else if (marching_squares_index == 5 || marching_squares_index == 10 || marching_squares_index == 15)
+                        {
+                            // These cases never yield a critical point, but are reported as unhandled for non-zero vectors
+                            if (!unhandled)
+                            {
+                                unhandled = !Eigen::Vector2f(vectors[index_bottom_left * 2 + 0], vectors[index_bottom_left * 2 + 1]).isZero();
+                            }
+
+                            continue;
+                        }
+                        else if ((cell_signs[x - x_begin] & y_sign_change) == 0)
+                        {
+                            continue;
+                        }
+
+                        const cell_t cell = {
+                            Eigen::Vector2f(vectors[index_bottom_left * 2 + 0], vectors[index_bottom_left * 2 + 1]),
+                            Eigen::Vector2f(vectors[index_bottom_right * 2 + 0], vectors[index_bottom_right * 2 + 1]),
+                            Eigen::Vector2f(vectors[index_top_left * 2 + 0], vectors[index_top_left * 2 + 1]),
+                            Eigen::Vector2f(vectors[index_top_right * 2 + 0], vectors[index_top_right * 2 + 1]),
+                            Eigen::Vector2f(positions[index_bottom_left * 2 + 0], positions[index_bottom_left * 2 + 1]),
+                            Eigen::Vector2f(positions[index_top_right * 2 + 0], positions[index_top_right * 2 + 1])
+                        };
+
+                        const auto critical_point = extract_critical_point(cell);
+
+                        if (critical_point.first != type::NONE && critical_point.first != type::UNHANDLED)
+                        {
+                            extracted.push_back(critical_point);
+                        }
+                        else if (critical_point.first == type::UNHANDLED)
+                        {
+                            unhandled = true;
+                        }
+                    }
+                }
+
+                tile_has_unhandled_case[tile] = unhandled ? 1 : 0;
+            }
+
+            // Combine results
+            std::size_t num_extracted = 0;
+
+            for (unsigned int tile = 0; tile < num_tiles; ++tile)
+            {
+                num_extracted += tile_extracted[tile].size();
+                has_unhandled_case |= tile_has_unhandled_case[tile] != 0;
+            }
+
+            std::vector<std::pair<type, Eigen::Vector2f>> extracted;
+            extracted.reserve(num_extracted);
+
+            for (const auto& tile : tile_extracted)
+            {
+                extracted.insert(extracted.end(), tile.begin(), tile.end());
+            }
+
+            return extracted;
+        }
+
+        std::pair<critical_points::type, Eigen::Vector2f> critical_points::extract_critical_point(const cell_t& cell)
         {
             // Return the point directly, if it is a zero-vector itself
             if (cell.bottom_left.isZero())
@@ -335,14 +446,14 @@ namespace megamol
             return std::make_pair(type::NONE, Eigen::Vector2f());
         }
 
-        Eigen::Vector2f critical_points::linear_interpolate_position(const Eigen::Vector2f& left, const Eigen::Vector2f& right, const float value_left, const float value_right) const
+        Eigen::Vector2f critical_points::linear_interpolate_position(const Eigen::Vector2f& left, const Eigen::Vector2f& right, const float value_left, const float value_right)
         {
             const auto lambda = value_left / (value_left - value_right);
 
             return left + lambda * (right - left);
         }
 
-        float critical_points::linear_interpolate_value(const float left, const float right, const float value_left, const float value_right, const float position) const
+        float critical_points::linear_interpolate_value(const float left, const float right, const float value_left, const float value_right, const float position)
         {
             const auto width = right - left;
 
@@ -352,7 +463,7 @@ namespace megamol
             return right_part * value_left + left_part * value_right;
         }
 
-        Eigen::Vector2f critical_points::linear_interpolate_value(float left, float right, const Eigen::Vector2f& value_left, const Eigen::Vector2f& value_right, float position) const
+        Eigen::Vector2f critical_points::linear_interpolate_value(float left, float right, const Eigen::Vector2f& value_left, const Eigen::Vector2f& value_right, float position)
         {
             const auto width = right - left;
 
@@ -362,7 +473,7 @@ namespace megamol
             return right_part * value_left + left_part * value_right;
         }
 
-        critical_points::cell_t::value_type critical_points::bilinear_interpolate_value(const cell_t& cell, const Eigen::Vector2f& position) const
+        critical_points::cell_t::value_type critical_points::bilinear_interpolate_value(const cell_t& cell, const Eigen::Vector2f& position)
         {
             const auto bottom = linear_interpolate_value(cell.bottom_left_corner[0], cell.top_right_corner[0], cell.bottom_left, cell.bottom_right, position[0]);
             const auto top = linear_interpolate_value(cell.bottom_left_corner[0], cell.top_right_corner[0], cell.top_left, cell.top_right, position[0]);
@@ -370,7 +481,7 @@ namespace megamol
             return linear_interpolate_value(cell.bottom_left_corner[1], cell.top_right_corner[1], bottom, top, position[1]);
         }
 
-        Eigen::Vector2f critical_points::calculate_gradient(const std::vector<Eigen::Vector2f>& vertices, const std::vector<float>& values) const
+        Eigen::Vector2f critical_points::calculate_gradient(const std::vector<Eigen::Vector2f>& vertices, const std::vector<float>& values)
         {
             // Create matrix A, weight matrix W and right-hand side b
             Eigen::Matrix<float, Eigen::Dynamic, 2> A;
@@ -408,7 +519,7 @@ namespace megamol
             return svd.solve(b);
         }
 
-        Eigen::Matrix<float, 2, 2> critical_points::calculate_jacobian(const std::vector<Eigen::Vector2f>& vertices, const std::vector<Eigen::Vector2f>& values) const
+        Eigen::Matrix<float, 2, 2> critical_points::calculate_jacobian(const std::vector<Eigen::Vector2f>& vertices, const std::vector<Eigen::Vector2f>& values)
         {
             // Get values component-wise
             auto x = std::vector<float>(values.size());
@@ -440,7 +551,7 @@ namespace megamol
             return jacobian;
         }
 
-        Eigen::Vector2cf critical_points::calculate_eigenvalues(const Eigen::Matrix<float, 2, 2>& matrix) const
+        Eigen::Vector2cf critical_points::calculate_eigenvalues(const Eigen::Matrix<float, 2, 2>& matrix)
         {
             Eigen::EigenSolver<Eigen::Matrix<float, 2, 2>> eigensolver(matrix, true);
 
@@ -14,6 +14,7 @@
 
 #include "Eigen/Dense"
 
+#include <array>
 #include <utility>
 #include <vector>
 
@@ -66,6 +67,21 @@ namespace megamol
              */
             virtual ~critical_points();
 
+            /**
+            * Extract critical points from all cells of a regular grid, processing tiles of rows in parallel.
+            * Cells without sign changes in both vector components are rejected before the full classification.
+            *
+            * @param resolution             Grid resolution (number of vectors per direction)
+            * @param positions              Positions of the vectors
+            * @param vectors                Vectors of the vector field
+            * @param boundary_layer         Number of boundary cells to skip
+            * @param has_unhandled_case     Returns true if a cell could not be handled
+            *
+            * @return Critical points and their corresponding types
+            */
+            static std::vector<std::pair<type, Eigen::Vector2f>> extract_critical_points(const std::array<unsigned int, 2>& resolution,
+                const std::vector<float>& positions, const std::vector<float>& vectors, unsigned int boundary_layer, bool& has_unhandled_case);
+
         protected:
             /**
              * Implementation of 'Create'.
@@ -96,7 +112,7 @@ namespace megamol
             *
             * @return Critical point and its corresponding type
             */
-            std::pair<type, Eigen::Vector2f> extract_critical_point(const cell_t& cell) const;
+            static std::pair<type, Eigen::Vector2f> extract_critical_point(const cell_t& cell);
 
             /**
             * Linear interpolate position based on value
@@ -108,7 +124,7 @@ namespace megamol
             *
             * @return Position at which the value is zero
             */
-            Eigen::Vector2f linear_interpolate_position(const Eigen::Vector2f& left, const Eigen::Vector2f& right, float value_left, float value_right) const;
+            static Eigen::Vector2f linear_interpolate_position(const Eigen::Vector2f& left, const Eigen::Vector2f& right, float value_left, float value_right);
 
             /**
             * Linear interpolate the value at a given position
@@ -121,8 +137,8 @@ namespace megamol
             *
             * @return Interpolated value
             */
-            float linear_interpolate_value(float left, float right, float value_left, float value_right, float position) const;
-            Eigen::Vector2f linear_interpolate_value(float left, float right, const Eigen::Vector2f& value_left, const Eigen::Vector2f& value_right, float position) const;
+            static float linear_interpolate_value(float left, float right, float value_left, float value_right, float position);
+            static Eigen::Vector2f linear_interpolate_value(float left, float right, const Eigen::Vector2f& value_left, const Eigen::Vector2f& value_right, float position);
 
             /**
             * Bilinear interpolate the value in a given cell
@@ -132,7 +148,7 @@ namespace megamol
             *
             * @return Interpolated value
             */
-            cell_t::value_type bilinear_interpolate_value(const cell_t& cell, const Eigen::Vector2f& position) const;
+            static cell_t::value_type bilinear_interpolate_value(const cell_t& cell, const Eigen::Vector2f& position);
 
             /**
             * Calculate the gradient at the first vertices' position
@@ -142,7 +158,7 @@ namespace megamol
             *
             * @return Gradient
             */
-            Eigen::Vector2f calculate_gradient(const std::vector<Eigen::Vector2f>& vertices, const std::vector<float>& values) const;
+            static Eigen::Vector2f calculate_gradient(const std::vector<Eigen::Vector2f>& vertices, const std::vector<float>& values);
 
             /**
             * Calculate the Jacobian at the first vertices' position
@@ -152,7 +168,7 @@ namespace megamol
             *
             * @return Jacobian
             */
-            Eigen::Matrix<float, 2, 2> calculate_jacobian(const std::vector<Eigen::Vector2f>& vertices, const std::vector<Eigen::Vector2f>& values) const;
+            static Eigen::Matrix<float, 2, 2> calculate_jacobian(const std::vector<Eigen::Vector2f>& vertices, const std::vector<Eigen::Vector2f>& values);
 
             /**
             * Calculate the eigenvalues of a matrix
@@ -161,7 +177,7 @@ namespace megamol
             *
             * @return Eigenvalues
             */
-            Eigen::Vector2cf calculate_eigenvalues(const Eigen::Matrix<float, 2, 2>& matrix) const;
+            static Eigen::Vector2cf calculate_eigenvalues(const Eigen::Matrix<float, 2, 2>& matrix);
 
             /** Callbacks for the triangle mesh */
             bool get_glyph_data_callback(core::Call& call);
@@ -0,0 +1,197 @@
+/*
+ * double_buffer.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include "recyclable.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        /**
+        * Array, of which one version can be published while the next version is computed.
+        *
+        * Publishing hands out the current buffer without copying it. Afterwards, a previously published
+        * buffer that has been released by all consumers is recycled for writing, and only updated with
+        * the range modified since it was published. Consumers may release buffers on any thread, as the
+        * release is ordered before the recycling (see recyclable). As up to two published buffers are kept,
+        * a consumer holding on to the latest one does not prevent recycling (triple buffering).
+        * Modifications are either complete (modify) or append to the end (append), such that the modified
+        * range always extends to the end of the array.
+        *
+        * @author Alexander Straub
+        */
+        template <typename T>
+        class double_buffer
+        {
+        public:
+            /**
+            * Initialize with writable data
+            *
+            * @param data   Initial data
+            */
+            explicit double_buffer(std::vector<T> data = std::vector<T>()) :
+                back(std::make_shared<std::vector<T>>(std::move(data))), back_synced(true), modified(true),
+                modified_begin(0)
+            { }
+
+            /**
+            * Initialize with data that has already been published
+            *
+            * @param data   Published data
+            */
+            explicit double_buffer(std::shared_ptr<std::vector<T>> data) :
+                front(recyclable<std::vector<T>>::adopt(std::move(data))), back_synced(false), modified(false),
+                modified_begin(0)
+            { }
+
+            /**
+            * Get read access to the current data
+            *
+            * @return Current data
+            */
+            const std::vector<T>& read() const
+            {
+                return this->back_synced ? *this->back : *this->front;
+            }
+
+            /**
+            * Get write access to the current data, which is marked as modified completely
+            *
+            * @return Current data
+            */
+            std::vector<T>& modify()
+            {
+                sync();
+
+                this->modified = true;
+                this->modified_begin = 0;
+
+                return *this->back;
+            }
+
+            /**
+            * Append data, which is marked as modified
+            *
+            * @param first  Iterator to the first element to append
+            * @param last   Past-the-end iterator of the elements to append
+            */
+            template <typename iterator_t>
+            void append(iterator_t first, iterator_t last)
+            {
+                sync();
+
+                const auto old_size = this->back->size();
+
+                this->back->insert(this->back->end(), first, last);
+
+                this->modified_begin = this->modified ? std::min(this->modified_begin, old_size) : old_size;
+                this->modified = true;
+            }
+
+            /**
+            * Publish the current data; it must not be modified by the receiver
+            *
+            * @return Current data
+            */
+            std::shared_ptr<std::vector<T>> publish()
+            {
+                if (this->modified)
+                {
+                    // All previously published buffers equal the new data up to the modified range
+                    for (auto& buffer : this->recycled)
+                    {
+                        buffer.valid = std::min(buffer.valid, this->modified_begin);
+                    }
+
+                    if (this->front)
+                    {
+                        if (this->recycled.size() == max_recycled)
+                        {
+                            this->recycled.erase(this->recycled.begin());
+                        }
+
+                        this->recycled.push_back(recycled_buffer{ std::move(this->front), this->modified_begin });
+                    }
+
+                    this->front = std::move(this->back);
+
+                    this->back_synced = false;
+                    this->modified = false;
+                }
+
+                return this->front.share();
+            }
+
+        private:
+            /**
+            * Make the back buffer writable and up to date
+            */
+            void sync()
+            {
+                if (this->back_synced)
+                {
+                    return;
+                }
+
+                // Recycle a published buffer released by all consumers, only copying what changed since
+                auto buffer_it = std::find_if(this->recycled.begin(), this->recycled.end(),
+                    [](const recycled_buffer& buffer) { return buffer.data.is_released(); });
+
+                std::size_t begin = 0;
+
+                if (buffer_it != this->recycled.end())
+                {
+                    this->back = std::move(buffer_it->data);
+                    begin = std::min(buffer_it->valid, this->front->size());
+
+                    this->recycled.erase(buffer_it);
+                }
+                else
+                {
+                    this->back = recyclable<std::vector<T>>(std::make_shared<std::vector<T>>());
+                }
+
+                this->back->resize(this->front->size());
+
+                std::copy(this->front->begin() + begin, this->front->end(), this->back->begin() + begin);
+
+                this->back_synced = true;
+            }
+
+            /** Previously published buffer, and the length of its prefix equal to the current data */
+            struct recycled_buffer
+            {
+                recyclable<std::vector<T>> data;
+                std::size_t valid;
+            };
+
+            /** Maximum number of previously published buffers kept for recycling */
+            static constexpr std::size_t max_recycled = 2;
+
+            /** Published (front) and writable (back) buffer */
+            recyclable<std::vector<T>> front;
+            recyclable<std::vector<T>> back;
+
+            /** Previously published buffers */
+            std::vector<recycled_buffer> recycled;
+
+            /** Indicator for the back buffer containing the current data */
+            bool back_synced;
+
+            /** Indicator for modifications since the last publication, and the start of the modified range */
+            bool modified;
+            std::size_t modified_begin;
+        };
+    }
+}
@@ -103,6 +103,8 @@ namespace megamol
 
         void glyph_data_call::add_line(const std::vector<Eigen::Vector2f>& points, float value)
         {
+            detach_lines();
+
             unsigned int next_index = static_cast<unsigned int>(this->line_vertices->size() / 2);
 
             // Push restart index
@@ -154,6 +156,35 @@ namespace megamol
             this->bounding_rectangle_valid = true;
         }
 
+        void glyph_data_call::set_lines(std::shared_ptr<std::vector<float>> vertices, std::shared_ptr<std::vector<unsigned int>> indices,
+            std::shared_ptr<std::vector<float>> values, const vislib::math::Rectangle<float>& bounding_rectangle)
+        {
+            this->line_vertices = vertices;
+            this->line_indices = indices;
+            this->line_values = values;
+
+            // Adjust bounding rectangle
+            if (this->line_indices->empty())
+            {
+                return;
+            }
+
+            if (this->bounding_rectangle_valid)
+            {
+                this->bounding_rectangle.SetLeft(std::min(this->bounding_rectangle.Left(), bounding_rectangle.Left()));
+                this->bounding_rectangle.SetRight(std::max(this->bounding_rectangle.Right(), bounding_rectangle.Right()));
+
+                this->bounding_rectangle.SetBottom(std::min(this->bounding_rectangle.Bottom(), bounding_rectangle.Bottom()));
+                this->bounding_rectangle.SetTop(std::max(this->bounding_rectangle.Top(), bounding_rectangle.Top()));
+            }
+            else
+            {
+                this->bounding_rectangle = bounding_rectangle;
+            }
+
+            this->bounding_rectangle_valid = true;
+        }
+
         std::vector<std::pair<Eigen::Vector2f, float>> glyph_data_call::get_points() const {
             std::vector<std::pair<Eigen::Vector2f, float>> points(this->point_indices->size());
 
@@ -212,15 +243,42 @@ namespace megamol
         void glyph_data_call::clear()
         {
             this->point_vertices->clear();
-            this->line_vertices->clear();
-
             this->point_indices->clear();
-            this->line_indices->clear();
-
             this->point_values->clear();
-            this->line_values->clear();
+
+            // Line buffers set from outside are not cleared, but replaced
+            if (this->line_vertices.use_count() > 1 || this->line_indices.use_count() > 1 || this->line_values.use_count() > 1)
+            {
+                this->line_vertices = std::make_shared<std::vector<float>>();
+                this->line_indices = std::make_shared<std::vector<unsigned int>>();
+                this->line_values = std::make_shared<std::vector<float>>();
+            }
+            else
+            {
+                this->line_vertices->clear();
+                this->line_indices->clear();
+                this->line_values->clear();
+            }
 
             this->bounding_rectangle_valid = false;
         }
+
+        void glyph_data_call::detach_lines()
+        {
+            if (this->line_vertices.use_count() > 1)
+            {
+                this->line_vertices = std::make_shared<std::vector<float>>(*this->line_vertices);
+            }
+
+            if (this->line_indices.use_count() > 1)
+            {
+                this->line_indices = std::make_shared<std::vector<unsigned int>>(*this->line_indices);
+            }
+
+            if (this->line_values.use_count() > 1)
+            {
+                this->line_values = std::make_shared<std::vector<float>>(*this->line_values);
+            }
+        }
     }
-}
\ No newline at end of file
+}
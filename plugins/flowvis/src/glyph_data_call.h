@@ -126,6 +126,18 @@ namespace megamol
             */
             void add_line(const std::vector<Eigen::Vector2f>& points, float value);
 
+            /**
+            * Set all lines at once, replacing all previously added lines. The buffers are shared
+            * with the call instead of copied, and must therefore not be modified afterwards.
+            *
+            * @param vertices Vertices (x, y), which may include vertices not referenced by any line
+            * @param indices Indices defining line strips, separated by restart indices (-1)
+            * @param values Values stored at the vertices
+            * @param bounding_rectangle Bounding rectangle of all lines
+            */
+            void set_lines(std::shared_ptr<std::vector<float>> vertices, std::shared_ptr<std::vector<unsigned int>> indices,
+                std::shared_ptr<std::vector<float>> values, const vislib::math::Rectangle<float>& bounding_rectangle);
+
             /**
             * Get all points
             *
@@ -153,6 +165,11 @@ namespace megamol
             void clear();
 
         protected:
+            /**
+            * Copy line buffers which are shared with others before modifying them
+            */
+            void detach_lines();
+
             /** Bounding rectangle */
             vislib::math::Rectangle<float> bounding_rectangle;
             bool bounding_rectangle_valid;
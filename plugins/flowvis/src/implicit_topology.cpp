@@ -4,6 +4,7 @@
 #include "glyph_data_call.h"
 #include "implicit_topology_call.h"
 #include "implicit_topology_computation.h"
+#include "implicit_topology_file.h"
 #include "implicit_topology_results.h"
 #include "mesh_data_call.h"
 #include "triangle_mesh_call.h"
@@ -29,12 +30,15 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <exception>
 #include <fstream>
 #include <future>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -49,6 +53,7 @@ namespace megamol
             screenshot_slot("screenshot_slot", "Screenshot output slot"),
             log_slot("log_slot", "Log output slot"),
             performance_slot("performance_slot", "Performance log output slot"),
+            telemetry_slot("telemetry_slot", "Detailed performance measurements output slot (JSON lines)"),
             vector_field_slot("vector_field_slot", "Vector field input slot"),
             convergence_structures_slot("convergence_structures_slot", "Convergence structures input slot"),
             result_reader_slot("result_reader_slot", "Results input slot"),
@@ -74,18 +79,24 @@ namespace megamol
             gradient_fixed_range("gradient_fixed_range", "Fixed or dynamic value range for gradients"),
             gradient_range_min("gradient_range_min", "Minimum value for gradients in the transfer function"),
             gradient_range_max("gradient_range_max", "Maximum value for gradients in the transfer function"),
+            computation_backend("computation_backend", "Backend used for stream line integration"),
             integration_method("integration_method", "Method for stream line integration"),
             num_integration_steps("num_integration_steps", "Number of stream line integration steps"),
             integration_timestep("integration_timestep", "Initial time step for stream line integration"),
             max_integration_error("max_integration_error", "Maximum integration error for Runge-Kutta 4-5"),
-            num_particles_per_batch("num_particles_per_batch", "Number of particles per batch (influences GPU utilization)"),
+            num_particles_per_batch("num_particles_per_batch", "Number of particles per batch (influences GPU utilization and CPU load balancing)"),
             num_integration_steps_per_batch("num_integration_steps_per_batch", "Number of integration steps per batch, after which a result can be visualized"),
             refinement_threshold("refinement_threshold", "Threshold for grid refinement, defined as minimum edge length"),
             refine_at_labels("refine_at_labels", "Should the grid be refined in regions of different labels?"),
             distance_difference_threshold("distance_difference_threshold", "Threshold for refining the grid when neighboring nodes exceed a distance difference"),
             auto_save_results("auto_save_results", "Automatically save results when new ones are available"),
             auto_save_screenshots("auto_save_screenshots", "Automatically take screenshot when new results are available"),
-            computation_running(false), mesh_output_changed(false), data_output_changed(false), computation(nullptr), previous_result(nullptr)
+            checkpoint_file("checkpoint_file", "File for automatic checkpoints, from which an interrupted computation is resumed on start"),
+            checkpoint_cycles("checkpoint_cycles", "Write checkpoint after this number of refinement cycles (0: disabled)"),
+            checkpoint_interval("checkpoint_interval", "Write checkpoint after this number of seconds (0: disabled)"),
+            time_budget("time_budget", "Stop computation cleanly after this number of seconds (0: unlimited)"),
+            computation_running(false), mesh_output_changed(false), data_output_changed(false), first_new_vertex(0), mesh_revision(0),
+            mesh_version(0), results_version(0), gradient_mesh_version(0), gradient_results_version(0), computation(nullptr), previous_result(nullptr)
         {
             // Connect output
             this->triangle_mesh_slot.SetCallback(triangle_mesh_call::ClassName(), triangle_mesh_call::FunctionName(0), &implicit_topology::get_triangle_data_callback);
@@ -114,6 +125,10 @@ namespace megamol
             this->MakeSlotAvailable(&this->performance_slot);
             this->get_performance_callback = []() -> std::ostream& { static std::ostream dummy(nullptr); return dummy; };
 
+            this->telemetry_slot.SetCallback(core::DirectDataWriterCall::ClassName(), core::DirectDataWriterCall::FunctionName(0), &implicit_topology::get_telemetry_cb_callback);
+            this->MakeSlotAvailable(&this->telemetry_slot);
+            this->get_telemetry_callback = []() -> std::ostream& { static std::ostream dummy(nullptr); return dummy; };
+
             // Connect input
             this->vector_field_slot.SetCompatibleCall<vector_field_call::vector_field_description>();
             this->MakeSlotAvailable(&this->vector_field_slot);
@@ -125,6 +140,16 @@ namespace megamol
             this->MakeSlotAvailable(&this->result_reader_slot);
 
             // Create computation parameters
+#ifdef FLOWVIS_USE_CUDA
+            this->computation_backend << new core::param::EnumParam(static_cast<int>(implicit_topology_computation::backend_t::CUDA));
+            this->computation_backend.Param<core::param::EnumParam>()->SetTypePair(static_cast<int>(implicit_topology_computation::backend_t::CPU), "CPU");
+            this->computation_backend.Param<core::param::EnumParam>()->SetTypePair(static_cast<int>(implicit_topology_computation::backend_t::CUDA), "GPU (CUDA)");
+#else
+            this->computation_backend << new core::param::EnumParam(static_cast<int>(implicit_topology_computation::backend_t::CPU));
+            this->computation_backend.Param<core::param::EnumParam>()->SetTypePair(static_cast<int>(implicit_topology_computation::backend_t::CPU), "CPU");
+#endif
+            this->MakeSlotAvailable(&this->computation_backend);
+
             this->integration_method << new core::param::EnumParam(0);
             this->integration_method.Param<core::param::EnumParam>()->SetTypePair(0, "Runge-Kutta 4 (fixed)");
             this->integration_method.Param<core::param::EnumParam>()->SetTypePair(1, "Runge-Kutta 4-5 (dynamic)");
@@ -182,6 +207,19 @@ namespace megamol
             this->auto_save_screenshots << new core::param::BoolParam(false);
             this->MakeSlotAvailable(&this->auto_save_screenshots);
 
+            // Create checkpoint and time budget parameters
+            this->checkpoint_file << new core::param::FilePathParam("");
+            this->MakeSlotAvailable(&this->checkpoint_file);
+
+            this->checkpoint_cycles << new core::param::IntParam(1, 0);
+            this->MakeSlotAvailable(&this->checkpoint_cycles);
+
+            this->checkpoint_interval << new core::param::IntParam(600, 0);
+            this->MakeSlotAvailable(&this->checkpoint_interval);
+
+            this->time_budget << new core::param::IntParam(0, 0);
+            this->MakeSlotAvailable(&this->time_budget);
+
             // Create transfer function parameters
             this->label_transfer_function << new core::param::TransferFunctionParam(
                 "{\"Interpolation\":\"LINEAR\",\"Nodes\":[[0.0,0.0,0.423499,1.0,0.0,0.05],[0.0,0.119346,0.529237,1.0,0.125,0.05]," \
@@ -275,8 +313,8 @@ namespace megamol
 
         bool implicit_topology::initialize_computation()
         {
-            // Try to load input vector field
-            if (this->computation == nullptr)
+            // Try to resume from checkpoint, or load input vector field
+            if (this->computation == nullptr && !resume_from_checkpoint())
             {
                 std::array<unsigned int, 2> resolution;
                 std::array<float, 4> domain;
@@ -291,7 +329,8 @@ namespace megamol
                 if (load_input(resolution, domain, positions, vectors, points, point_ids, lines, line_ids))
                 {
                     // Create new computation object
-                    this->computation = std::make_unique<implicit_topology_computation>(this->get_log_callback(), this->get_performance_callback(),
+                    this->mesh_revision = 0;
+                    this->computation = std::make_unique<implicit_topology_computation>(this->get_log_callback(), this->get_performance_callback(), this->get_telemetry_callback(),
                         std::move(resolution), std::move(domain), std::move(positions), std::move(vectors), std::move(points), std::move(point_ids),
                         std::move(lines), std::move(line_ids),
                         this->integration_timestep.Param<core::param::FloatParam>()->Value(),
@@ -309,6 +348,75 @@ namespace megamol
             return true;
         }
 
+        bool implicit_topology::resume_from_checkpoint()
+        {
+            const std::string path(this->checkpoint_file.Param<core::param::FilePathParam>()->Value());
+
+            if (path.empty() || !std::ifstream(path).good())
+            {
+                return false;
+            }
+
+            // Load checkpoint
+            implicit_topology_results previous_results;
+
+            try
+            {
+                implicit_topology_file::read(path, previous_results);
+            }
+            catch (const std::exception& e)
+            {
+                vislib::sys::Log::DefaultLog.WriteWarn("Unable to resume from checkpoint '%s': %s", path.c_str(), e.what());
+
+                return false;
+            }
+
+            // Load input from file
+            std::array<unsigned int, 2> resolution;
+            std::array<float, 4> domain;
+
+            std::vector<float> positions;
+            std::vector<float> vectors;
+            std::vector<float> points;
+            std::vector<int> point_ids;
+            std::vector<float> lines;
+            std::vector<int> line_ids;
+
+            if (!load_input(resolution, domain, positions, vectors, points, point_ids, lines, line_ids))
+            {
+                return false;
+            }
+
+            // Only resume if the checkpoint was computed for exactly this input
+            const auto& state = previous_results.computation_state;
+
+            if (state.resolution != resolution || state.domain != domain
+                || state.input_hash != implicit_topology_computation::hash_input(vectors, points, point_ids, lines, line_ids)
+                || previous_results.labels_forward == nullptr || previous_results.labels_forward->size() < positions.size() / 2)
+            {
+                vislib::sys::Log::DefaultLog.WriteWarn("Checkpoint '%s' does not match the input, starting new computation.", path.c_str());
+
+                return false;
+            }
+
+            // Create new computation object
+            this->mesh_revision = 0;
+            this->computation = std::make_unique<implicit_topology_computation>(this->get_log_callback(), this->get_performance_callback(), this->get_telemetry_callback(),
+                std::move(resolution), std::move(domain), std::move(positions), std::move(vectors), std::move(points), std::move(point_ids),
+                std::move(lines), std::move(line_ids), previous_results);
+
+            this->integration_method.Param<core::param::EnumParam>()->SetValue(static_cast<int>(previous_results.computation_state.method));
+            this->integration_timestep.Param<core::param::FloatParam>()->SetValue(previous_results.computation_state.integration_timestep);
+            this->max_integration_error.Param<core::param::FloatParam>()->SetValue(previous_results.computation_state.max_integration_error);
+
+            set_readonly_fixed_parameters(true);
+
+            vislib::sys::Log::DefaultLog.WriteInfo("Computation of topology resumed from checkpoint '%s' after %u integration steps.",
+                path.c_str(), previous_results.computation_state.num_integration_steps);
+
+            return true;
+        }
+
         bool implicit_topology::load_input(std::array<unsigned int, 2>& resolution, std::array<float, 4>& domain, std::vector<float>& positions,
             std::vector<float>& vectors, std::vector<float>& points, std::vector<int>& point_ids, std::vector<float>& lines, std::vector<int>& line_ids)
         {
@@ -388,6 +496,22 @@ namespace megamol
                 // Store triangles
                 auto result = this->last_result.get();
 
+                // Changes of the triangle mesh are only known if no intermediate result was skipped
+                const bool consecutive_mesh = this->vertices != nullptr && result.mesh_revision != 0 && result.mesh_revision == this->mesh_revision + 1;
+
+                this->first_new_vertex = consecutive_mesh ? result.first_new_vertex : 0;
+                this->changed_cells = consecutive_mesh ? result.changed_cells : nullptr;
+                this->mesh_revision = result.mesh_revision;
+
+                const bool mesh_unchanged = consecutive_mesh && result.changed_cells != nullptr && result.changed_cells->empty() && result.first_new_vertex == result.vertices->size() / 2;
+
+                if (!mesh_unchanged)
+                {
+                    ++this->mesh_version;
+                }
+
+                ++this->results_version;
+
                 this->vertices = result.vertices;
                 this->indices = result.indices;
 
@@ -438,6 +562,7 @@ namespace megamol
 
         void implicit_topology::set_readonly_variable_parameters(const bool read_only)
         {
+            this->computation_backend.Parameter()->SetGUIReadOnly(read_only);
             this->num_integration_steps.Parameter()->SetGUIReadOnly(read_only);
             this->num_particles_per_batch.Parameter()->SetGUIReadOnly(read_only);
             this->num_integration_steps_per_batch.Parameter()->SetGUIReadOnly(read_only);
@@ -445,6 +570,114 @@ namespace megamol
             this->refinement_threshold.Parameter()->SetGUIReadOnly(read_only);
             this->refine_at_labels.Parameter()->SetGUIReadOnly(read_only);
             this->distance_difference_threshold.Parameter()->SetGUIReadOnly(read_only);
+
+            this->checkpoint_file.Parameter()->SetGUIReadOnly(read_only);
+            this->checkpoint_cycles.Parameter()->SetGUIReadOnly(read_only);
+            this->checkpoint_interval.Parameter()->SetGUIReadOnly(read_only);
+            this->time_budget.Parameter()->SetGUIReadOnly(read_only);
+        }
+
+        void implicit_topology::compute_gradients()
+        {
+            // Only the versions are remembered, as holding on to the buffers would prevent their recycling
+            const bool mesh_changed = this->mesh_version != this->gradient_mesh_version;
+
+            if (!mesh_changed && this->gradients != nullptr && this->results_version == this->gradient_results_version)
+            {
+                return;
+            }
+
+            const auto& vertices = *this->vertices;
+            const auto& indices = *this->indices;
+
+            const auto num_vertices = this->distances_forward->size();
+
+            // Extract unique edges and compute their lengths once, storing them for both incident vertices
+            if (mesh_changed || this->edge_offsets.size() != num_vertices + 1)
+            {
+                std::vector<std::pair<GLuint, GLuint>> edges;
+                edges.reserve(indices.size());
+
+                for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    edges.push_back(std::minmax(indices[i + 0], indices[i + 1]));
+                    edges.push_back(std::minmax(indices[i + 0], indices[i + 2]));
+                    edges.push_back(std::minmax(indices[i + 1], indices[i + 2]));
+                }
+
+                std::sort(edges.begin(), edges.end());
+                edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+                std::vector<GLfloat> lengths(edges.size());
+
+                #pragma omp parallel for
+                for (long long i = 0; i < static_cast<long long>(edges.size()); ++i)
+                {
+                    const Eigen::Vector2f point_1(vertices[edges[i].first * 2 + 0], vertices[edges[i].first * 2 + 1]);
+                    const Eigen::Vector2f point_2(vertices[edges[i].second * 2 + 0], vertices[edges[i].second * 2 + 1]);
+
+                    lengths[i] = (point_1 - point_2).norm();
+                }
+
+                this->edge_offsets.assign(num_vertices + 1, 0);
+
+                for (const auto& edge : edges)
+                {
+                    ++this->edge_offsets[edge.first + 1];
+                    ++this->edge_offsets[edge.second + 1];
+                }
+
+                for (std::size_t i = 0; i < num_vertices; ++i)
+                {
+                    this->edge_offsets[i + 1] += this->edge_offsets[i];
+                }
+
+                this->edge_neighbors.resize(this->edge_offsets.back());
+                this->edge_lengths.resize(this->edge_offsets.back());
+
+                std::vector<std::size_t> fill(this->edge_offsets.begin(), this->edge_offsets.end() - 1);
+
+                for (std::size_t i = 0; i < edges.size(); ++i)
+                {
+                    this->edge_neighbors[fill[edges[i].first]] = edges[i].second;
+                    this->edge_lengths[fill[edges[i].first]++] = lengths[i];
+
+                    this->edge_neighbors[fill[edges[i].second]] = edges[i].first;
+                    this->edge_lengths[fill[edges[i].second]++] = lengths[i];
+                }
+
+                this->gradient_mesh_version = this->mesh_version;
+            }
+
+            // Compute gradient magnitudes per vertex from its incident edges
+            auto& gradients = *(this->gradients = std::make_shared<std::vector<float>>(num_vertices, 0.0f));
+            auto& gradients_forward = *(this->gradients_forward = std::make_shared<std::vector<float>>(num_vertices, 0.0f));
+            auto& gradients_backward = *(this->gradients_backward = std::make_shared<std::vector<float>>(num_vertices, 0.0f));
+
+            const auto& distances_forward = *this->distances_forward;
+            const auto& distances_backward = *this->distances_backward;
+
+            #pragma omp parallel for schedule(static, 1024)
+            for (long long i = 0; i < static_cast<long long>(num_vertices); ++i)
+            {
+                float gradient_forward = 0.0f;
+                float gradient_backward = 0.0f;
+
+                for (auto edge = this->edge_offsets[i]; edge < this->edge_offsets[i + 1]; ++edge)
+                {
+                    const auto neighbor = this->edge_neighbors[edge];
+                    const auto length = this->edge_lengths[edge];
+
+                    gradient_forward = std::max(gradient_forward, std::abs(distances_forward[i] - distances_forward[neighbor]) / length);
+                    gradient_backward = std::max(gradient_backward, std::abs(distances_backward[i] - distances_backward[neighbor]) / length);
+                }
+
+                gradients_forward[i] = gradient_forward;
+                gradients_backward[i] = gradient_backward;
+                gradients[i] = std::max(gradient_forward, gradient_backward);
+            }
+
+            this->gradient_results_version = this->results_version;
         }
 
         bool implicit_topology::get_triangle_data_callback(core::Call& call)
@@ -459,6 +692,7 @@ namespace megamol
             {
                 triangle_call->set_vertices(this->vertices);
                 triangle_call->set_indices(this->indices);
+                triangle_call->set_changes(this->first_new_vertex, this->changed_cells);
 
                 triangle_call->SetDataHash(triangle_call->DataHash() + 1);
 
@@ -675,44 +909,7 @@ namespace megamol
                 // Compute and set gradient magnitudes
                 if (this->data_output_changed)
                 {
-                    auto& gradients = *(this->gradients = std::make_shared<std::vector<float>>(this->distances_forward->size()));
-                    auto& gradients_forward = *(this->gradients_forward = std::make_shared<std::vector<float>>(this->distances_forward->size(), 0.0f));
-                    auto& gradients_backward = *(this->gradients_backward = std::make_shared<std::vector<float>>(this->distances_backward->size(), 0.0f));
-
-                    const auto& vertices = *this->vertices;
-                    const auto& indices = *this->indices;
-
-                    const auto& distances_forward = *this->distances_forward;
-                    const auto& distances_backward = *this->distances_backward;
-
-                    for (std::size_t i = 0; i < indices.size(); i += 3)
-                    {
-                        const Eigen::Vector2f point_1(vertices[indices[i + 0] * 2 + 0], vertices[indices[i + 0] * 2 + 1]);
-                        const Eigen::Vector2f point_2(vertices[indices[i + 1] * 2 + 0], vertices[indices[i + 1] * 2 + 1]);
-                        const Eigen::Vector2f point_3(vertices[indices[i + 2] * 2 + 0], vertices[indices[i + 2] * 2 + 1]);
-
-                        const Eigen::Vector2f distance_1(distances_forward[indices[i + 0]], distances_backward[indices[i + 0]]);
-                        const Eigen::Vector2f distance_2(distances_forward[indices[i + 1]], distances_backward[indices[i + 1]]);
-                        const Eigen::Vector2f distance_3(distances_forward[indices[i + 2]], distances_backward[indices[i + 2]]);
-
-                        gradients_forward[indices[i + 0]] = std::max(gradients_forward[indices[i + 0]], std::abs(distance_1[0] - distance_2[0]) / (point_1 - point_2).norm());
-                        gradients_forward[indices[i + 1]] = std::max(gradients_forward[indices[i + 1]], std::abs(distance_1[0] - distance_2[0]) / (point_1 - point_2).norm());
-                        gradients_forward[indices[i + 0]] = std::max(gradients_forward[indices[i + 0]], std::abs(distance_1[0] - distance_3[0]) / (point_1 - point_3).norm());
-                        gradients_forward[indices[i + 2]] = std::max(gradients_forward[indices[i + 2]], std::abs(distance_1[0] - distance_3[0]) / (point_1 - point_3).norm());
-                        gradients_forward[indices[i + 1]] = std::max(gradients_forward[indices[i + 1]], std::abs(distance_2[0] - distance_3[0]) / (point_2 - point_3).norm());
-                        gradients_forward[indices[i + 2]] = std::max(gradients_forward[indices[i + 2]], std::abs(distance_2[0] - distance_3[0]) / (point_2 - point_3).norm());
-
-                        gradients_backward[indices[i + 0]] = std::max(gradients_backward[indices[i + 0]], std::abs(distance_1[1] - distance_2[1]) / (point_1 - point_2).norm());
-                        gradients_backward[indices[i + 1]] = std::max(gradients_backward[indices[i + 1]], std::abs(distance_1[1] - distance_2[1]) / (point_1 - point_2).norm());
-                        gradients_backward[indices[i + 0]] = std::max(gradients_backward[indices[i + 0]], std::abs(distance_1[1] - distance_3[1]) / (point_1 - point_3).norm());
-                        gradients_backward[indices[i + 2]] = std::max(gradients_backward[indices[i + 2]], std::abs(distance_1[1] - distance_3[1]) / (point_1 - point_3).norm());
-                        gradients_backward[indices[i + 1]] = std::max(gradients_backward[indices[i + 1]], std::abs(distance_2[1] - distance_3[1]) / (point_2 - point_3).norm());
-                        gradients_backward[indices[i + 2]] = std::max(gradients_backward[indices[i + 2]], std::abs(distance_2[1] - distance_3[1]) / (point_2 - point_3).norm());
-
-                        gradients[indices[i + 0]] = std::max(gradients_forward[indices[i + 0]], gradients_backward[indices[i + 0]]);
-                        gradients[indices[i + 1]] = std::max(gradients_forward[indices[i + 1]], gradients_backward[indices[i + 1]]);
-                        gradients[indices[i + 2]] = std::max(gradients_forward[indices[i + 2]], gradients_backward[indices[i + 2]]);
-                    }
+                    compute_gradients();
                 }
 
                 set_data(data_call, this->gradients, "gradients",
@@ -910,6 +1107,13 @@ namespace megamol
             return true;
         }
 
+        bool implicit_topology::get_telemetry_cb_callback(core::Call& call)
+        {
+            this->get_telemetry_callback = dynamic_cast<core::DirectDataWriterCall*>(&call)->GetCallback();
+
+            return true;
+        }
+
         bool implicit_topology::start_computation_callback(core::param::ParamSlot& slot)
         {
             // Initialize computation object
@@ -925,7 +1129,13 @@ namespace megamol
                 this->refine_at_labels.Param<core::param::BoolParam>()->Value(),
                 this->distance_difference_threshold.Param<core::param::FloatParam>()->Value(),
                 this->num_particles_per_batch.Param<core::param::IntParam>()->Value(),
-                this->num_integration_steps_per_batch.Param<core::param::IntParam>()->Value());
+                this->num_integration_steps_per_batch.Param<core::param::IntParam>()->Value(),
+                static_cast<implicit_topology_computation::backend_t>(this->computation_backend.Param<core::param::EnumParam>()->Value()),
+                implicit_topology_computation::run_control_t{
+                    std::string(this->checkpoint_file.Param<core::param::FilePathParam>()->Value()),
+                    static_cast<unsigned int>(this->checkpoint_cycles.Param<core::param::IntParam>()->Value()),
+                    std::chrono::seconds(this->checkpoint_interval.Param<core::param::IntParam>()->Value()),
+                    std::chrono::seconds(this->time_budget.Param<core::param::IntParam>()->Value()) });
 
             this->last_result = this->computation->get_results();
 
@@ -1009,10 +1219,12 @@ namespace megamol
                 }
                     
                 // Create new computation object
-                this->computation = std::make_unique<implicit_topology_computation>(this->get_log_callback(), this->get_performance_callback(),
+                this->mesh_revision = 0;
+                this->computation = std::make_unique<implicit_topology_computation>(this->get_log_callback(), this->get_performance_callback(), this->get_telemetry_callback(),
                     std::move(resolution), std::move(domain), std::move(positions), std::move(vectors), std::move(points), std::move(point_ids),
                     std::move(lines), std::move(line_ids), previous_results);
 
+                this->integration_method.Param<core::param::EnumParam>()->SetValue(static_cast<int>(previous_results.computation_state.method));
                 this->integration_timestep.Param<core::param::FloatParam>()->SetValue(previous_results.computation_state.integration_timestep);
                 this->max_integration_error.Param<core::param::FloatParam>()->SetValue(previous_results.computation_state.max_integration_error);
 
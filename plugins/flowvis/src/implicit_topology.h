@@ -19,6 +19,7 @@
 #include "glad/glad.h"
 
 #include <array>
+#include <cstddef>
 #include <iostream>
 #include <memory>
 #include <type_traits>
@@ -109,6 +110,10 @@ namespace megamol
             bool get_performance_cb_callback(core::Call& call);
             std::function<std::ostream&()> get_performance_callback;
 
+            /** Callbacks for the detailed performance measurements */
+            bool get_telemetry_cb_callback(core::Call& call);
+            std::function<std::ostream&()> get_telemetry_callback;
+
             /** Callbacks for starting/stopping/resetting the computation */
             bool start_computation_callback(core::param::ParamSlot& parameter);
             bool stop_computation_callback(core::param::ParamSlot& parameter);
@@ -123,6 +128,13 @@ namespace megamol
             */
             bool initialize_computation();
 
+            /**
+            * Resume computation from the checkpoint file, if it exists.
+            *
+            * @return True if the computation was resumed
+            */
+            bool resume_from_checkpoint();
+
             /**
             * Load input from file.
             *
@@ -159,6 +171,14 @@ namespace megamol
             */
             void set_readonly_variable_parameters(bool read_only);
 
+            /**
+            * Compute gradient magnitudes of the forward and backward distances, using
+            * the maximum difference along the incident edges of each vertex.
+            * Edges are cached until the triangle mesh changes, and the gradients are
+            * only recomputed if either the mesh or the distances change.
+            */
+            void compute_gradients();
+
             /** Output slot for the triangle mesh */
             core::CalleeSlot triangle_mesh_slot;
 
@@ -174,6 +194,7 @@ namespace megamol
             /** Output slots for logging */
             core::CalleeSlot log_slot;
             core::CalleeSlot performance_slot;
+            core::CalleeSlot telemetry_slot;
 
             /** Input slot for getting the vector field */
             core::CallerSlot vector_field_slot;
@@ -213,6 +234,7 @@ namespace megamol
             core::param::ParamSlot gradient_range_min, gradient_range_max;
 
             /** Parameters for stream line computation */
+            core::param::ParamSlot computation_backend;
             core::param::ParamSlot integration_method;
             core::param::ParamSlot num_integration_steps;
             core::param::ParamSlot integration_timestep;
@@ -229,6 +251,12 @@ namespace megamol
             core::param::ParamSlot auto_save_results;
             core::param::ParamSlot auto_save_screenshots;
 
+            /** Parameters for checkpoints and time-limited runs */
+            core::param::ParamSlot checkpoint_file;
+            core::param::ParamSlot checkpoint_cycles;
+            core::param::ParamSlot checkpoint_interval;
+            core::param::ParamSlot time_budget;
+
             /** Input information */
             std::array<unsigned int, 2> resolution;
 
@@ -242,6 +270,15 @@ namespace megamol
             std::shared_ptr<std::vector<GLfloat>> vertices;
             std::shared_ptr<std::vector<GLuint>> indices;
 
+            /** Changes of the triangle mesh with respect to the previous output, and revision of the current mesh */
+            std::size_t first_new_vertex;
+            std::shared_ptr<std::vector<GLuint>> changed_cells;
+            std::size_t mesh_revision;
+
+            /** Versions of the output mesh and of all output data, counted up on change across computations */
+            std::size_t mesh_version;
+            std::size_t results_version;
+
             /** Output labels */
             std::shared_ptr<std::vector<GLfloat>> labels;
             std::shared_ptr<std::vector<GLfloat>> labels_forward;
@@ -261,6 +298,15 @@ namespace megamol
             std::shared_ptr<std::vector<GLfloat>> gradients_forward;
             std::shared_ptr<std::vector<GLfloat>> gradients_backward;
 
+            /** Versions of the mesh and the results used for the last gradient computation */
+            std::size_t gradient_mesh_version;
+            std::size_t gradient_results_version;
+
+            /** Incident edges per vertex, stored consecutively with offsets per vertex */
+            std::vector<std::size_t> edge_offsets;
+            std::vector<GLuint> edge_neighbors;
+            std::vector<GLfloat> edge_lengths;
+
             /** Output mask */
             std::shared_ptr<std::vector<GLfloat>> valid_all;
             std::shared_ptr<std::vector<GLfloat>> valid_one;
@@ -1,21 +1,28 @@
 #include "stdafx.h"
 
 #include "implicit_topology_computation.h"
+#include "implicit_topology_file.h"
 #include "implicit_topology_results.h"
+#include "streamlines_cpu.h"
+#include "telemetry.h"
 
 #include "../cuda/streamlines.h"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
-#include <deque>
+#include <cstdint>
+#include <cstdio>
 #include <future>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <thread>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -23,8 +30,8 @@ namespace megamol
 {
     namespace flowvis
     {
-        implicit_topology_computation::implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream, 
-            std::array<unsigned int, 2> resolution, std::array<float, 4> domain, std::vector<float> positions, std::vector<float> vectors,
+        implicit_topology_computation::implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream,
+            std::ostream& telemetry_stream, std::array<unsigned int, 2> resolution, std::array<float, 4> domain, std::vector<float> positions, std::vector<float> vectors,
             std::vector<float> points, std::vector<int> point_ids, std::vector<float> lines, std::vector<int> line_ids,
             const float integration_timestep, const float max_integration_error, const streamlines_cuda::integration_method method)
             :
@@ -36,13 +43,16 @@ namespace megamol
             lines(std::move(lines)),
             point_ids(std::move(point_ids)),
             line_ids(std::move(line_ids)),
+            input_hash(hash_input(this->vectors, this->points, this->point_ids, this->lines, this->line_ids)),
             integration_timestep(integration_timestep),
             max_integration_error(max_integration_error),
             method(method),
             num_integration_steps_performed(0),
+            computation_complete(false),
             terminate_computation(false),
             log_output(log_stream),
-            performance_output(performance_stream)
+            performance_output(performance_stream),
+            telemetry_output(telemetry_stream)
         {
             this->log_output << "Initializing computation..." << std::endl;
             this->log_output << "Resolution:                            " << this->resolution[0] << " x " << this->resolution[1] << std::endl;
@@ -54,19 +64,27 @@ namespace megamol
             this->log_output << "Maximum integration error:             " << this->max_integration_error << std::endl;
 
             // Store positions
-            this->positions_forward = this->positions;
-            this->positions_backward = this->positions;
+            this->positions_forward.modify() = this->positions;
+            this->positions_backward.modify() = this->positions;
 
             // Compute initial fields
             unsigned int num = this->resolution[0] * this->resolution[1];
 
-            this->labels_forward.resize(num);
-            this->distances_forward.resize(num);
-            this->terminations_forward.resize(num);
+            auto& labels_forward = this->labels_forward.modify();
+            auto& distances_forward = this->distances_forward.modify();
+            auto& terminations_forward = this->terminations_forward.modify();
+
+            auto& labels_backward = this->labels_backward.modify();
+            auto& distances_backward = this->distances_backward.modify();
+            auto& terminations_backward = this->terminations_backward.modify();
 
-            this->labels_backward.resize(num);
-            this->distances_backward.resize(num);
-            this->terminations_backward.resize(num);
+            labels_forward.resize(num);
+            distances_forward.resize(num);
+            terminations_forward.resize(num);
+
+            labels_backward.resize(num);
+            distances_backward.resize(num);
+            terminations_backward.resize(num);
 
             auto calc_dot = [](const float x_1, const float y_1, const float x_2, const float y_2) { return x_1 * x_2 + y_1 * y_2; };
             auto calc_norm = [calc_dot](const float x, const float y) { return calc_dot(x, y, x, y); };
@@ -80,7 +98,7 @@ namespace megamol
                 const float x_vec = this->vectors[n * 2 + 0];
                 const float y_vec = this->vectors[n * 2 + 1];
 
-                this->distances_forward[n] = this->distances_backward[n] = std::numeric_limits<float>::max();
+                distances_forward[n] = distances_backward[n] = std::numeric_limits<float>::max();
 
                 // Compute minimum distance to convergence structures represented by points
                 for (unsigned int i = 0; i < this->point_ids.size(); ++i)
@@ -90,10 +108,10 @@ namespace megamol
 
                     const float distance = calc_length(x_pos, y_pos, point_x_pos, point_y_pos);
 
-                    if (this->distances_forward[n] > distance)
+                    if (distances_forward[n] > distance)
                     {
-                        this->labels_forward[n] = this->labels_backward[n] = static_cast<GLfloat>(this->point_ids[i]);
-                        this->distances_forward[n] = this->distances_backward[n] = distance;
+                        labels_forward[n] = labels_backward[n] = static_cast<GLfloat>(this->point_ids[i]);
+                        distances_forward[n] = distances_backward[n] = distance;
                     }
                 }
 
@@ -137,23 +155,23 @@ namespace megamol
                         }
                     }
 
-                    if (this->distances_forward[n] > distance)
+                    if (distances_forward[n] > distance)
                     {
-                        this->labels_forward[n] = this->labels_backward[n] = static_cast<GLfloat>(this->line_ids[i]);
-                        this->distances_forward[n] = this->distances_backward[n] = distance;
+                        labels_forward[n] = labels_backward[n] = static_cast<GLfloat>(this->line_ids[i]);
+                        distances_forward[n] = distances_backward[n] = distance;
                     }
                 }
 
                 // Set special values if it is part of the boundary
                 if (x_vec == 0.0f && y_vec == 0.0f)
                 {
-                    this->labels_forward[n] = this->labels_backward[n] = -1.0f;
-                    this->distances_forward[n] = this->distances_backward[n] = 0.0f;
-                    this->terminations_forward[n] = this->terminations_backward[n] = -1.0f;
+                    labels_forward[n] = labels_backward[n] = -1.0f;
+                    distances_forward[n] = distances_backward[n] = 0.0f;
+                    terminations_forward[n] = terminations_backward[n] = -1.0f;
                 }
                 else
                 {
-                    this->terminations_forward[n] = this->terminations_backward[n] = 0.0f;
+                    terminations_forward[n] = terminations_backward[n] = 0.0f;
                 }
             }
 
@@ -162,7 +180,7 @@ namespace megamol
         }
 
         implicit_topology_computation::implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream,
-            std::array<unsigned int, 2> resolution, std::array<float, 4> domain, std::vector<float> positions, std::vector<float> vectors,
+            std::ostream& telemetry_stream, std::array<unsigned int, 2> resolution, std::array<float, 4> domain, std::vector<float> positions, std::vector<float> vectors,
             std::vector<float> points, std::vector<int> point_ids, std::vector<float> lines, std::vector<int> line_ids, implicit_topology_results previous_result)
             :
             resolution(std::move(resolution)),
@@ -173,22 +191,25 @@ namespace megamol
             lines(std::move(lines)),
             point_ids(std::move(point_ids)),
             line_ids(std::move(line_ids)),
+            input_hash(hash_input(this->vectors, this->points, this->point_ids, this->lines, this->line_ids)),
             integration_timestep(previous_result.computation_state.integration_timestep),
             max_integration_error(previous_result.computation_state.max_integration_error),
             method(previous_result.computation_state.method),
-            positions_forward(*previous_result.positions_forward),
-            positions_backward(*previous_result.positions_backward),
-            labels_forward(*previous_result.labels_forward),
-            distances_forward(*previous_result.distances_forward),
-            terminations_forward(*previous_result.terminations_forward),
-            labels_backward(*previous_result.labels_backward),
-            distances_backward(*previous_result.distances_backward),
-            terminations_backward(*previous_result.terminations_backward),
+            positions_forward(previous_result.positions_forward),
+            positions_backward(previous_result.positions_backward),
+            labels_forward(previous_result.labels_forward),
+            distances_forward(previous_result.distances_forward),
+            terminations_forward(previous_result.terminations_forward),
+            labels_backward(previous_result.labels_backward),
+            distances_backward(previous_result.distances_backward),
+            terminations_backward(previous_result.terminations_backward),
             num_integration_steps_performed(previous_result.computation_state.num_integration_steps),
+            computation_complete(previous_result.computation_state.finished),
             delaunay(*previous_result.vertices),
             terminate_computation(false),
             log_output(log_stream),
-            performance_output(performance_stream)
+            performance_output(performance_stream),
+            telemetry_output(telemetry_stream)
         {
             this->log_output << "Initializing computation from previous results..." << std::endl;
             this->log_output << "Resolution:                            " << this->resolution[0] << " x " << this->resolution[1] << std::endl;
@@ -208,18 +229,22 @@ namespace megamol
 
         void implicit_topology_computation::start(const unsigned int num_integration_steps,
             const float refinement_threshold, const bool refine_at_labels, const float distance_difference_threshold,
-            const unsigned int num_particles_per_batch, const unsigned int num_integration_steps_per_batch)
+            const unsigned int num_particles_per_batch, const unsigned int num_integration_steps_per_batch, const backend_t backend,
+            run_control_t run_control)
         {
             // Prepare results
             {
                 std::promise<implicit_topology_results> promise;
                 this->current_result = promise.get_future().share();
 
+                // Check if there is actually something to do; a checkpoint written during refinement
+                // has performed all integration steps, but still needs refinement to be resumed
+                const bool complete = this->computation_complete && num_integration_steps <= this->num_integration_steps_performed;
+
                 // Set initial result
-                set_result(promise, num_integration_steps <= this->num_integration_steps_performed);
+                set_result(promise, complete);
 
-                // Check if there is actually something to do
-                if (num_integration_steps <= this->num_integration_steps_performed)
+                if (complete)
                 {
                     return;
                 }
@@ -234,9 +259,11 @@ namespace megamol
                 this->computation.join();
             }
 
+            this->time_start_requested = std::chrono::steady_clock::now();
+
             this->computation = std::thread(&implicit_topology_computation::run, this, std::move(promise),
                 num_integration_steps, refinement_threshold, refine_at_labels, distance_difference_threshold,
-                num_particles_per_batch, num_integration_steps_per_batch);
+                num_particles_per_batch, num_integration_steps_per_batch, backend, std::move(run_control));
         }
 
         void implicit_topology_computation::terminate()
@@ -256,14 +283,59 @@ namespace megamol
             return this->current_result;
         }
 
+        std::uint64_t implicit_topology_computation::hash_input(const std::vector<float>& vectors, const std::vector<float>& points,
+            const std::vector<int>& point_ids, const std::vector<float>& lines, const std::vector<int>& line_ids)
+        {
+            // FNV-1a over the bytes of all arrays, including their sizes
+            std::uint64_t hash = 14695981039346656037ull;
+
+            auto hash_bytes = [&hash](const char* data, const std::size_t size)
+            {
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+                }
+            };
+
+            auto hash_array = [&hash_bytes](const auto& array)
+            {
+                const std::uint64_t size = array.size();
+
+                hash_bytes(reinterpret_cast<const char*>(&size), sizeof(size));
+                hash_bytes(reinterpret_cast<const char*>(array.data()), array.size() * sizeof(array[0]));
+            };
+
+            hash_array(vectors);
+            hash_array(points);
+            hash_array(point_ids);
+            hash_array(lines);
+            hash_array(line_ids);
+
+            return hash;
+        }
+
         void implicit_topology_computation::run(std::promise<implicit_topology_results>&& promise, const unsigned int num_integration_steps,
             const float refinement_threshold, const bool refine_at_labels, const float distance_difference_threshold,
-            const unsigned int num_particles_per_batch, const unsigned int num_integration_steps_per_batch)
+            const unsigned int num_particles_per_batch, const unsigned int num_integration_steps_per_batch, const backend_t backend,
+            const run_control_t run_control)
         {
             // Write output
             this->log_output << "Refinement threshold:                  " << refinement_threshold << std::endl;
             this->log_output << "Refinement at labels:                  " << (refine_at_labels ? "yes" : "no") << std::endl;
             this->log_output << "Distance difference threshold:         " << distance_difference_threshold << std::endl;
+
+            if (!run_control.checkpoint_path.empty())
+            {
+                this->log_output << "Checkpoint file:                       " << run_control.checkpoint_path << std::endl;
+                this->log_output << "Checkpoint every ... refinement cycles: " << run_control.checkpoint_cycles << std::endl;
+                this->log_output << "Checkpoint every ... seconds:          " << run_control.checkpoint_interval.count() << std::endl;
+            }
+
+            if (run_control.time_budget.count() > 0)
+            {
+                this->log_output << "Time budget in seconds:                " << run_control.time_budget.count() << std::endl;
+            }
+
             this->log_output << std::endl;
 
             this->log_output << "Starting computation..." << std::endl;
@@ -272,14 +344,195 @@ namespace megamol
             this->log_output << "Number of integration steps:           " << num_integration_steps - this->num_integration_steps_performed << std::endl;
             this->log_output << "Number of particles per batch:         " << num_particles_per_batch << std::endl;
             this->log_output << "Number of integration steps per batch: " << num_integration_steps_per_batch << std::endl;
-            this->log_output << std::endl;
 
             // Start computation initialization
             const std::chrono::time_point<clock_t> time_start_total = clock_t::now();
+
+            this->last_checkpoint = std::chrono::steady_clock::now();
+            this->num_cycles_since_checkpoint = 0;
+            this->time_checkpoint_wait = std::chrono::steady_clock::duration::zero();
+
+            const auto time_budget_start = std::chrono::steady_clock::now();
+            bool time_budget_exhausted = false;
+
+            auto check_time_budget = [&]()
+            {
+                if (run_control.time_budget.count() > 0 && !this->terminate_computation &&
+                    std::chrono::steady_clock::now() - time_budget_start >= run_control.time_budget)
+                {
+                    this->log_output << "Time budget exhausted, stopping computation." << std::endl;
+
+                    this->terminate_computation = time_budget_exhausted = true;
+                }
+            };
             const std::chrono::time_point<clock_t> time_start_initialization = clock_t::now();
 
-            streamlines_cuda streamlines(this->resolution, this->domain, this->vectors, this->points, this->point_ids,
-                this->lines, this->line_ids, this->integration_timestep, this->max_integration_error, this->method);
+            const auto time_queued = std::chrono::steady_clock::now() - this->time_start_requested;
+
+            // Size of all particle data, and its high-water mark
+            std::size_t peak_data_size = 0;
+
+            auto get_data_size = [this, &peak_data_size](const std::size_t num_additional_particles)
+            {
+                const std::size_t data_size = sizeof(float) * (this->positions_forward.read().size() + this->positions_backward.read().size()
+                    + this->labels_forward.read().size() + this->labels_backward.read().size() + this->distances_forward.read().size()
+                    + this->distances_backward.read().size() + this->terminations_forward.read().size() + this->terminations_backward.read().size()
+                    + 2 * 5 * num_additional_particles);
+
+                peak_data_size = std::max(peak_data_size, data_size);
+
+                return data_size;
+            };
+
+            // Create stream line integrator on the selected backend, falling back to the CPU if CUDA is not available
+            std::unique_ptr<streamlines_cpu> streamlines_host;
+#ifdef FLOWVIS_USE_CUDA
+            std::unique_ptr<streamlines_cuda> streamlines_device;
+
+            if (backend == backend_t::CUDA)
+            {
+                streamlines_device = std::make_unique<streamlines_cuda>(this->resolution, this->domain, this->vectors, this->points, this->point_ids,
+                    this->lines, this->line_ids, this->integration_timestep, this->max_integration_error, this->method);
+            }
+            else
+#else
+            if (backend == backend_t::CUDA)
+            {
+                this->log_output << "CUDA is not available, falling back to the CPU." << std::endl;
+            }
+#endif
+            {
+                streamlines_host = std::make_unique<streamlines_cpu>(this->resolution, this->domain, this->vectors, this->points, this->point_ids,
+                    this->lines, this->line_ids, this->integration_timestep, this->max_integration_error, this->method);
+            }
+
+            this->log_output << "Integration backend:                   " << (streamlines_host != nullptr ? "CPU" : "CUDA") << std::endl;
+            this->log_output << std::endl;
+
+            this->telemetry_output.record("start")
+                .add("backend", streamlines_host != nullptr ? "CPU" : "CUDA")
+                .add("num_particles", this->labels_forward.read().size())
+                .add("num_integration_steps", num_integration_steps)
+                .add("num_integration_steps_performed", this->num_integration_steps_performed)
+                .add("num_particles_per_batch", num_particles_per_batch)
+                .add("num_integration_steps_per_batch", num_integration_steps_per_batch)
+                .add("queue_ms", telemetry::milliseconds(time_queued))
+                .add("initialization_ms", telemetry::milliseconds(clock_t::now() - time_start_initialization));
+
+            auto update_labels = [&](std::vector<float>& source, std::vector<float>& labels, std::vector<float>& distances,
+                std::vector<float>& terminations, const int num_steps, const float sign, const unsigned int num_particles)
+            {
+#ifdef FLOWVIS_USE_CUDA
+                if (streamlines_device != nullptr)
+                {
+                    streamlines_device->update_labels(source, labels, distances, terminations, num_steps, sign, num_particles);
+                    return;
+                }
+#endif
+                streamlines_host->update_labels(source, labels, distances, terminations, num_steps, sign, num_particles);
+            };
+
+            // Compacted arrays of active particles, reused between batches
+            std::vector<float> active_positions, active_labels, active_distances, active_terminations;
+
+            auto update_active_labels = [&](std::vector<float>& source, std::vector<float>& labels, std::vector<float>& distances,
+                std::vector<float>& terminations, std::vector<std::size_t>& active, const int num_steps, const float sign, const unsigned int num_particles)
+            {
+                if (active.empty())
+                {
+                    return;
+                }
+
+                const long long num_active = static_cast<long long>(active.size());
+
+                active_positions.resize(2 * active.size());
+                active_labels.resize(active.size());
+                active_distances.resize(active.size());
+                active_terminations.resize(active.size());
+
+                // Gather active particles
+                #pragma omp parallel for
+                for (long long i = 0; i < num_active; ++i)
+                {
+                    const auto index = active[i];
+
+                    active_positions[i * 2 + 0] = source[index * 2 + 0];
+                    active_positions[i * 2 + 1] = source[index * 2 + 1];
+                    active_labels[i] = labels[index];
+                    active_distances[i] = distances[index];
+                    active_terminations[i] = terminations[index];
+                }
+
+                update_labels(active_positions, active_labels, active_distances, active_terminations, num_steps, sign, num_particles);
+
+                // Scatter results back
+                #pragma omp parallel for
+                for (long long i = 0; i < num_active; ++i)
+                {
+                    const auto index = active[i];
+
+                    source[index * 2 + 0] = active_positions[i * 2 + 0];
+                    source[index * 2 + 1] = active_positions[i * 2 + 1];
+                    labels[index] = active_labels[i];
+                    distances[index] = active_distances[i];
+                    terminations[index] = active_terminations[i];
+                }
+
+                // Remove particles that have been terminated in this batch
+                std::size_t num_remaining = 0;
+
+                for (std::size_t i = 0; i < active.size(); ++i)
+                {
+                    if (active_terminations[i] == 0.0f)
+                    {
+                        active[num_remaining++] = active[i];
+                    }
+                }
+
+                active.resize(num_remaining);
+            };
+
+            auto get_active = [](const std::vector<float>& terminations)
+            {
+                std::vector<std::size_t> active;
+                active.reserve(terminations.size());
+
+                for (std::size_t i = 0; i < terminations.size(); ++i)
+                {
+                    if (terminations[i] == 0.0f)
+                    {
+                        active.push_back(i);
+                    }
+                }
+
+                return active;
+            };
+
+            auto record_batch = [this](const char* phase, const unsigned int cycle, const unsigned int num_steps,
+                const std::size_t num_active_forward, const std::size_t num_active_backward,
+                const std::size_t num_remaining_forward, const std::size_t num_remaining_backward,
+                const clock_t::duration time_batch, const clock_t::duration time_publish, const std::size_t data_size)
+            {
+                const auto num_active = num_active_forward + num_active_backward;
+
+                this->telemetry_output.record("batch")
+                    .add("phase", phase)
+                    .add("cycle", cycle)
+                    .add("num_steps", num_steps)
+                    .add("active_forward", num_active_forward)
+                    .add("active_backward", num_active_backward)
+                    .add("terminated_forward", num_active_forward - num_remaining_forward)
+                    .add("terminated_backward", num_active_backward - num_remaining_backward)
+                    .add("integration_ms", telemetry::milliseconds(time_batch))
+                    .add("particles_per_second", telemetry::per_second(static_cast<double>(num_active), time_batch))
+                    .add("particle_steps_per_second", telemetry::per_second(static_cast<double>(num_active) * num_steps, time_batch))
+                    .add("publish_ms", telemetry::milliseconds(time_publish))
+                    .add("checkpoint_wait_ms", telemetry::milliseconds(this->time_checkpoint_wait))
+                    .add("data_bytes", data_size)
+                    .add("peak_memory_bytes", telemetry::peak_memory());
+
+                this->time_checkpoint_wait = std::chrono::steady_clock::duration::zero();
+            };
 
             this->performance_output << "Initialization:;" << std::chrono::duration_cast<duration_t>(clock_t::now() - time_start_initialization).count() << std::endl << std::endl;
 
@@ -301,23 +554,60 @@ namespace megamol
             {
                 this->log_output << "Integrating stream lines..." << std::endl;
 
+                // Only integrate particles which have not been terminated yet
+                auto active_forward = get_active(this->terminations_forward.read());
+                auto active_backward = get_active(this->terminations_backward.read());
+
                 while (this->num_integration_steps_performed < num_integration_steps && !this->terminate_computation)
                 {
                     const unsigned int num_steps = std::min(num_integration_steps - this->num_integration_steps_performed, num_integration_steps_per_batch);
 
                     this->log_output << "Number of integration steps:           " << num_steps << "   "
                         << this->num_integration_steps_performed << " / " << num_integration_steps << std::endl;
+                    this->log_output << "Number of active particles:            " << active_forward.size() << " / "
+                        << active_backward.size() << std::endl;
 
-                    streamlines.update_labels(this->positions_forward, this->labels_forward, this->distances_forward, this->terminations_forward,
-                        num_steps, 1.0f, num_particles_per_batch);
+                    const auto num_active_forward = active_forward.size();
+                    const auto num_active_backward = active_backward.size();
 
-                    streamlines.update_labels(this->positions_backward, this->labels_backward, this->distances_backward, this->terminations_backward,
-                        num_steps, -1.0f, num_particles_per_batch);
+                    const auto time_start_batch = clock_t::now();
+
+                    if (!active_forward.empty())
+                    {
+                        update_active_labels(this->positions_forward.modify(), this->labels_forward.modify(),
+                            this->distances_forward.modify(), this->terminations_forward.modify(),
+                            active_forward, num_steps, 1.0f, num_particles_per_batch);
+                    }
+
+                    if (!active_backward.empty())
+                    {
+                        update_active_labels(this->positions_backward.modify(), this->labels_backward.modify(),
+                            this->distances_backward.modify(), this->terminations_backward.modify(),
+                            active_backward, num_steps, -1.0f, num_particles_per_batch);
+                    }
 
                     this->num_integration_steps_performed += num_steps;
 
-                    // Set (intermediate) result, and prepare new one
-                    set_result(promise, this->terminate_computation);
+                    // Further integration does not change anything if all particles have been terminated
+                    if (active_forward.empty() && active_backward.empty())
+                    {
+                        this->num_integration_steps_performed = num_integration_steps;
+                    }
+
+                    const auto time_batch = clock_t::now() - time_start_batch;
+
+                    // Stop at this consistent state if the time budget is exhausted
+                    check_time_budget();
+
+                    // Set (intermediate) result, write checkpoint, and prepare new one
+                    const auto time_start_publish = clock_t::now();
+                    const auto result = set_result(promise, this->terminate_computation);
+                    const auto time_publish = clock_t::now() - time_start_publish;
+
+                    write_checkpoint(result, run_control, false, this->terminate_computation);
+
+                    record_batch("integration", 0, num_steps, num_active_forward, num_active_backward,
+                        active_forward.size(), active_backward.size(), time_batch, time_publish, get_data_size(0));
 
                     if (!this->terminate_computation)
                     {
@@ -333,7 +623,7 @@ namespace megamol
                 this->total_time = this->total_time_integration = std::chrono::duration_cast<duration_t>(clock_t::now() - time_start_integration);
 
                 this->performance_output << "-;";
-                this->performance_output << this->labels_forward.size() << ";";
+                this->performance_output << this->labels_forward.read().size() << ";";
                 this->performance_output << performance_num_integration_steps << ";";
                 this->performance_output << this->total_time_integration.count() << ";";
                 this->performance_output << this->total_time.count() << std::endl;
@@ -355,7 +645,16 @@ namespace megamol
             std::vector<float> new_terminations_forward;
             std::vector<float> new_terminations_backward;
 
+            std::vector<std::size_t> new_active_forward;
+            std::vector<std::size_t> new_active_backward;
+
             unsigned int num_refined_integration_steps = 0;
+            unsigned int refinement_cycle = 0;
+
+            unsigned int num_refined_steps_batch = 0;
+            std::size_t num_refined_active_forward = 0;
+            std::size_t num_refined_active_backward = 0;
+            clock_t::duration time_refined_batch = clock_t::duration::zero();
 
             duration_t time_refinement;
             std::chrono::time_point<clock_t> time_start_refined_integration;
@@ -381,12 +680,22 @@ namespace megamol
 
                     this->performance_num_particles_added += new_positions_forward.size() / 2;
 
+                    ++refinement_cycle;
+
+                    this->telemetry_output.record("refinement")
+                        .add("cycle", refinement_cycle)
+                        .add("refinement_ms", telemetry::milliseconds(time_refinement))
+                        .add("new_seeds", new_positions_forward.size() / 2)
+                        .add("num_points", this->labels_forward.read().size() + new_positions_forward.size() / 2)
+                        .add("data_bytes", get_data_size(new_positions_forward.size() / 2))
+                        .add("peak_memory_bytes", telemetry::peak_memory());
+
                     // Check if new points have been added; if not, the computation is finished
                     if (new_positions_forward.empty())
                     {
                         this->performance_output << "-;-;" << time_refinement.count() << std::endl;
 
-                        finished = true;
+                        finished = this->computation_complete = true;
                     }
                     else
                     {
@@ -410,6 +719,13 @@ namespace megamol
                         std::fill(new_terminations_forward.begin(), new_terminations_forward.end(), 0.0f);
                         std::fill(new_terminations_backward.begin(), new_terminations_backward.end(), 0.0f);
 
+                        // All new particles are active
+                        new_active_forward.resize(new_terminations_forward.size());
+                        new_active_backward.resize(new_terminations_backward.size());
+
+                        std::iota(new_active_forward.begin(), new_active_forward.end(), std::size_t(0));
+                        std::iota(new_active_backward.begin(), new_active_backward.end(), std::size_t(0));
+
                         finished_refined_integration = false;
 
                         num_refined_integration_steps = 0;
@@ -427,15 +743,31 @@ namespace megamol
 
                     this->log_output << "Number of integration steps:           " << num_steps << "   "
                                      << num_refined_integration_steps << " / " << num_integration_steps << std::endl;
+                    this->log_output << "Number of active particles:            " << new_active_forward.size() << " / "
+                                     << new_active_backward.size() << std::endl;
+
+                    num_refined_active_forward = new_active_forward.size();
+                    num_refined_active_backward = new_active_backward.size();
 
-                    streamlines.update_labels(new_positions_forward, new_labels_forward, new_distances_forward, new_terminations_forward,
-                        num_steps, 1.0f, num_particles_per_batch);
+                    const auto time_start_batch = clock_t::now();
 
-                    streamlines.update_labels(new_positions_backward, new_labels_backward, new_distances_backward, new_terminations_backward,
-                        num_steps, -1.0f, num_particles_per_batch);
+                    update_active_labels(new_positions_forward, new_labels_forward, new_distances_forward, new_terminations_forward,
+                        new_active_forward, num_steps, 1.0f, num_particles_per_batch);
+
+                    update_active_labels(new_positions_backward, new_labels_backward, new_distances_backward, new_terminations_backward,
+                        new_active_backward, num_steps, -1.0f, num_particles_per_batch);
 
                     num_refined_integration_steps += num_steps;
 
+                    num_refined_steps_batch = num_steps;
+                    time_refined_batch = clock_t::now() - time_start_batch;
+
+                    // Further integration does not change anything if all new particles have been terminated
+                    if (new_active_forward.empty() && new_active_backward.empty())
+                    {
+                        num_refined_integration_steps = num_integration_steps;
+                    }
+
                     // Check if all integration steps have been performed
                     if (num_refined_integration_steps >= num_integration_steps)
                     {
@@ -452,26 +784,50 @@ namespace megamol
                         this->performance_output << (time_refinement + time_integration).count() << std::endl;
 
                         // Merge positions and output arrays
-                        this->positions_forward.insert(this->positions_forward.end(), new_positions_forward.begin(), new_positions_forward.end());
-                        this->positions_backward.insert(this->positions_backward.end(), new_positions_backward.begin(), new_positions_backward.end());
+                        this->positions_forward.append(new_positions_forward.begin(), new_positions_forward.end());
+                        this->positions_backward.append(new_positions_backward.begin(), new_positions_backward.end());
 
-                        this->labels_forward.insert(this->labels_forward.end(), new_labels_forward.begin(), new_labels_forward.end());
-                        this->labels_backward.insert(this->labels_backward.end(), new_labels_backward.begin(), new_labels_backward.end());
+                        this->labels_forward.append(new_labels_forward.begin(), new_labels_forward.end());
+                        this->labels_backward.append(new_labels_backward.begin(), new_labels_backward.end());
 
-                        this->distances_forward.insert(this->distances_forward.end(), new_distances_forward.begin(), new_distances_forward.end());
-                        this->distances_backward.insert(this->distances_backward.end(), new_distances_backward.begin(), new_distances_backward.end());
+                        this->distances_forward.append(new_distances_forward.begin(), new_distances_forward.end());
+                        this->distances_backward.append(new_distances_backward.begin(), new_distances_backward.end());
 
-                        this->terminations_forward.insert(this->terminations_forward.end(), new_terminations_forward.begin(), new_terminations_forward.end());
-                        this->terminations_backward.insert(this->terminations_backward.end(), new_terminations_backward.begin(), new_terminations_backward.end());
+                        this->terminations_forward.append(new_terminations_forward.begin(), new_terminations_forward.end());
+                        this->terminations_backward.append(new_terminations_backward.begin(), new_terminations_backward.end());
 
                         finished_refined_integration = true;
                     }
                 }
 
-                // Set (intermediate) results
+                // Stop after a completed refinement cycle if the time budget is exhausted
+                if (finished_refined_integration)
+                {
+                    check_time_budget();
+                }
+
+                // Set (intermediate) results, and write checkpoint if they are consistent, i.e., not within a refinement cycle
+                auto time_publish = clock_t::duration::zero();
+
                 if (finished_refined_integration || finished || this->terminate_computation)
                 {
-                    set_result(promise, finished || this->terminate_computation);
+                    const auto time_start_publish = clock_t::now();
+                    const auto result = set_result(promise, finished || this->terminate_computation);
+                    time_publish = clock_t::now() - time_start_publish;
+
+                    if (finished_refined_integration)
+                    {
+                        write_checkpoint(result, run_control, !finished, finished || this->terminate_computation);
+                    }
+                }
+
+                if (num_refined_steps_batch != 0)
+                {
+                    record_batch("refinement_integration", refinement_cycle, num_refined_steps_batch, num_refined_active_forward,
+                        num_refined_active_backward, new_active_forward.size(), new_active_backward.size(), time_refined_batch, time_publish,
+                        get_data_size(finished_refined_integration ? 0 : new_labels_forward.size()));
+
+                    num_refined_steps_batch = 0;
                 }
 
                 // Prepare new results
@@ -489,33 +845,150 @@ namespace megamol
             this->total_runtime = std::chrono::duration_cast<duration_t>(clock_t::now() - time_start_total);
 
             print_performance(num_integration_steps);
+
+            this->telemetry_output.record("finish")
+                .add("terminated", this->terminate_computation)
+                .add("time_budget_exhausted", time_budget_exhausted)
+                .add("num_points", this->labels_forward.read().size())
+                .add("num_integration_steps_performed", this->num_integration_steps_performed)
+                .add("refinement_cycles", refinement_cycle)
+                .add("integration_ms", telemetry::milliseconds(this->total_time_integration))
+                .add("refinement_ms", telemetry::milliseconds(this->total_time_refinement))
+                .add("runtime_ms", telemetry::milliseconds(this->total_runtime))
+                .add("peak_data_bytes", peak_data_size)
+                .add("peak_memory_bytes", telemetry::peak_memory());
+
+            // Allow the computation to be continued after it was stopped due to the time budget
+            if (time_budget_exhausted)
+            {
+                this->terminate_computation = false;
+            }
         }
 
-        void implicit_topology_computation::set_result(std::promise<implicit_topology_results>& promise, const bool finished)
+        implicit_topology_results implicit_topology_computation::set_result(std::promise<implicit_topology_results>& promise, const bool finished)
         {
             implicit_topology_results current_result;
 
             auto mesh = this->delaunay.export_grid();
-            current_result.vertices = mesh.first;
-            current_result.indices = mesh.second;
-
-            current_result.positions_forward = std::make_shared<std::vector<float>>(this->positions_forward);
-            current_result.labels_forward = std::make_shared<std::vector<float>>(this->labels_forward);
-            current_result.distances_forward = std::make_shared<std::vector<float>>(this->distances_forward);
-            current_result.terminations_forward = std::make_shared<std::vector<float>>(this->terminations_forward);
-
-            current_result.positions_backward = std::make_shared<std::vector<float>>(this->positions_backward);
-            current_result.labels_backward = std::make_shared<std::vector<float>>(this->labels_backward);
-            current_result.distances_backward = std::make_shared<std::vector<float>>(this->distances_backward);
-            current_result.terminations_backward = std::make_shared<std::vector<float>>(this->terminations_backward);
+            current_result.vertices = mesh.vertices;
+            current_result.indices = mesh.indices;
+            current_result.first_new_vertex = mesh.first_new_vertex;
+            current_result.changed_cells = mesh.changed_cells;
+            current_result.mesh_revision = mesh.revision;
+
+            current_result.positions_forward = this->positions_forward.publish();
+            current_result.labels_forward = this->labels_forward.publish();
+            current_result.distances_forward = this->distances_forward.publish();
+            current_result.terminations_forward = this->terminations_forward.publish();
+
+            current_result.positions_backward = this->positions_backward.publish();
+            current_result.labels_backward = this->labels_backward.publish();
+            current_result.distances_backward = this->distances_backward.publish();
+            current_result.terminations_backward = this->terminations_backward.publish();
 
             current_result.computation_state.finished = finished;
 
+            current_result.computation_state.method = this->method;
             current_result.computation_state.integration_timestep = this->integration_timestep;
             current_result.computation_state.max_integration_error = this->max_integration_error;
             current_result.computation_state.num_integration_steps = this->num_integration_steps_performed;
+            current_result.computation_state.resolution = this->resolution;
+            current_result.computation_state.domain = this->domain;
+            current_result.computation_state.input_hash = this->input_hash;
 
-            promise.set_value(std::move(current_result));
+            promise.set_value(current_result);
+
+            return current_result;
+        }
+
+        void implicit_topology_computation::write_checkpoint(const implicit_topology_results& result, const run_control_t& run_control,
+            const bool refinement_cycle, const bool force)
+        {
+            if (run_control.checkpoint_path.empty())
+            {
+                return;
+            }
+
+            if (refinement_cycle)
+            {
+                ++this->num_cycles_since_checkpoint;
+            }
+
+            const bool due_by_cycles = run_control.checkpoint_cycles != 0 && this->num_cycles_since_checkpoint >= run_control.checkpoint_cycles;
+            const bool due_by_time = run_control.checkpoint_interval.count() != 0 &&
+                std::chrono::steady_clock::now() - this->last_checkpoint >= run_control.checkpoint_interval;
+
+            if (!(force || due_by_cycles || due_by_time))
+            {
+                return;
+            }
+
+            // Wait for previous checkpoint
+            const auto time_start_wait = std::chrono::steady_clock::now();
+
+            if (this->checkpoint_writer.valid())
+            {
+                try
+                {
+                    this->checkpoint_writer.get();
+                }
+                catch (const std::exception& e)
+                {
+                    this->log_output << "Unable to write checkpoint: " << e.what() << std::endl;
+                }
+            }
+
+            const auto time_wait = std::chrono::steady_clock::now() - time_start_wait;
+
+            this->time_checkpoint_wait += time_wait;
+
+            this->telemetry_output.record("checkpoint")
+                .add("num_integration_steps", result.computation_state.num_integration_steps)
+                .add("num_points", result.vertices->size() / 2)
+                .add("forced", force)
+                .add("wait_ms", telemetry::milliseconds(time_wait));
+
+            this->log_output << "Writing checkpoint after " << result.computation_state.num_integration_steps << " integration steps and "
+                << (result.vertices->size() / 2) << " points..." << std::endl;
+
+            // Only mark the checkpoint as finished if the computation is complete, not if it was merely stopped
+            implicit_topology_results checkpoint = result;
+            checkpoint.computation_state.finished = this->computation_complete;
+
+            // Write in the background to a temporary file, which replaces the previous checkpoint when complete;
+            // the published results are not modified anymore, and can thus be safely accessed
+            this->checkpoint_writer = std::async(std::launch::async, [checkpoint](const std::string path)
+            {
+                const std::string temporary_path = path + ".tmp";
+
+                implicit_topology_file::write(temporary_path, checkpoint, implicit_topology_file::compression_t::shuffle_deflate);
+
+                std::remove(path.c_str());
+
+                if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+                {
+                    throw std::runtime_error("Unable to rename '" + temporary_path + "' to '" + path + "'");
+                }
+            }, run_control.checkpoint_path);
+
+            this->last_checkpoint = std::chrono::steady_clock::now();
+            this->num_cycles_since_checkpoint = 0;
+
+            if (force)
+            {
+                const auto time_start_final_wait = std::chrono::steady_clock::now();
+
+                try
+                {
+                    this->checkpoint_writer.get();
+                }
+                catch (const std::exception& e)
+                {
+                    this->log_output << "Unable to write checkpoint: " << e.what() << std::endl;
+                }
+
+                this->time_checkpoint_wait += std::chrono::steady_clock::now() - time_start_final_wait;
+            }
         }
 
         std::vector<float> implicit_topology_computation::refine_grid(const float refinement_threshold,
@@ -523,41 +996,71 @@ namespace megamol
         {
             this->log_output << "Refining grid..." << std::endl;
 
-            // Find and mark points where the edges should be refined
-            std::unordered_set<std::size_t> marked_points;
+            // Gather vertex indices of all cells and vertex positions for parallel access
+            const std::size_t num_vertices = this->delaunay.delaunay.number_of_vertices();
 
-            std::size_t num_points_by_label = 0;
-            std::size_t num_points_by_distance = 0;
+            std::vector<std::size_t> cells;
+            cells.reserve(this->delaunay.get_number_of_cells() * 3);
 
             for (auto cell_it = this->delaunay.get_finite_cells_begin(); cell_it != this->delaunay.get_finite_cells_end(); ++cell_it)
+            {
+                cells.push_back(cell_it->vertex(0)->info());
+                cells.push_back(cell_it->vertex(1)->info());
+                cells.push_back(cell_it->vertex(2)->info());
+            }
+
+            std::vector<triangulation::point_t> vertices(num_vertices);
+
+            for (auto vertex_it = this->delaunay.delaunay.finite_vertices_begin(); vertex_it != this->delaunay.delaunay.finite_vertices_end(); ++vertex_it)
+            {
+                vertices[vertex_it->info()] = vertex_it->point();
+            }
+
+            const long long num_cells = static_cast<long long>(cells.size() / 3);
+
+            // Find and mark points where the edges should be refined
+            const auto& labels_forward = this->labels_forward.read();
+            const auto& labels_backward = this->labels_backward.read();
+
+            const auto& distances_forward = this->distances_forward.read();
+            const auto& distances_backward = this->distances_backward.read();
+
+            const auto& terminations_forward = this->terminations_forward.read();
+            const auto& terminations_backward = this->terminations_backward.read();
+
+            std::vector<std::atomic<bool>> marked_points(num_vertices);
+
+            long long num_points_by_label = 0;
+            long long num_points_by_distance = 0;
+
+            #pragma omp parallel for reduction(+ : num_points_by_label, num_points_by_distance)
+            for (long long cell_index = 0; cell_index < num_cells; ++cell_index)
             {
                 for (int pi = 0; pi < 2; ++pi)
                 {
-                    const auto vertex_i = cell_it->vertex(pi);
-                    const auto point_i = vertex_i->info();
+                    const auto point_i = cells[cell_index * 3 + pi];
 
-                    const auto label_forward_i = this->labels_forward[point_i];
-                    const auto label_backward_i = this->labels_backward[point_i];
+                    const auto label_forward_i = labels_forward[point_i];
+                    const auto label_backward_i = labels_backward[point_i];
 
-                    const auto distance_forward_i = this->distances_forward[point_i];
-                    const auto distance_backward_i = this->distances_backward[point_i];
+                    const auto distance_forward_i = distances_forward[point_i];
+                    const auto distance_backward_i = distances_backward[point_i];
 
-                    const auto termination_forward_i = this->terminations_forward[point_i];
-                    const auto termination_backward_i = this->terminations_backward[point_i];
+                    const auto termination_forward_i = terminations_forward[point_i];
+                    const auto termination_backward_i = terminations_backward[point_i];
 
                     for (int pj = pi + 1; pj < 3; ++pj)
                     {
-                        const auto vertex_j = cell_it->vertex(pj);
-                        const auto point_j = vertex_j->info();
+                        const auto point_j = cells[cell_index * 3 + pj];
 
-                        const auto label_forward_j = this->labels_forward[point_j];
-                        const auto label_backward_j = this->labels_backward[point_j];
+                        const auto label_forward_j = labels_forward[point_j];
+                        const auto label_backward_j = labels_backward[point_j];
 
-                        const auto distance_forward_j = this->distances_forward[point_j];
-                        const auto distance_backward_j = this->distances_backward[point_j];
+                        const auto distance_forward_j = distances_forward[point_j];
+                        const auto distance_backward_j = distances_backward[point_j];
 
-                        const auto termination_forward_j = this->terminations_forward[point_j];
-                        const auto termination_backward_j = this->terminations_backward[point_j];
+                        const auto termination_forward_j = terminations_forward[point_j];
+                        const auto termination_backward_j = terminations_backward[point_j];
 
                         if (termination_forward_i == 0 || termination_backward_i == 0 || termination_forward_j == 0 || termination_backward_j == 0)
                         {
@@ -565,65 +1068,72 @@ namespace megamol
                             {
                                 ++num_points_by_label;
 
-                                marked_points.insert(point_i);
-                                marked_points.insert(point_j);
+                                marked_points[point_i].store(true, std::memory_order_relaxed);
+                                marked_points[point_j].store(true, std::memory_order_relaxed);
                             }
                             else if (std::abs(distance_forward_i - distance_forward_j) > distance_difference_threshold
                                 || std::abs(distance_backward_i - distance_backward_j) > distance_difference_threshold)
                             {
                                 ++num_points_by_distance;
 
-                                marked_points.insert(point_i);
-                                marked_points.insert(point_j);
+                                marked_points[point_i].store(true, std::memory_order_relaxed);
+                                marked_points[point_j].store(true, std::memory_order_relaxed);
                             }
                         }
                     }
                 }
             }
 
-            this->log_output << "Marked points:                         " << marked_points.size() << std::endl;
+            const auto num_marked_points = std::count_if(marked_points.begin(), marked_points.end(),
+                [](const std::atomic<bool>& marked) { return marked.load(std::memory_order_relaxed); });
+
+            this->log_output << "Marked points:                         " << num_marked_points << std::endl;
             this->log_output << "Marked points by label:                " << num_points_by_label << std::endl;
             this->log_output << "Marked points by distance difference:  " << num_points_by_distance << std::endl;
 
-            // Refine edges connected to marked points if they are not too short already
-            std::deque<std::pair<triangulation::point_t, std::size_t>> new_points;
-            std::size_t point_index = this->delaunay.delaunay.number_of_vertices();
-
-            auto edge_hash = [](const std::pair<std::size_t, std::size_t>& edge) { return std::hash<std::size_t>()(edge.first) ^ std::hash<std::size_t>()(edge.second); };
+            // Collect edges connected to marked points, encoded as pair of sorted vertex indices;
+            // each cell writes to its own slots, and unmarked edges are removed afterwards
+            constexpr auto no_edge = std::numeric_limits<std::uint64_t>::max();
 
-            std::unordered_set<std::pair<std::size_t, std::size_t>, decltype(edge_hash)> edges(199, edge_hash);
-            std::vector<triangulation::point_t> vertices(this->delaunay.delaunay.number_of_vertices());
+            std::vector<std::uint64_t> edges(cells.size(), no_edge);
 
-            for (auto cell_it = this->delaunay.get_finite_cells_begin(); cell_it != this->delaunay.get_finite_cells_end(); ++cell_it)
+            #pragma omp parallel for
+            for (long long cell_index = 0; cell_index < num_cells; ++cell_index)
             {
-                for (int pi = 0; pi < 2; ++pi)
+                for (int pi = 0, edge_index = 0; pi < 2; ++pi)
                 {
-                    const auto point_i = static_cast<std::size_t>(cell_it->vertex(pi)->info());
+                    const auto point_i = cells[cell_index * 3 + pi];
 
-                    for (int pj = pi + 1; pj < 3; ++pj)
+                    for (int pj = pi + 1; pj < 3; ++pj, ++edge_index)
                     {
-                        const auto point_j = static_cast<std::size_t>(cell_it->vertex(pj)->info());
+                        const auto point_j = cells[cell_index * 3 + pj];
 
-                        if (marked_points.find(point_i) != marked_points.end() || marked_points.find(point_j) != marked_points.end())
+                        if (marked_points[point_i].load(std::memory_order_relaxed) || marked_points[point_j].load(std::memory_order_relaxed))
                         {
-                            vertices[point_i] = cell_it->vertex(pi)->point();
-                            vertices[point_j] = cell_it->vertex(pj)->point();
-
-                            const auto e = std::make_pair(std::min(point_i, point_j), std::max(point_i, point_j));
-                            edges.insert(e);
+                            edges[cell_index * 3 + edge_index] = (static_cast<std::uint64_t>(std::min(point_i, point_j)) << 32)
+                                | static_cast<std::uint64_t>(std::max(point_i, point_j));
                         }
                     }
                 }
             }
 
+            edges.erase(std::remove(edges.begin(), edges.end(), no_edge), edges.end());
+
+            // Remove duplicates of edges shared by neighboring cells
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
             this->log_output << "Marked edges:                          " << edges.size() << std::endl;
 
+            // Refine edges if they are not too short already
+            std::vector<triangulation::point_t> new_points;
+
             const auto refinement_threshold_squared = refinement_threshold * refinement_threshold;
 
             for (const auto& edge : edges)
             {
-                const auto point_i = edge.first;
-                const auto point_j = edge.second;
+                const auto point_i = static_cast<std::size_t>(edge >> 32);
+                const auto point_j = static_cast<std::size_t>(edge & 0xFFFFFFFFull);
 
                 const auto edge_point_0 = vertices[point_i];
                 const auto edge_point_1 = vertices[point_j];
@@ -633,16 +1143,11 @@ namespace megamol
 
                 if (edge_length_squared > refinement_threshold_squared)
                 {
-                    const auto mid_point = edge_point_1 + 0.5 * sub;
-
-                    new_points.push_back(std::make_pair(mid_point, point_index++));
+                    new_points.push_back(edge_point_1 + 0.5 * sub);
                 }
             }
 
-            if (new_points.size() != 0)
-            {
-                this->delaunay.delaunay.insert(new_points.begin(), new_points.end());
-            }
+            this->delaunay.insert_points(new_points);
 
             this->log_output << "New points:                            " << new_points.size() << std::endl;
             this->log_output << "Refinement finished!" << std::endl;
@@ -653,10 +1158,10 @@ namespace megamol
             new_points_gl.reserve(new_points.size());
 
             std::for_each(new_points.begin(), new_points.end(),
-                [&new_points_gl](const std::pair<triangulation::point_t, std::size_t>& value)
+                [&new_points_gl](const triangulation::point_t& value)
             {
-                new_points_gl.push_back(static_cast<float>(CGAL::to_double(value.first[0])));
-                new_points_gl.push_back(static_cast<float>(CGAL::to_double(value.first[1])));
+                new_points_gl.push_back(static_cast<float>(CGAL::to_double(value[0])));
+                new_points_gl.push_back(static_cast<float>(CGAL::to_double(value[1])));
             });
 
             return new_points_gl;
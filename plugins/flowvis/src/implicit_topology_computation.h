@@ -6,16 +6,21 @@
  */
 #pragma once
 
+#include "double_buffer.h"
 #include "implicit_topology_results.h"
+#include "streamlines_cpu.h"
+#include "telemetry.h"
 #include "triangulation.h"
 
 #include "../cuda/streamlines.h"
 
 #include <array>
 #include <chrono>
+#include <cstdint>
 #include <future>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -34,12 +39,40 @@ namespace megamol
         class implicit_topology_computation
         {
         public:
+            /**
+            * Backends for stream line integration
+            */
+            enum class backend_t
+            {
+                CPU,
+                CUDA
+            };
+
+            /**
+            * Settings for automatic checkpoints and limitation of the run time
+            */
+            struct run_control_t
+            {
+                /** Checkpoint file; empty for no checkpoints */
+                std::string checkpoint_path;
+
+                /** Write checkpoint after this number of refinement cycles (0: never) */
+                unsigned int checkpoint_cycles;
+
+                /** Write checkpoint after this time has passed since the last checkpoint (0: never) */
+                std::chrono::seconds checkpoint_interval;
+
+                /** Stop computation after this time (0: unlimited) */
+                std::chrono::seconds time_budget;
+            };
+
             /**
             * Initialize computation by providing seed positions and corresponding vectors, convergence structures,
             * and the initial delaunay triangulation of the domain.
             *
             * @param log_stream                         Stream in which to write output
             * @param performance_stream                 Stream in which to write the performance in CSV format
+            * @param telemetry_stream                   Stream in which to write detailed performance measurements in JSON lines format
             * @param resolution                         Domain resolution (number of vectors per direction)
             * @param domain                             Domain size (minimum and maximum coordinates)
             * @param positions                          Positions of the vectors, also used as initial seed
@@ -52,7 +85,7 @@ namespace megamol
             * @param max_integration_error              Maximum integration error
             * @param method                             Integration method
             */
-            implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream,
+            implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream, std::ostream& telemetry_stream,
                 std::array<unsigned int, 2> resolution, std::array<float, 4> domain,
                 std::vector<float> positions, std::vector<float> vectors, std::vector<float> points,
                 std::vector<int> point_ids, std::vector<float> lines, std::vector<int> line_ids,
@@ -65,6 +98,7 @@ namespace megamol
             *
             * @param log_stream                         Stream in which to write output
             * @param performance_stream                 Stream in which to write the performance in CSV format
+            * @param telemetry_stream                   Stream in which to write detailed performance measurements in JSON lines format
             * @param resolution                         Domain resolution (number of vectors per direction)
             * @param domain                             Domain size (minimum and maximum coordinates)
             * @param positions                          Positions of the vectors, also used as initial seed
@@ -75,7 +109,7 @@ namespace megamol
             * @param line_ids                           (Unique) IDs (or labels) of the given lines
             * @param previous_result                    Previous results, used as initialization for restarting
             */
-            implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream,
+            implicit_topology_computation(std::ostream& log_stream, std::ostream& performance_stream, std::ostream& telemetry_stream,
                 std::array<unsigned int, 2> resolution, std::array<float, 4> domain,
                 std::vector<float> positions, std::vector<float> vectors, std::vector<float> points,
                 std::vector<int> point_ids, std::vector<float> lines, std::vector<int> line_ids,
@@ -95,9 +129,12 @@ namespace megamol
             * @param distance_difference_threshold      Refine when distance difference between neighboring nodes exceed the threshold
             * @param num_particles_per_batch            Number of particles processed and uploaded to the GPU per batch
             * @param num_integration_steps_per_batch    Number of integration steps per batch, after which a new (intermediate) result can be extracted
+            * @param backend                            Backend used for stream line integration; falls back to the CPU if CUDA is not available
+            * @param run_control                        Settings for checkpoints and the time budget
             */
             void start(unsigned int num_integration_steps, float refinement_threshold, bool refine_at_labels,
-                float distance_difference_threshold, unsigned int num_particles_per_batch, unsigned int num_integration_steps_per_batch);
+                float distance_difference_threshold, unsigned int num_particles_per_batch, unsigned int num_integration_steps_per_batch,
+                backend_t backend, run_control_t run_control);
 
             /**
             * Terminate current computation as soon as possible.
@@ -111,6 +148,20 @@ namespace megamol
             */
             std::shared_future<implicit_topology_results> get_results() const;
 
+            /**
+            * Compute a hash of the input, identifying the input results were computed for
+            *
+            * @param vectors                            Vectors of the vector field
+            * @param points                             Convergence structure points
+            * @param point_ids                          Unique IDs (or labels) of the given points
+            * @param lines                              Convergence structure lines
+            * @param line_ids                           (Unique) IDs (or labels) of the given lines
+            *
+            * @return Hash of the input
+            */
+            static std::uint64_t hash_input(const std::vector<float>& vectors, const std::vector<float>& points,
+                const std::vector<int>& point_ids, const std::vector<float>& lines, const std::vector<int>& line_ids);
+
         private:
             /**
             * Main algorithm.
@@ -122,18 +173,32 @@ namespace megamol
             * @param distance_difference_threshold      Refine when distance difference between neighboring nodes exceed the threshold
             * @param num_particles_per_batch            Number of particles processed and uploaded to the GPU per batch
             * @param num_integration_steps_per_batch    Number of integration steps per batch, after which a new (intermediate) result can be extracted
+            * @param backend                            Backend used for stream line integration
+            * @param run_control                        Settings for checkpoints and the time budget
             */
             void run(std::promise<implicit_topology_results>&& promise, unsigned int num_integration_steps, float refinement_threshold,
                 bool refine_at_labels, float distance_difference_threshold, unsigned int num_particles_per_batch,
-                unsigned int num_integration_steps_per_batch);
+                unsigned int num_integration_steps_per_batch, backend_t backend, run_control_t run_control);
 
             /**
             * Set current results.
             *
             * @param promise    Promise containing future results
             * @param finished   Set finished flag of the results accordingly
+            *
+            * @return Results, sharing their data with the promised ones
+            */
+            implicit_topology_results set_result(std::promise<implicit_topology_results>& promise, bool finished);
+
+            /**
+            * Write checkpoint in the background if one is due, waiting for the previous one to be finished.
+            *
+            * @param result                             Consistent results to write
+            * @param run_control                        Settings for checkpoints
+            * @param refinement_cycle                   Results were obtained at the end of a refinement cycle
+            * @param force                              Write checkpoint regardless of the interval, and wait for it to be finished
             */
-            void set_result(std::promise<implicit_topology_results>& promise, bool finished);
+            void write_checkpoint(const implicit_topology_results& result, const run_control_t& run_control, bool refinement_cycle, bool force);
 
             /**
             * Refine the grid around nodes and edges which satisfy the refinement criteria defined by the parameters.
@@ -168,6 +233,9 @@ namespace megamol
             const std::vector<int> point_ids;
             const std::vector<int> line_ids;
 
+            /** Hash of the input, stored with the results for validating checkpoints */
+            const std::uint64_t input_hash;
+
             /** Input timestep information */
             const float integration_timestep;
             const float max_integration_error;
@@ -175,22 +243,25 @@ namespace megamol
             /** Integration method */
             streamlines_cuda::integration_method method;
 
-            /** Output positions */
-            std::vector<float> positions_forward;
-            std::vector<float> positions_backward;
+            /** Output positions, double-buffered for publishing results without copying */
+            double_buffer<float> positions_forward;
+            double_buffer<float> positions_backward;
 
             /** Output labels, distances, and reasons for termination for forward, and backward integration */
-            std::vector<float> labels_forward;
-            std::vector<float> distances_forward;
-            std::vector<float> terminations_forward;
+            double_buffer<float> labels_forward;
+            double_buffer<float> distances_forward;
+            double_buffer<float> terminations_forward;
 
-            std::vector<float> labels_backward;
-            std::vector<float> distances_backward;
-            std::vector<float> terminations_backward;
+            double_buffer<float> labels_backward;
+            double_buffer<float> distances_backward;
+            double_buffer<float> terminations_backward;
 
             /** Number of integration steps performed */
             unsigned int num_integration_steps_performed;
 
+            /** Indicator for the refinement having converged, i.e., the computation being complete */
+            bool computation_complete;
+
             /** Delaunay triangulation for computing a triangle mesh for refinement */
             triangulation delaunay;
 
@@ -201,6 +272,17 @@ namespace megamol
             /** Current results */
             std::shared_future<implicit_topology_results> current_result;
 
+            /** Checkpoint state */
+            std::future<void> checkpoint_writer;
+            std::chrono::steady_clock::time_point last_checkpoint;
+            unsigned int num_cycles_since_checkpoint;
+
+            /** Time spent waiting for checkpoints since the last recorded batch */
+            std::chrono::steady_clock::duration time_checkpoint_wait;
+
+            /** Time at which the computation was requested to start */
+            std::chrono::steady_clock::time_point time_start_requested;
+
             /** Performance */
             std::size_t performance_num_particles_added;
 
@@ -216,6 +298,9 @@ namespace megamol
             /** Performance output */
             std::ostream& log_output;
             std::ostream& performance_output;
+
+            /** Detailed performance output */
+            telemetry telemetry_output;
         };
     }
 }
@@ -0,0 +1,514 @@
+#include "stdafx.h"
+#include "implicit_topology_file.h"
+
+#include "implicit_topology_results.h"
+
+#include "mmcore/utility/MappedFile.h"
+
+#include "vislib/String.h"
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        constexpr char implicit_topology_file::magic[4];
+        constexpr std::uint32_t implicit_topology_file::version;
+        constexpr std::uint64_t implicit_topology_file::chunk_elements;
+        constexpr implicit_topology_file::selection_t implicit_topology_file::select_all;
+
+        namespace
+        {
+            /**
+            * Map file into memory
+            *
+            * @param filename   Path to the file
+            * @param file       Mapping
+            *
+            * @throws std::runtime_error if the file cannot be opened or mapped
+            */
+            void map_file(const std::string& filename, core::utility::MappedFile& file)
+            {
+                if (!file.Open(vislib::TString(filename.c_str())))
+                {
+                    throw std::runtime_error("Unable to map file '" + filename + "' into memory");
+                }
+            }
+
+            /**
+            * Get the floating point results array with the given ID
+            */
+            template <typename results_t>
+            auto get_float_array(results_t& content, const implicit_topology_file::array_t id) -> decltype((content.vertices))
+            {
+                switch (id)
+                {
+                case implicit_topology_file::array_t::vertices: return content.vertices;
+                case implicit_topology_file::array_t::positions_forward: return content.positions_forward;
+                case implicit_topology_file::array_t::positions_backward: return content.positions_backward;
+                case implicit_topology_file::array_t::labels_forward: return content.labels_forward;
+                case implicit_topology_file::array_t::labels_backward: return content.labels_backward;
+                case implicit_topology_file::array_t::distances_forward: return content.distances_forward;
+                case implicit_topology_file::array_t::distances_backward: return content.distances_backward;
+                case implicit_topology_file::array_t::terminations_forward: return content.terminations_forward;
+                case implicit_topology_file::array_t::terminations_backward: return content.terminations_backward;
+                default: throw std::runtime_error("Array is not of floating point type");
+                }
+            }
+
+            /**
+            * Get raw data and number of elements of the results array with the given ID
+            */
+            std::pair<const char*, std::size_t> get_raw_array(const implicit_topology_results& content, const implicit_topology_file::array_t id)
+            {
+                if (id == implicit_topology_file::array_t::indices)
+                {
+                    return content.indices != nullptr ? std::make_pair(reinterpret_cast<const char*>(content.indices->data()), content.indices->size())
+                        : std::make_pair(static_cast<const char*>(nullptr), std::size_t(0));
+                }
+
+                const auto& array = get_float_array(content, id);
+
+                return array != nullptr ? std::make_pair(reinterpret_cast<const char*>(array->data()), array->size())
+                    : std::make_pair(static_cast<const char*>(nullptr), std::size_t(0));
+            }
+
+            /**
+            * Allocate the results array with the given ID, and return its raw data
+            */
+            char* allocate_raw_array(implicit_topology_results& content, const implicit_topology_file::array_t id, const std::size_t num_elements)
+            {
+                if (id == implicit_topology_file::array_t::indices)
+                {
+                    content.indices = std::make_shared<std::vector<unsigned int>>(num_elements);
+
+                    return reinterpret_cast<char*>(content.indices->data());
+                }
+
+                auto& array = get_float_array(content, id);
+                array = std::make_shared<std::vector<float>>(num_elements);
+
+                return reinterpret_cast<char*>(array->data());
+            }
+
+            /**
+            * Bounds-checked access to the file content
+            */
+            template <typename T>
+            T read_value(const char* data, const std::size_t size, const std::size_t offset)
+            {
+                if (offset > size || size - offset < sizeof(T))
+                {
+                    throw std::runtime_error("Unexpected end of file");
+                }
+
+                T value;
+                std::memcpy(&value, data + offset, sizeof(T));
+
+                return value;
+            }
+        }
+
+        void implicit_topology_file::write(const std::string& filename, const implicit_topology_results& content, const compression_t compression)
+        {
+            std::ofstream ofs(filename, std::ios_base::out | std::ios_base::binary);
+
+            if (!ofs.good())
+            {
+                throw std::runtime_error("Unable to open file '" + filename + "'");
+            }
+
+            ofs.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+
+            // Write preliminary header, which is completed after writing the table of contents
+            file_header header;
+            std::copy(std::begin(magic), std::end(magic), header.magic);
+            header.version = version;
+            header.toc_offset = 0;
+            header.num_arrays = static_cast<std::uint32_t>(array_t::num_arrays);
+            header.method = static_cast<std::uint32_t>(content.computation_state.method);
+            header.num_integration_steps = content.computation_state.num_integration_steps;
+            header.integration_timestep = content.computation_state.integration_timestep;
+            header.max_integration_error = content.computation_state.max_integration_error;
+            header.finished = content.computation_state.finished ? 1u : 0u;
+            std::copy(content.computation_state.resolution.begin(), content.computation_state.resolution.end(), header.resolution);
+            std::copy(content.computation_state.domain.begin(), content.computation_state.domain.end(), header.domain);
+            header.input_hash = content.computation_state.input_hash;
+
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(file_header));
+
+            std::uint64_t offset = sizeof(file_header);
+
+            // Write arrays chunk by chunk, encoding chunks in parallel
+            std::vector<stored_array> arrays(static_cast<std::size_t>(array_t::num_arrays));
+
+            for (std::uint32_t array_index = 0; array_index < static_cast<std::uint32_t>(array_t::num_arrays); ++array_index)
+            {
+                const auto raw_array = get_raw_array(content, static_cast<array_t>(array_index));
+
+                auto& array = arrays[array_index];
+                array.entry.id = array_index;
+                array.entry.element_size = sizeof(float);
+                array.entry.num_elements = raw_array.second;
+                array.entry.chunk_elements = chunk_elements;
+                array.entry.num_chunks = (raw_array.second + chunk_elements - 1) / chunk_elements;
+
+                array.chunks.resize(array.entry.num_chunks);
+
+                std::vector<std::vector<char>> encoded(array.entry.num_chunks);
+
+                #pragma omp parallel for schedule(dynamic)
+                for (long long chunk_index = 0; chunk_index < static_cast<long long>(array.entry.num_chunks); ++chunk_index)
+                {
+                    const auto first = static_cast<std::size_t>(chunk_index * chunk_elements);
+                    const auto num_elements = std::min(static_cast<std::size_t>(chunk_elements), raw_array.second - first);
+
+                    array.chunks[chunk_index].compression = static_cast<std::uint32_t>(encode(raw_array.first + first * array.entry.element_size,
+                        num_elements, array.entry.element_size, compression, encoded[chunk_index]));
+                    array.chunks[chunk_index].reserved = 0;
+                }
+
+                for (std::size_t chunk_index = 0; chunk_index < array.chunks.size(); ++chunk_index)
+                {
+                    array.chunks[chunk_index].offset = offset;
+                    array.chunks[chunk_index].stored_size = encoded[chunk_index].size();
+
+                    ofs.write(encoded[chunk_index].data(), encoded[chunk_index].size());
+
+                    offset += encoded[chunk_index].size();
+                }
+            }
+
+            // Write table of contents
+            for (const auto& array : arrays)
+            {
+                ofs.write(reinterpret_cast<const char*>(&array.entry), sizeof(array_entry));
+                ofs.write(reinterpret_cast<const char*>(array.chunks.data()), array.chunks.size() * sizeof(chunk_entry));
+            }
+
+            // Complete header
+            header.toc_offset = offset;
+
+            ofs.seekp(0);
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(file_header));
+
+            ofs.close();
+        }
+
+        void implicit_topology_file::read(const std::string& filename, implicit_topology_results& content, const selection_t selection)
+        {
+            core::utility::MappedFile file;
+            map_file(filename, file);
+
+            const auto size = static_cast<std::size_t>(file.Size());
+
+            if (size < sizeof(magic) || !std::equal(std::begin(magic), std::end(magic), file.Data()))
+            {
+                read_legacy(file.Data(), size, content, selection);
+                return;
+            }
+
+            file_header header;
+            const auto arrays = parse(file.Data(), size, header);
+
+            content.computation_state.method = static_cast<streamlines_cuda::integration_method>(header.method);
+            content.computation_state.num_integration_steps = header.num_integration_steps;
+            content.computation_state.integration_timestep = header.integration_timestep;
+            content.computation_state.max_integration_error = header.max_integration_error;
+            content.computation_state.finished = header.finished != 0;
+            std::copy(std::begin(header.resolution), std::end(header.resolution), content.computation_state.resolution.begin());
+            std::copy(std::begin(header.domain), std::end(header.domain), content.computation_state.domain.begin());
+            content.computation_state.input_hash = header.input_hash;
+
+            // Decode selected arrays directly from the mapped file, decoding chunks in parallel
+            for (const auto& array : arrays)
+            {
+                const auto id = static_cast<array_t>(array.entry.id);
+
+                if (array.entry.id >= static_cast<std::uint32_t>(array_t::num_arrays) || (selection & select(id)) == 0)
+                {
+                    continue;
+                }
+
+                char* output = allocate_raw_array(content, id, static_cast<std::size_t>(array.entry.num_elements));
+
+                // Exceptions must not leave the parallel region
+                bool valid = true;
+
+                #pragma omp parallel for schedule(dynamic) reduction(&& : valid)
+                for (long long chunk_index = 0; chunk_index < static_cast<long long>(array.chunks.size()); ++chunk_index)
+                {
+                    const auto& chunk = array.chunks[chunk_index];
+
+                    const auto first = static_cast<std::size_t>(chunk_index * array.entry.chunk_elements);
+                    const auto num_elements = static_cast<std::size_t>(std::min(array.entry.chunk_elements, array.entry.num_elements - first));
+
+                    if (!decode(file.Data() + chunk.offset, static_cast<std::size_t>(chunk.stored_size), num_elements, array.entry.element_size,
+                        static_cast<compression_t>(chunk.compression), output + first * array.entry.element_size))
+                    {
+                        valid = false;
+                    }
+                }
+
+                if (!valid)
+                {
+                    throw std::runtime_error("Unable to decode chunk");
+                }
+            }
+
+            // Mark the complete mesh as new
+            content.first_new_vertex = 0;
+            content.mesh_revision = 0;
+
+            if (content.indices != nullptr)
+            {
+                content.changed_cells = std::make_shared<std::vector<unsigned int>>(content.indices->size() / 3);
+                std::iota(content.changed_cells->begin(), content.changed_cells->end(), 0u);
+            }
+        }
+
+        std::vector<implicit_topology_file::array_info> implicit_topology_file::read_contents(const std::string& filename, implicit_topology_results::state& state)
+        {
+            core::utility::MappedFile file;
+            map_file(filename, file);
+
+            const auto size = static_cast<std::size_t>(file.Size());
+
+            if (size < sizeof(magic) || !std::equal(std::begin(magic), std::end(magic), file.Data()))
+            {
+                throw std::runtime_error("File '" + filename + "' was written by a previous version and has no table of contents");
+            }
+
+            file_header header;
+            const auto arrays = parse(file.Data(), size, header);
+
+            state.method = static_cast<streamlines_cuda::integration_method>(header.method);
+            state.num_integration_steps = header.num_integration_steps;
+            state.integration_timestep = header.integration_timestep;
+            state.max_integration_error = header.max_integration_error;
+            state.finished = header.finished != 0;
+            std::copy(std::begin(header.resolution), std::end(header.resolution), state.resolution.begin());
+            std::copy(std::begin(header.domain), std::end(header.domain), state.domain.begin());
+            state.input_hash = header.input_hash;
+
+            std::vector<array_info> contents;
+            contents.reserve(arrays.size());
+
+            for (const auto& array : arrays)
+            {
+                array_info info;
+                info.id = static_cast<array_t>(array.entry.id);
+                info.num_elements = array.entry.num_elements;
+                info.stored_size = std::accumulate(array.chunks.begin(), array.chunks.end(), std::uint64_t(0),
+                    [](const std::uint64_t size, const chunk_entry& chunk) { return size + chunk.stored_size; });
+
+                contents.push_back(info);
+            }
+
+            return contents;
+        }
+
+        std::vector<implicit_topology_file::stored_array> implicit_topology_file::parse(const char* data, const std::size_t size, file_header& header)
+        {
+            const auto file_version = read_value<std::uint32_t>(data, size, offsetof(file_header, version));
+
+            if (file_version != version)
+            {
+                throw std::runtime_error("Unsupported file version " + std::to_string(file_version));
+            }
+
+            header = read_value<file_header>(data, size, 0);
+
+            // Validate counts against the file size before allocating
+            if (header.toc_offset > size || header.num_arrays > (size - header.toc_offset) / sizeof(array_entry))
+            {
+                throw std::runtime_error("Table of contents exceeds file size");
+            }
+
+            std::vector<stored_array> arrays(header.num_arrays);
+
+            std::size_t offset = static_cast<std::size_t>(header.toc_offset);
+
+            for (auto& array : arrays)
+            {
+                array.entry = read_value<array_entry>(data, size, offset);
+                offset += sizeof(array_entry);
+
+                if (array.entry.element_size != sizeof(float) || array.entry.chunk_elements == 0 ||
+                    array.entry.num_chunks != (array.entry.num_elements + array.entry.chunk_elements - 1) / array.entry.chunk_elements)
+                {
+                    throw std::runtime_error("Invalid table of contents");
+                }
+
+                if (array.entry.num_chunks > (size - std::min(size, offset)) / sizeof(chunk_entry))
+                {
+                    throw std::runtime_error("Table of contents exceeds file size");
+                }
+
+                array.chunks.resize(static_cast<std::size_t>(array.entry.num_chunks));
+
+                // Deflate cannot compress by more than this factor, which bounds the elements a chunk can hold
+                constexpr std::uint64_t max_compression_ratio = 1032;
+
+                for (std::size_t chunk_index = 0; chunk_index < array.chunks.size(); ++chunk_index)
+                {
+                    auto& chunk = array.chunks[chunk_index];
+
+                    chunk = read_value<chunk_entry>(data, size, offset);
+                    offset += sizeof(chunk_entry);
+
+                    if (chunk.offset > size || size - chunk.offset < chunk.stored_size)
+                    {
+                        throw std::runtime_error("Chunk exceeds file size");
+                    }
+
+                    const auto num_elements = std::min(array.entry.chunk_elements, array.entry.num_elements - chunk_index * array.entry.chunk_elements);
+
+                    if (num_elements > (chunk.stored_size * max_compression_ratio) / array.entry.element_size + 1)
+                    {
+                        throw std::runtime_error("Chunk is too small for its number of elements");
+                    }
+                }
+            }
+
+            return arrays;
+        }
+
+        void implicit_topology_file::read_legacy(const char* data, const std::size_t size, implicit_topology_results& content, const selection_t selection)
+        {
+            // Header
+            const auto num_particles = read_value<unsigned int>(data, size, 0 * sizeof(unsigned int));
+            const auto num_indices = read_value<unsigned int>(data, size, 1 * sizeof(unsigned int));
+
+            content.computation_state.method = streamlines_cuda::integration_method::RUNGE_KUTTA_4;
+            content.computation_state.num_integration_steps = read_value<unsigned int>(data, size, 2 * sizeof(unsigned int));
+            content.computation_state.integration_timestep = read_value<float>(data, size, 3 * sizeof(unsigned int));
+            content.computation_state.max_integration_error = read_value<float>(data, size, 4 * sizeof(unsigned int));
+            content.computation_state.finished = false;
+
+            std::size_t offset = 5 * sizeof(unsigned int);
+
+            if (size - std::min(size, offset) != (static_cast<std::size_t>(num_particles) * 12 + num_indices) * sizeof(float))
+            {
+                throw std::runtime_error("File size does not match its header");
+            }
+
+            // Arrays in order of their IDs
+            for (std::uint32_t array_index = 0; array_index < static_cast<std::uint32_t>(array_t::num_arrays); ++array_index)
+            {
+                const auto id = static_cast<array_t>(array_index);
+
+                const std::size_t num_elements = (id == array_t::indices) ? num_indices :
+                    ((id == array_t::vertices || id == array_t::positions_forward || id == array_t::positions_backward) ? 2 * num_particles : num_particles);
+
+                if ((selection & select(id)) != 0)
+                {
+                    std::memcpy(allocate_raw_array(content, id, num_elements), data + offset, num_elements * sizeof(float));
+                }
+
+                offset += num_elements * sizeof(float);
+            }
+
+            // Mark the complete mesh as new
+            content.first_new_vertex = 0;
+            content.mesh_revision = 0;
+
+            if (content.indices != nullptr)
+            {
+                content.changed_cells = std::make_shared<std::vector<unsigned int>>(content.indices->size() / 3);
+                std::iota(content.changed_cells->begin(), content.changed_cells->end(), 0u);
+            }
+        }
+
+        implicit_topology_file::compression_t implicit_topology_file::encode(const char* data, const std::size_t num_elements,
+            const std::size_t element_size, const compression_t compression, std::vector<char>& output)
+        {
+            const std::size_t num_bytes = num_elements * element_size;
+
+            if (compression == compression_t::shuffle_deflate)
+            {
+                // Group bytes by significance, which results in long runs of similar bytes for floating point data
+                std::vector<char> shuffled(num_bytes);
+
+                for (std::size_t i = 0; i < num_elements; ++i)
+                {
+                    for (std::size_t b = 0; b < element_size; ++b)
+                    {
+                        shuffled[b * num_elements + i] = data[i * element_size + b];
+                    }
+                }
+
+                // Compress using deflate, and only use the result if it is actually smaller
+                uLongf compressed_size = compressBound(static_cast<uLong>(num_bytes));
+                output.resize(compressed_size);
+
+                if (compress2(reinterpret_cast<Bytef*>(output.data()), &compressed_size, reinterpret_cast<const Bytef*>(shuffled.data()),
+                    static_cast<uLong>(num_bytes), Z_BEST_SPEED) == Z_OK && compressed_size < num_bytes)
+                {
+                    output.resize(compressed_size);
+
+                    return compression_t::shuffle_deflate;
+                }
+            }
+
+            output.assign(data, data + num_bytes);
+
+            return compression_t::none;
+        }
+
+        bool implicit_topology_file::decode(const char* data, const std::size_t stored_size, const std::size_t num_elements,
+            const std::size_t element_size, const compression_t compression, char* output)
+        {
+            const std::size_t num_bytes = num_elements * element_size;
+
+            switch (compression)
+            {
+            case compression_t::none:
+                if (stored_size != num_bytes)
+                {
+                    return false;
+                }
+
+                std::memcpy(output, data, num_bytes);
+
+                return true;
+            case compression_t::shuffle_deflate:
+            {
+                std::vector<char> shuffled(num_bytes);
+                uLongf decompressed_size = static_cast<uLongf>(num_bytes);
+
+                if (uncompress(reinterpret_cast<Bytef*>(shuffled.data()), &decompressed_size,
+                    reinterpret_cast<const Bytef*>(data), static_cast<uLong>(stored_size)) != Z_OK || decompressed_size != num_bytes)
+                {
+                    return false;
+                }
+
+                for (std::size_t i = 0; i < num_elements; ++i)
+                {
+                    for (std::size_t b = 0; b < element_size; ++b)
+                    {
+                        output[i * element_size + b] = shuffled[b * num_elements + i];
+                    }
+                }
+
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+    }
+}
@@ -0,0 +1,239 @@
+/*
+ * implicit_topology_file.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include "implicit_topology_results.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        /**
+        * File format for results from implicit topology computation.
+        *
+        * The file starts with a header, followed by the data of all arrays, split into chunks which are
+        * optionally compressed, and ends with a table of contents listing all arrays and chunks.
+        * Thus, single arrays can be loaded without reading the rest of the file, and chunks can be
+        * (de)compressed in parallel.
+        *
+        * Files written by previous versions, consisting of an unstructured sequence of all arrays,
+        * can still be read.
+        *
+        * @author Alexander Straub
+        */
+        class implicit_topology_file
+        {
+        public:
+            /**
+            * Arrays stored in the file
+            */
+            enum class array_t : std::uint32_t
+            {
+                vertices = 0,
+                indices,
+                positions_forward,
+                positions_backward,
+                labels_forward,
+                labels_backward,
+                distances_forward,
+                distances_backward,
+                terminations_forward,
+                terminations_backward,
+                num_arrays
+            };
+
+            /**
+            * Compression applied to the chunks
+            */
+            enum class compression_t : std::uint32_t
+            {
+                none = 0,
+                shuffle_deflate
+            };
+
+            /**
+            * Information on a stored array
+            */
+            struct array_info
+            {
+                array_t id;
+                std::uint64_t num_elements;
+                std::uint64_t stored_size;
+            };
+
+            /**
+            * Selection of arrays for loading
+            */
+            using selection_t = std::uint32_t;
+
+            static constexpr selection_t select_all = (1u << static_cast<std::uint32_t>(array_t::num_arrays)) - 1u;
+
+            /**
+            * Get selection bit for a single array
+            *
+            * @param array                  Array to select
+            *
+            * @return Selection
+            */
+            static constexpr selection_t select(const array_t array)
+            {
+                return 1u << static_cast<std::uint32_t>(array);
+            }
+
+            /**
+            * Write results to file
+            *
+            * @param filename               Output file path
+            * @param content                Results to write
+            * @param compression            Compression applied to the chunks
+            *
+            * @throws std::runtime_error on failure
+            */
+            static void write(const std::string& filename, const implicit_topology_results& content, compression_t compression);
+
+            /**
+            * Read results from file, leaving arrays which are not selected empty
+            *
+            * @param filename               Input file path
+            * @param content                Results to fill
+            * @param selection              Arrays to read
+            *
+            * @throws std::runtime_error on failure
+            */
+            static void read(const std::string& filename, implicit_topology_results& content, selection_t selection = select_all);
+
+            /**
+            * Read only the computation state and the table of contents
+            *
+            * @param filename               Input file path
+            * @param state                  Computation state
+            *
+            * @return Information on the stored arrays
+            *
+            * @throws std::runtime_error on failure
+            */
+            static std::vector<array_info> read_contents(const std::string& filename, implicit_topology_results::state& state);
+
+        private:
+            /** Identifier and version of the file format */
+            static constexpr char magic[4] = { 'M', 'M', 'I', 'T' };
+            static constexpr std::uint32_t version = 3;
+
+            /** Number of elements per chunk */
+            static constexpr std::uint64_t chunk_elements = 1ull << 20;
+
+            /**
+            * File header
+            */
+            struct file_header
+            {
+                char magic[4];
+                std::uint32_t version;
+
+                std::uint64_t toc_offset;
+                std::uint32_t num_arrays;
+
+                std::uint32_t method;
+                std::uint32_t num_integration_steps;
+                float integration_timestep;
+                float max_integration_error;
+                std::uint32_t finished;
+
+                /** Input the results were computed for */
+                std::uint32_t resolution[2];
+                float domain[4];
+                std::uint64_t input_hash;
+            };
+
+            /**
+            * Table of contents entry for an array, followed by the entries for its chunks
+            */
+            struct array_entry
+            {
+                std::uint32_t id;
+                std::uint32_t element_size;
+                std::uint64_t num_elements;
+                std::uint64_t chunk_elements;
+                std::uint64_t num_chunks;
+            };
+
+            /**
+            * Table of contents entry for a chunk
+            */
+            struct chunk_entry
+            {
+                std::uint64_t offset;
+                std::uint64_t stored_size;
+                std::uint32_t compression;
+                std::uint32_t reserved;
+            };
+
+            /**
+            * Array with its table of contents entries as parsed from the file
+            */
+            struct stored_array
+            {
+                array_entry entry;
+                std::vector<chunk_entry> chunks;
+            };
+
+            /**
+            * Parse header and table of contents
+            *
+            * @param data                   File content
+            * @param size                   File size
+            * @param header                 Output header
+            *
+            * @return Stored arrays
+            */
+            static std::vector<stored_array> parse(const char* data, std::size_t size, file_header& header);
+
+            /**
+            * Read file written by previous versions
+            *
+            * @param data                   File content
+            * @param size                   File size
+            * @param content                Results to fill
+            * @param selection              Arrays to read
+            */
+            static void read_legacy(const char* data, std::size_t size, implicit_topology_results& content, selection_t selection);
+
+            /**
+            * Encode a chunk
+            *
+            * @param data                   Chunk data
+            * @param num_elements           Number of elements in the chunk
+            * @param element_size           Size of an element in bytes
+            * @param compression            Requested compression
+            * @param output                 Encoded chunk
+            *
+            * @return Compression actually applied, which is none if compression does not reduce the size
+            */
+            static compression_t encode(const char* data, std::size_t num_elements, std::size_t element_size,
+                compression_t compression, std::vector<char>& output);
+
+            /**
+            * Decode a chunk
+            *
+            * @param data                   Encoded chunk data
+            * @param stored_size            Size of the encoded chunk in bytes
+            * @param num_elements           Number of elements in the chunk
+            * @param element_size           Size of an element in bytes
+            * @param compression            Compression applied to the chunk
+            * @param output                 Output memory for the decoded elements
+            *
+            * @return Success
+            */
+            static bool decode(const char* data, std::size_t stored_size, std::size_t num_elements, std::size_t element_size,
+                compression_t compression, char* output);
+        };
+    }
+}
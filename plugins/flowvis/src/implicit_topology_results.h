@@ -8,6 +8,9 @@
 
 #include "../cuda/streamlines.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -40,6 +43,13 @@ namespace megamol
             std::shared_ptr<std::vector<float>> vertices;
             std::shared_ptr<std::vector<unsigned int>> indices;
 
+            /** Changes of the triangle mesh since the previous result: first added vertex and modified triangles */
+            std::size_t first_new_vertex;
+            std::shared_ptr<std::vector<unsigned int>> changed_cells;
+
+            /** Revision of the triangle mesh, consecutively numbered for the results of one computation; 0 if unknown */
+            std::size_t mesh_revision;
+
             /** Computation state */
             struct state
             {
@@ -56,6 +66,11 @@ namespace megamol
                 /** Indicate that the computation is finished */
                 bool finished;
 
+                /** Input the results were computed for: resolution, domain, and hash of the vectors and convergence structures; zero if unknown */
+                std::array<unsigned int, 2> resolution = { 0, 0 };
+                std::array<float, 4> domain = { 0.0f, 0.0f, 0.0f, 0.0f };
+                std::uint64_t input_hash = 0;
+
             } computation_state;
         };
     }
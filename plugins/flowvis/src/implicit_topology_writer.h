@@ -10,6 +10,7 @@
 #include "implicit_topology_results.h"
 
 #include "mmcore/AbstractCallbackWriter.h"
+#include "mmcore/param/ParamSlot.h"
 
 namespace megamol
 {
@@ -74,6 +75,10 @@ namespace megamol
             * @return true if the job has been successfully started.
             */
             virtual bool write(const std::string& filename, const implicit_topology_results& content) override;
+
+        private:
+            /** Compression of the stored arrays */
+            core::param::ParamSlot compression;
         };
     }
 }
@@ -1,4 +1,471 @@
 #include "stdafx.h"
 #include "flowvis/integrator.h"
 
-// Empty
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+/** Number of particles processed together, matching eight single-precision values per AVX register */
+constexpr std::size_t block_size = 8;
+
+/**
+ * Precomputed quantities for the bilinear lookup
+ */
+struct lookup_t {
+    float origin_x, origin_y;
+    float inv_cell_size_x, inv_cell_size_y;
+    float max_x, max_y;
+    int max_cell_x, max_cell_y;
+    int row_stride;
+    const float* vectors;
+
+    explicit lookup_t(const megamol::flowvis::uniform_vector_field_2d& vector_field)
+        : origin_x(vector_field.origin[0])
+        , origin_y(vector_field.origin[1])
+        , inv_cell_size_x(1.0f / vector_field.cell_size[0])
+        , inv_cell_size_y(1.0f / vector_field.cell_size[1])
+        , max_x(static_cast<float>(vector_field.resolution[0] - 1))
+        , max_y(static_cast<float>(vector_field.resolution[1] - 1))
+        , max_cell_x(static_cast<int>(vector_field.resolution[0]) - 2)
+        , max_cell_y(static_cast<int>(vector_field.resolution[1]) - 2)
+        , row_stride(static_cast<int>(vector_field.resolution[0]))
+        , vectors(vector_field.vectors) {
+
+        if (vector_field.resolution[0] < 2 || vector_field.resolution[1] < 2) {
+            throw std::runtime_error("Vector field must have at least two vectors per direction");
+        }
+
+        if (vector_field.vectors == nullptr) {
+            throw std::runtime_error("Vector field has no vectors");
+        }
+    }
+};
+
+/**
+ * Bilinearly interpolate the vector field at a block of positions. The cell is computed from the position,
+ * as this is cheaper than looking it up on a uniform grid.
+ *
+ * @param lookup Lookup information
+ * @param x, y Positions
+ * @param v_x, v_y Interpolated vectors
+ * @param inside Set to false for positions outside the domain, or NaN positions
+ */
+void interpolate(const lookup_t& lookup, const float* x, const float* y, float* v_x, float* v_y, bool* inside) {
+    #pragma omp simd
+    for (std::size_t i = 0; i < block_size; ++i) {
+        const auto f_x = (x[i] - lookup.origin_x) * lookup.inv_cell_size_x;
+        const auto f_y = (y[i] - lookup.origin_y) * lookup.inv_cell_size_y;
+
+        // Comparisons with NaN are false, rendering those positions outside
+        const bool valid = f_x >= 0.0f && f_x <= lookup.max_x && f_y >= 0.0f && f_y <= lookup.max_y;
+
+        const auto c_x = valid ? f_x : 0.0f;
+        const auto c_y = valid ? f_y : 0.0f;
+
+        const auto cell_x = std::min(static_cast<int>(c_x), lookup.max_cell_x);
+        const auto cell_y = std::min(static_cast<int>(c_y), lookup.max_cell_y);
+
+        const auto t_x = c_x - cell_x;
+        const auto t_y = c_y - cell_y;
+
+        const auto index_00 = 2 * (cell_y * lookup.row_stride + cell_x);
+        const auto index_10 = index_00 + 2;
+        const auto index_01 = index_00 + 2 * lookup.row_stride;
+        const auto index_11 = index_01 + 2;
+
+        v_x[i] = (1.0f - t_y) * ((1.0f - t_x) * lookup.vectors[index_00] + t_x * lookup.vectors[index_10]) +
+                 t_y * ((1.0f - t_x) * lookup.vectors[index_01] + t_x * lookup.vectors[index_11]);
+        v_y[i] = (1.0f - t_y) * ((1.0f - t_x) * lookup.vectors[index_00 + 1] + t_x * lookup.vectors[index_10 + 1]) +
+                 t_y * ((1.0f - t_x) * lookup.vectors[index_01 + 1] + t_x * lookup.vectors[index_11 + 1]);
+
+        inside[i] = inside[i] && valid;
+    }
+}
+
+/**
+ * Load particles of a block, padding the last block with inactive particles
+ *
+ * @return Number of particles in this block
+ */
+std::size_t load_block(const megamol::flowvis::particle_batch& particles, const std::size_t offset, float* x, float* y,
+    float* delta, bool* active) {
+
+    const auto num_particles = std::min(block_size, particles.size() - offset);
+
+    for (std::size_t i = 0; i < block_size; ++i) {
+        const auto valid = i < num_particles;
+
+        x[i] = valid ? particles.x[offset + i] : 0.0f;
+        y[i] = valid ? particles.y[offset + i] : 0.0f;
+        delta[i] = valid ? particles.delta[offset + i] : 0.0f;
+        active[i] = valid && particles.active[offset + i] != 0;
+    }
+
+    return num_particles;
+}
+
+/**
+ * Advect a block of particles using Runge-Kutta 4
+ *
+ * @param lookup Lookup information
+ * @param particles Particles to advect (will be modified)
+ * @param offset Index of the first particle of the block
+ * @param min_cellsize Minimum cell size
+ * @param sign Integration direction
+ */
+void advect_block_rk4(const lookup_t& lookup, megamol::flowvis::particle_batch& particles, const std::size_t offset,
+    const float min_cellsize, const float sign) {
+
+    alignas(32) float x[block_size], y[block_size], delta[block_size];
+    alignas(32) float sample_x[block_size], sample_y[block_size];
+    alignas(32) float k1_x[block_size], k1_y[block_size], k2_x[block_size], k2_y[block_size];
+    alignas(32) float k3_x[block_size], k3_y[block_size], k4_x[block_size], k4_y[block_size];
+    alignas(32) float max_velocity[block_size], step[block_size];
+    bool active[block_size], inside[block_size];
+
+    const auto num_particles = load_block(particles, offset, x, y, delta, active);
+
+    bool any_active = false;
+
+    for (std::size_t i = 0; i < block_size; ++i) {
+        any_active |= active[i];
+        inside[i] = true;
+    }
+
+    if (!any_active) {
+        return;
+    }
+
+    // Calculate step size from the velocity at the current position, which is reused as first coefficient
+    interpolate(lookup, x, y, k1_x, k1_y, inside);
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < block_size; ++i) {
+        max_velocity[i] = std::sqrt(k1_x[i] * k1_x[i] + k1_y[i] * k1_y[i]);
+
+        const auto steps_per_cell = max_velocity[i] > 0.0f ? min_cellsize / max_velocity[i] : 0.0f;
+
+        step[i] = steps_per_cell * delta[i] * sign;
+
+        k1_x[i] *= step[i];
+        k1_y[i] *= step[i];
+
+        sample_x[i] = x[i] + 0.5f * k1_x[i];
+        sample_y[i] = y[i] + 0.5f * k1_y[i];
+    }
+
+    // Calculate Runge-Kutta coefficients
+    interpolate(lookup, sample_x, sample_y, k2_x, k2_y, inside);
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < block_size; ++i) {
+        k2_x[i] *= step[i];
+        k2_y[i] *= step[i];
+
+        sample_x[i] = x[i] + 0.5f * k2_x[i];
+        sample_y[i] = y[i] + 0.5f * k2_y[i];
+    }
+
+    interpolate(lookup, sample_x, sample_y, k3_x, k3_y, inside);
+
+    #pragma omp simd
+    for (std::size_t i = 0; i < block_size; ++i) {
+        k3_x[i] *= step[i];
+        k3_y[i] *= step[i];
+
+        sample_x[i] = x[i] + k3_x[i];
+        sample_y[i] = y[i] + k3_y[i];
+    }
+
+    interpolate(lookup, sample_x, sample_y, k4_x, k4_y, inside);
+
+    // Advect, limiting the advection to the local velocity
+    #pragma omp simd
+    for (std::size_t i = 0; i < block_size; ++i) {
+        auto advection_x = (1.0f / 6.0f) * (k1_x[i] + 2.0f * k2_x[i] + 2.0f * k3_x[i] + step[i] * k4_x[i]);
+        auto advection_y = (1.0f / 6.0f) * (k1_y[i] + 2.0f * k2_y[i] + 2.0f * k3_y[i] + step[i] * k4_y[i]);
+
+        const auto length = std::sqrt(advection_x * advection_x + advection_y * advection_y);
+
+        if (length > max_velocity[i]) {
+            advection_x *= max_velocity[i] / length;
+            advection_y *= max_velocity[i] / length;
+        }
+
+        const auto advect = active[i] && inside[i];
+
+        x[i] = advect ? x[i] + advection_x : x[i];
+        y[i] = advect ? y[i] + advection_y : y[i];
+    }
+
+    // Store results
+    for (std::size_t i = 0; i < num_particles; ++i) {
+        if (active[i]) {
+            particles.x[offset + i] = x[i];
+            particles.y[offset + i] = y[i];
+            particles.active[offset + i] = inside[i] ? 1 : 0;
+        }
+    }
+}
+
+/**
+ * Advect a block of particles using Runge-Kutta-Fehlberg 4-5
+ *
+ * @param lookup Lookup information
+ * @param particles Particles to advect (will be modified)
+ * @param offset Index of the first particle of the block
+ * @param max_error Maximum allowed error
+ * @param sign Integration direction
+ */
+void advect_block_rk45(const lookup_t& lookup, megamol::flowvis::particle_batch& particles, const std::size_t offset,
+    const float max_error, const float sign) {
+
+    // Cash-Karp parameters
+    constexpr float b_21 = 0.2f;
+    constexpr float b_31 = 0.075f;
+    constexpr float b_41 = 0.3f;
+    constexpr float b_51 = -11.0f / 54.0f;
+    constexpr float b_61 = 1631.0f / 55296.0f;
+    constexpr float b_32 = 0.225f;
+    constexpr float b_42 = -0.9f;
+    constexpr float b_52 = 2.5f;
+    constexpr float b_62 = 175.0f / 512.0f;
+    constexpr float b_43 = 1.2f;
+    constexpr float b_53 = -70.0f / 27.0f;
+    constexpr float b_63 = 575.0f / 13824.0f;
+    constexpr float b_54 = 35.0f / 27.0f;
+    constexpr float b_64 = 44275.0f / 110592.0f;
+    constexpr float b_65 = 253.0f / 4096.0f;
+
+    constexpr float c_1 = 37.0f / 378.0f;
+    constexpr float c_3 = 250.0f / 621.0f;
+    constexpr float c_4 = 125.0f / 594.0f;
+    constexpr float c_6 = 512.0f / 1771.0f;
+
+    constexpr float c_1s = 2825.0f / 27648.0f;
+    constexpr float c_3s = 18575.0f / 48384.0f;
+    constexpr float c_4s = 13525.0f / 55296.0f;
+    constexpr float c_5s = 277.0f / 14336.0f;
+    constexpr float c_6s = 0.25f;
+
+    // Constants
+    constexpr float grow_exponent = -0.2f;
+    constexpr float shrink_exponent = -0.25f;
+    constexpr float max_growth = 5.0f;
+    constexpr float max_shrink = 0.1f;
+    constexpr float safety = 0.9f;
+
+
+    alignas(32) float x[block_size], y[block_size], delta[block_size];
+    alignas(32) float sample_x[block_size], sample_y[block_size];
+    alignas(32) float v_x[block_size], v_y[block_size];
+    alignas(32) float k1_x[block_size], k1_y[block_size], k2_x[block_size], k2_y[block_size];
+    alignas(32) float k3_x[block_size], k3_y[block_size], k4_x[block_size], k4_y[block_size];
+    alignas(32) float k5_x[block_size], k5_y[block_size], k6_x[block_size], k6_y[block_size];
+    alignas(32) float step[block_size];
+    bool active[block_size], inside[block_size], step_inside[block_size], pending[block_size];
+
+    const auto num_particles = load_block(particles, offset, x, y, delta, active);
+
+    bool any_pending = false;
+
+    for (std::size_t i = 0; i < block_size; ++i) {
+        pending[i] = active[i];
+        inside[i] = true;
+        any_pending |= pending[i];
+    }
+
+    // Repeat the step for particles whose time step was decreased
+    while (any_pending) {
+        std::fill(step_inside, step_inside + block_size, true);
+
+        // Calculate Runge-Kutta coefficients; the velocity at the current position is also used as error scale
+        interpolate(lookup, x, y, v_x, v_y, step_inside);
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < block_size; ++i) {
+            step[i] = delta[i] * sign;
+
+            k1_x[i] = step[i] * v_x[i];
+            k1_y[i] = step[i] * v_y[i];
+
+            sample_x[i] = x[i] + b_21 * k1_x[i];
+            sample_y[i] = y[i] + b_21 * k1_y[i];
+        }
+
+        interpolate(lookup, sample_x, sample_y, k2_x, k2_y, step_inside);
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < block_size; ++i) {
+            k2_x[i] *= step[i];
+            k2_y[i] *= step[i];
+
+            sample_x[i] = x[i] + b_31 * k1_x[i] + b_32 * k2_x[i];
+            sample_y[i] = y[i] + b_31 * k1_y[i] + b_32 * k2_y[i];
+        }
+
+        interpolate(lookup, sample_x, sample_y, k3_x, k3_y, step_inside);
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < block_size; ++i) {
+            k3_x[i] *= step[i];
+            k3_y[i] *= step[i];
+
+            sample_x[i] = x[i] + b_41 * k1_x[i] + b_42 * k2_x[i] + b_43 * k3_x[i];
+            sample_y[i] = y[i] + b_41 * k1_y[i] + b_42 * k2_y[i] + b_43 * k3_y[i];
+        }
+
+        interpolate(lookup, sample_x, sample_y, k4_x, k4_y, step_inside);
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < block_size; ++i) {
+            k4_x[i] *= step[i];
+            k4_y[i] *= step[i];
+
+            sample_x[i] = x[i] + b_51 * k1_x[i] + b_52 * k2_x[i] + b_53 * k3_x[i] + b_54 * k4_x[i];
+            sample_y[i] = y[i] + b_51 * k1_y[i] + b_52 * k2_y[i] + b_53 * k3_y[i] + b_54 * k4_y[i];
+        }
+
+        interpolate(lookup, sample_x, sample_y, k5_x, k5_y, step_inside);
+
+        #pragma omp simd
+        for (std::size_t i = 0; i < block_size; ++i) {
+            k5_x[i] *= step[i];
+            k5_y[i] *= step[i];
+
+            sample_x[i] =
+                x[i] + b_61 * k1_x[i] + b_62 * k2_x[i] + b_63 * k3_x[i] + b_64 * k4_x[i] + b_65 * k5_x[i];
+            sample_y[i] =
+                y[i] + b_61 * k1_y[i] + b_62 * k2_y[i] + b_63 * k3_y[i] + b_64 * k4_y[i] + b_65 * k5_y[i];
+        }
+
+        interpolate(lookup, sample_x, sample_y, k6_x, k6_y, step_inside);
+
+        any_pending = false;
+
+        for (std::size_t i = 0; i < block_size; ++i) {
+            if (!pending[i]) {
+                continue;
+            }
+
+            // Particles that left the domain stay where they are
+            if (!step_inside[i]) {
+                inside[i] = false;
+                pending[i] = false;
+                continue;
+            }
+
+            k6_x[i] *= step[i];
+            k6_y[i] *= step[i];
+
+            // Calculate error estimate
+            const auto fifth_order_x = x[i] + c_1 * k1_x[i] + c_3 * k3_x[i] + c_4 * k4_x[i] + c_6 * k6_x[i];
+            const auto fifth_order_y = y[i] + c_1 * k1_y[i] + c_3 * k3_y[i] + c_4 * k4_y[i] + c_6 * k6_y[i];
+            const auto fourth_order_x =
+                x[i] + c_1s * k1_x[i] + c_3s * k3_x[i] + c_4s * k4_x[i] + c_5s * k5_x[i] + c_6s * k6_x[i];
+            const auto fourth_order_y =
+                y[i] + c_1s * k1_y[i] + c_3s * k3_y[i] + c_4s * k4_y[i] + c_5s * k5_y[i] + c_6s * k6_y[i];
+
+            const auto error_x = std::abs(fifth_order_x - fourth_order_x) / std::abs(v_x[i]);
+            const auto error_y = std::abs(fifth_order_y - fourth_order_y) / std::abs(v_y[i]);
+
+            const auto error = std::max(0.0f, std::max(error_x, error_y)) / max_error;
+
+            // Set new, adapted time step
+            if (error > 1.0f) {
+                // Error too large, reduce time step
+                delta[i] *= std::max(max_shrink, safety * std::pow(error, shrink_exponent));
+                pending[i] = true;
+                any_pending = true;
+            } else {
+                // Error (too) small, increase time step
+                delta[i] *= std::min(max_growth, safety * std::pow(error, grow_exponent));
+                pending[i] = false;
+            }
+
+            x[i] = fifth_order_x;
+            y[i] = fifth_order_y;
+        }
+    }
+
+    // Store results
+    for (std::size_t i = 0; i < num_particles; ++i) {
+        if (active[i]) {
+            particles.x[offset + i] = x[i];
+            particles.y[offset + i] = y[i];
+            particles.delta[offset + i] = delta[i];
+            particles.active[offset + i] = inside[i] ? 1 : 0;
+        }
+    }
+}
+
+} // namespace
+
+megamol::flowvis::uniform_vector_field_2d megamol::flowvis::make_uniform_vector_field(
+    const std::array<unsigned int, 2>& resolution, const std::vector<float>& positions,
+    const std::vector<float>& vectors) {
+
+    const auto num_vectors = static_cast<std::size_t>(resolution[0]) * resolution[1];
+
+    if (resolution[0] < 2 || resolution[1] < 2 || positions.size() < 2 * num_vectors ||
+        vectors.size() < 2 * num_vectors) {
+
+        throw std::runtime_error("Vector field resolution does not match its positions and vectors");
+    }
+
+    uniform_vector_field_2d vector_field;
+    vector_field.resolution = resolution;
+    vector_field.origin = {positions[0], positions[1]};
+    vector_field.cell_size = {positions[2] - positions[0], positions[2 * resolution[0] + 1] - positions[1]};
+    vector_field.vectors = vectors.data();
+
+    return vector_field;
+}
+
+void megamol::flowvis::advect_points_rk4(
+    const uniform_vector_field_2d& vector_field, particle_batch& particles, const bool forward, const bool parallel) {
+
+    const lookup_t lookup(vector_field);
+
+    const auto min_cellsize = std::min(std::abs(vector_field.cell_size[0]), std::abs(vector_field.cell_size[1]));
+    const auto sign = forward ? 1.0f : -1.0f;
+
+    const auto num_blocks = static_cast<long long>((particles.size() + block_size - 1) / block_size);
+
+    if (parallel) {
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (long long block_index = 0; block_index < num_blocks; ++block_index) {
+            advect_block_rk4(lookup, particles, static_cast<std::size_t>(block_index) * block_size, min_cellsize, sign);
+        }
+    } else {
+        for (long long block_index = 0; block_index < num_blocks; ++block_index) {
+            advect_block_rk4(lookup, particles, static_cast<std::size_t>(block_index) * block_size, min_cellsize, sign);
+        }
+    }
+}
+
+void megamol::flowvis::advect_points_rk45(const uniform_vector_field_2d& vector_field, particle_batch& particles,
+    const float max_error, const bool forward, const bool parallel) {
+
+    const lookup_t lookup(vector_field);
+
+    const auto sign = forward ? 1.0f : -1.0f;
+
+    const auto num_blocks = static_cast<long long>((particles.size() + block_size - 1) / block_size);
+
+    if (parallel) {
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (long long block_index = 0; block_index < num_blocks; ++block_index) {
+            advect_block_rk45(lookup, particles, static_cast<std::size_t>(block_index) * block_size, max_error, sign);
+        }
+    } else {
+        for (long long block_index = 0; block_index < num_blocks; ++block_index) {
+            advect_block_rk45(lookup, particles, static_cast<std::size_t>(block_index) * block_size, max_error, sign);
+        }
+    }
+}
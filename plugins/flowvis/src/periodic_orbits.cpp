@@ -4,6 +4,7 @@
 #include "critical_points.h"
 #include "glyph_data_call.h"
 #include "mouse_click_call.h"
+#include "task_pool.h"
 #include "vector_field_call.h"
 
 #include "mmcore/Call.h"
@@ -33,9 +34,9 @@
 #include <cmath>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <ostream>
-#include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <utility>
@@ -54,6 +55,7 @@ namespace megamol
             vector_field_hash(-1),
             critical_points_slot("get_critical_points", "Critical points input"),
             critical_points_hash(-1),
+            seed_points_slot("get_seed_points", "Seed points input for searching periodic orbits from multiple seeds"),
             integration_method("integration_method", "Method used for stream line integration"),
             integration_direction("integration_direction", "Direction of integration"),
             min_steps_per_cell("min_steps_per_cell", "Minimum number of stream line integration steps per cell"),
@@ -70,7 +72,8 @@ namespace megamol
             stop("stop", "Stop the currently running integration processes"),
             reset("reset", "Reset and clear all previous results"),
             output("output", "Output next valid turn"),
-            num_threads(0), terminate(false), output_next(false)
+            process_seeds("process_seeds", "Search for periodic orbits from all input seed points"),
+            num_threads(0), generation(0), output_next(false)
         {
             // Connect output
             this->glyph_slot.SetCallback(glyph_data_call::ClassName(), glyph_data_call::FunctionName(0), &periodic_orbits::get_glyph_data_callback);
@@ -91,6 +94,9 @@ namespace megamol
             this->critical_points_slot.SetCompatibleCall<glyph_data_call::glyph_data_description>();
             this->MakeSlotAvailable(&this->critical_points_slot);
 
+            this->seed_points_slot.SetCompatibleCall<glyph_data_call::glyph_data_description>();
+            this->MakeSlotAvailable(&this->seed_points_slot);
+
             // Set parameters
             this->integration_method << new core::param::EnumParam(0);
             this->integration_method.Param<core::param::EnumParam>()->SetTypePair(static_cast<int>(integration_parameter_t::method_t::RUNGE_KUTTA_4), "Runge-Kutta 4 (fixed)");
@@ -147,27 +153,30 @@ namespace megamol
             this->output << new core::param::ButtonParam();
             this->output.SetUpdateCallback(&periodic_orbits::output_callback);
             this->MakeSlotAvailable(&this->output);
+
+            this->process_seeds << new core::param::ButtonParam();
+            this->process_seeds.SetUpdateCallback(&periodic_orbits::process_seeds_callback);
+            this->MakeSlotAvailable(&this->process_seeds);
         }
 
         periodic_orbits::~periodic_orbits()
         {
-            this->terminate = true;
-
-            while (this->num_threads != 0)
-            {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-
             this->Release();
         }
 
         bool periodic_orbits::create()
         {
+            this->pool = std::make_unique<task_pool>();
+
             return true;
         }
 
         void periodic_orbits::release()
         {
+            // Stop running extractions, and wait for them to finish
+            ++this->generation;
+
+            this->pool.reset();
         }
 
         bool periodic_orbits::get_glyph_data_callback(core::Call& call)
@@ -199,7 +208,7 @@ namespace megamol
                 {
                     std::lock_guard<std::mutex> locker(this->lock);
 
-                    if (this->num_threads != 0)
+                    if (this->pool->get_num_tasks() != 0)
                     {
                         return true;
                     }
@@ -248,7 +257,7 @@ namespace megamol
                         node_coordinates[d][cell_sizes[d].size()] = node_coordinates[d][cell_sizes[d].size() - 1] + cell_sizes[d][cell_sizes[d].size() - 1];
                     }
 
-                    this->grid = tpf::data::grid<double, double, 2, 2>("vector_field", extent, std::move(vectors),
+                    this->grid = std::make_shared<const tpf::data::grid<double, double, 2, 2>>("vector_field", extent, std::move(vectors),
                         std::move(cell_coordinates), std::move(node_coordinates), std::move(cell_sizes));
 
                     // Reset output
@@ -259,14 +268,18 @@ namespace megamol
                     this->orbit_cells.clear();
 
                     // Store critical points
-                    this->input_critical_points.reserve(critical_points.size());
+                    std::vector<std::pair<critical_points::type, Eigen::Vector2d>> input_critical_points;
+                    input_critical_points.reserve(critical_points.size());
 
                     for (const auto& critical_point : critical_points)
                     {
-                        this->input_critical_points.push_back(
+                        input_critical_points.push_back(
                             std::make_pair(static_cast<critical_points::type>(static_cast<int>(critical_point.second)),
                                 Eigen::Vector2d(critical_point.first[0], critical_point.first[1])));
                     }
+
+                    this->input_critical_points = std::make_shared<const std::vector<std::pair<critical_points::type, Eigen::Vector2d>>>(
+                        std::move(input_critical_points));
                 }
 
                 // Fill glyph call
@@ -311,25 +324,39 @@ namespace megamol
 
             std::lock_guard<std::mutex> locker(this->lock);
 
-            if (get_mouse_coordinates != nullptr && this->grid.get_num_elements() > 0)
+            if (get_mouse_coordinates != nullptr && this->grid != nullptr && this->grid->get_num_elements() > 0)
             {
                 const Eigen::Vector2d seed(get_mouse_coordinates->get_coordinates().first, get_mouse_coordinates->get_coordinates().second);
 
                 // Seed a stream lines
-                const auto direction = this->integration_direction.Param<core::param::EnumParam>()->Value();
+                enqueue_seed(seed);
+            }
 
-                if (direction == 0 || direction == 1)
-                {
-                    std::thread(&periodic_orbits::extract_periodic_orbit, this, this->grid, this->input_critical_points, seed, 1.0f).detach();
-                }
+            return true;
+        }
+
+        void periodic_orbits::enqueue_seed(const Eigen::Vector2d& seed)
+        {
+            const auto direction = this->integration_direction.Param<core::param::EnumParam>()->Value();
+
+            // Share vector field and critical points among all extractions
+            const auto grid = this->grid;
+            const auto input_critical_points = this->input_critical_points;
+            const std::size_t current_generation = this->generation;
 
-                if (direction == 0 || direction == 2)
+            for (const auto sign : { 1.0f, -1.0f })
+            {
+                if (direction == 0 || (direction == 1 && sign > 0.0f) || (direction == 2 && sign < 0.0f))
                 {
-                    std::thread(&periodic_orbits::extract_periodic_orbit, this, this->grid, this->input_critical_points, seed, -1.0f).detach();
+                    this->pool->enqueue([this, grid, input_critical_points, seed, sign, current_generation]()
+                        { this->extract_periodic_orbit(*grid, *input_critical_points, seed, sign, current_generation); });
                 }
             }
+        }
 
-            return true;
+        bool periodic_orbits::is_terminated(const integration_parameter_t& integration_parameter) const
+        {
+            return integration_parameter.generation != this->generation;
         }
 
         bool periodic_orbits::get_output_callback(core::Call& call)
@@ -342,11 +369,12 @@ namespace megamol
 
                 this->get_output = get_output_cb->GetCallback();
 
-                if (!this->output_critical_points_finished && this->output_critical_points.Param<core::param::BoolParam>()->Value())
+                if (!this->output_critical_points_finished && this->output_critical_points.Param<core::param::BoolParam>()->Value() &&
+                    this->input_critical_points != nullptr)
                 {
                     this->get_output() << "# Critical points" << std::endl;
 
-                    for (const auto& critical_point : this->input_critical_points)
+                    for (const auto& critical_point : *this->input_critical_points)
                     {
                         this->get_output() << critical_point.second[0] << "," << critical_point.second[1] << std::endl;
                     }
@@ -364,7 +392,11 @@ namespace megamol
         {
             std::lock_guard<std::mutex> locker(this->lock);
 
-            this->terminate = true;
+            // Stop running extractions and discard queued ones
+            ++this->generation;
+
+            vislib::sys::Log::DefaultLog.WriteInfo("Stopped search for periodic orbits, discarding %d queued seeds",
+                static_cast<int>(this->pool->cancel()));
 
             return true;
         }
@@ -373,6 +405,11 @@ namespace megamol
         {
             std::lock_guard<std::mutex> locker(this->lock);
 
+            // Stop running extractions and discard queued ones, as their results would be invalid
+            ++this->generation;
+
+            this->pool->cancel();
+
             this->line_output.clear();
             this->point_output.clear();
             ++this->glyph_hash;
@@ -393,8 +430,42 @@ namespace megamol
             return true;
         }
 
+        bool periodic_orbits::process_seeds_callback(core::param::ParamSlot&)
+        {
+            auto* get_seed_points = this->seed_points_slot.CallAs<glyph_data_call>();
+
+            if (get_seed_points == nullptr || !(*get_seed_points)(0))
+            {
+                vislib::sys::Log::DefaultLog.WriteWarn("No seed points available for searching periodic orbits");
+
+                return true;
+            }
+
+            const auto seed_points = get_seed_points->get_points();
+
+            std::lock_guard<std::mutex> locker(this->lock);
+
+            if (this->grid == nullptr || this->grid->get_num_elements() == 0)
+            {
+                vislib::sys::Log::DefaultLog.WriteWarn("No vector field available for searching periodic orbits");
+
+                return true;
+            }
+
+            for (const auto& seed_point : seed_points)
+            {
+                enqueue_seed(seed_point.first.cast<double>());
+            }
+
+            vislib::sys::Log::DefaultLog.WriteInfo("Queued %d seeds for searching periodic orbits on %d threads",
+                static_cast<int>(seed_points.size()), static_cast<int>(this->pool->get_num_threads()));
+
+            return true;
+        }
+
         void periodic_orbits::extract_periodic_orbit(const tpf::data::grid<double, double, 2, 2>& grid,
-            const std::vector<std::pair<critical_points::type, Eigen::Vector2d>>& input_critical_points, const Eigen::Vector2d& seed, const float sign)
+            const std::vector<std::pair<critical_points::type, Eigen::Vector2d>>& input_critical_points, const Eigen::Vector2d& seed, const float sign,
+            const std::size_t start_generation)
         {
             try
             {
@@ -409,6 +480,7 @@ namespace megamol
                 // Get parameters for stream line integration
                 integration_parameter_t integration;
                 integration.sign = sign;
+                integration.generation = start_generation;
 
                 float max_poincare_error;
 
@@ -421,8 +493,6 @@ namespace megamol
                 {
                     std::lock_guard<std::mutex> locker(this->lock);
 
-                    this->terminate = false;
-
                     vislib::sys::Log::DefaultLog.WriteInfo("Number of processes running: %d", ++this->num_threads);
 
                     vislib::sys::Log::DefaultLog.WriteInfo("Starting %s stream line at [%.5f, %.5f]", (sign < 0.0f) ? "backward" : "forward", seed[0], seed[1]);
@@ -456,12 +526,12 @@ namespace megamol
                 bool has_exit = true;
                 bool output_now = false;
 
-                while (has_exit && !this->terminate)
+                while (has_exit && !is_terminated(integration))
                 {
                     // Find turn
                     const auto visited_cells = find_turn(grid, input_critical_points, position, integration, critical_point_detection);
 
-                    if (!this->terminate)
+                    if (!is_terminated(integration))
                     {
                         if (visited_cells && !visited_cells->first.empty())
                         {
@@ -601,7 +671,7 @@ namespace megamol
                                 }
 
                                 // Add list of cells to already extracted periodic orbits
-                                if (!has_exit && !this->terminate && unique_detection)
+                                if (!has_exit && !is_terminated(integration) && unique_detection)
                                 {
                                     std::lock_guard<std::mutex> locker(this->lock);
 
@@ -640,7 +710,7 @@ namespace megamol
                     }
                 }
 
-                if (!this->terminate)
+                if (!is_terminated(integration))
                 {
                     // Use Poincar map for finding the closed stream line
                     if (!output_exit_streamline)
@@ -843,7 +913,7 @@ namespace megamol
 
             bool found_turn = false;
 
-            while (!found_turn && !this->terminate)
+            while (!found_turn && !is_terminated(integration_param))
             {
                 const auto old_position = position;
 
@@ -1034,7 +1104,7 @@ namespace megamol
             // Advect stream line while it corresponds to the input list of cells
             bool first_cell = true;
 
-            while (!this->terminate)
+            while (!is_terminated(integration_param))
             {
                 const auto old_position = position;
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "critical_points.h"
+#include "task_pool.h"
 
 #include "mmcore/Call.h"
 #include "mmcore/CalleeSlot.h"
@@ -22,8 +23,10 @@
 
 #include "Eigen/Dense"
 
+#include <atomic>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <set>
@@ -96,6 +99,9 @@ namespace megamol
             {
                 float sign;
 
+                /** Generation of the computation, which is terminated when the module's generation changes */
+                std::size_t generation;
+
                 enum class method_t
                 {
                     RUNGE_KUTTA_4,
@@ -125,9 +131,28 @@ namespace megamol
             * @param input_critical_points Critical points
             * @param seed Seed of the stream line used to find the periodic orbit
             * @param sign Direction of integration
+            * @param start_generation Generation at the time of queueing the extraction
             */
             void extract_periodic_orbit(const tpf::data::grid<double, double, 2, 2>& grid,
-                const std::vector<std::pair<critical_points::type, Eigen::Vector2d>>& input_critical_points, const Eigen::Vector2d& seed, float sign);
+                const std::vector<std::pair<critical_points::type, Eigen::Vector2d>>& input_critical_points, const Eigen::Vector2d& seed, float sign,
+                std::size_t start_generation);
+
+            /**
+            * Queue extraction of periodic orbits from a seed in the selected integration directions.
+            * The lock has to be held by the caller.
+            *
+            * @param seed Seed of the stream line used to find the periodic orbit
+            */
+            void enqueue_seed(const Eigen::Vector2d& seed);
+
+            /**
+            * Check if the computation was stopped after starting the integration
+            *
+            * @param integration_parameter Parameter for time step control, containing the generation
+            *
+            * @return True if terminated, false otherwise
+            */
+            bool is_terminated(const integration_parameter_t& integration_parameter) const;
 
             /**
             * Advect using the predefined method
@@ -271,6 +296,7 @@ namespace megamol
             bool stop_callback(core::param::ParamSlot&);
             bool reset_callback(core::param::ParamSlot&);
             bool output_callback(core::param::ParamSlot&);
+            bool process_seeds_callback(core::param::ParamSlot&);
 
             /** Output slot for the glyphs */
             core::CalleeSlot glyph_slot;
@@ -295,6 +321,9 @@ namespace megamol
             core::CallerSlot critical_points_slot;
             SIZE_T critical_points_hash;
 
+            /** Input slot for getting a list of seeds, processed on request */
+            core::CallerSlot seed_points_slot;
+
             /** Parameter for stream line integration */
             core::param::ParamSlot integration_method;
             core::param::ParamSlot integration_direction;
@@ -325,18 +354,26 @@ namespace megamol
             core::param::ParamSlot reset;
             core::param::ParamSlot output;
 
-            /** Stored vector field */
-            tpf::data::grid<double, double, 2, 2> grid;
+            /** Parameter for seeding from all input seed points */
+            core::param::ParamSlot process_seeds;
 
-            /** Stored critical points */
-            std::vector<std::pair<critical_points::type, Eigen::Vector2d>> input_critical_points;
+            /** Stored vector field, shared read-only with running extractions */
+            std::shared_ptr<const tpf::data::grid<double, double, 2, 2>> grid;
+
+            /** Stored critical points, shared read-only with running extractions */
+            std::shared_ptr<const std::vector<std::pair<critical_points::type, Eigen::Vector2d>>> input_critical_points;
 
             /** Mutex for synchronization */
             std::mutex lock;
             std::size_t num_threads;
 
-            bool terminate;
+            /** Generation of the computation, increased for stopping all running extractions */
+            std::atomic<std::size_t> generation;
+
             bool output_next;
+
+            /** Worker threads for extraction of periodic orbits */
+            std::unique_ptr<task_pool> pool;
         };
     }
 }
\ No newline at end of file
@@ -240,6 +240,9 @@ bool periodic_orbits_theisel::compute_periodic_orbits() {
 
         // Create grid containing the vector field
         const auto vector_field = create_grid();
+        const auto uniform_vector_field = make_uniform_vector_field(this->resolution, *this->grid_positions, *this->vectors);
+
+        particle_batch particles;
 
         // Get seed lines
         std::vector<std::pair<Eigen::Vector2f, Eigen::Vector2f>> seed_lines;
@@ -379,14 +382,12 @@ bool periodic_orbits_theisel::compute_periodic_orbits() {
             advected_forward_points.reserve(num_seed_points);
             advected_backward_points.reserve(num_seed_points);
 
+            advection_cache forward_refinement_cache, backward_refinement_cache;
+
             for (std::size_t integration = 0; integration < num_integration_steps; ++integration) {
                 // Advect forward stream surface
-                advected_forward_points.clear();
-
-                for (std::size_t point_index = 0; point_index < previous_forward_points.size(); ++point_index) {
-                    advected_forward_points.push_back(advect_point(
-                        vector_field, previous_forward_points[point_index], forward_timesteps[point_index], true));
-                }
+                advect_points(uniform_vector_field, previous_forward_points, forward_timesteps, true, particles,
+                    advected_forward_points);
 
                 forward_points.insert(forward_points.end(), advected_forward_points.begin(), advected_forward_points.end());
 
@@ -404,7 +405,8 @@ bool periodic_orbits_theisel::compute_periodic_orbits() {
                             const auto refined_intersections =
                                 refine_intersections(vector_field, seed_line_start, direction, step, timestep,
                                     integration, previous_forward_points, previous_backward_points,
-                                    advected_forward_points, advected_backward_points, intersection_points);
+                                    advected_forward_points, advected_backward_points, intersection_points,
+                                    forward_refinement_cache, backward_refinement_cache);
 
                             for (const auto& refined_intersection : refined_intersections) {
                                 this->periodic_orbits.push_back(std::make_pair(0.0f, refined_intersection));
@@ -420,12 +422,8 @@ bool periodic_orbits_theisel::compute_periodic_orbits() {
                 std::swap(previous_forward_points, advected_forward_points);
 
                 // Advect backward stream surface
-                advected_backward_points.clear();
-
-                for (std::size_t point_index = 0; point_index < previous_backward_points.size(); ++point_index) {
-                    advected_backward_points.push_back(advect_point(
-                        vector_field, previous_backward_points[point_index], backward_timesteps[point_index], false));
-                }
+                advect_points(uniform_vector_field, previous_backward_points, backward_timesteps, false, particles,
+                    advected_backward_points);
 
                 backward_points.insert(backward_points.end(), advected_backward_points.begin(), advected_backward_points.end());
 
@@ -443,7 +441,8 @@ bool periodic_orbits_theisel::compute_periodic_orbits() {
                             const auto refined_intersections =
                                 refine_intersections(vector_field, seed_line_start, direction, step, timestep,
                                     integration, previous_forward_points, previous_backward_points,
-                                    advected_forward_points, advected_backward_points, intersection_points);
+                                    advected_forward_points, advected_backward_points, intersection_points,
+                                    forward_refinement_cache, backward_refinement_cache);
 
                             for (const auto& refined_intersection : refined_intersections) {
                                 this->periodic_orbits.push_back(std::make_pair(0.0f, refined_intersection));
@@ -670,6 +669,43 @@ Eigen::Vector3f periodic_orbits_theisel::advect_point(const tpf::data::grid<floa
     return Eigen::Vector3f(advected_point[0], advected_point[1], point[2]);
 }
 
+void periodic_orbits_theisel::advect_points(const uniform_vector_field_2d& vector_field,
+    const std::vector<Eigen::Vector3f>& points, std::vector<float>& deltas, const bool forward,
+    particle_batch& particles, std::vector<Eigen::Vector3f>& advected_points) const {
+
+    // Points with zero time step have left the domain before and are not advected any further
+    particles.resize(points.size());
+
+    for (std::size_t point_index = 0; point_index < points.size(); ++point_index) {
+        particles.x[point_index] = points[point_index][0];
+        particles.y[point_index] = points[point_index][1];
+        particles.delta[point_index] = deltas[point_index];
+        particles.active[point_index] = deltas[point_index] != 0.0f ? 1 : 0;
+    }
+
+    // Advect
+    switch (this->integration_method.Param<core::param::EnumParam>()->Value()) {
+    case 0:
+        advect_points_rk4(vector_field, particles, forward);
+        break;
+    case 1:
+        advect_points_rk45(
+            vector_field, particles, this->max_integration_error.Param<core::param::FloatParam>()->Value(), forward);
+        break;
+    default:
+        vislib::sys::Log::DefaultLog.WriteError("Unknown advection method selected");
+    }
+
+    // Set output
+    advected_points.resize(points.size());
+
+    for (std::size_t point_index = 0; point_index < points.size(); ++point_index) {
+        advected_points[point_index] =
+            Eigen::Vector3f(particles.x[point_index], particles.y[point_index], points[point_index][2]);
+        deltas[point_index] = particles.active[point_index] != 0 ? particles.delta[point_index] : 0.0f;
+    }
+}
+
 std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>> periodic_orbits_theisel::find_intersection(
     const std::vector<Eigen::Vector3f>& previous_forward_points,
     const std::vector<Eigen::Vector3f>& previous_backward_points,
@@ -680,7 +716,41 @@ std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>> periodic_orbi
 
     std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>> intersections;
 
+    if (num_seed_points < 2 || previous_backward_points.size() < 2) {
+        return intersections;
+    }
+
+    // Index the quads of the backward triangle strip by their bounding boxes, such that only
+    // overlapping quads have to be tested for intersection
+    const auto get_quad_box = [](const std::vector<Eigen::Vector3f>& previous_points,
+                                  const std::vector<Eigen::Vector3f>& advected_points, const std::size_t index) {
+        aabb_grid::box_t box(previous_points[index]);
+        box.extend(previous_points[index + 1]);
+        box.extend(advected_points[index]);
+        box.extend(advected_points[index + 1]);
+
+        return box;
+    };
+
+    std::vector<aabb_grid::box_t> backward_boxes(previous_backward_points.size() - 1);
+
+    for (std::size_t bwd_point_index = 0; bwd_point_index < backward_boxes.size(); ++bwd_point_index) {
+        backward_boxes[bwd_point_index] =
+            get_quad_box(previous_backward_points, advected_backward_points, bwd_point_index);
+    }
+
+    this->intersection_grid.build(backward_boxes);
+
+    std::vector<std::size_t> candidates;
+
     for (std::size_t fwd_point_index = 0; fwd_point_index < num_seed_points - 1; ++fwd_point_index) {
+        this->intersection_grid.query(
+            get_quad_box(previous_forward_points, advected_forward_points, fwd_point_index), candidates);
+
+        if (candidates.empty()) {
+            continue;
+        }
+
         const kernel_t::Point_3 fwd_point_1(previous_forward_points[fwd_point_index][0],
             previous_forward_points[fwd_point_index][1], previous_forward_points[fwd_point_index][2]);
         const kernel_t::Point_3 fwd_point_2(previous_forward_points[fwd_point_index + 1][0],
@@ -693,7 +763,7 @@ std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>> periodic_orbi
         const kernel_t::Triangle_3 fwd_triangle_1(fwd_point_1, fwd_point_3, fwd_point_4);
         const kernel_t::Triangle_3 fwd_triangle_2(fwd_point_1, fwd_point_4, fwd_point_2);
 
-        for (std::size_t bwd_point_index = 0; bwd_point_index < num_seed_points - 1; ++bwd_point_index) {
+        for (const auto bwd_point_index : candidates) {
             const kernel_t::Point_3 bwd_point_1(previous_backward_points[bwd_point_index][0],
                 previous_backward_points[bwd_point_index][1], previous_backward_points[bwd_point_index][2]);
             const kernel_t::Point_3 bwd_point_2(previous_backward_points[bwd_point_index + 1][0],
@@ -751,12 +821,29 @@ std::vector<Eigen::Vector2f> periodic_orbits_theisel::refine_intersections(
     const std::vector<Eigen::Vector3f>& previous_backward_points,
     const std::vector<Eigen::Vector3f>& advected_forward_points,
     const std::vector<Eigen::Vector3f>& advected_backward_points,
-    const std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>>& intersections) const {
+    const std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>>& intersections,
+    advection_cache& forward_cache, advection_cache& backward_cache) const {
 
     const auto num_subdivisions = this->num_subdivisions.Param<core::param::IntParam>()->Value();
 
     std::vector<Eigen::Vector2f> refined_intersections;
 
+    const auto advance_seed = [&](advection_cache& cache, const float seed_line_position, const bool forward) {
+        auto state = cache.find(seed_line_position);
+
+        if (state == cache.end()) {
+            state = cache.insert(std::make_pair(seed_line_position,
+                advection_state{seed_line_start + (seed_line_position * seed_line_step) * seed_line_direction,
+                    timestep, 0})).first;
+        }
+
+        for (; state->second.num_integrations < integration; ++state->second.num_integrations) {
+            state->second.point = advect_point(vector_field, state->second.point, state->second.delta, forward);
+        }
+
+        return state->second;
+    };
+
     for (const auto& intersection_point : intersections) {
         // Seed a new point for each subdivision and check intersection again
         float step_fwd_low = static_cast<float>(std::get<1>(intersection_point));
@@ -777,17 +864,15 @@ std::vector<Eigen::Vector2f> periodic_orbits_theisel::refine_intersections(
             const float step_fwd_ref = 0.5f * (step_fwd_low + step_fwd_hi);
             const float step_bwd_ref = 0.5f * (step_bwd_low + step_bwd_hi);
 
-            Eigen::Vector3f seed_point_fwd = seed_line_start + (step_fwd_ref * seed_line_step) * seed_line_direction;
-            Eigen::Vector3f seed_point_bwd = seed_line_start + (step_bwd_ref * seed_line_step) * seed_line_direction;
+            // Advect new seed points, continuing from their state at a previous integration step if available
+            const auto state_fwd = advance_seed(forward_cache, step_fwd_ref, true);
+            const auto state_bwd = advance_seed(backward_cache, step_bwd_ref, false);
 
-            float delta_fwd = timestep;
-            float delta_bwd = timestep;
+            const Eigen::Vector3f seed_point_fwd = state_fwd.point;
+            const Eigen::Vector3f seed_point_bwd = state_bwd.point;
 
-            // Advect new seed points
-            for (std::size_t ref_integration = 0; ref_integration < integration; ++ref_integration) {
-                seed_point_fwd = advect_point(vector_field, seed_point_fwd, delta_fwd, true);
-                seed_point_bwd = advect_point(vector_field, seed_point_bwd, delta_bwd, false);
-            }
+            float delta_fwd = state_fwd.delta;
+            float delta_bwd = state_bwd.delta;
 
             const Eigen::Vector3f adv_point_fwd = advect_point(vector_field, seed_point_fwd, delta_fwd, true);
             const Eigen::Vector3f adv_point_bwd = advect_point(vector_field, seed_point_bwd, delta_bwd, true);
@@ -6,8 +6,11 @@
  */
 #pragma once
 
+#include "aabb_grid.h"
 #include "mesh_data_call.h"
 
+#include "flowvis/integrator.h"
+
 #include "mmcore/Call.h"
 #include "mmcore/CalleeSlot.h"
 #include "mmcore/CallerSlot.h"
@@ -28,6 +31,7 @@
 #include <array>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -118,6 +122,19 @@ namespace megamol
              */
             Eigen::Vector3f advect_point(const tpf::data::grid<float, float, 2, 2>& grid, const Eigen::Vector3f& point, float& delta, bool forward) const;
 
+            /**
+             * Advect all given points at once with the selected integration method
+             *
+             * @param vector_field Vector field
+             * @param points Points to advect
+             * @param deltas Time step sizes, which can be adjusted by the integration method; set to zero if the point left the domain
+             * @param forward True: forward integration, false: reverse integration
+             * @param particles Buffer for advection, reused across calls
+             * @param advected_points Advected points
+             */
+            void advect_points(const uniform_vector_field_2d& vector_field, const std::vector<Eigen::Vector3f>& points,
+                std::vector<float>& deltas, bool forward, particle_batch& particles, std::vector<Eigen::Vector3f>& advected_points) const;
+
             /**
              * Find intersection between two triangle strips
              *
@@ -135,6 +152,18 @@ namespace megamol
                 const std::vector<Eigen::Vector3f>& advected_forward_points,
                 const std::vector<Eigen::Vector3f>& advected_backward_points) const;
 
+            /**
+             * State of a point advected from the seed line
+             */
+            struct advection_state {
+                Eigen::Vector3f point;
+                float delta;
+                std::size_t num_integrations;
+            };
+
+            /** Advection states of refinement seeds, identified by their position on the seed line */
+            using advection_cache = std::map<float, advection_state>;
+
             /**
              * Refine the triangle strips at the intersection by seeding new points on the seed line
              * in a binary search manner
@@ -150,6 +179,8 @@ namespace megamol
              * @param advected_forward_points Other side of the first triangle strip
              * @param advected_backward_points Other side of the second triangle strip
              * @param intersections Found intersections, for which the refinement is performed
+             * @param forward_cache Advection states of forward refinement seeds, which are reused and updated
+             * @param backward_cache Advection states of backward refinement seeds, which are reused and updated
              *
              * @returns The refined intersections, which after refinement still hold
              */
@@ -161,7 +192,8 @@ namespace megamol
                 const std::vector<Eigen::Vector3f>& previous_backward_points,
                 const std::vector<Eigen::Vector3f>& advected_forward_points,
                 const std::vector<Eigen::Vector3f>& advected_backward_points,
-                const std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>>& intersections) const;
+                const std::vector<std::tuple<Eigen::Vector2f, std::size_t, std::size_t>>& intersections,
+                advection_cache& forward_cache, advection_cache& backward_cache) const;
 
             /** Callbacks for the computed periodic orbits */
             bool get_periodic_orbits_data(core::Call& call);
@@ -244,6 +276,9 @@ namespace megamol
             SIZE_T periodic_orbits_hash;
 
             std::vector<std::pair<float, Eigen::Vector2f>> periodic_orbits;
+
+            /** Spatial index for intersection tests, kept for reusing its memory */
+            mutable aabb_grid intersection_grid;
         };
     }
 }
@@ -0,0 +1,128 @@
+/*
+ * recyclable.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        /**
+        * Buffer owned by a producer, which shares it with consumers and writes it again once they released it.
+        *
+        * Consumers receive a shared pointer with its own reference count. Dropping the last of these references
+        * sets a flag with release semantics, which the producer checks with acquire semantics. Thus, all reads by
+        * consumers happen before the producer writes the buffer again, regardless of the thread releasing it.
+        *
+        * @author Alexander Straub
+        */
+        template <typename T>
+        class recyclable
+        {
+        public:
+            /**
+            * Initialize without a buffer
+            */
+            recyclable() = default;
+
+            /**
+            * Take ownership of a buffer that has not been shared yet
+            *
+            * @param data   Buffer
+            */
+            explicit recyclable(std::shared_ptr<T> data) : data(std::move(data))
+            { }
+
+            /**
+            * Adopt a buffer that may be referenced elsewhere already, and which is thus never released
+            *
+            * @param data   Buffer
+            *
+            * @return Buffer, which is shared as the given pointer
+            */
+            static recyclable adopt(std::shared_ptr<T> data)
+            {
+                recyclable buffer(std::move(data));
+
+                buffer.handle = buffer.data;
+                buffer.released = std::make_shared<std::atomic<bool>>(false);
+
+                return buffer;
+            }
+
+            /**
+            * Share the buffer with consumers; the same pointer is returned while it is still referenced
+            *
+            * @return Buffer for read-only access by consumers
+            */
+            std::shared_ptr<T> share()
+            {
+                auto shared = this->handle.lock();
+
+                if (shared == nullptr && this->data != nullptr)
+                {
+                    auto data = this->data;
+                    auto released = std::make_shared<std::atomic<bool>>(false);
+
+                    shared = std::shared_ptr<T>(data.get(),
+                        [data, released](T*) { released->store(true, std::memory_order_release); });
+
+                    this->handle = shared;
+                    this->released = std::move(released);
+                }
+
+                return shared;
+            }
+
+            /**
+            * Check if all consumers released the buffer, such that it can be written
+            *
+            * @return True if the buffer was never shared or has been released
+            */
+            bool is_released() const
+            {
+                return this->released == nullptr || this->released->load(std::memory_order_acquire);
+            }
+
+            /**
+            * Get access to the buffer
+            *
+            * @return Buffer
+            */
+            T& operator*() const
+            {
+                return *this->data;
+            }
+
+            T* operator->() const
+            {
+                return this->data.get();
+            }
+
+            /**
+            * Check if a buffer is held
+            *
+            * @return True if a buffer is held
+            */
+            explicit operator bool() const
+            {
+                return this->data != nullptr;
+            }
+
+        private:
+            /** Buffer */
+            std::shared_ptr<T> data;
+
+            /** Pointer handed out to consumers, and the flag set when its last reference is dropped */
+            std::weak_ptr<T> handle;
+            std::shared_ptr<std::atomic<bool>> released;
+        };
+    }
+}
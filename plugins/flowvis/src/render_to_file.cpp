@@ -8,13 +8,17 @@
 
 #include "render_to_file.h"
 
+#include "mmcore/CoreInstance.h"
 #include "mmcore/job/TickCall.h"
 #include "mmcore/param/ButtonParam.h"
 #include "mmcore/param/EnumParam.h"
 #include "mmcore/param/FilePathParam.h"
+#include "mmcore/param/FloatParam.h"
 #include "mmcore/param/IntParam.h"
+#include "mmcore/param/StringParam.h"
 #include "mmcore/view/CallRenderView.h"
 
+#include "vislib/String.h"
 #include "vislib/Trace.h"
 #include "vislib/graphics/gl/FramebufferObject.h"
 #include "vislib/sys/FastFile.h"
@@ -23,7 +27,11 @@
 #include "png.h"
 
 #include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace {
@@ -68,6 +76,134 @@ static void PNGAPI myPngFlush(png_structp pngPtr) {
     vislib::sys::File* f = static_cast<vislib::sys::File*>(png_get_io_ptr(pngPtr));
     f->Flush();
 }
+
+/** Output formats */
+enum output_format_t { PNG = 0, RAW = 1 };
+
+/**
+ * Write image to PNG file
+ *
+ * @param path Output file path
+ * @param width Image width
+ * @param height Image height
+ * @param buffer RGBA image data, starting with the bottom row
+ *
+ * @return Success
+ */
+bool write_png(const std::string& path, const unsigned int width, const unsigned int height,
+    const std::vector<uint8_t>& buffer) {
+
+    static_assert(sizeof(GLubyte) == sizeof(uint8_t) && sizeof(uint8_t) == sizeof(png_byte), "Mismatching data types");
+
+    vislib::sys::FastFile file;
+
+    if (!file.Open(path.c_str(), vislib::sys::File::WRITE_ONLY, vislib::sys::File::SHARE_EXCLUSIVE,
+            vislib::sys::File::CREATE_OVERWRITE)) {
+        vislib::sys::Log::DefaultLog.WriteError("Cannot open output file '%s'", path.c_str());
+        return false;
+    }
+
+    auto png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, &myPngError, &myPngWarn);
+    if (png_ptr == nullptr) {
+        vislib::sys::Log::DefaultLog.WriteError("Cannot create png structure");
+        return false;
+    }
+
+    auto png_info_ptr = png_create_info_struct(png_ptr);
+    if (png_info_ptr == nullptr) {
+        vislib::sys::Log::DefaultLog.WriteError("Cannot create png info");
+        png_destroy_write_struct(&png_ptr, nullptr);
+        return false;
+    }
+
+    png_set_write_fn(png_ptr, static_cast<void*>(&file), &myPngWrite, &myPngFlush);
+    png_set_IHDR(png_ptr, png_info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+        PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    bool success = true;
+
+    try {
+        std::vector<uint8_t*> rows(height);
+
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            rows[rows.size() - (1 + i)] = const_cast<uint8_t*>(buffer.data()) + sizeof(uint8_t) * i * 4 * width;
+        }
+
+        png_set_rows(png_ptr, png_info_ptr, rows.data());
+        png_write_png(png_ptr, png_info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+    } catch (...) {
+        vislib::sys::Log::DefaultLog.WriteError("Cannot write png file '%s'", path.c_str());
+        success = false;
+    }
+
+    png_destroy_write_struct(&png_ptr, &png_info_ptr);
+
+    file.Close();
+
+    return success;
+}
+
+/**
+ * Write image as raw RGBA data, starting with the top row
+ *
+ * @param path Output file path
+ * @param width Image width
+ * @param height Image height
+ * @param buffer RGBA image data, starting with the bottom row
+ *
+ * @return Success
+ */
+bool write_raw(const std::string& path, const unsigned int width, const unsigned int height,
+    const std::vector<uint8_t>& buffer) {
+
+    vislib::sys::FastFile file;
+
+    if (!file.Open(path.c_str(), vislib::sys::File::WRITE_ONLY, vislib::sys::File::SHARE_EXCLUSIVE,
+            vislib::sys::File::CREATE_OVERWRITE)) {
+        vislib::sys::Log::DefaultLog.WriteError("Cannot open output file '%s'", path.c_str());
+        return false;
+    }
+
+    const std::size_t row_size = static_cast<std::size_t>(width) * 4;
+
+    for (std::size_t i = 0; i < height; ++i) {
+        if (file.Write(buffer.data() + (height - (1 + i)) * row_size, row_size) != row_size) {
+            vislib::sys::Log::DefaultLog.WriteError("Cannot write raw file '%s'", path.c_str());
+            return false;
+        }
+    }
+
+    file.Close();
+
+    return true;
+}
+
+/**
+ * Get file path for a frame of a sequence, inserting the frame number before the extension
+ *
+ * @param path Output file path
+ * @param frame Frame number
+ * @param num_frames Number of frames in the sequence; the path is returned unchanged for single frames
+ *
+ * @return File path for the frame
+ */
+std::string get_frame_path(const std::string& path, const unsigned int frame, const unsigned int num_frames) {
+    if (num_frames <= 1) {
+        return path;
+    }
+
+    std::array<char, 16> number;
+    std::snprintf(number.data(), number.size(), "_%05u", frame);
+
+    const auto separator = path.find_last_of("/\\");
+    const auto extension = path.find_last_of('.');
+
+    if (extension == std::string::npos || (separator != std::string::npos && extension < separator)) {
+        return path + number.data();
+    }
+
+    return path.substr(0, extension) + number.data() + path.substr(extension);
+}
 } // namespace
 
 namespace megamol {
@@ -84,7 +220,16 @@ render_to_file::render_to_file(void)
     , fbo_height("height", "Output height")
     , fbo_viewport("viewport", "Viewport options to set viewport of file output")
     , output_file("output_file", "Output file path")
-    , trigger("trigger", "Write the rendering to file") {
+    , output_format("output_format", "Output file format")
+    , sequence_length("sequence_length", "Number of frames to record, numbered in the file names if larger than one")
+    , sequence_time_step("sequence_time_step", "Time step between consecutive frames of a sequence")
+    , sweep_parameter("sweep_parameter",
+          "Full name of a parameter to sweep over the frames of a sequence, e.g. '::inst::module::param'; empty for none")
+    , sweep_start("sweep_start", "Value of the swept parameter at the first frame")
+    , sweep_end("sweep_end", "Value of the swept parameter at the last frame")
+    , trigger("trigger", "Write the rendering to file")
+    , pbos_initialized(false)
+    , next_pbo(0) {
 
     this->viewSlot.SetCompatibleCall<core::view::CallRenderViewDescription>();
     this->MakeSlotAvailable(&this->viewSlot);
@@ -103,6 +248,26 @@ render_to_file::render_to_file(void)
     this->output_file << new core::param::FilePathParam("");
     this->MakeSlotAvailable(&this->output_file);
 
+    this->output_format << new core::param::EnumParam(PNG);
+    this->output_format.Param<core::param::EnumParam>()->SetTypePair(PNG, "PNG");
+    this->output_format.Param<core::param::EnumParam>()->SetTypePair(RAW, "Raw RGBA");
+    this->MakeSlotAvailable(&this->output_format);
+
+    this->sequence_length << new core::param::IntParam(1, 1);
+    this->MakeSlotAvailable(&this->sequence_length);
+
+    this->sequence_time_step << new core::param::FloatParam(1.0f);
+    this->MakeSlotAvailable(&this->sequence_time_step);
+
+    this->sweep_parameter << new core::param::StringParam("");
+    this->MakeSlotAvailable(&this->sweep_parameter);
+
+    this->sweep_start << new core::param::FloatParam(0.0f);
+    this->MakeSlotAvailable(&this->sweep_start);
+
+    this->sweep_end << new core::param::FloatParam(1.0f);
+    this->MakeSlotAvailable(&this->sweep_end);
+
     this->trigger << new core::param::ButtonParam(core::view::Key::KEY_S, core::view::Modifier::ALT);
     this->trigger.SetUpdateCallback(&render_to_file::record);
     this->MakeSlotAvailable(&this->trigger);
@@ -189,6 +354,9 @@ void render_to_file::Render(const mmcRenderViewContext& context) {
  * render_to_file::record
  */
 bool render_to_file::record(core::param::ParamSlot&) {
+    // Hand finished frames of previous recordings to the encoders
+    this->finish_frames(false);
+
     // Get parameters
     const auto fbo_viewport = this->fbo_viewport.Param<core::param::EnumParam>()->Value();
 
@@ -199,26 +367,65 @@ bool render_to_file::record(core::param::ParamSlot&) {
                                 ? this->height
                                 : static_cast<unsigned int>(this->fbo_height.Param<core::param::IntParam>()->Value());
 
-    const auto output_file = this->output_file.Param<core::param::FilePathParam>()->Value();
+    const std::string output_file(
+        vislib::StringA(this->output_file.Param<core::param::FilePathParam>()->Value()).PeekBuffer());
+    const auto output_format = this->output_format.Param<core::param::EnumParam>()->Value();
 
-    // Set up fbo
-    vislib::graphics::gl::FramebufferObject fbo;
+    const auto num_frames = static_cast<unsigned int>(this->sequence_length.Param<core::param::IntParam>()->Value());
+    const auto time_step = this->sequence_time_step.Param<core::param::FloatParam>()->Value();
 
-    std::array<vislib::graphics::gl::FramebufferObject::ColourAttachParams, 1> cap;
-    cap[0].internalFormat = GL_RGBA8;
-    cap[0].format = GL_RGBA;
-    cap[0].type = GL_UNSIGNED_BYTE;
+    const vislib::StringA sweep_name(this->sweep_parameter.Param<core::param::StringParam>()->Value());
+    const auto sweep_start = this->sweep_start.Param<core::param::FloatParam>()->Value();
+    const auto sweep_end = this->sweep_end.Param<core::param::FloatParam>()->Value();
 
-    vislib::graphics::gl::FramebufferObject::DepthAttachParams dap;
-    dap.format = GL_DEPTH_COMPONENT24;
-    dap.state = vislib::graphics::gl::FramebufferObject::ATTACHMENT_DISABLED;
+    // Find parameter to sweep, remembering its value for restoring it after recording
+    vislib::SmartPtr<core::param::AbstractParam> sweep_param;
+    vislib::TString sweep_original_value;
 
-    vislib::graphics::gl::FramebufferObject::StencilAttachParams sap;
-    sap.format = GL_STENCIL_INDEX;
-    sap.state = vislib::graphics::gl::FramebufferObject::ATTACHMENT_DISABLED;
+    if (!sweep_name.IsEmpty()) {
+        if (this->GetCoreInstance() != nullptr) {
+            sweep_param = this->GetCoreInstance()->FindParameter(sweep_name, true);
+        }
+
+        if (sweep_param.IsNull()) {
+            vislib::sys::Log::DefaultLog.WriteWarn(
+                "Parameter '%s' to sweep not found; recording without sweep", sweep_name.PeekBuffer());
+        } else {
+            sweep_original_value = sweep_param->ValueString();
+        }
+    }
+
+    // Set up fbo, if it does not fit the requested size
+    if (!this->fbo.IsValid() || this->fbo.GetWidth() != fbo_width || this->fbo.GetHeight() != fbo_height) {
+        this->fbo.Release();
 
-    fbo.Create(fbo_width, fbo_height, cap.size(), cap.data(), dap, sap);
-    fbo.Disable();
+        std::array<vislib::graphics::gl::FramebufferObject::ColourAttachParams, 1> cap;
+        cap[0].internalFormat = GL_RGBA8;
+        cap[0].format = GL_RGBA;
+        cap[0].type = GL_UNSIGNED_BYTE;
+
+        vislib::graphics::gl::FramebufferObject::DepthAttachParams dap;
+        dap.format = GL_DEPTH_COMPONENT24;
+        dap.state = vislib::graphics::gl::FramebufferObject::ATTACHMENT_DISABLED;
+
+        vislib::graphics::gl::FramebufferObject::StencilAttachParams sap;
+        sap.format = GL_STENCIL_INDEX;
+        sap.state = vislib::graphics::gl::FramebufferObject::ATTACHMENT_DISABLED;
+
+        if (!this->fbo.Create(fbo_width, fbo_height, cap.size(), cap.data(), dap, sap)) {
+            vislib::sys::Log::DefaultLog.WriteError("Cannot create framebuffer of size %u x %u", fbo_width, fbo_height);
+            return false;
+        }
+
+        this->fbo.Disable();
+    }
+
+    // Create pixel buffers for read back
+    if (!this->pbos_initialized) {
+        glGenBuffers(static_cast<GLsizei>(this->pbos.size()), this->pbos.data());
+
+        this->pbos_initialized = true;
+    }
 
     // Save state
     std::array<float, 4> clear_color;
@@ -239,21 +446,63 @@ bool render_to_file::record(core::param::ParamSlot&) {
         }
     }
 
-    // Render
-    fbo.Enable();
+    // Render frames, and start reading them back asynchronously
+    const auto size = static_cast<std::size_t>(fbo_width) * fbo_height * 4 * sizeof(GLubyte);
 
-    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (unsigned int frame = 0; frame < num_frames; ++frame) {
+        this->fbo.Enable();
 
-    mmcRenderViewContext context;
-    ::ZeroMemory(&context, sizeof(context));
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    context.Time = this->time;
-    context.InstanceTime = this->instance_time;
+        mmcRenderViewContext context;
+        ::ZeroMemory(&context, sizeof(context));
 
-    this->Render(context);
+        context.Time = this->time + frame * time_step;
+        context.InstanceTime = this->instance_time;
+
+        if (!sweep_param.IsNull()) {
+            const auto factor = num_frames > 1 ? static_cast<float>(frame) / (num_frames - 1) : 0.0f;
+            const auto value = sweep_start + factor * (sweep_end - sweep_start);
+
+            if (!sweep_param->ParseValue(vislib::TString(std::to_string(value).c_str()))) {
+                vislib::sys::Log::DefaultLog.WriteWarn(
+                    "Cannot set swept parameter '%s' to %f", sweep_name.PeekBuffer(), value);
+            }
+        }
 
-    fbo.Disable();
+        this->Render(context);
+
+        // Wait for the oldest frame if all pixel buffers are in use
+        while (this->pending_frames.size() >= this->pbos.size()) {
+            this->finish_oldest_frame(true);
+        }
+
+        pending_frame_t pending_frame;
+        pending_frame.pbo = this->pbos[this->next_pbo];
+        pending_frame.width = fbo_width;
+        pending_frame.height = fbo_height;
+        pending_frame.format = output_format;
+        pending_frame.path = get_frame_path(output_file, frame, num_frames);
+
+        this->next_pbo = (this->next_pbo + 1) % this->pbos.size();
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pending_frame.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+        glReadPixels(0, 0, fbo_width, fbo_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        pending_frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        this->pending_frames.push_back(pending_frame);
+
+        this->fbo.Disable();
+    }
+
+    // Restore swept parameter
+    if (!sweep_param.IsNull()) {
+        sweep_param->ParseValue(sweep_original_value);
+    }
 
     // Restore viewport
     this->vp_width = this->width;
@@ -271,65 +520,81 @@ bool render_to_file::record(core::param::ParamSlot&) {
     // Restore state
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
 
-    // Download texture data
-    static_assert(sizeof(GLubyte) == sizeof(uint8_t) && sizeof(uint8_t) == sizeof(png_byte), "Mismatching data types");
+    return true;
+}
 
-    std::vector<uint8_t> buffer(static_cast<std::size_t>(fbo_width) * fbo_height * 4 * sizeof(GLubyte));
 
-    fbo.BindColourTexture(0);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
-    glBindTexture(GL_TEXTURE_2D, 0);
+/*
+ * render_to_file::finish_oldest_frame
+ */
+bool render_to_file::finish_oldest_frame(const bool wait) {
+    const auto frame = this->pending_frames.front();
 
-    // Save to file
-    vislib::sys::FastFile file;
+    // Check if the read back has finished
+    const GLuint64 timeout = wait ? 1000000000ull : 0ull;
 
-    if (!file.Open(output_file.PeekBuffer(), vislib::sys::File::WRITE_ONLY, vislib::sys::File::SHARE_EXCLUSIVE,
-            vislib::sys::File::CREATE_OVERWRITE)) {
-        vislib::sys::Log::DefaultLog.WriteError("Cannot open output file");
-        return false;
-    }
+    GLenum status;
 
-    auto png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, &myPngError, &myPngWarn);
-    if (png_ptr == nullptr) {
-        vislib::sys::Log::DefaultLog.WriteError("Cannot create png structure");
+    do {
+        status = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    } while (wait && status == GL_TIMEOUT_EXPIRED);
+
+    if (status == GL_TIMEOUT_EXPIRED) {
         return false;
     }
 
-    auto png_info_ptr = png_create_info_struct(png_ptr);
-    if (png_info_ptr == nullptr) {
-        vislib::sys::Log::DefaultLog.WriteError("Cannot create png info");
-        return false;
+    glDeleteSync(frame.fence);
+
+    this->pending_frames.pop_front();
+
+    if (status == GL_WAIT_FAILED) {
+        vislib::sys::Log::DefaultLog.WriteError("Failed to read back frame for file '%s'", frame.path.c_str());
+        return true;
     }
 
-    png_set_write_fn(png_ptr, static_cast<void*>(&file), &myPngWrite, &myPngFlush);
-    png_set_IHDR(png_ptr, png_info_ptr, fbo_width, fbo_height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
-        PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    // Copy frame from the pixel buffer
+    const auto size = static_cast<std::size_t>(frame.width) * frame.height * 4 * sizeof(GLubyte);
 
-    try {
-        std::vector<uint8_t*> rows(fbo_height);
+    auto buffer = std::make_shared<std::vector<uint8_t>>(size);
 
-        for (std::size_t i = 0; i < rows.size(); ++i) {
-            rows[rows.size() - (1 + i)] = buffer.data() + sizeof(uint8_t) * i * 4 * fbo_width;
-        }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, frame.pbo);
 
-        png_set_rows(png_ptr, png_info_ptr, rows.data());
-        png_write_png(png_ptr, png_info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-    } catch (...) {
-        vislib::sys::Log::DefaultLog.WriteError("Cannot write png file");
-        return false;
+    const auto* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+
+    if (data != nullptr) {
+        std::memcpy(buffer->data(), data, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
     }
 
-    if (png_ptr != nullptr) {
-        if (png_info_ptr != nullptr) {
-            png_destroy_write_struct(&png_ptr, &png_info_ptr);
-        } else {
-            png_destroy_write_struct(&png_ptr, nullptr);
-        }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (data == nullptr) {
+        vislib::sys::Log::DefaultLog.WriteError("Failed to map pixel buffer for file '%s'", frame.path.c_str());
+        return true;
     }
 
-    file.Close();
+    // Limit the number of frames waiting for encoding, to bound memory consumption
+    this->encoders->wait(2 * this->encoders->get_num_threads() - 1);
+
+    this->encoders->enqueue([frame, buffer]() {
+        const auto success = frame.format == RAW ? write_raw(frame.path, frame.width, frame.height, *buffer)
+                                                 : write_png(frame.path, frame.width, frame.height, *buffer);
+
+        if (success) {
+            vislib::sys::Log::DefaultLog.WriteInfo("Saved screenshot to file '%s'", frame.path.c_str());
+        }
+    });
 
-    vislib::sys::Log::DefaultLog.WriteInfo("Saved screenshot to file '%s'", output_file.PeekBuffer());
+    return true;
+}
+
+
+/*
+ * render_to_file::finish_frames
+ */
+void render_to_file::finish_frames(const bool wait) {
+    while (!this->pending_frames.empty() && this->finish_oldest_frame(wait))
+        ;
 }
 
 
@@ -382,6 +647,9 @@ bool render_to_file::OnRenderView(core::Call& call) {
 
     this->override_view_call = nullptr;
 
+    // Hand finished frames to the encoders
+    this->finish_frames(false);
+
     return true;
 }
 
@@ -501,7 +769,8 @@ bool render_to_file::OnMouseScroll(double dx, double dy) {
  * render_to_file::create
  */
 bool render_to_file::create(void) {
-    // nothing to do
+    this->encoders = std::make_unique<task_pool>();
+
     return true;
 }
 
@@ -509,7 +778,23 @@ bool render_to_file::create(void) {
 /*
  * render_to_file::release
  */
-void render_to_file::release(void) {}
+void render_to_file::release(void) {
+    // Finish all pending frames, and wait for them to be written
+    if (this->pbos_initialized) {
+        this->finish_frames(true);
+
+        glDeleteBuffers(static_cast<GLsizei>(this->pbos.size()), this->pbos.data());
+
+        this->pbos_initialized = false;
+    }
+
+    this->fbo.Release();
+
+    if (this->encoders != nullptr) {
+        this->encoders->wait(0);
+        this->encoders.reset();
+    }
+}
 
 
 /*
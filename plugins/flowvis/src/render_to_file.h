@@ -6,6 +6,8 @@
  */
 #pragma once
 
+#include "task_pool.h"
+
 #include "mmcore/Call.h"
 #include "mmcore/CallerSlot.h"
 #include "mmcore/param/ParamSlot.h"
@@ -14,8 +16,15 @@
 #include "mmcore/view/Input.h"
 
 #include "vislib/Serialiser.h"
+#include "vislib/graphics/gl/FramebufferObject.h"
+
+#include "glad/glad.h"
 
+#include <array>
+#include <cstddef>
+#include <deque>
 #include <memory>
+#include <string>
 
 namespace megamol {
 namespace flowvis {
@@ -170,6 +179,22 @@ private:
      */
     bool record(core::param::ParamSlot&);
 
+    /**
+     * Read back the oldest pending frame from its pixel buffer, and hand it to the encoders
+     *
+     * @param wait Wait for the read back to finish
+     *
+     * @return False if the frame is not yet available
+     */
+    bool finish_oldest_frame(bool wait);
+
+    /**
+     * Read back pending frames and hand them to the encoders
+     *
+     * @param wait Wait for all read backs to finish, instead of only processing the finished ones
+     */
+    void finish_frames(bool wait);
+
     /** Connection to a view */
     core::CallerSlot viewSlot;
 
@@ -193,9 +218,41 @@ private:
 
     /** Parameters for file output */
     core::param::ParamSlot output_file;
+    core::param::ParamSlot output_format;
+
+    /** Parameters for rendering a sequence of frames at different times */
+    core::param::ParamSlot sequence_length;
+    core::param::ParamSlot sequence_time_step;
+
+    /** Parameters for sweeping another module's parameter linearly over the frames of a sequence */
+    core::param::ParamSlot sweep_parameter;
+    core::param::ParamSlot sweep_start;
+    core::param::ParamSlot sweep_end;
 
     /** Trigger */
     core::param::ParamSlot trigger;
+
+    /** Framebuffer, reused for recordings of the same size */
+    vislib::graphics::gl::FramebufferObject fbo;
+
+    /** Frame which is being read back into a pixel buffer */
+    struct pending_frame_t {
+        GLsync fence;
+        GLuint pbo;
+        unsigned int width, height;
+        int format;
+        std::string path;
+    };
+
+    /** Ring of pixel buffers for asynchronous read back, and frames in flight in order of rendering */
+    std::array<GLuint, 3> pbos;
+    bool pbos_initialized;
+    std::size_t next_pbo;
+
+    std::deque<pending_frame_t> pending_frames;
+
+    /** Worker threads for encoding and writing frames */
+    std::unique_ptr<task_pool> encoders;
 };
 
 } // namespace flowvis
@@ -14,9 +14,10 @@
 
 #include "vislib/sys/Log.h"
 
-#include "tpf/data/tpf_data_information.h"
-#include "tpf/data/tpf_grid.h"
-#include "tpf/data/tpf_grid_information.h"
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
 
 namespace megamol {
 namespace flowvis {
@@ -34,7 +35,15 @@ streamlines_2d::streamlines_2d()
     , vector_field_changed(false)
     , seed_points_hash(-1)
     , seed_points_changed(false)
-    , streamlines_hash(-1) {
+    , streamlines_hash(-1)
+    , current_line_storage(0) {
+
+    // Create line storage
+    for (auto& storage : this->line_storage) {
+        storage.vertices = std::make_shared<std::vector<float>>();
+        storage.indices = std::make_shared<std::vector<unsigned int>>();
+        storage.values = std::make_shared<std::vector<float>>();
+    }
 
     // Connect output
     this->streamlines_slot.SetCallback(
@@ -157,89 +166,160 @@ bool streamlines_2d::compute_streamlines() {
         this->max_integration_error.ResetDirty();
         this->num_integration_steps.ResetDirty();
 
-        // Create grid containing the vector field
-        tpf::data::extent_t extent;
-        extent.push_back(std::make_pair(0ull, static_cast<std::size_t>(this->resolution[0] - 1)));
-        extent.push_back(std::make_pair(0ull, static_cast<std::size_t>(this->resolution[1] - 1)));
+        // Describe the uniform grid containing the vector field
+        const auto vector_field = make_uniform_vector_field(this->resolution, *this->grid_positions, *this->vectors);
+
+        // Get parameters
+        const auto integration_method = this->integration_method.Param<core::param::EnumParam>()->Value();
+        const auto num_integration_steps = this->num_integration_steps.Param<core::param::IntParam>()->Value();
+        const auto integration_timestep = this->integration_timestep.Param<core::param::FloatParam>()->Value();
+        const auto max_integration_error = this->max_integration_error.Param<core::param::FloatParam>()->Value();
+        const auto direction = this->direction.Param<core::param::EnumParam>()->Value();
+
+        // Store the vertices of each line at a fixed offset in a vertex arena
+        const auto num_seed_points = this->seed_points.size();
+        const std::size_t num_runs = direction == 0 ? 2 : 1;
+        const auto num_lines = num_runs * num_seed_points;
+        const auto line_capacity = static_cast<std::size_t>(std::max(num_integration_steps, 0)) + 1;
+
+        this->arena_vertices.resize(2 * num_lines * line_capacity);
+
+        std::vector<std::size_t> line_lengths(num_lines);
+        std::vector<std::array<float, 4>> line_extents(num_lines);
+
+        // Advect chunks of seed points, which are distributed dynamically among the threads as lines
+        // terminate at different times
+        constexpr std::size_t chunk_size = 64;
+
+        const auto num_chunks = (num_seed_points + chunk_size - 1) / chunk_size;
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long work_index = 0; work_index < static_cast<long long>(num_runs * num_chunks); ++work_index) {
+            const auto direction_run = static_cast<std::size_t>(work_index) / num_chunks;
+            const auto first_seed = (static_cast<std::size_t>(work_index) % num_chunks) * chunk_size;
+            const auto num_chunk_seeds = std::min(chunk_size, num_seed_points - first_seed);
+            const auto forward = direction == 1 || (direction == 0 && direction_run == 0);
+
+            auto& vertices = this->arena_vertices;
 
-        const Eigen::Vector2f origin((*this->grid_positions)[0], (*this->grid_positions)[1]);
-        const Eigen::Vector2f right((*this->grid_positions)[2], (*this->grid_positions)[3]);
-        const Eigen::Vector2f up(
-            (*this->grid_positions)[2 * this->resolution[0]], (*this->grid_positions)[2 * this->resolution[0] + 1]);
+            const auto add_vertex = [&](const std::size_t line_index, const float x, const float y) {
+                const auto vertex_index = line_index * line_capacity + line_lengths[line_index]++;
 
-        const Eigen::Vector2f cell_size(right.x() - origin.x(), up.y() - origin.y());
-        const auto node_origin = origin - 0.5f * cell_size;
+                vertices[2 * vertex_index + 0] = x;
+                vertices[2 * vertex_index + 1] = y;
 
-        tpf::data::grid_information<float>::array_type cell_coordinates(2), node_coordinates(2), cell_sizes(2);
+                auto& extent = line_extents[line_index];
+                extent[0] = std::min(extent[0], x);
+                extent[1] = std::max(extent[1], x);
+                extent[2] = std::min(extent[2], y);
+                extent[3] = std::max(extent[3], y);
+            };
 
-        for (std::size_t dimension = 0; dimension < 2; ++dimension) {
-            cell_coordinates[dimension].resize(this->resolution[dimension]);
-            node_coordinates[dimension].resize(this->resolution[dimension] + 1);
-            cell_sizes[dimension].resize(this->resolution[dimension]);
+            particle_batch particles;
+            particles.resize(num_chunk_seeds);
 
-            for (std::size_t element = 0; element < this->resolution[dimension]; ++element) {
-                cell_sizes[dimension][element] = cell_size[dimension];
-                cell_coordinates[dimension][element] = origin[dimension] + element * cell_size[dimension];
-                node_coordinates[dimension][element] = origin[dimension] + (element - 0.5f) * cell_size[dimension];
+            for (std::size_t i = 0; i < num_chunk_seeds; ++i) {
+                const auto& seed_point = this->seed_points[first_seed + i].first;
+                const auto line_index = direction_run * num_seed_points + first_seed + i;
+
+                particles.x[i] = seed_point.x();
+                particles.y[i] = seed_point.y();
+                particles.delta[i] = integration_timestep;
+                particles.active[i] = 1;
+
+                line_extents[line_index] = {seed_point.x(), seed_point.x(), seed_point.y(), seed_point.y()};
+                add_vertex(line_index, seed_point.x(), seed_point.y());
             }
 
-            node_coordinates[dimension][this->resolution[dimension]] =
-                origin[dimension] + (this->resolution[dimension] - 0.5f) * cell_size[dimension];
-        }
+            for (std::size_t integration = 0; integration < line_capacity - 1; ++integration) {
+                switch (integration_method) {
+                case 0:
+                    advect_points_rk4(vector_field, particles, forward, false);
+                    break;
+                case 1:
+                    advect_points_rk45(vector_field, particles, max_integration_error, forward, false);
+                    break;
+                }
 
-        const tpf::data::grid<float, float, 2, 2> vector_field("vector_field", extent, *this->vectors,
-            std::move(cell_coordinates), std::move(node_coordinates), std::move(cell_sizes));
+                // Append advected points; stream lines leaving the domain consist of at least two points
+                bool any_active = false;
 
-        // Get parameters
-        const auto integration_method = this->integration_method.Param<core::param::EnumParam>()->Value();
-        const auto num_integration_steps = this->num_integration_steps.Param<core::param::IntParam>()->Value();
-        const auto max_integration_error = this->max_integration_error.Param<core::param::FloatParam>()->Value();
-        const auto direction = this->direction.Param<core::param::EnumParam>()->Value();
+                for (std::size_t i = 0; i < num_chunk_seeds; ++i) {
+                    const auto line_index = direction_run * num_seed_points + first_seed + i;
 
-        // Advect all seed points
-        this->streamlines.clear();
-        this->streamlines.resize(direction == 0 ? 2 * this->seed_points.size() : this->seed_points.size());
-
-        for (std::size_t direction_run = 0; direction_run < (direction == 0 ? 2 : 1); ++direction_run) {
-            #pragma omp parallel for
-            for (long long point_index = 0; point_index < static_cast<long long>(this->seed_points.size());
-                 ++point_index) {
-
-                Eigen::Vector2f point = this->seed_points[point_index].first;
-
-                auto integration_timestep = this->integration_timestep.Param<core::param::FloatParam>()->Value();
-
-                std::vector<Eigen::Vector2f> line_points;
-                line_points.reserve(num_integration_steps + 1);
-
-                line_points.push_back(point);
-
-                try {
-                    for (std::size_t integration = 0; integration < num_integration_steps; ++integration) {
-                        switch (integration_method) {
-                        case 0:
-                            advect_point_rk4<2>(vector_field, point, integration_timestep,
-                                direction == 1 || (direction == 0 && direction_run == 0));
-                            line_points.push_back(point);
-                            break;
-                        case 1:
-                            advect_point_rk45<2>(vector_field, point, integration_timestep, max_integration_error,
-                                direction == 1 || (direction == 0 && direction_run == 0));
-                            line_points.push_back(point);
-                            break;
-                        }
-                    }
-                } catch (std::exception&) {
-                    if (line_points.size() == 1) {
-                        line_points.push_back(point);
+                    if (particles.active[i] != 0 || line_lengths[line_index] == 1) {
+                        add_vertex(line_index, particles.x[i], particles.y[i]);
                     }
+
+                    any_active |= particles.active[i] != 0;
+                }
+
+                if (!any_active) {
+                    break;
                 }
+            }
+        }
+
+        // Compact the arena into the output, and create line strips separated by restart indices
+        std::vector<std::size_t> vertex_offsets(num_lines);
+        std::vector<std::size_t> index_offsets(num_lines);
+        std::size_t num_vertices = 0;
+        std::size_t num_indices = 0;
+
+        for (std::size_t line_index = 0; line_index < num_lines; ++line_index) {
+            vertex_offsets[line_index] = num_vertices;
+            num_vertices += line_lengths[line_index];
+
+            index_offsets[line_index] = num_indices + (line_index != 0 ? 1 : 0);
+            num_indices = index_offsets[line_index] + line_lengths[line_index];
+        }
+
+        auto& storage = get_unused_line_storage();
+        storage.vertices->resize(2 * num_vertices);
+        storage.values->resize(num_vertices);
+        storage.indices->resize(num_indices);
 
-                this->streamlines[direction_run * this->seed_points.size() + point_index] =
-                   std::make_pair(static_cast<float>(point_index), line_points);
+        #pragma omp parallel for
+        for (long long line = 0; line < static_cast<long long>(num_lines); ++line) {
+            const auto line_index = static_cast<std::size_t>(line);
+            const auto vertex_offset = vertex_offsets[line_index];
+            const auto index_offset = index_offsets[line_index];
+            const auto line_length = line_lengths[line_index];
+
+            // Lines are identified by their seed point, independent of the direction
+            const auto value = static_cast<float>(line_index % num_seed_points);
+
+            auto& vertices = *storage.vertices;
+            auto& values = *storage.values;
+            auto& indices = *storage.indices;
+
+            std::copy_n(this->arena_vertices.begin() + 2 * line_index * line_capacity, 2 * line_length,
+                vertices.begin() + 2 * vertex_offset);
+            std::fill_n(values.begin() + vertex_offset, line_length, value);
+
+            if (line_index != 0) {
+                indices[index_offset - 1] = static_cast<unsigned int>(-1);
+            }
+
+            for (std::size_t vertex = 0; vertex < line_length; ++vertex) {
+                indices[index_offset + vertex] = static_cast<unsigned int>(vertex_offset + vertex);
             }
         }
 
+        // Combine line extents
+        if (num_lines != 0) {
+            auto extent = line_extents[0];
+
+            for (const auto& line_extent : line_extents) {
+                extent[0] = std::min(extent[0], line_extent[0]);
+                extent[1] = std::max(extent[1], line_extent[1]);
+                extent[2] = std::min(extent[2], line_extent[2]);
+                extent[3] = std::max(extent[3], line_extent[3]);
+            }
+
+            this->streamlines_bounding_rectangle.Set(extent[0], extent[2], extent[1], extent[3]);
+        }
+
         this->streamlines_hash = core::utility::DataHash(this->vector_field_hash, this->seed_points_hash,
             this->direction.Param<core::param::EnumParam>()->Value(),
             this->integration_method.Param<core::param::EnumParam>()->Value(),
@@ -254,6 +334,20 @@ bool streamlines_2d::compute_streamlines() {
     return true;
 }
 
+streamlines_2d::line_storage_t& streamlines_2d::get_unused_line_storage() {
+    this->current_line_storage = (this->current_line_storage + 1) % this->line_storage.size();
+
+    auto& storage = this->line_storage[this->current_line_storage];
+
+    if (storage.vertices.use_count() > 1 || storage.indices.use_count() > 1 || storage.values.use_count() > 1) {
+        storage.vertices = std::make_shared<std::vector<float>>();
+        storage.indices = std::make_shared<std::vector<unsigned int>>();
+        storage.values = std::make_shared<std::vector<float>>();
+    }
+
+    return storage;
+}
+
 bool streamlines_2d::get_streamlines_data(core::Call& call) {
     auto& gdc = static_cast<glyph_data_call&>(call);
 
@@ -262,11 +356,10 @@ bool streamlines_2d::get_streamlines_data(core::Call& call) {
     }
 
     if (gdc.DataHash() != this->streamlines_hash) {
-        gdc.clear();
+        const auto& storage = this->line_storage[this->current_line_storage];
 
-        for (const auto& line : this->streamlines) {
-            gdc.add_line(line.second, line.first);
-        }
+        gdc.clear();
+        gdc.set_lines(storage.vertices, storage.indices, storage.values, this->streamlines_bounding_rectangle);
 
         gdc.SetDataHash(this->streamlines_hash);
     }
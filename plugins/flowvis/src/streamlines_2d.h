@@ -78,6 +78,13 @@ protected:
     virtual void release() override;
 
 private:
+    /** Vertices, indices and values of lines */
+    struct line_storage_t {
+        std::shared_ptr<std::vector<float>> vertices;
+        std::shared_ptr<std::vector<unsigned int>> indices;
+        std::shared_ptr<std::vector<float>> values;
+    };
+
     /** Get input data and extent from called modules */
     bool get_input_data();
     bool get_input_extent();
@@ -87,6 +94,13 @@ private:
      */
     bool compute_streamlines();
 
+    /**
+     * Select line storage which is not referenced by the output call, allocating new buffers if all are in use
+     *
+     * @return Line storage to write the streamlines to
+     */
+    line_storage_t& get_unused_line_storage();
+
     /** Callbacks for the computed streamlines */
     bool get_streamlines_data(core::Call& call);
     bool get_streamlines_extent(core::Call& call);
@@ -124,10 +138,17 @@ private:
 
     std::vector<std::pair<Eigen::Vector2f, float>> seed_points;
 
-    /** Output streamlines */
+    /** Output streamlines, computed in a vertex arena with a fixed number of vertices per line */
     SIZE_T streamlines_hash;
 
-    std::vector<std::pair<float, std::vector<Eigen::Vector2f>>> streamlines;
+    /** Vertex arena, reused between computations and compacted into the line storage */
+    std::vector<float> arena_vertices;
+
+    /** Two sets of line storage, one of them is published while the other is recomputed */
+    std::array<line_storage_t, 2> line_storage;
+    std::size_t current_line_storage;
+
+    vislib::math::Rectangle<float> streamlines_bounding_rectangle;
 };
 
 } // namespace flowvis
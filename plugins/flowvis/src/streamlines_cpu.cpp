@@ -0,0 +1,694 @@
+#include "stdafx.h"
+#include "streamlines_cpu.h"
+
+#include "../cuda/streamlines.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        namespace
+        {
+            /**
+            * Fetch a value from a grid, returning zero outside (equivalent to border addressing of CUDA textures)
+            *
+            * @param data       Grid data
+            * @param x          Index in x-direction
+            * @param y          Index in y-direction
+            * @param width      Grid width
+            * @param height     Grid height
+            *
+            * @return Value at the given index or zero
+            */
+            inline float fetch(const float* data, const int x, const int y, const int width, const int height)
+            {
+                const bool inside = x >= 0 && x < width && y >= 0 && y < height;
+
+                return inside ? data[y * width + x] : 0.0f;
+            }
+
+            /**
+            * Clamp a grid coordinate to the range where at least one interpolation node may lie inside the grid.
+            * Values outside map to the border, where interpolation yields zero, and NaN maps to the lower border.
+            *
+            * @param coordinate Grid coordinate
+            * @param size       Number of grid nodes in this direction
+            *
+            * @return Clamped grid coordinate
+            */
+            inline float clamp_grid_coordinate(const float coordinate, const float size)
+            {
+                return coordinate > -1.0f ? (coordinate < size ? coordinate : size) : -1.0f;
+            }
+        }
+
+        streamlines_cpu::streamlines_cpu(const std::array<unsigned int, 2>& resolution, const std::array<float, 4>& domain,
+            const std::vector<float>& vectors, const std::vector<float>& points, const std::vector<int>& point_ids,
+            const std::vector<float>& lines, const std::vector<int>& line_ids, const float integration_timestep,
+            const float max_integration_error, const integration_method method)
+            : resolution(resolution), integration_timestep(integration_timestep), max_integration_error(max_integration_error), method(method)
+        {
+            // Create constants
+            const float cellx = (domain[2] - domain[0]) / (this->resolution[0] - 1);
+            const float celly = (domain[3] - domain[1]) / (this->resolution[1] - 1);
+            const float cell_diag = std::sqrt(cellx * cellx + celly * celly);
+
+            this->domain_offset = { domain[0], domain[1] };
+            this->domain_scale = { 1.0f / (domain[2] - domain[0]), 1.0f / (domain[3] - domain[1]) };
+            this->grid_scale = { static_cast<float>(this->resolution[0] - 1), static_cast<float>(this->resolution[1] - 1) };
+
+            this->cell_size = { cellx, celly };
+            this->min_cell_size = std::min(cellx, celly);
+
+            // Store vector field in struct-of-arrays layout
+            const std::size_t num_vectors = vectors.size() / 2;
+
+            this->velocity_x.resize(num_vectors);
+            this->velocity_y.resize(num_vectors);
+
+            for (std::size_t i = 0; i < num_vectors; ++i)
+            {
+                this->velocity_x[i] = vectors[i * 2 + 0];
+                this->velocity_y[i] = vectors[i * 2 + 1];
+            }
+
+            // Create field for Runge-Kutta step size
+            this->rk4_step.assign(num_vectors, cell_diag);
+
+            // Store convergence points
+            this->convergence_points_x.resize(point_ids.size());
+            this->convergence_points_y.resize(point_ids.size());
+            this->convergence_point_ids.resize(point_ids.size());
+
+            for (std::size_t i = 0; i < point_ids.size(); ++i)
+            {
+                this->convergence_points_x[i] = points[i * 2 + 0];
+                this->convergence_points_y[i] = points[i * 2 + 1];
+                this->convergence_point_ids[i] = static_cast<float>(point_ids[i]);
+            }
+
+            // Store convergence lines, and precompute their direction and length
+            this->convergence_lines_x0.resize(line_ids.size());
+            this->convergence_lines_y0.resize(line_ids.size());
+            this->convergence_lines_x1.resize(line_ids.size());
+            this->convergence_lines_y1.resize(line_ids.size());
+            this->convergence_lines_dir_x.resize(line_ids.size());
+            this->convergence_lines_dir_y.resize(line_ids.size());
+            this->convergence_lines_length.resize(line_ids.size());
+            this->convergence_line_ids.resize(line_ids.size());
+
+            for (std::size_t i = 0; i < line_ids.size(); ++i)
+            {
+                this->convergence_lines_x0[i] = lines[i * 4 + 0];
+                this->convergence_lines_y0[i] = lines[i * 4 + 1];
+                this->convergence_lines_x1[i] = lines[i * 4 + 2];
+                this->convergence_lines_y1[i] = lines[i * 4 + 3];
+
+                const float dir_x = lines[i * 4 + 2] - lines[i * 4 + 0];
+                const float dir_y = lines[i * 4 + 3] - lines[i * 4 + 1];
+                const float length = std::sqrt(dir_x * dir_x + dir_y * dir_y);
+
+                this->convergence_lines_dir_x[i] = length > 0.0f ? dir_x / length : 0.0f;
+                this->convergence_lines_dir_y[i] = length > 0.0f ? dir_y / length : 0.0f;
+                this->convergence_lines_length[i] = length;
+
+                this->convergence_line_ids[i] = static_cast<float>(line_ids[i]);
+            }
+        }
+
+        void streamlines_cpu::update_labels(std::vector<float>& source, std::vector<float>& labels, std::vector<float>& distances,
+            std::vector<float>& terminations, const int num_integration_steps, const float sign, const unsigned int num_particles_per_batch) const
+        {
+            // Subdivide the input
+            const std::size_t num_particles = source.size() / 2;
+            const std::size_t batch_size = std::max(num_particles_per_batch, 1u);
+
+            for (std::size_t offset = 0; offset < num_particles; offset += batch_size)
+            {
+                const std::size_t num_particles_this_batch = std::min(batch_size, num_particles - offset);
+                const int num_blocks = static_cast<int>((num_particles_this_batch + block_size - 1) / block_size);
+
+                // Distribute blocks of particles among all threads
+                #pragma omp parallel for schedule(dynamic)
+                for (int block_index = 0; block_index < num_blocks; ++block_index)
+                {
+                    const std::size_t begin = offset + static_cast<std::size_t>(block_index) * block_size;
+
+                    particle_block block;
+                    block.num_particles = std::min(block_size, offset + num_particles_this_batch - begin);
+
+                    // Load particles into struct-of-arrays layout, padding with terminated particles
+                    for (std::size_t i = 0; i < block_size; ++i)
+                    {
+                        const bool valid = i < block.num_particles;
+
+                        block.x[i] = valid ? source[(begin + i) * 2 + 0] : 0.0f;
+                        block.y[i] = valid ? source[(begin + i) * 2 + 1] : 0.0f;
+                        block.labels[i] = valid ? labels[begin + i] : -1.0f;
+                        block.distances[i] = valid ? distances[begin + i] : 0.0f;
+                        block.terminations[i] = valid ? terminations[begin + i] : -1.0f;
+                    }
+
+                    compute_streamlines(block, num_integration_steps, sign);
+
+                    // Store results
+                    for (std::size_t i = 0; i < block.num_particles; ++i)
+                    {
+                        source[(begin + i) * 2 + 0] = block.x[i];
+                        source[(begin + i) * 2 + 1] = block.y[i];
+                        labels[begin + i] = block.labels[i];
+                        distances[begin + i] = block.distances[i];
+                        terminations[begin + i] = block.terminations[i];
+                    }
+                }
+            }
+        }
+
+        void streamlines_cpu::compute_streamlines(particle_block& block, const int num_steps, const float sign) const
+        {
+            // Only advect particles which have not yet been terminated
+            alignas(32) bool active[block_size];
+            bool any_active = false;
+
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                active[i] = i < block.num_particles && block.terminations[i] == 0.0f;
+                any_active |= active[i];
+            }
+
+            if (!any_active)
+            {
+                return;
+            }
+
+            // Labels are stored as integers during integration
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                block.labels[i] = static_cast<float>(static_cast<short>(block.labels[i]));
+            }
+
+#if !(__streamlines_cuda_shi_et_al)
+            // Initially update values by evaluating the distance to convergence structures
+            update_label_and_dist(block.x, block.y, active, block.labels, block.distances);
+#endif
+
+            // Calculate initial time step
+            interpolate_step(block.x, block.y, block.steps);
+
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                block.steps[i] *= this->integration_timestep;
+            }
+
+            alignas(32) float x[block_size];
+            alignas(32) float y[block_size];
+
+            for (int j = 0; j < num_steps && any_active; ++j)
+            {
+                // Advect all particles of the block, and only store the result for active ones
+                std::copy(block.x, block.x + block_size, x);
+                std::copy(block.y, block.y + block_size, y);
+
+                if (this->method == integration_method::RUNGE_KUTTA_4)
+                {
+                    advect_rk4(x, y, sign);
+                }
+                else if (this->method == integration_method::RUNGE_KUTTA_4_5)
+                {
+                    advect_rk45(x, y, block.steps, active, sign);
+                }
+
+#if !(__streamlines_cuda_shi_et_al)
+                // Update values by evaluating the distance to convergence structures
+                update_label_and_dist(x, y, active, block.labels, block.distances);
+#endif
+
+                any_active = false;
+
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    if (!active[i])
+                    {
+                        continue;
+                    }
+
+                    // If advection had no effect, abort the algorithm
+                    if (block.x[i] == x[i] && block.y[i] == y[i])
+                    {
+                        block.terminations[i] = (min_distance(x[i], y[i]) < 0.5f * this->min_cell_size) ? 3.0f : 2.0f;
+                        active[i] = false;
+
+                        continue;
+                    }
+
+                    block.x[i] = x[i];
+                    block.y[i] = y[i];
+
+                    // If current position is outside of the domain, set "outside"-label and distance and
+                    // abort the algorithm
+                    const float pos_01_x = (x[i] - this->domain_offset[0]) * this->domain_scale[0];
+                    const float pos_01_y = (y[i] - this->domain_offset[1]) * this->domain_scale[1];
+
+                    if (pos_01_x < 0.0f || pos_01_x > 1.0f || pos_01_y < 0.0f || pos_01_y > 1.0f)
+                    {
+                        block.terminations[i] = 1.0f;
+                        active[i] = false;
+
+#if __streamlines_cuda_shi_et_al
+                        block.labels[i] = -1.0f;
+                        block.distances[i] = 0.0f;
+#endif
+
+                        continue;
+                    }
+
+                    any_active = true;
+                }
+            }
+
+#if __streamlines_cuda_shi_et_al
+            // Update values by evaluating the distance to convergence structures at the final position
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                active[i] = i < block.num_particles && block.terminations[i] != 1.0f && block.terminations[i] != -1.0f;
+            }
+
+            update_label_and_dist(block.x, block.y, active, block.labels, block.distances);
+#endif
+        }
+
+        void streamlines_cpu::advect_rk4(float* x, float* y, const float sign) const
+        {
+            alignas(32) float v_x[block_size], v_y[block_size];
+            alignas(32) float p_x[block_size], p_y[block_size];
+            alignas(32) float h[block_size];
+            alignas(32) float k1_x[block_size], k1_y[block_size];
+            alignas(32) float k2_x[block_size], k2_y[block_size];
+            alignas(32) float k3_x[block_size], k3_y[block_size];
+
+            // Calculate step size, and first Runge-Kutta coefficient from the same interpolated velocity
+            interpolate(x, y, v_x, v_y);
+
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                const float max_velocity = std::sqrt(v_x[i] * v_x[i] + v_y[i] * v_y[i]);
+                const float steps_per_cell = max_velocity > 0.0f ? this->min_cell_size / max_velocity : 0.0f;
+
+                h[i] = steps_per_cell * this->integration_timestep * sign;
+
+                k1_x[i] = h[i] * v_x[i];
+                k1_y[i] = h[i] * v_y[i];
+
+                p_x[i] = x[i] + 0.5f * k1_x[i];
+                p_y[i] = y[i] + 0.5f * k1_y[i];
+            }
+
+            // Calculate remaining Runge-Kutta coefficients
+            interpolate(p_x, p_y, v_x, v_y);
+
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                k2_x[i] = h[i] * v_x[i];
+                k2_y[i] = h[i] * v_y[i];
+
+                p_x[i] = x[i] + 0.5f * k2_x[i];
+                p_y[i] = y[i] + 0.5f * k2_y[i];
+            }
+
+            interpolate(p_x, p_y, v_x, v_y);
+
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                k3_x[i] = h[i] * v_x[i];
+                k3_y[i] = h[i] * v_y[i];
+
+                p_x[i] = x[i] + k3_x[i];
+                p_y[i] = y[i] + k3_y[i];
+            }
+
+            interpolate(p_x, p_y, v_x, v_y);
+
+            // Advect and store position
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                const float k4_x = h[i] * v_x[i];
+                const float k4_y = h[i] * v_y[i];
+
+                x[i] += (1.0f / 6.0f) * (k1_x[i] + 2.0f * k2_x[i] + 2.0f * k3_x[i] + k4_x);
+                y[i] += (1.0f / 6.0f) * (k1_y[i] + 2.0f * k2_y[i] + 2.0f * k3_y[i] + k4_y);
+            }
+        }
+
+        void streamlines_cpu::advect_rk45(float* x, float* y, float* steps, const bool* active, const float sign) const
+        {
+            // Cash-Karp parameters
+            constexpr float b_21 = 0.2f;
+            constexpr float b_31 = 0.075f;
+            constexpr float b_41 = 0.3f;
+            constexpr float b_51 = -11.0f / 54.0f;
+            constexpr float b_61 = 1631.0f / 55296.0f;
+            constexpr float b_32 = 0.225f;
+            constexpr float b_42 = -0.9f;
+            constexpr float b_52 = 2.5f;
+            constexpr float b_62 = 175.0f / 512.0f;
+            constexpr float b_43 = 1.2f;
+            constexpr float b_53 = -70.0f / 27.0f;
+            constexpr float b_63 = 575.0f / 13824.0f;
+            constexpr float b_54 = 35.0f / 27.0f;
+            constexpr float b_64 = 44275.0f / 110592.0f;
+            constexpr float b_65 = 253.0f / 4096.0f;
+
+            constexpr float c_1 = 37.0f / 378.0f;
+            constexpr float c_3 = 250.0f / 621.0f;
+            constexpr float c_4 = 125.0f / 594.0f;
+            constexpr float c_6 = 512.0f / 1771.0f;
+
+            constexpr float c_1s = 2825.0f / 27648.0f;
+            constexpr float c_3s = 18575.0f / 48384.0f;
+            constexpr float c_4s = 13525.0f / 55296.0f;
+            constexpr float c_5s = 277.0f / 14336.0f;
+            constexpr float c_6s = 0.25f;
+
+            // Constants
+            constexpr float grow_exponent = -0.2f;
+            constexpr float shrink_exponent = -0.25f;
+            constexpr float max_growth = 5.0f;
+            constexpr float max_shrink = 0.1f;
+            constexpr float safety = 0.9f;
+
+            alignas(32) float v_x[block_size], v_y[block_size];
+            alignas(32) float p_x[block_size], p_y[block_size];
+            alignas(32) float h[block_size];
+            alignas(32) float k1_x[block_size], k1_y[block_size];
+            alignas(32) float k2_x[block_size], k2_y[block_size];
+            alignas(32) float k3_x[block_size], k3_y[block_size];
+            alignas(32) float k4_x[block_size], k4_y[block_size];
+            alignas(32) float k5_x[block_size], k5_y[block_size];
+            alignas(32) float scale_x[block_size], scale_y[block_size];
+
+            // The velocity at the start position does not change between attempts
+            interpolate(x, y, scale_x, scale_y);
+
+            // Repeat the step with reduced time step size for all particles whose error exceeds the threshold
+            alignas(32) bool pending[block_size];
+            bool any_pending = false;
+
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                pending[i] = active[i];
+                any_pending |= pending[i];
+            }
+
+            while (any_pending)
+            {
+                // Calculate Runge-Kutta coefficients
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    h[i] = steps[i] * sign;
+
+                    k1_x[i] = h[i] * scale_x[i];
+                    k1_y[i] = h[i] * scale_y[i];
+
+                    p_x[i] = x[i] + b_21 * k1_x[i];
+                    p_y[i] = y[i] + b_21 * k1_y[i];
+                }
+
+                interpolate(p_x, p_y, v_x, v_y);
+
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    k2_x[i] = h[i] * v_x[i];
+                    k2_y[i] = h[i] * v_y[i];
+
+                    p_x[i] = x[i] + b_31 * k1_x[i] + b_32 * k2_x[i];
+                    p_y[i] = y[i] + b_31 * k1_y[i] + b_32 * k2_y[i];
+                }
+
+                interpolate(p_x, p_y, v_x, v_y);
+
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    k3_x[i] = h[i] * v_x[i];
+                    k3_y[i] = h[i] * v_y[i];
+
+                    p_x[i] = x[i] + b_41 * k1_x[i] + b_42 * k2_x[i] + b_43 * k3_x[i];
+                    p_y[i] = y[i] + b_41 * k1_y[i] + b_42 * k2_y[i] + b_43 * k3_y[i];
+                }
+
+                interpolate(p_x, p_y, v_x, v_y);
+
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    k4_x[i] = h[i] * v_x[i];
+                    k4_y[i] = h[i] * v_y[i];
+
+                    p_x[i] = x[i] + b_51 * k1_x[i] + b_52 * k2_x[i] + b_53 * k3_x[i] + b_54 * k4_x[i];
+                    p_y[i] = y[i] + b_51 * k1_y[i] + b_52 * k2_y[i] + b_53 * k3_y[i] + b_54 * k4_y[i];
+                }
+
+                interpolate(p_x, p_y, v_x, v_y);
+
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    k5_x[i] = h[i] * v_x[i];
+                    k5_y[i] = h[i] * v_y[i];
+
+                    p_x[i] = x[i] + b_61 * k1_x[i] + b_62 * k2_x[i] + b_63 * k3_x[i] + b_64 * k4_x[i] + b_65 * k5_x[i];
+                    p_y[i] = y[i] + b_61 * k1_y[i] + b_62 * k2_y[i] + b_63 * k3_y[i] + b_64 * k4_y[i] + b_65 * k5_y[i];
+                }
+
+                interpolate(p_x, p_y, v_x, v_y);
+
+                any_pending = false;
+
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    if (!pending[i])
+                    {
+                        continue;
+                    }
+
+                    const float k6_x = h[i] * v_x[i];
+                    const float k6_y = h[i] * v_y[i];
+
+                    // Calculate error estimate
+                    const float fifth_order_x = x[i] + c_1 * k1_x[i] + c_3 * k3_x[i] + c_4 * k4_x[i] + c_6 * k6_x;
+                    const float fifth_order_y = y[i] + c_1 * k1_y[i] + c_3 * k3_y[i] + c_4 * k4_y[i] + c_6 * k6_y;
+
+                    const float fourth_order_x = x[i] + c_1s * k1_x[i] + c_3s * k3_x[i] + c_4s * k4_x[i] + c_5s * k5_x[i] + c_6s * k6_x;
+                    const float fourth_order_y = y[i] + c_1s * k1_y[i] + c_3s * k3_y[i] + c_4s * k4_y[i] + c_5s * k5_y[i] + c_6s * k6_y;
+
+                    const float difference_x = std::abs(fifth_order_x - fourth_order_x);
+                    const float difference_y = std::abs(fifth_order_y - fourth_order_y);
+
+                    const float error = std::fmax(0.0f, std::fmax(difference_x / std::abs(scale_x[i]),
+                        difference_y / std::abs(scale_y[i]))) / this->max_integration_error;
+
+                    // Set new, adapted time step
+                    if (error > 1.0f)
+                    {
+                        // Error too large, reduce time step
+                        steps[i] *= std::fmax(max_shrink, safety * std::pow(error, shrink_exponent));
+                        any_pending = true;
+                    }
+                    else
+                    {
+                        // Error (too) small, increase time step, and store accepted position
+                        steps[i] *= std::fmin(max_growth, safety * std::pow(error, grow_exponent));
+                        pending[i] = false;
+
+                        x[i] = fifth_order_x;
+                        y[i] = fifth_order_y;
+                    }
+                }
+            }
+        }
+
+        void streamlines_cpu::interpolate(const float* x, const float* y, float* v_x, float* v_y) const
+        {
+            const int width = static_cast<int>(this->resolution[0]);
+            const int height = static_cast<int>(this->resolution[1]);
+
+            const float* velocity_x = this->velocity_x.data();
+            const float* velocity_y = this->velocity_y.data();
+
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                // Transform position from [physical] to [0 : resolution - 1]
+                const float grid_x = clamp_grid_coordinate((x[i] - this->domain_offset[0]) * this->domain_scale[0] * this->grid_scale[0], static_cast<float>(width));
+                const float grid_y = clamp_grid_coordinate((y[i] - this->domain_offset[1]) * this->domain_scale[1] * this->grid_scale[1], static_cast<float>(height));
+
+                // Calculate lower corner of the interpolated cell, and relative position within
+                const float lower_x = std::floor(grid_x);
+                const float lower_y = std::floor(grid_y);
+
+                const int index_x = static_cast<int>(lower_x);
+                const int index_y = static_cast<int>(lower_y);
+
+                const float a_x = grid_x - lower_x;
+                const float a_y = grid_y - lower_y;
+
+                // Interpolate linearly
+                const float ra_x = (1.0f - a_x) * fetch(velocity_x, index_x, index_y, width, height) + a_x * fetch(velocity_x, index_x + 1, index_y, width, height);
+                const float ra_y = (1.0f - a_x) * fetch(velocity_y, index_x, index_y, width, height) + a_x * fetch(velocity_y, index_x + 1, index_y, width, height);
+                const float rb_x = (1.0f - a_x) * fetch(velocity_x, index_x, index_y + 1, width, height) + a_x * fetch(velocity_x, index_x + 1, index_y + 1, width, height);
+                const float rb_y = (1.0f - a_x) * fetch(velocity_y, index_x, index_y + 1, width, height) + a_x * fetch(velocity_y, index_x + 1, index_y + 1, width, height);
+
+                // Interpolate linearly between previous results
+                v_x[i] = (1.0f - a_y) * ra_x + a_y * rb_x;
+                v_y[i] = (1.0f - a_y) * ra_y + a_y * rb_y;
+            }
+        }
+
+        void streamlines_cpu::interpolate_step(const float* x, const float* y, float* value) const
+        {
+            const int width = static_cast<int>(this->resolution[0]);
+            const int height = static_cast<int>(this->resolution[1]);
+
+            const float* rk4_step = this->rk4_step.data();
+
+            #pragma omp simd
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                const float grid_x = clamp_grid_coordinate((x[i] - this->domain_offset[0]) * this->domain_scale[0] * this->grid_scale[0], static_cast<float>(width));
+                const float grid_y = clamp_grid_coordinate((y[i] - this->domain_offset[1]) * this->domain_scale[1] * this->grid_scale[1], static_cast<float>(height));
+
+                const float lower_x = std::floor(grid_x);
+                const float lower_y = std::floor(grid_y);
+
+                const int index_x = static_cast<int>(lower_x);
+                const int index_y = static_cast<int>(lower_y);
+
+                const float a_x = grid_x - lower_x;
+                const float a_y = grid_y - lower_y;
+
+                const float ra = (1.0f - a_x) * fetch(rk4_step, index_x, index_y, width, height) + a_x * fetch(rk4_step, index_x + 1, index_y, width, height);
+                const float rb = (1.0f - a_x) * fetch(rk4_step, index_x, index_y + 1, width, height) + a_x * fetch(rk4_step, index_x + 1, index_y + 1, width, height);
+
+                value[i] = (1.0f - a_y) * ra + a_y * rb;
+            }
+        }
+
+        void streamlines_cpu::update_label_and_dist(const float* x, const float* y, const bool* active, float* labels, float* distances) const
+        {
+#if __streamlines_cuda_shi_et_al
+            for (std::size_t i = 0; i < block_size; ++i)
+            {
+                if (active[i])
+                {
+                    labels[i] = -1.0f;
+                    distances[i] = std::numeric_limits<float>::max();
+                }
+            }
+#endif
+
+            // Calculate distance of the current positions to critical points
+            for (std::size_t k = 0; k < this->convergence_point_ids.size(); ++k)
+            {
+                const float id = this->convergence_point_ids[k];
+                const float p_x = this->convergence_points_x[k];
+                const float p_y = this->convergence_points_y[k];
+
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    const float dist = std::sqrt((x[i] - p_x) * (x[i] - p_x) + (y[i] - p_y) * (y[i] - p_y));
+
+                    // Store new label and distance if distance to convergence structure is smaller than previous one
+                    const bool closer = active[i] && dist < distances[i];
+
+                    labels[i] = closer ? id : labels[i];
+                    distances[i] = closer ? dist : distances[i];
+                }
+            }
+
+            // Calculate distance of the current positions to line segments
+            for (std::size_t k = 0; k < this->convergence_line_ids.size(); ++k)
+            {
+                const float id = this->convergence_line_ids[k];
+                const float p0_x = this->convergence_lines_x0[k];
+                const float p0_y = this->convergence_lines_y0[k];
+                const float p1_x = this->convergence_lines_x1[k];
+                const float p1_y = this->convergence_lines_y1[k];
+                const float dir_x = this->convergence_lines_dir_x[k];
+                const float dir_y = this->convergence_lines_dir_y[k];
+                const float length = this->convergence_lines_length[k];
+
+                #pragma omp simd
+                for (std::size_t i = 0; i < block_size; ++i)
+                {
+                    // Project point onto line, clamping to the endpoints
+                    const float d = dir_x * (x[i] - p0_x) + dir_y * (y[i] - p0_y);
+
+                    const float proj_x = d < 0.0f ? p0_x : (d > length ? p1_x : p0_x + dir_x * d);
+                    const float proj_y = d < 0.0f ? p0_y : (d > length ? p1_y : p0_y + dir_y * d);
+
+                    const float dist = std::sqrt((x[i] - proj_x) * (x[i] - proj_x) + (y[i] - proj_y) * (y[i] - proj_y));
+
+                    const bool closer = active[i] && dist < distances[i];
+
+                    labels[i] = closer ? id : labels[i];
+                    distances[i] = closer ? dist : distances[i];
+                }
+            }
+        }
+
+        float streamlines_cpu::min_distance(const float x, const float y) const
+        {
+            float dist = std::numeric_limits<float>::max();
+
+            for (std::size_t k = 0; k < this->convergence_point_ids.size(); ++k)
+            {
+                const float d_x = x - this->convergence_points_x[k];
+                const float d_y = y - this->convergence_points_y[k];
+
+                dist = std::min(dist, std::sqrt(d_x * d_x + d_y * d_y));
+            }
+
+            for (std::size_t k = 0; k < this->convergence_line_ids.size(); ++k)
+            {
+                const float d = this->convergence_lines_dir_x[k] * (x - this->convergence_lines_x0[k])
+                    + this->convergence_lines_dir_y[k] * (y - this->convergence_lines_y0[k]);
+
+                float proj_x, proj_y;
+
+                if (d < 0.0f)
+                {
+                    proj_x = this->convergence_lines_x0[k];
+                    proj_y = this->convergence_lines_y0[k];
+                }
+                else if (d > this->convergence_lines_length[k])
+                {
+                    proj_x = this->convergence_lines_x1[k];
+                    proj_y = this->convergence_lines_y1[k];
+                }
+                else
+                {
+                    proj_x = this->convergence_lines_x0[k] + this->convergence_lines_dir_x[k] * d;
+                    proj_y = this->convergence_lines_y0[k] + this->convergence_lines_dir_y[k] * d;
+                }
+
+                dist = std::min(dist, std::sqrt((x - proj_x) * (x - proj_x) + (y - proj_y) * (y - proj_y)));
+            }
+
+            return dist;
+        }
+    }
+}
@@ -0,0 +1,196 @@
+/*
+ * streamlines_cpu.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include "../cuda/streamlines.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        /**
+        * Class for computation of stream lines, corresponding labels and distances on the CPU.
+        * Mirrors the interface and results of streamlines_cuda, processing particles in blocks
+        * of SIMD width in a struct-of-arrays layout, and distributing the blocks among all cores.
+        */
+        class streamlines_cpu
+        {
+        public:
+            /**
+            * Integration methods
+            */
+            using integration_method = streamlines_cuda::integration_method;
+
+            /**
+            * Initialize constants and vector field
+            *
+            * @param resolution                 Domain resolution (number of vectors per direction)
+            * @param domain                     Domain size (minimum and maximum coordinates)
+            * @param vectors                    Vectors defining the vector field to analyze
+            * @param points                     Convergence structures defined as points
+            * @param point_ids                  IDs (or labels) of the point convergence structures
+            * @param lines                      Convergence structures defined as lines
+            * @param line_ids                   IDs (or labels) of the line convergence structures
+            * @param integration_timestep       Time step factor for advection
+            * @param max_integration_error      Maximum error for Runge-Kutta 4-5, above which the time step size has to be adapted
+            * @param method                     Integration method
+            */
+            streamlines_cpu(const std::array<unsigned int, 2>& resolution, const std::array<float, 4>& domain,
+                const std::vector<float>& vectors, const std::vector<float>& points, const std::vector<int>& point_ids,
+                const std::vector<float>& lines, const std::vector<int>& line_ids, float integration_timestep,
+                float max_integration_error, integration_method method);
+
+            /**
+            * Update labels for the given seed
+            *
+            * @param source                     In/output seed for advecting stream lines
+            * @param labels                     In/output labels
+            * @param distances                  In/output distances
+            * @param terminations               In/output termination reasons
+            * @param num_integration_steps      Number of integration steps
+            * @param sign                       Sign indicating forward (1) or backward (-1) integration
+            * @param num_particles_per_batch    Number of particles processed in parallel per batch
+            */
+            void update_labels(std::vector<float>& source, std::vector<float>& labels, std::vector<float>& distances,
+                std::vector<float>& terminations, int num_integration_steps, float sign, unsigned int num_particles_per_batch) const;
+
+        private:
+            /** Number of particles processed together, matching the width of 256 bit vector registers */
+            static constexpr std::size_t block_size = 8;
+
+            /**
+            * Block of particles in struct-of-arrays layout
+            */
+            struct particle_block
+            {
+                alignas(32) float x[block_size];
+                alignas(32) float y[block_size];
+
+                alignas(32) float labels[block_size];
+                alignas(32) float distances[block_size];
+                alignas(32) float terminations[block_size];
+
+                /** Current time step for Runge-Kutta 4-5 */
+                alignas(32) float steps[block_size];
+
+                /** Number of valid particles in this block */
+                std::size_t num_particles;
+            };
+
+            /**
+            * Compute stream lines for a block of particles and update their labels and distances
+            *
+            * @param block                  In/output block of particles
+            * @param num_steps              Number of integration steps
+            * @param sign                   Sign indicating forward (1) or backward (-1) integration
+            */
+            void compute_streamlines(particle_block& block, int num_steps, float sign) const;
+
+            /**
+            * Advect a block of positions using 4th-order Runge-Kutta
+            *
+            * @param x                      In/out x-coordinates
+            * @param y                      In/out y-coordinates
+            * @param sign                   Sign indicating forward (1) or backward (-1) integration
+            */
+            void advect_rk4(float* x, float* y, float sign) const;
+
+            /**
+            * Advect a block of positions using 4th-order Runge-Kutta with 5th-order error estimation for adaptive time steps
+            *
+            * @param x                      In/out x-coordinates
+            * @param y                      In/out y-coordinates
+            * @param steps                  In/out time steps
+            * @param active                 Mask of particles which are still advected
+            * @param sign                   Sign indicating forward (1) or backward (-1) integration
+            */
+            void advect_rk45(float* x, float* y, float* steps, const bool* active, float sign) const;
+
+            /**
+            * Bilinearly interpolate the vector field at a block of positions, returning zero outside the grid
+            *
+            * @param x                      x-coordinates
+            * @param y                      y-coordinates
+            * @param v_x                    Output x-components
+            * @param v_y                    Output y-components
+            */
+            void interpolate(const float* x, const float* y, float* v_x, float* v_y) const;
+
+            /**
+            * Bilinearly interpolate the time step field at a block of positions, returning zero outside the grid
+            *
+            * @param x                      x-coordinates
+            * @param y                      y-coordinates
+            * @param value                  Output time step
+            */
+            void interpolate_step(const float* x, const float* y, float* value) const;
+
+            /**
+            * Update labels and distances by evaluating the distance to the convergence structures
+            *
+            * @param x                      x-coordinates
+            * @param y                      y-coordinates
+            * @param active                 Mask of particles which are still advected
+            * @param labels                 In/out labels
+            * @param distances              In/out distances
+            */
+            void update_label_and_dist(const float* x, const float* y, const bool* active, float* labels, float* distances) const;
+
+            /**
+            * Compute the minimum distance of a position to all convergence structures
+            *
+            * @param x                      x-coordinate
+            * @param y                      y-coordinate
+            *
+            * @return Minimum distance
+            */
+            float min_distance(float x, float y) const;
+
+            /** Vector field resolution */
+            std::array<unsigned int, 2> resolution;
+
+            /** Vector field in struct-of-arrays layout, and initial time step per node */
+            std::vector<float> velocity_x;
+            std::vector<float> velocity_y;
+            std::vector<float> rk4_step;
+
+            /** Transformation from world to grid coordinates */
+            std::array<float, 2> domain_offset;
+            std::array<float, 2> domain_scale;
+            std::array<float, 2> grid_scale;
+
+            /** Cell size */
+            std::array<float, 2> cell_size;
+            float min_cell_size;
+
+            /** Convergence structures in struct-of-arrays layout */
+            std::vector<float> convergence_points_x;
+            std::vector<float> convergence_points_y;
+            std::vector<float> convergence_point_ids;
+
+            std::vector<float> convergence_lines_x0;
+            std::vector<float> convergence_lines_y0;
+            std::vector<float> convergence_lines_x1;
+            std::vector<float> convergence_lines_y1;
+            std::vector<float> convergence_lines_dir_x;
+            std::vector<float> convergence_lines_dir_y;
+            std::vector<float> convergence_lines_length;
+            std::vector<float> convergence_line_ids;
+
+            /** Time step information */
+            float integration_timestep;
+            float max_integration_error;
+
+            /** Integration method */
+            integration_method method;
+        };
+    }
+}
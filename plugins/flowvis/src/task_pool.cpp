@@ -0,0 +1,140 @@
+#include "stdafx.h"
+#include "task_pool.h"
+
+#include "vislib/sys/Log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        task_pool::task_pool(std::size_t num_threads) : num_running(0), shutdown(false)
+        {
+            if (num_threads == 0)
+            {
+                num_threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            this->workers.reserve(num_threads);
+
+            for (std::size_t i = 0; i < num_threads; ++i)
+            {
+                this->workers.emplace_back(&task_pool::work, this);
+            }
+        }
+
+        task_pool::~task_pool()
+        {
+            {
+                std::lock_guard<std::mutex> locker(this->lock);
+
+                this->tasks.clear();
+                this->shutdown = true;
+            }
+
+            this->condition.notify_all();
+
+            for (auto& worker : this->workers)
+            {
+                worker.join();
+            }
+        }
+
+        void task_pool::enqueue(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> locker(this->lock);
+
+                this->tasks.push_back(std::move(task));
+            }
+
+            this->condition.notify_one();
+        }
+
+        std::size_t task_pool::cancel()
+        {
+            std::size_t num_cancelled;
+
+            {
+                std::lock_guard<std::mutex> locker(this->lock);
+
+                num_cancelled = this->tasks.size();
+
+                this->tasks.clear();
+            }
+
+            this->finished_condition.notify_all();
+
+            return num_cancelled;
+        }
+
+        void task_pool::wait(const std::size_t max_tasks)
+        {
+            std::unique_lock<std::mutex> locker(this->lock);
+
+            this->finished_condition.wait(locker,
+                [this, max_tasks]() { return this->tasks.size() + this->num_running <= max_tasks; });
+        }
+
+        std::size_t task_pool::get_num_tasks() const
+        {
+            std::lock_guard<std::mutex> locker(this->lock);
+
+            return this->tasks.size() + this->num_running;
+        }
+
+        std::size_t task_pool::get_num_threads() const
+        {
+            return this->workers.size();
+        }
+
+        void task_pool::work()
+        {
+            std::unique_lock<std::mutex> locker(this->lock);
+
+            while (true)
+            {
+                this->condition.wait(locker, [this]() { return this->shutdown || !this->tasks.empty(); });
+
+                if (this->shutdown)
+                {
+                    return;
+                }
+
+                auto task = std::move(this->tasks.front());
+                this->tasks.pop_front();
+
+                ++this->num_running;
+
+                locker.unlock();
+
+                try
+                {
+                    task();
+                }
+                catch (const std::exception& e)
+                {
+                    vislib::sys::Log::DefaultLog.WriteError("Error in task: %s", e.what());
+                }
+                catch (...)
+                {
+                    vislib::sys::Log::DefaultLog.WriteError("Unknown error in task");
+                }
+
+                locker.lock();
+
+                --this->num_running;
+
+                this->finished_condition.notify_all();
+            }
+        }
+    }
+}
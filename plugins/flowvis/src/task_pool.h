@@ -0,0 +1,101 @@
+/*
+ * task_pool.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        /**
+        * Fixed number of worker threads, processing queued tasks in order of their submission.
+        *
+        * @author Alexander Straub
+        */
+        class task_pool
+        {
+        public:
+            /**
+            * Start worker threads
+            *
+            * @param num_threads    Number of worker threads; 0 for the number of hardware threads
+            */
+            explicit task_pool(std::size_t num_threads = 0);
+
+            /**
+            * Discard pending tasks, and wait for running tasks to finish
+            */
+            ~task_pool();
+
+            task_pool(const task_pool&) = delete;
+            task_pool& operator=(const task_pool&) = delete;
+
+            /**
+            * Queue task for execution
+            *
+            * @param task       Task
+            */
+            void enqueue(std::function<void()> task);
+
+            /**
+            * Discard all tasks which have not yet been started
+            *
+            * @return Number of discarded tasks
+            */
+            std::size_t cancel();
+
+            /**
+            * Block until at most the given number of tasks are either queued or running
+            *
+            * @param max_tasks  Maximum number of remaining tasks
+            */
+            void wait(std::size_t max_tasks);
+
+            /**
+            * Get number of tasks, which are either queued or running
+            *
+            * @return Number of tasks
+            */
+            std::size_t get_num_tasks() const;
+
+            /**
+            * Get number of worker threads
+            *
+            * @return Number of worker threads
+            */
+            std::size_t get_num_threads() const;
+
+        private:
+            /**
+            * Process tasks until the pool is destroyed
+            */
+            void work();
+
+            /** Worker threads */
+            std::vector<std::thread> workers;
+
+            /** Queued tasks */
+            std::deque<std::function<void()>> tasks;
+            std::size_t num_running;
+
+            /** Signal for the workers to finish */
+            bool shutdown;
+
+            /** Synchronization */
+            mutable std::mutex lock;
+            std::condition_variable condition;
+            std::condition_variable finished_condition;
+        };
+    }
+}
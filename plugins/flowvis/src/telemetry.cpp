@@ -0,0 +1,163 @@
+#include "stdafx.h"
+#include "telemetry.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        telemetry::event::event(std::ostream& output, const std::string& type, const double elapsed) : output(&output)
+        {
+            this->line << std::setprecision(9) << "{\"event\":\"" << type << "\",\"time\":" << elapsed;
+        }
+
+        telemetry::event::event(event&& original) : output(original.output), line(std::move(original.line))
+        {
+            original.output = nullptr;
+        }
+
+        telemetry::event::~event()
+        {
+            if (this->output != nullptr)
+            {
+                *this->output << this->line.str() << "}" << std::endl;
+            }
+        }
+
+        telemetry::event& telemetry::event::add(const std::string& key, const std::string& value)
+        {
+            add_key(key);
+
+            this->line << "\"";
+
+            for (const auto character : value)
+            {
+                switch (character)
+                {
+                case '"': this->line << "\\\""; break;
+                case '\\': this->line << "\\\\"; break;
+                case '\n': this->line << "\\n"; break;
+                case '\t': this->line << "\\t"; break;
+                default: this->line << character;
+                }
+            }
+
+            this->line << "\"";
+
+            return *this;
+        }
+
+        telemetry::event& telemetry::event::add(const std::string& key, const char* value)
+        {
+            return add(key, std::string(value));
+        }
+
+        telemetry::event& telemetry::event::add(const std::string& key, const double value)
+        {
+            add_key(key);
+
+            // JSON does not support infinity and NaN
+            if (std::isfinite(value))
+            {
+                this->line << value;
+            }
+            else
+            {
+                this->line << "null";
+            }
+
+            return *this;
+        }
+
+        telemetry::event& telemetry::event::add(const std::string& key, const long long value)
+        {
+            add_key(key);
+
+            this->line << value;
+
+            return *this;
+        }
+
+        telemetry::event& telemetry::event::add(const std::string& key, const unsigned long long value)
+        {
+            add_key(key);
+
+            this->line << value;
+
+            return *this;
+        }
+
+        telemetry::event& telemetry::event::add(const std::string& key, const bool value)
+        {
+            add_key(key);
+
+            this->line << (value ? "true" : "false");
+
+            return *this;
+        }
+
+        telemetry::event& telemetry::event::add_json(const std::string& key, const std::string& json)
+        {
+            add_key(key);
+
+            this->line << json;
+
+            return *this;
+        }
+
+        void telemetry::event::add_key(const std::string& key)
+        {
+            this->line << ",\"" << key << "\":";
+        }
+
+        telemetry::telemetry(std::ostream& output) : output(output), start(std::chrono::steady_clock::now())
+        { }
+
+        telemetry::event telemetry::record(const std::string& type)
+        {
+            return event(this->output, type, std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - this->start).count());
+        }
+
+        std::size_t telemetry::peak_memory()
+        {
+#ifdef _WIN32
+            PROCESS_MEMORY_COUNTERS counters;
+
+            if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            {
+                return static_cast<std::size_t>(counters.PeakWorkingSetSize);
+            }
+
+            return 0;
+#else
+            struct rusage usage;
+
+            if (getrusage(RUSAGE_SELF, &usage) == 0)
+            {
+#ifdef __APPLE__
+                return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+                return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+            }
+
+            return 0;
+#endif
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ * telemetry.h
+ *
+ * Copyright (C) 2019 by Universitaet Stuttgart (VIS).
+ * Alle Rechte vorbehalten.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace megamol
+{
+    namespace flowvis
+    {
+        /**
+        * Writer for structured performance measurements in JSON lines format, i.e.,
+        * one JSON object per line and event, including the event type and the time
+        * elapsed since creation of the writer.
+        *
+        * @author Alexander Straub
+        */
+        class telemetry
+        {
+        public:
+            /**
+            * Single event, which is written when it is destroyed
+            */
+            class event
+            {
+            public:
+                /**
+                * Start event
+                *
+                * @param output     Output stream
+                * @param type       Event type
+                * @param elapsed    Time elapsed since creation of the writer in seconds
+                */
+                event(std::ostream& output, const std::string& type, double elapsed);
+
+                /**
+                * Write event
+                */
+                ~event();
+
+                event(event&& original);
+                event(const event&) = delete;
+                event& operator=(const event&) = delete;
+
+                /**
+                * Add values
+                *
+                * @param key        Key
+                * @param value      Value
+                *
+                * @return This event
+                */
+                event& add(const std::string& key, const std::string& value);
+                event& add(const std::string& key, const char* value);
+                event& add(const std::string& key, double value);
+                event& add(const std::string& key, long long value);
+                event& add(const std::string& key, unsigned long long value);
+                event& add(const std::string& key, bool value);
+
+                event& add(const std::string& key, int value) { return add(key, static_cast<long long>(value)); }
+                event& add(const std::string& key, unsigned int value) { return add(key, static_cast<unsigned long long>(value)); }
+                event& add(const std::string& key, unsigned long value) { return add(key, static_cast<unsigned long long>(value)); }
+
+                /**
+                * Add value which is already formatted as JSON, e.g., a nested object
+                *
+                * @param key        Key
+                * @param json       JSON value
+                *
+                * @return This event
+                */
+                event& add_json(const std::string& key, const std::string& json);
+
+            private:
+                /**
+                * Start new entry
+                *
+                * @param key        Key
+                */
+                void add_key(const std::string& key);
+
+                /** Output stream, or nullptr if the event has been moved */
+                std::ostream* output;
+
+                /** Content of the line */
+                std::ostringstream line;
+            };
+
+            /**
+            * Create writer
+            *
+            * @param output     Output stream
+            */
+            explicit telemetry(std::ostream& output);
+
+            /**
+            * Start event, which is written when the returned object is destroyed
+            *
+            * @param type       Event type
+            *
+            * @return Event for adding values
+            */
+            event record(const std::string& type);
+
+            /**
+            * Get peak memory usage of the process
+            *
+            * @return Peak resident set size in bytes, or 0 if not available
+            */
+            static std::size_t peak_memory();
+
+            /**
+            * Get duration in milliseconds with fractional part
+            *
+            * @param duration   Duration
+            *
+            * @return Milliseconds
+            */
+            template <typename duration_t>
+            static double milliseconds(const duration_t duration)
+            {
+                return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(duration).count();
+            }
+
+            /**
+            * Get rate per second, with zero for empty durations
+            *
+            * @param count      Count
+            * @param duration   Duration
+            *
+            * @return Count per second
+            */
+            template <typename duration_t>
+            static double per_second(const double count, const duration_t duration)
+            {
+                const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+
+                return seconds > 0.0 ? count / seconds : 0.0;
+            }
+
+        private:
+            /** Output stream */
+            std::ostream& output;
+
+            /** Reference time point */
+            const std::chrono::steady_clock::time_point start;
+        };
+    }
+}
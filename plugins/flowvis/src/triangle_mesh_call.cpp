@@ -4,6 +4,7 @@
 #include "vislib/math/Cuboid.h"
 #include "vislib/math/Rectangle.h"
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -11,7 +12,7 @@ namespace megamol
 {
     namespace flowvis
     {
-        triangle_mesh_call::triangle_mesh_call() : dimension(dimension_t::INVALID) {}
+        triangle_mesh_call::triangle_mesh_call() : dimension(dimension_t::INVALID), first_new_vertex(0) {}
 
         triangle_mesh_call::dimension_t triangle_mesh_call::get_dimension() const
         {
@@ -72,5 +73,21 @@ namespace megamol
         {
             this->indices = indices;
         }
+
+        std::size_t triangle_mesh_call::get_first_new_vertex() const
+        {
+            return this->first_new_vertex;
+        }
+
+        std::shared_ptr<std::vector<unsigned int>> triangle_mesh_call::get_changed_cells() const
+        {
+            return this->changed_cells;
+        }
+
+        void triangle_mesh_call::set_changes(const std::size_t first_new_vertex, std::shared_ptr<std::vector<unsigned int>> changed_cells)
+        {
+            this->first_new_vertex = first_new_vertex;
+            this->changed_cells = changed_cells;
+        }
     }
 }
@@ -12,6 +12,7 @@
 #include "vislib/math/Cuboid.h"
 #include "vislib/math/Rectangle.h"
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -126,6 +127,22 @@ namespace megamol
             */
             void set_indices(std::shared_ptr<std::vector<unsigned int>> indices);
 
+            /**
+            * Getter for the index of the first vertex added since the previous data hash
+            */
+            std::size_t get_first_new_vertex() const;
+
+            /**
+            * Getter for the sorted indices of triangles changed since the previous data hash;
+            * nullptr if the changes are unknown, requiring the complete mesh to be updated
+            */
+            std::shared_ptr<std::vector<unsigned int>> get_changed_cells() const;
+
+            /**
+            * Setter for the changes since the previous data hash
+            */
+            void set_changes(std::size_t first_new_vertex, std::shared_ptr<std::vector<unsigned int>> changed_cells);
+
         protected:
             /** Dimension */
             dimension_t dimension;
@@ -140,6 +157,10 @@ namespace megamol
             std::shared_ptr<std::vector<float>> vertices;
             std::shared_ptr<std::vector<float>> normals;
             std::shared_ptr<std::vector<unsigned int>> indices;
+
+            /** Changes since the previous data hash */
+            std::size_t first_new_vertex;
+            std::shared_ptr<std::vector<unsigned int>> changed_cells;
         };
     }
 }
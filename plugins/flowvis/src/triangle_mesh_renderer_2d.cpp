@@ -17,13 +17,69 @@
 
 #include "glad/glad.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <exception>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+namespace
+{
+    /**
+    * Upload ranges of the data to a buffer. If the buffer is too small, it is enlarged
+    * geometrically, and all data is uploaded.
+    *
+    * @param target     Buffer target
+    * @param capacity   Capacity of the currently bound buffer in bytes
+    * @param data       Data to upload
+    * @param ranges     Ranges [begin, end) of elements to upload
+    */
+    template <typename T>
+    void upload_buffer(const GLenum target, std::size_t& capacity, const std::vector<T>& data,
+        const std::vector<std::pair<std::size_t, std::size_t>>& ranges)
+    {
+        const auto size = data.size() * sizeof(T);
+
+        if (size > capacity)
+        {
+            capacity = std::max(size, 2 * capacity);
+
+            glBufferData(target, static_cast<GLsizeiptr>(capacity), nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(target, 0, static_cast<GLsizeiptr>(size), data.data());
+
+            return;
+        }
+
+        for (const auto& range : ranges)
+        {
+            const auto begin = std::min(range.first, data.size());
+            const auto end = std::min(range.second, data.size());
+
+            if (begin < end)
+            {
+                glBufferSubData(target, static_cast<GLintptr>(begin * sizeof(T)), static_cast<GLsizeiptr>((end - begin) * sizeof(T)), data.data() + begin);
+            }
+        }
+    }
+
+    /**
+    * Upload all data to a buffer, enlarging it geometrically if necessary
+    *
+    * @param target     Buffer target
+    * @param capacity   Capacity of the currently bound buffer in bytes
+    * @param data       Data to upload
+    */
+    template <typename T>
+    void upload_buffer(const GLenum target, std::size_t& capacity, const std::vector<T>& data)
+    {
+        upload_buffer(target, capacity, data, { std::make_pair(static_cast<std::size_t>(0), data.size()) });
+    }
+}
+
 namespace megamol
 {
     namespace flowvis
@@ -175,6 +231,10 @@ namespace megamol
 
             if (get_triangles->DataHash() != this->triangle_mesh_hash)
             {
+                // Only upload changes if they refer to the mesh already in the buffers
+                const bool has_changes = this->render_data.vertices != nullptr && this->render_data.indices != nullptr
+                    && get_triangles->DataHash() == this->triangle_mesh_hash + 1 && get_triangles->get_changed_cells() != nullptr;
+
                 // Set hash
                 this->triangle_mesh_hash = get_triangles->DataHash();
 
@@ -188,13 +248,53 @@ namespace megamol
                     glBindVertexArray(this->render_data.vao);
 
                     glBindBuffer(GL_ARRAY_BUFFER, this->render_data.vbo);
-                    glBufferData(GL_ARRAY_BUFFER, this->render_data.vertices->size() * sizeof(GLfloat), this->render_data.vertices->data(), GL_STATIC_DRAW);
+
+                    if (has_changes)
+                    {
+                        upload_buffer(GL_ARRAY_BUFFER, this->render_data.vbo_capacity, *this->render_data.vertices,
+                            { std::make_pair(2 * get_triangles->get_first_new_vertex(), this->render_data.vertices->size()) });
+                    }
+                    else
+                    {
+                        upload_buffer(GL_ARRAY_BUFFER, this->render_data.vbo_capacity, *this->render_data.vertices);
+                    }
 
                     glEnableVertexAttribArray(0);
                     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
 
                     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->render_data.ibo);
-                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->render_data.indices->size() * sizeof(GLuint), this->render_data.indices->data(), GL_STATIC_DRAW);
+
+                    if (has_changes)
+                    {
+                        // Merge changed triangles into ranges, accepting small gaps to reduce the number of uploads
+                        const std::size_t max_gap = 64;
+
+                        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+                        for (const auto cell : *get_triangles->get_changed_cells())
+                        {
+                            if (!ranges.empty() && cell <= ranges.back().second + max_gap)
+                            {
+                                ranges.back().second = std::max(ranges.back().second, static_cast<std::size_t>(cell) + 1);
+                            }
+                            else
+                            {
+                                ranges.push_back(std::make_pair(static_cast<std::size_t>(cell), static_cast<std::size_t>(cell) + 1));
+                            }
+                        }
+
+                        for (auto& range : ranges)
+                        {
+                            range.first *= 3;
+                            range.second *= 3;
+                        }
+
+                        upload_buffer(GL_ELEMENT_ARRAY_BUFFER, this->render_data.ibo_capacity, *this->render_data.indices, ranges);
+                    }
+                    else
+                    {
+                        upload_buffer(GL_ELEMENT_ARRAY_BUFFER, this->render_data.ibo_capacity, *this->render_data.indices);
+                    }
 
                     glBindVertexArray(0);
                 }
@@ -233,7 +333,8 @@ namespace megamol
                     this->mesh_data_hash = get_data->DataHash();
                 }
 
-                if (this->render_data.values == nullptr)
+                if (this->render_data.values == nullptr || (this->render_data.default_values
+                    && this->render_data.values->data->size() != this->render_data.vertices->size() / 2))
                 {
                     this->render_data.values = std::make_shared<mesh_data_call::data_set>();
 
@@ -248,35 +349,50 @@ namespace megamol
                     this->render_data.values->min_value = 0.0f;
                     this->render_data.values->max_value = 1.0f;
                     this->render_data.values->data = std::make_shared<std::vector<GLfloat>>(this->render_data.vertices->size() / 2, 1.0f);
+
+                    this->render_data.default_values = true;
+
+                    new_data = true;
+                }
+                else if (new_data)
+                {
+                    this->render_data.default_values = false;
                 }
 
-                if (this->render_data.mask == nullptr)
+                if (this->render_data.mask == nullptr || (this->render_data.default_mask
+                    && this->render_data.mask->size() != this->render_data.vertices->size() / 2))
                 {
                     this->render_data.mask = std::make_shared<std::vector<GLfloat>>(this->render_data.vertices->size() / 2, 1.0f);
 
+                    this->render_data.default_mask = true;
+
                     new_mask = true;
                 }
+                else if (new_mask)
+                {
+                    this->render_data.default_mask = false;
+                }
 
-                // Prepare OpenGL buffers
-                glBindVertexArray(this->render_data.vao);
-
-                glBindBuffer(GL_ARRAY_BUFFER, this->render_data.cbo);
-                glBufferData(GL_ARRAY_BUFFER, this->render_data.values->data->size() * sizeof(GLfloat), this->render_data.values->data->data(), GL_STATIC_DRAW);
+                // Prepare OpenGL buffers, only uploading values and masks that changed
+                if (new_data)
+                {
+                    glBindVertexArray(this->render_data.vao);
 
-                glEnableVertexAttribArray(1);
-                glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+                    glBindBuffer(GL_ARRAY_BUFFER, this->render_data.cbo);
+                    upload_buffer(GL_ARRAY_BUFFER, this->render_data.cbo_capacity, *this->render_data.values->data);
 
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->render_data.ibo);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->render_data.indices->size() * sizeof(GLuint), this->render_data.indices->data(), GL_STATIC_DRAW);
+                    glEnableVertexAttribArray(1);
+                    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-                glBindVertexArray(0);
+                    glBindVertexArray(0);
+                }
 
                 if (new_mask)
                 {
                     glBindVertexArray(this->render_data.vao);
 
                     glBindBuffer(GL_ARRAY_BUFFER, this->render_data.mbo);
-                    glBufferData(GL_ARRAY_BUFFER, this->render_data.mask->size() * sizeof(GLfloat), this->render_data.mask->data(), GL_STATIC_DRAW);
+                    upload_buffer(GL_ARRAY_BUFFER, this->render_data.mbo_capacity, *this->render_data.mask);
 
                     glEnableVertexAttribArray(2);
                     glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -19,6 +19,7 @@
 #include "glad/glad.h"
 
 #include <array>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -163,12 +164,16 @@ namespace megamol
                 GLuint vao, vbo, ibo, cbo, mbo;
                 GLuint tf, tf_size;
 
+                std::size_t vbo_capacity = 0, ibo_capacity = 0, cbo_capacity = 0, mbo_capacity = 0;
+
                 std::shared_ptr<std::vector<GLfloat>> vertices;
                 std::shared_ptr<std::vector<GLuint>> indices;
 
                 std::shared_ptr<mesh_data_call::data_set> values;
+                bool default_values = false;
 
                 std::shared_ptr<std::vector<GLfloat>> mask;
+                bool default_mask = false;
 
             } render_data;
 
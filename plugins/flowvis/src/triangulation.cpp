@@ -1,8 +1,14 @@
 #include "stdafx.h"
 #include "triangulation.h"
 
+#include <CGAL/property_map.h>
+#include <CGAL/spatial_sort.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+
 #include "glad/glad.h"
 
+#include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -10,7 +16,7 @@ namespace megamol
 {
     namespace flowvis
     {
-        triangulation::triangulation(const std::vector<GLfloat>& initial_points) : point_index(0)
+        triangulation::triangulation(const std::vector<GLfloat>& initial_points) : point_index(0), num_exports(0)
         {
             if (!initial_points.empty())
             {
@@ -20,45 +26,254 @@ namespace megamol
 
         void triangulation::insert_points(const std::vector<GLfloat>& new_points)
         {
-            // Get new points and add them to the triangulation and the output
-            std::vector<std::pair<point_t, std::size_t>> points;
+            // Convert input to points
+            std::vector<point_t> points;
             points.reserve(new_points.size() / 2);
 
             for (std::size_t i = 0; i < new_points.size() / 2; ++i)
             {
-                points.push_back(std::make_pair(point_t(static_cast<double>(new_points[i * 2 + 0]), static_cast<double>(new_points[i * 2 + 1])), this->point_index++));
+                points.push_back(point_t(static_cast<double>(new_points[i * 2 + 0]), static_cast<double>(new_points[i * 2 + 1])));
+            }
+
+            insert_points(points);
+        }
+
+        void triangulation::insert_points(const std::vector<point_t>& new_points)
+        {
+            // Get new points and assign indices in input order
+            std::vector<std::pair<point_t, std::size_t>> points;
+            points.reserve(new_points.size());
+
+            for (const auto& point : new_points)
+            {
+                points.push_back(std::make_pair(point, this->point_index++));
+            }
+
+            // Sort along a Hilbert curve, such that consecutive points are close to each other
+            typedef CGAL::First_of_pair_property_map<std::pair<point_t, std::size_t>> point_map_t;
+
+            CGAL::spatial_sort(points.begin(), points.end(), CGAL::Spatial_sort_traits_adapter_2<kernel, point_map_t>());
+
+            // Apply delaunay, starting point location at the previously inserted vertex
+            vertex_t hint;
+
+            for (const auto& point : points)
+            {
+                hint = this->delaunay.insert(point.first, hint == vertex_t() ? delaunay_t::Face_handle() : hint->face());
+                hint->info() = point.second;
+            }
+
+            // Remember points for the next export
+            this->pending_points.insert(this->pending_points.end(), points.begin(), points.end());
+        }
+
+        void triangulation::acquire_buffers()
+        {
+            // Number of buffers kept for recycling, allowing a consumer to hold on to one previous export
+            constexpr std::size_t max_spare_buffers = 2;
+
+            if (!this->vertices)
+            {
+                this->vertices = recyclable<std::vector<GLfloat>>(std::make_shared<std::vector<GLfloat>>());
+                this->indices = recyclable<std::vector<GLuint>>(std::make_shared<std::vector<GLuint>>());
+
+                return;
+            }
+
+            if (this->vertices.is_released() && this->indices.is_released())
+            {
+                return;
+            }
+
+            // Take a buffer released by all consumers, or create a new one
+            auto spare_it = std::find_if(this->spare_buffers.begin(), this->spare_buffers.end(),
+                [](const buffers_t& buffers) { return buffers.vertices.is_released() && buffers.indices.is_released(); });
+
+            buffers_t buffers;
+
+            if (spare_it != this->spare_buffers.end())
+            {
+                buffers = std::move(*spare_it);
+                this->spare_buffers.erase(spare_it);
+            }
+            else
+            {
+                buffers.vertices = recyclable<std::vector<GLfloat>>(std::make_shared<std::vector<GLfloat>>());
+                buffers.indices = recyclable<std::vector<GLuint>>(std::make_shared<std::vector<GLuint>>());
+                buffers.revision = 0;
+
+                if (this->spare_buffers.size() == max_spare_buffers)
+                {
+                    this->spare_buffers.erase(this->spare_buffers.begin());
+                }
+            }
+
+            // Update with the changes since the buffer was exported; vertices are only ever appended
+            const std::size_t num_missing = this->num_exports - buffers.revision;
+
+            if (buffers.revision == 0 || num_missing > this->change_history.size())
+            {
+                *buffers.vertices = *this->vertices;
+                *buffers.indices = *this->indices;
+            }
+            else
+            {
+                buffers.vertices->insert(buffers.vertices->end(), this->vertices->begin() + buffers.vertices->size(), this->vertices->end());
+                buffers.indices->resize(this->indices->size());
+
+                const std::size_t num_cells = this->indices->size() / 3;
+
+                for (auto changes_it = this->change_history.end() - num_missing; changes_it != this->change_history.end(); ++changes_it)
+                {
+                    for (const auto cell : **changes_it)
+                    {
+                        if (cell < num_cells)
+                        {
+                            std::copy_n(this->indices->begin() + cell * 3, 3, buffers.indices->begin() + cell * 3);
+                        }
+                    }
+                }
             }
 
-            // Apply delaunay
-            this->delaunay.insert(points.begin(), points.end());
+            this->spare_buffers.push_back(buffers_t{ std::move(this->vertices), std::move(this->indices), this->num_exports });
+
+            this->vertices = std::move(buffers.vertices);
+            this->indices = std::move(buffers.indices);
         }
 
-        std::pair<std::shared_ptr<std::vector<GLfloat>>, std::shared_ptr<std::vector<GLuint>>> triangulation::export_grid() const
+        triangulation::grid_t triangulation::export_grid()
         {
-            // Extract points
-            auto vertices = std::make_shared<std::vector<GLfloat>>(this->delaunay.number_of_vertices() * 2);
+            // Number of exports, of which the changed cells are remembered for updating recycled buffers
+            constexpr std::size_t max_change_history = 4;
+
+            acquire_buffers();
+
+            grid_t grid;
+            grid.first_new_vertex = this->vertices->size() / 2;
+            grid.changed_cells = std::make_shared<std::vector<GLuint>>();
+
+            // Append new points
+            this->vertices->resize(this->point_index * 2);
 
-            for (auto vertex_it = this->delaunay.finite_vertices_begin(); vertex_it != this->delaunay.finite_vertices_end(); ++vertex_it)
+            for (const auto& point : this->pending_points)
             {
-                (*vertices)[vertex_it->info() * 2 + 0] = static_cast<GLfloat>(CGAL::to_double(vertex_it->point()[0]));
-                (*vertices)[vertex_it->info() * 2 + 1] = static_cast<GLfloat>(CGAL::to_double(vertex_it->point()[1]));
+                (*this->vertices)[point.second * 2 + 0] = static_cast<GLfloat>(CGAL::to_double(point.first[0]));
+                (*this->vertices)[point.second * 2 + 1] = static_cast<GLfloat>(CGAL::to_double(point.first[1]));
             }
 
-            // Extract cells
-            auto indices = std::make_shared<std::vector<GLuint>>(get_number_of_cells() * 3);
+            this->pending_points.clear();
 
-            std::size_t cell_index = 0;
+            // Find cells which were removed from or added to the triangulation
+            const std::size_t num_slots = this->indices->size() / 3;
+            const std::size_t num_cells = get_number_of_cells();
+
+            std::vector<delaunay_t::Face_handle> slot_cells(num_slots);
+            std::vector<delaunay_t::Face_handle> new_cells;
+            std::vector<delaunay_t::Face_handle> modified_cells;
 
             for (auto face_it = get_finite_cells_begin(); face_it != get_finite_cells_end(); ++face_it)
             {
-                // Get all triangle points
+                const std::size_t cell_slot = face_it->info().slot;
+
+                if (cell_slot == cell_info::unassigned || cell_slot >= num_slots || slot_cells[cell_slot] != delaunay_t::Face_handle())
+                {
+                    new_cells.push_back(face_it);
+                }
+                else
+                {
+                    slot_cells[cell_slot] = face_it;
+
+                    // CGAL reuses faces during insertion and flips, such that they keep their slot with different vertices
+                    for (unsigned int i = 0; i < 3; ++i)
+                    {
+                        if ((*this->indices)[cell_slot * 3 + i] != static_cast<GLuint>(face_it->vertex(i)->info()))
+                        {
+                            modified_cells.push_back(face_it);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            auto assign_slot = [this, &grid, &slot_cells](const delaunay_t::Face_handle& face, const std::size_t slot)
+            {
+                face->info().slot = slot;
+
                 for (unsigned int i = 0; i < 3; ++i)
                 {
-                    (*indices)[cell_index++] = static_cast<GLuint>(face_it->vertex(i)->info());
+                    (*this->indices)[slot * 3 + i] = static_cast<GLuint>(face->vertex(i)->info());
                 }
+
+                slot_cells[slot] = face;
+                grid.changed_cells->push_back(static_cast<GLuint>(slot));
+            };
+
+            for (const auto& face : modified_cells)
+            {
+                assign_slot(face, face->info().slot);
             }
 
-            return std::make_pair(vertices, indices);
+            // Put new cells into slots of removed cells first, and append the rest
+            auto new_cell_it = new_cells.begin();
+            std::size_t slot = 0;
+
+            for (; slot < num_slots && new_cell_it != new_cells.end(); ++slot)
+            {
+                if (slot_cells[slot] == delaunay_t::Face_handle())
+                {
+                    assign_slot(*new_cell_it++, slot);
+                }
+            }
+
+            if (new_cell_it != new_cells.end())
+            {
+                this->indices->resize(num_cells * 3);
+                slot_cells.resize(num_cells);
+
+                for (slot = num_slots; new_cell_it != new_cells.end(); ++slot)
+                {
+                    assign_slot(*new_cell_it++, slot);
+                }
+            }
+            else
+            {
+                // Close remaining gaps by moving cells from the end
+                std::size_t source = num_slots;
+
+                for (; slot < num_cells; ++slot)
+                {
+                    if (slot_cells[slot] == delaunay_t::Face_handle())
+                    {
+                        do
+                        {
+                            --source;
+                        } while (slot_cells[source] == delaunay_t::Face_handle());
+
+                        assign_slot(slot_cells[source], slot);
+                        slot_cells[source] = delaunay_t::Face_handle();
+                    }
+                }
+
+                this->indices->resize(num_cells * 3);
+            }
+
+            std::sort(grid.changed_cells->begin(), grid.changed_cells->end());
+            grid.changed_cells->erase(std::unique(grid.changed_cells->begin(), grid.changed_cells->end()), grid.changed_cells->end());
+            grid.changed_cells->erase(std::remove_if(grid.changed_cells->begin(), grid.changed_cells->end(),
+                [num_cells](const GLuint cell) { return cell >= num_cells; }), grid.changed_cells->end());
+
+            this->change_history.push_back(grid.changed_cells);
+
+            if (this->change_history.size() > max_change_history)
+            {
+                this->change_history.pop_front();
+            }
+
+            grid.vertices = this->vertices.share();
+            grid.indices = this->indices.share();
+            grid.revision = ++this->num_exports;
+
+            return grid;
         }
 
         std::vector<triangulation::vertex_t> triangulation::get_neighbors(const vertex_t& vertex) const
@@ -3,11 +3,16 @@
 #include <CGAL/Delaunay_triangulation_2.h>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Triangulation_vertex_base_with_info_2.h>
-#include <CGAL/Triangulation_face_base_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
 #include <CGAL/Triangulation_data_structure_2.h>
 
+#include "recyclable.h"
+
 #include "glad/glad.h"
 
+#include <deque>
+#include <limits>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -18,10 +23,21 @@ namespace megamol
         class triangulation
         {
         private:
+            /**
+            * Information attached to each cell: position of the cell in the exported index buffer.
+            * Cells created by insertion of new points are default-constructed and thus unassigned.
+            */
+            struct cell_info
+            {
+                static constexpr std::size_t unassigned = std::numeric_limits<std::size_t>::max();
+
+                std::size_t slot = unassigned;
+            };
+
             typedef CGAL::Exact_predicates_inexact_constructions_kernel kernel;
 
             typedef CGAL::Triangulation_vertex_base_with_info_2<std::size_t, kernel> vertex_base;
-            typedef CGAL::Triangulation_face_base_2<kernel> face_base;
+            typedef CGAL::Triangulation_face_base_with_info_2<cell_info, kernel> face_base;
 
             typedef CGAL::Triangulation_data_structure_2<vertex_base, face_base> data_structure;
 
@@ -33,6 +49,25 @@ namespace megamol
 
             typedef delaunay_t::Vertex_handle vertex_t;
 
+            /**
+            * Exported grid, and the changes with respect to the previous export
+            */
+            struct grid_t
+            {
+                /** Vertices (two coordinates each) and indices (three per cell) */
+                std::shared_ptr<std::vector<GLfloat>> vertices;
+                std::shared_ptr<std::vector<GLuint>> indices;
+
+                /** Index of the first vertex added since the previous export */
+                std::size_t first_new_vertex;
+
+                /** Sorted indices of cells that were added or replaced since the previous export */
+                std::shared_ptr<std::vector<GLuint>> changed_cells;
+
+                /** Number of exports including this one, identifying the export the changes refer to */
+                std::size_t revision;
+            };
+
         public:
             /**
             * Constructor
@@ -49,11 +84,22 @@ namespace megamol
             void insert_points(const std::vector<GLfloat>& new_points);
 
             /**
-            * Export triangulation as grid
+            * Insert points in spatially sorted (Hilbert curve) order, each using the previously
+            * inserted vertex as hint for point location
             *
-            * @param grid Grid storing the triangulation
+            * @param new_points New points to add to the triangulation
             */
-            std::pair<std::shared_ptr<std::vector<GLfloat>>, std::shared_ptr<std::vector<GLuint>>> export_grid() const;
+            void insert_points(const std::vector<point_t>& new_points);
+
+            /**
+            * Export triangulation as grid, only updating vertices and cells changed since the last export.
+            * Buffers of previous exports are recycled once all consumers released them, and only
+            * updated with the changes since; buffers still in use are never modified. Consumers may
+            * release the buffers on any thread.
+            *
+            * @return Grid storing the triangulation
+            */
+            grid_t export_grid();
 
             /**
             * Get neighbor vertices
@@ -94,9 +140,39 @@ namespace megamol
             void to_c_point(const point_t& point, float* c_point) const;
 
         private:
+            /**
+            * Exported vertex and index buffers, and the number of the export they represent
+            */
+            struct buffers_t
+            {
+                recyclable<std::vector<GLfloat>> vertices;
+                recyclable<std::vector<GLuint>> indices;
+
+                std::size_t revision;
+            };
+
+            /**
+            * Get writable buffers equal to the last export, recycling unused buffers of earlier exports
+            */
+            void acquire_buffers();
+
             // Counter for mapping triangulated points to original input
             std::size_t point_index;
 
+            // Points inserted since the last export
+            std::vector<std::pair<point_t, std::size_t>> pending_points;
+
+            // Number of exports
+            std::size_t num_exports;
+
+            // Last exported vertices and indices
+            recyclable<std::vector<GLfloat>> vertices;
+            recyclable<std::vector<GLuint>> indices;
+
+            // Buffers of earlier exports for recycling, and the changed cells of the latest exports
+            std::vector<buffers_t> spare_buffers;
+            std::deque<std::shared_ptr<std::vector<GLuint>>> change_history;
+
         public:
             // Access to delaunay triangulation
             delaunay_t delaunay;
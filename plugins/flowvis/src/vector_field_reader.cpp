@@ -5,12 +5,15 @@
 
 #include "mmcore/Call.h"
 #include "mmcore/param/FilePathParam.h"
+#include "mmcore/utility/MappedFile.h"
 
+#include "vislib/String.h"
 #include "vislib/sys/Log.h"
 
-#include <fstream>
-#include <iostream>
+#include <cstring>
+#include <exception>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace megamol
@@ -34,6 +37,7 @@ namespace megamol
             this->stored_data.resolution = { 0u, 0u };
             this->stored_data.positions = std::make_shared<std::vector<float>>();
             this->stored_data.vectors = std::make_shared<std::vector<float>>();
+            this->stored_data.hash = 0;
         }
 
         vector_field_reader::~vector_field_reader()
@@ -54,192 +58,141 @@ namespace megamol
             // Get call
             auto* vf_call = dynamic_cast<vector_field_call*>(&call);
 
-            if (vf_call != nullptr)
+            if (vf_call == nullptr || !load())
             {
-                if (!this->file_path_slot.Param<core::param::FilePathParam>()->Value().IsEmpty() &&
-                    this->file_path_slot.IsDirty())
-                {
-                    this->file_path_slot.ResetDirty();
-
-                    // Open file
-                    std::ifstream vectors_ifs(this->file_path_slot.Param<core::param::FilePathParam>()->Value(), std::ios_base::in | std::ios_base::binary);
-
-                    if (vectors_ifs.good())
-                    {
-                        // Get dimension from file
-                        unsigned int dimension, components;
-
-                        vectors_ifs.read(reinterpret_cast<char*>(&dimension), sizeof(unsigned int));
-                        vectors_ifs.read(reinterpret_cast<char*>(&components), sizeof(unsigned int));
-
-                        if (dimension != 2)
-                        {
-                            vislib::sys::Log::DefaultLog.WriteError("Vector field file must have exactly two dimensions '%s'",
-                                this->file_path_slot.Param<core::param::FilePathParam>()->Value());
-
-                            return false;
-                        }
-
-                        if (components != 2)
-                        {
-                            vislib::sys::Log::DefaultLog.WriteError("Vectors must have exactly two components '%s'",
-                                this->file_path_slot.Param<core::param::FilePathParam>()->Value());
+                return false;
+            }
 
-                            return false;
-                        }
+            vf_call->set_resolution(this->stored_data.resolution);
+            vf_call->set_bounding_rectangle(this->stored_data.bounding_rectangle);
 
-                        // Read extents from file
-                        float x_min, x_max, y_min, y_max;
-                        unsigned int x_num, y_num, num;
+            vf_call->set_positions(this->stored_data.positions);
+            vf_call->set_vectors(this->stored_data.vectors);
 
-                        vectors_ifs.read(reinterpret_cast<char*>(&x_num), sizeof(unsigned int));
-                        vectors_ifs.read(reinterpret_cast<char*>(&x_min), sizeof(float));
-                        vectors_ifs.read(reinterpret_cast<char*>(&x_max), sizeof(float));
-                        vectors_ifs.read(reinterpret_cast<char*>(&y_num), sizeof(unsigned int));
-                        vectors_ifs.read(reinterpret_cast<char*>(&y_min), sizeof(float));
-                        vectors_ifs.read(reinterpret_cast<char*>(&y_max), sizeof(float));
+            vf_call->SetDataHash(this->stored_data.hash);
 
-                        num = x_num * y_num;
+            return true;
+        }
 
-                        vf_call->set_resolution(this->stored_data.resolution = { static_cast<unsigned int>(x_num), static_cast<unsigned int>(y_num) });
-                        vf_call->set_bounding_rectangle(this->stored_data.bounding_rectangle = vislib::math::Rectangle<float>(x_min, y_min, x_max, y_max));
+        bool vector_field_reader::get_extent(core::Call& call)
+        {
+            // Get call
+            auto* vf_call = dynamic_cast<vector_field_call*>(&call);
 
-                        // Read file content
-                        const float x_step = (x_max - x_min) / (x_num - 1);
-                        const float y_step = (y_max - y_min) / (y_num - 1);
+            if (vf_call == nullptr || !load())
+            {
+                return false;
+            }
 
-                        auto positions = std::make_shared<std::vector<float>>(num * 2);
-                        auto vectors = std::make_shared<std::vector<float>>(num * 2);
+            vf_call->set_resolution(this->stored_data.resolution);
+            vf_call->set_bounding_rectangle(this->stored_data.bounding_rectangle);
 
-                        for (unsigned int y = 0; y < y_num; ++y)
-                        {
-                            for (unsigned int x = 0; x < x_num; ++x)
-                            {
-                                const unsigned int xy = y * x_num + x;
+            vf_call->SetDataHash(this->stored_data.hash);
 
-                                // Calculate positions
-                                const float x_pos = x_min + x * x_step;
-                                const float y_pos = y_min + y * y_step;
+            return true;
+        }
 
-                                (*positions)[xy * 2 + 0] = x_pos;
-                                (*positions)[xy * 2 + 1] = y_pos;
+        bool vector_field_reader::load()
+        {
+            if (this->file_path_slot.Param<core::param::FilePathParam>()->Value().IsEmpty() || !this->file_path_slot.IsDirty())
+            {
+                return true;
+            }
 
-                                // Read vectors
-                                vectors_ifs.read(reinterpret_cast<char*>(&(*vectors)[xy * 2 + 0]), sizeof(float));
-                                vectors_ifs.read(reinterpret_cast<char*>(&(*vectors)[xy * 2 + 1]), sizeof(float));
-                            }
-                        }
+            this->file_path_slot.ResetDirty();
 
-                        vf_call->set_positions(this->stored_data.positions = positions);
-                        vf_call->set_vectors(this->stored_data.vectors = vectors);
+            const std::string filename(this->file_path_slot.Param<core::param::FilePathParam>()->Value());
 
-                        vectors_ifs.close();
+            try
+            {
+                // Map file into memory, instead of reading it value by value
+                core::utility::MappedFile file;
 
-                        vf_call->SetDataHash(this->stored_data.hash = (vf_call->DataHash() + 1));
+                if (!file.Open(vislib::TString(filename.c_str())))
+                {
+                    vislib::sys::Log::DefaultLog.WriteError("Unable to map vector field file '%s' into memory", filename.c_str());
+                    return false;
+                }
 
-                        return true;
-                    }
-                    else
-                    {
-                        vislib::sys::Log::DefaultLog.WriteWarn("Unable to open input vector field file '%s'!",
-                            this->file_path_slot.Param<core::param::FilePathParam>()->Value());
+                const auto file_size = static_cast<std::size_t>(file.Size());
 
-                        return false;
-                    }
-                }
-                else
+                // Get header from file
+                struct header_t
                 {
-                    vf_call->set_resolution(this->stored_data.resolution);
-                    vf_call->set_bounding_rectangle(this->stored_data.bounding_rectangle);
+                    unsigned int dimension, components;
 
-                    vf_call->set_positions(this->stored_data.positions);
-                    vf_call->set_vectors(this->stored_data.vectors);
+                    unsigned int x_num;
+                    float x_min, x_max;
+                    unsigned int y_num;
+                    float y_min, y_max;
+                } header;
 
-                    vf_call->SetDataHash(this->stored_data.hash);
-
-                    return true;
+                if (file_size < sizeof(header_t))
+                {
+                    vislib::sys::Log::DefaultLog.WriteError("Vector field file is too small '%s'", filename.c_str());
+                    return false;
                 }
-            }
-            else
-            {
-                return false;
-            }
 
-            return true;
-        }
+                std::memcpy(&header, file.Data(), sizeof(header_t));
 
-        bool vector_field_reader::get_extent(core::Call& call)
-        {
-            // Get call
-            auto* vf_call = dynamic_cast<vector_field_call*>(&call);
-
-            if (vf_call != nullptr)
-            {
-                if (!this->file_path_slot.Param<core::param::FilePathParam>()->Value().IsEmpty() && this->file_path_slot.IsDirty())
+                if (header.dimension != 2)
                 {
-                    // Open file
-                    std::ifstream vectors_ifs(this->file_path_slot.Param<core::param::FilePathParam>()->Value(), std::ios_base::in | std::ios_base::binary);
-
-                    if (vectors_ifs.good())
-                    {
-                        // Get dimension from file
-                        unsigned int dimension, components;
-
-                        vectors_ifs.read(reinterpret_cast<char*>(&dimension), sizeof(unsigned int));
-                        vectors_ifs.read(reinterpret_cast<char*>(&components), sizeof(unsigned int));
-
-                        if (dimension != 2)
-                        {
-                            vislib::sys::Log::DefaultLog.WriteError("Vector field file must have exactly two dimensions '%s'",
-                                this->file_path_slot.Param<core::param::FilePathParam>()->Value());
+                    vislib::sys::Log::DefaultLog.WriteError("Vector field file must have exactly two dimensions '%s'", filename.c_str());
+                    return false;
+                }
 
-                            return false;
-                        }
+                if (header.components != 2)
+                {
+                    vislib::sys::Log::DefaultLog.WriteError("Vectors must have exactly two components '%s'", filename.c_str());
+                    return false;
+                }
 
-                        if (components != 2)
-                        {
-                            vislib::sys::Log::DefaultLog.WriteError("Vectors must have exactly two components '%s'",
-                                this->file_path_slot.Param<core::param::FilePathParam>()->Value());
+                const std::size_t num = static_cast<std::size_t>(header.x_num) * header.y_num;
 
-                            return false;
-                        }
+                if (file_size < sizeof(header_t) + num * 2 * sizeof(float))
+                {
+                    vislib::sys::Log::DefaultLog.WriteError("Vector field file is smaller than indicated by its header '%s'", filename.c_str());
+                    return false;
+                }
 
-                        // Read extents from file
-                        float x_min, x_max, y_min, y_max;
-                        unsigned int x_num, y_num;
+                // Copy vectors, which are stored in the same layout as used in memory, in one pass. This is the
+                // only copy: the call hands out owning arrays, which must stay valid after the file is unmapped.
+                // The data is aligned, as the mapping is page aligned and the header consists of 4-byte values.
+                const float* file_vectors = reinterpret_cast<const float*>(file.Data() + sizeof(header_t));
 
-                        vectors_ifs.read(reinterpret_cast<char*>(&x_num), sizeof(unsigned int));
-                        vectors_ifs.read(reinterpret_cast<char*>(&x_min), sizeof(float));
-                        vectors_ifs.read(reinterpret_cast<char*>(&x_max), sizeof(float));
-                        vectors_ifs.read(reinterpret_cast<char*>(&y_num), sizeof(unsigned int));
-                        vectors_ifs.read(reinterpret_cast<char*>(&y_min), sizeof(float));
-                        vectors_ifs.read(reinterpret_cast<char*>(&y_max), sizeof(float));
+                auto vectors = std::make_shared<std::vector<float>>(file_vectors, file_vectors + num * 2);
 
-                        vf_call->set_resolution(this->stored_data.resolution = { static_cast<unsigned int>(x_num), static_cast<unsigned int>(y_num) });
-                        vf_call->set_bounding_rectangle(this->stored_data.bounding_rectangle = vislib::math::Rectangle<float>(x_min, y_min, x_max, y_max));
+                // Calculate positions
+                const float x_step = (header.x_max - header.x_min) / (header.x_num - 1);
+                const float y_step = (header.y_max - header.y_min) / (header.y_num - 1);
 
-                        vectors_ifs.close();
+                auto positions = std::make_shared<std::vector<float>>(num * 2);
 
-                        return true;
-                    }
-                    else
+                #pragma omp parallel for
+                for (long long y = 0; y < static_cast<long long>(header.y_num); ++y)
+                {
+                    for (unsigned int x = 0; x < header.x_num; ++x)
                     {
-                        vislib::sys::Log::DefaultLog.WriteWarn("Unable to open input vector field file '%s'!",
-                            this->file_path_slot.Param<core::param::FilePathParam>()->Value());
+                        const std::size_t xy = y * header.x_num + x;
 
-                        return false;
+                        (*positions)[xy * 2 + 0] = header.x_min + x * x_step;
+                        (*positions)[xy * 2 + 1] = header.y_min + y * y_step;
                     }
                 }
-                else
-                {
-                    vf_call->set_resolution(this->stored_data.resolution);
-                    vf_call->set_bounding_rectangle(this->stored_data.bounding_rectangle);
 
-                    return true;
-                }
+                // Store data, and update hash
+                this->stored_data.resolution = { header.x_num, header.y_num };
+                this->stored_data.bounding_rectangle = vislib::math::Rectangle<float>(header.x_min, header.y_min, header.x_max, header.y_max);
+
+                this->stored_data.positions = positions;
+                this->stored_data.vectors = vectors;
+
+                ++this->stored_data.hash;
             }
-            else
+            catch (const std::exception& e)
             {
+                vislib::sys::Log::DefaultLog.WriteWarn("Unable to open input vector field file '%s': %s", filename.c_str(), e.what());
+
                 return false;
             }
 
@@ -84,6 +84,13 @@ namespace megamol
             bool get_data(core::Call& call);
             bool get_extent(core::Call& call);
 
+            /**
+             * Load the vector field if the file path changed, otherwise use the cached data.
+             *
+             * @return 'true' on success, 'false' otherwise.
+             */
+            bool load();
+
             /** Output slot */
             core::CalleeSlot output_slot;
 
@@ -0,0 +1,85 @@
+/*
+ * SpatialIndexDataCall.h
+ *
+ * Copyright (C) 2019 by MegaMol Team
+ * Alle Rechte vorbehalten.
+ */
+
+#ifndef MEGAMOL_DATATOOLS_SPATIALINDEXDATACALL_H_INCLUDED
+#define MEGAMOL_DATATOOLS_SPATIALINDEXDATACALL_H_INCLUDED
+#pragma once
+
+#include "mmstd_datatools/mmstd_datatools.h"
+#include "mmcore/AbstractGetDataCall.h"
+#include "mmcore/factories/CallAutoDescription.h"
+#include <cstddef>
+#include <memory>
+
+namespace megamol {
+namespace stdplugin {
+namespace datatools {
+
+    class PeriodicKDTree;
+
+    /**
+     * Call to share a spatial index over the particles of one frame of a MultiParticleDataCall,
+     * so that downstream modules can query it instead of building their own.
+     * The index addresses all particles with float positions across all lists.
+     */
+    class MMSTD_DATATOOLS_API SpatialIndexDataCall : public core::AbstractGetDataCall {
+    public:
+
+        enum CallFunctionName : int {
+            GET_DATA = 0,
+            GET_EXTENT = 1 /* temporal */
+        };
+
+        static const char *ClassName(void) { return "SpatialIndexDataCall"; }
+        static const char *Description(void) { return "Call to get a spatial index over particle data"; }
+        static unsigned int FunctionCount(void) { return 2; }
+        static const char * FunctionName(unsigned int idx) {
+            switch (idx) {
+            case GET_DATA: return "GetData";
+            case GET_EXTENT: return "GetExtent";
+            }
+            return nullptr;
+        }
+
+        SpatialIndexDataCall(void);
+        virtual ~SpatialIndexDataCall(void);
+
+        /** The index, or nullptr if none is available */
+        inline std::shared_ptr<const PeriodicKDTree> const& GetIndex(void) const { return index; }
+        /** Data hash of the particle data the index was built from */
+        inline size_t GetSourceDataHash(void) const { return sourceDataHash; }
+        inline unsigned int FrameID(void) const { return frameID; }
+        inline unsigned int FrameCount(void) const { return frameCnt; }
+
+        /** Sets the index, which is shared and not copied */
+        inline void SetIndex(std::shared_ptr<const PeriodicKDTree> const& index, size_t sourceDataHash) {
+            this->index = index;
+            this->sourceDataHash = sourceDataHash;
+        }
+        inline void SetFrameID(unsigned int fid) {
+            frameID = fid;
+        }
+        inline void SetFrameCount(unsigned int cnt) {
+            frameCnt = cnt;
+        }
+
+    private:
+
+        std::shared_ptr<const PeriodicKDTree> index;
+        size_t sourceDataHash;
+        unsigned int frameCnt;
+        unsigned int frameID;
+
+    };
+
+    typedef core::factories::CallAutoDescription<SpatialIndexDataCall> SpatialIndexDataCallDescription;
+
+} /* end namespace datatools */
+} /* end namespace stdplugin */
+} /* end namespace megamol */
+
+#endif /* MEGAMOL_DATATOOLS_SPATIALINDEXDATACALL_H_INCLUDED */
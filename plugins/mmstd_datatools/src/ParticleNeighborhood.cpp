@@ -6,6 +6,8 @@
  */
 #include "stdafx.h"
 #include "ParticleNeighborhood.h"
+#include "ParticleSpatialIndex.h"
+#include "mmstd_datatools/SpatialIndexDataCall.h"
 #include "mmcore/param/BoolParam.h"
 #include "mmcore/param/FloatParam.h"
 #include "mmcore/param/IntParam.h"
@@ -15,6 +17,7 @@
 #include <algorithm>
 #include <cfloat>
 #include <cassert>
+#include <cmath>
 
 using namespace megamol;
 using namespace megamol::stdplugin;
@@ -32,8 +35,9 @@ datatools::ParticleNeighborhood::ParticleNeighborhood(void)
         particleNumberSlot("idx", "the particle to track"),
         outDataSlot("outData", "Provides colors based on local particle temperature"),
         inDataSlot("inData", "Takes the directional particle data"),
+        inIndexSlot("inIndex", "Optionally takes a shared spatial index of the particle data"),
         datahash(0), lastTime(-1), newColors(), maxDist(0),
-        allParts(), particleTree(nullptr), myPts(nullptr) {
+        allParts(), particleTree(), localTree(), myPts(nullptr) {
 
     this->cyclXSlot.SetParameter(new core::param::BoolParam(true));
     this->MakeSlotAvailable(&this->cyclXSlot);
@@ -65,6 +69,9 @@ datatools::ParticleNeighborhood::ParticleNeighborhood(void)
 
     this->inDataSlot.SetCompatibleCall<megamol::core::moldyn::MultiParticleDataCallDescription>();
     this->MakeSlotAvailable(&this->inDataSlot);
+
+    this->inIndexSlot.SetCompatibleCall<SpatialIndexDataCallDescription>();
+    this->MakeSlotAvailable(&this->inIndexSlot);
 }
 
 
@@ -130,6 +137,9 @@ bool datatools::ParticleNeighborhood::assertData(megamol::core::AbstractGetData3
     int theNumber = this->numNeighborSlot.Param<core::param::IntParam>()->Value();
     auto theSearchType = this->searchTypeSlot.Param<core::param::EnumParam>()->Value();
     int thePart = this->particleNumberSlot.Param<core::param::IntParam>()->Value();
+    bool cycl_x = this->cyclXSlot.Param<megamol::core::param::BoolParam>()->Value();
+    bool cycl_y = this->cyclYSlot.Param<megamol::core::param::BoolParam>()->Value();
+    bool cycl_z = this->cyclZSlot.Param<megamol::core::param::BoolParam>()->Value();
 
     if (this->lastTime != time || this->datahash != in->DataHash()) {
         in->SetFrameID(time, true);
@@ -175,8 +185,9 @@ bool datatools::ParticleNeighborhood::assertData(megamol::core::AbstractGetData3
         assert(allpartcnt == totalParts);
 
         this->myPts = std::make_shared<simplePointcloud>(inMpdc, allParts);
-        particleTree = std::make_shared<my_kd_tree_t>(3 /* dim */, *myPts, nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
-        particleTree->buildIndex();
+        // the search structure is shared by a provider or built on demand
+        this->particleTree.reset();
+        this->localTree.reset();
         this->datahash = in->DataHash();
         this->lastTime = time;
         this->radiusSlot.ForceSetDirty();
@@ -198,67 +209,50 @@ bool datatools::ParticleNeighborhood::assertData(megamol::core::AbstractGetData3
                 }
             }
 
-            const float *vbase = myPts->get_position(thePart);
-            float theVertex[3];
             maxDist = 0.0f;
-            std::vector<std::pair<size_t, float> > ret_matches;
-            std::vector<std::pair<size_t, float> > ret_localMatches;
-            std::vector<size_t> ret_index(theNumber);
-            std::vector<float> out_dist_sqr(theNumber);
-            nanoflann::KNNResultSet<float> resultSet(theNumber);
-            nanoflann::SearchParams params;
-            params.sorted = false;
+            PeriodicKDTree::matches_t ret_matches;
 
             // final computation
-            bool cycl_x = this->cyclXSlot.Param<megamol::core::param::BoolParam>()->Value();
-            bool cycl_y = this->cyclYSlot.Param<megamol::core::param::BoolParam>()->Value();
-            bool cycl_z = this->cyclZSlot.Param<megamol::core::param::BoolParam>()->Value();
             auto bbox = in->AccessBoundingBoxes().ObjectSpaceBBox();
             //bbox.EnforcePositiveSize(); // paranoia
-            auto bbox_cntr = bbox.CalcCenter();
-
-            ret_matches.clear();
-            ret_matches.reserve(100);
-
-            for (int x_s = 0; x_s < (cycl_x ? 2 : 1); ++x_s) {
-                for (int y_s = 0; y_s < (cycl_y ? 2 : 1); ++y_s) {
-                    for (int z_s = 0; z_s < (cycl_z ? 2 : 1); ++z_s) {
-
-                        theVertex[0] = vbase[0];
-                        theVertex[1] = vbase[1];
-                        theVertex[2] = vbase[2];
-                        if (x_s > 0) theVertex[0] = theVertex[0] + ((theVertex[0] > bbox_cntr.X()) ? -bbox.Width() : bbox.Width());
-                        if (y_s > 0) theVertex[1] = theVertex[1] + ((theVertex[1] > bbox_cntr.Y()) ? -bbox.Height() : bbox.Height());
-                        if (z_s > 0) theVertex[2] = theVertex[2] + ((theVertex[2] > bbox_cntr.Z()) ? -bbox.Depth() : bbox.Depth());
-
-                        if (theSearchType == searchTypeEnum::RADIUS) {
-                            particleTree->radiusSearch(theVertex, theRadius, ret_localMatches, params);
-                            ret_matches.insert(ret_matches.end(), ret_localMatches.begin(), ret_localMatches.end());
-                        } else {
-                            resultSet.init(ret_index.data(), out_dist_sqr.data());
-                            particleTree->findNeighbors(resultSet, theVertex, params);
-                            for (size_t i = 0; i < resultSet.size(); ++i) {
-                                ret_matches.push_back(std::pair<size_t, float>(ret_index[i], out_dist_sqr[i]));
-                            }
-                        }
+
+            this->particleTree = ParticleSpatialIndex::FetchIndex(
+                this->inIndexSlot, time, in->DataHash(), newColors.size(), bbox, {cycl_x, cycl_y, cycl_z},
+                theSearchType == searchTypeEnum::RADIUS ? std::sqrt(theRadius) : 0.0f);
+
+            if (this->particleTree == nullptr) {
+                if (this->localTree == nullptr) {
+                    std::vector<float> positions(3 * newColors.size());
+                    for (size_t part_i = 0; part_i < newColors.size(); ++part_i) {
+                        const float *pos = myPts->get_position(part_i);
+                        std::copy(pos, pos + 3, positions.begin() + 3 * part_i);
                     }
+                    // only one particle is queried, so the ghost layers are not widened for later radius changes
+                    this->localTree = std::make_shared<PeriodicKDTree>();
+                    this->localTree->build(std::move(positions), bbox, {cycl_x, cycl_y, cycl_z},
+                        theSearchType == searchTypeEnum::RADIUS ? std::sqrt(theRadius) : 0.0f);
+                } else {
+                    this->localTree->ensurePeriodicity(bbox, {cycl_x, cycl_y, cycl_z}, 0.0f);
                 }
+                this->particleTree = this->localTree;
             }
 
-            size_t num_matches = 0;
+            const float *vbase = particleTree->getPosition(thePart);
 
-            // TODO this probably is not even worth it, writing something several times is probably cheaper.
-            //sort(ret_matches.begin(), ret_matches.end());
-            //ret_matches.erase(unique(ret_matches.begin(), ret_matches.end()), ret_matches.end());
+            if (theSearchType == searchTypeEnum::RADIUS) {
+                particleTree->radiusSearch(vbase, theRadius, ret_matches);
+            } else {
+                particleTree->knnSearch(vbase, theNumber, ret_matches);
+            }
+
+            size_t num_matches = 0;
 
             // reset all colors
             if (theSearchType == searchTypeEnum::RADIUS) {
                 maxDist = theRadius;
                 num_matches = ret_matches.size();
             } else {
-                // find overall closest! we did search around periodic boundary conditions, so there will be huge distances!
-                sort(ret_matches.begin(), ret_matches.end(),
-                    [](const decltype(ret_matches)::value_type &left, const decltype(ret_matches)::value_type &right) {return left.second < right.second; });
+                // the matches are sorted by distance, and
                 // the furthest is theNumber closest or the last one if fewer.
                 num_matches = ret_matches.size() >= theNumber ? theNumber : ret_matches.size();
                 maxDist = ret_matches[num_matches - 1].second;
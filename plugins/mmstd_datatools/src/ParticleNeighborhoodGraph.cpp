@@ -13,7 +13,11 @@
 #include "mmcore/param/IntParam.h"
 #include <chrono>
 #include <omp.h>
-#include <set>
+#include <algorithm>
+#include <memory>
+#include "ParticleSpatialIndex.h"
+#include "PeriodicKDTree.h"
+#include "mmstd_datatools/SpatialIndexDataCall.h"
 
 using namespace megamol;
 using namespace megamol::stdplugin::datatools;
@@ -21,6 +25,7 @@ using namespace megamol::stdplugin::datatools;
 ParticleNeighborhoodGraph::ParticleNeighborhoodGraph() : Module(),
         outGraphDataSlot("outGraphData", "Publishes graph edge data"),
         inParticleDataSlot("inParticle", "Fetches particle data"),
+        inIndexSlot("inIndex", "Optionally fetches a shared spatial index of the particle data"),
         radiusSlot("radius", "The neighborhood radius"),
         autoRadiusSlot("autoRadius::detect", "Flag to automatically assess the neighborhood radius"),
         autoRadiusSamplesSlot("autoRadius::samples", "Number of samples to determine the neighborhood radius"),
@@ -41,6 +46,9 @@ ParticleNeighborhoodGraph::ParticleNeighborhoodGraph() : Module(),
     inParticleDataSlot.SetCompatibleCall<core::moldyn::MultiParticleDataCallDescription>();
     MakeSlotAvailable(&inParticleDataSlot);
 
+    inIndexSlot.SetCompatibleCall<SpatialIndexDataCallDescription>();
+    MakeSlotAvailable(&inIndexSlot);
+
     autoRadiusSlot.SetParameter(new core::param::BoolParam(true));
     MakeSlotAvailable(&autoRadiusSlot);
 
@@ -224,187 +232,65 @@ void ParticleNeighborhoodGraph::calcData(core::moldyn::MultiParticleDataCall* da
     }
     float neiRadSq = neiRad * neiRad;
 
-    vislib::math::Cuboid<float> box(
-        vislib::math::ShallowPoint<float, 3>(const_cast<float*>(d.get_position(0))),
-        vislib::math::Dimension<float, 3>(0.0f, 0.0f, 0.0f));
-    for (size_t i = 1; i < d.get_count(); ++i) {
-        box.GrowToPoint(
-            vislib::math::ShallowPoint<float, 3>(const_cast<float*>(d.get_position(i)))
-            );
-    }
-
-    unsigned int x_size = static_cast<unsigned int>(std::ceil(box.Width() / neiRad));
-    unsigned int y_size = static_cast<unsigned int>(std::ceil(box.Height() / neiRad));
-    unsigned int z_size = static_cast<unsigned int>(std::ceil(box.Depth() / neiRad));
-
-    auto const& bboxR = data->AccessBoundingBoxes().ObjectSpaceBBox();
-    auto const bboxCent = bboxR.CalcCenter();
-    float bboxCentX = bboxCent.X();
-    float bboxCentY = bboxCent.Y();
-    float bboxCentZ = bboxCent.Z();
-
-#define _COORD(x, y, z) ((x) + ((y) + ((z) * y_size)) * x_size)
-
-    std::vector<size_t> grid(d.get_count());
-    std::vector<size_t*> gridCell(x_size * y_size * z_size);
-
-    vislib::sys::Log::DefaultLog.WriteInfo("PNhG search grid : (%u, %u, %u)", x_size, y_size, z_size);
-
-    std::vector<vislib::math::Vector<unsigned int, 3> > cell(d.get_count());
-    for (size_t i = 0; i < d.get_count(); ++i) {
-        vislib::math::Vector<float, 3> c = vislib::math::ShallowPoint<float, 3>(const_cast<float*>(d.get_position(i))) - box.GetLeftBottomBack();
-        cell[i] = c / neiRad;
-        if (cell[i].X() >= x_size) cell[i].SetX(x_size - 1);
-        if (cell[i].Y() >= y_size) cell[i].SetY(y_size - 1);
-        if (cell[i].Z() >= z_size) cell[i].SetZ(z_size - 1);
-        //assert(cell[i].X() < x_size);
-        //assert(cell[i].Y() < y_size);
-        //assert(cell[i].Z() < z_size);
-    }
-
-    std::vector<size_t> gridCellSize(x_size * y_size * z_size);
-    std::fill(gridCellSize.begin(), gridCellSize.end(), 0);
-    for (size_t i = 0; i < d.get_count(); ++i) {
-        gridCellSize[_COORD(cell[i].X(), cell[i].Y(), cell[i].Z())]++;
-    }
-
-    size_t * p = grid.data();
-    for (unsigned int gci = 0; gci < x_size * y_size * z_size; ++gci) {
-        if (gridCellSize[gci] == 0) {
-            gridCell[gci] = nullptr;
-        } else {
-            gridCell[gci] = p;
-            p += gridCellSize[gci];
-            gridCellSize[gci] = 0;
-        }
-    }
-    assert((p - grid.data()) == d.get_count());
-
-    for (size_t i = 0; i < d.get_count(); ++i) {
-        size_t idx = _COORD(cell[i].X(), cell[i].Y(), cell[i].Z());
-        *((gridCell[idx]) + gridCellSize[idx]) = i;
-        gridCellSize[idx]++;
-    }
-
-    end = high_resolution_clock::now();
-    vislib::sys::Log::DefaultLog.WriteInfo("PNhG search grid constructed in %u ms", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
-    start = end;
-
-    edges.reserve(d.get_count() * 2 * 4); // something
-
     bool cycX = boundaryXCyclicSlot.Param<core::param::BoolParam>()->Value();
     bool cycY = boundaryYCyclicSlot.Param<core::param::BoolParam>()->Value();
     bool cycZ = boundaryZCyclicSlot.Param<core::param::BoolParam>()->Value();
 
-    // iterate over cells
-    int cellCnt = static_cast<int>(x_size * y_size * z_size);
-    int maxThreads = omp_get_max_threads();
-    std::vector<std::set<int> > neighborCellsMT(maxThreads); // all neighboring cells, from which particles need to be tested.
-    std::vector<std::vector<vislib::math::Point<float, 3> > > testPossMT(maxThreads); // all positions of this one particle to be tested.
-
-    float bboxSizeX = data->AccessBoundingBoxes().ObjectSpaceBBox().Width();
-    float bboxSizeY = data->AccessBoundingBoxes().ObjectSpaceBBox().Height();
-    float bboxSizeZ = data->AccessBoundingBoxes().ObjectSpaceBBox().Depth();
-
-    #pragma omp parallel for
-    for (int cellIdx = 0; cellIdx < cellCnt; ++cellIdx) {
-        int mt = omp_get_thread_num();
-        std::set<int>& neighborCells = neighborCellsMT[mt];
-        std::vector<vislib::math::Point<float, 3> >& testPoss = testPossMT[mt];
-        neighborCells.clear();
-
-        // cell coordinate from cell index
-        int cellX = cellIdx % x_size;
-        int cellZ = (cellIdx - cellX) / x_size;
-        int cellY = cellZ % y_size;
-        cellZ = (cellZ - cellY) / y_size;
-
-        // collect neighboring cells
-        for (int dx = -1; dx <= 1; ++dx) {
-            int x = cellX + dx;
-            if (x < 0) {
-                if (cycX) x = x_size - 1; else continue; // skip this x
-            }
-            if (x >= static_cast<int>(x_size)) {
-                if (cycX) x = 0; else continue; // skip this x
-            }
-            for (int dy = -1; dy <= 1; ++dy) {
-                int y = cellY + dy;
-                if (y < 0) {
-                    if (cycY) y = y_size - 1; else continue; // skip this y
-                }
-                if (y >= static_cast<int>(y_size)) {
-                    if (cycY) y = 0; else continue; // skip this y
-                }
-                for (int dz = -1; dz <= 1; ++dz) {
-                    int z = cellZ + dz;
-                    if (z < 0) {
-                        if (cycZ) z = z_size - 1; else continue; // skip this z
-                    }
-                    if (z >= static_cast<int>(z_size)) {
-                        if (cycZ) z = 0; else continue; // skip this z
-                    }
-                    neighborCells.insert(_COORD(x, y, z));
-                }
-            }
-        }
-
-        // for all points in the current cell
-        for (size_t locPtIdx = 0; locPtIdx < gridCellSize[cellIdx]; ++locPtIdx) {
-            // point position
-            size_t ptIdx = gridCell[cellIdx][locPtIdx];
-            vislib::math::ShallowPoint<float, 3> ptOrigPos(const_cast<float*>(d.get_position(ptIdx)));
-            testPoss.clear();
-
-            // multiply connections due to cyclic boundary tests
-            float x = ptOrigPos.X(), y, z;
-            for (int dx = 0; dx < (cycX ? 2 : 1); ++dx) {
-                y = ptOrigPos.Y();
-                for (int dy = 0; dy < (cycY ? 2 : 1); ++dy) {
-                    z = ptOrigPos.Z();
-                    for (int dz = 0; dz < (cycZ ? 2 : 1); ++dz) {
-                        testPoss.push_back(vislib::math::Point<float, 3>(x, y, z));
-                        if (dz == 0) {
-                            if (z < bboxCentZ) z += bboxSizeZ; else z -= bboxSizeZ;
-                        }
-                    }
-                    if (dy == 0) {
-                        if (y < bboxCentY) y += bboxSizeY; else y -= bboxSizeY;
-                    }
-                }
-                if (dx == 0) {
-                    if (x < bboxCentX) x += bboxSizeX; else x -= bboxSizeX;
-                }
-            }
-
-            for (int neiCellIdx : neighborCells) {
-                for (size_t locNPtIdx = 0; locNPtIdx < gridCellSize[neiCellIdx]; ++locNPtIdx) {
-                    // point to test
-                    size_t nPtIdx = gridCell[neiCellIdx][locNPtIdx];
+    // search structure with ghost layers, answering each cyclic neighborhood with a single query
+    std::shared_ptr<const PeriodicKDTree> tree = ParticleSpatialIndex::FetchIndex(
+        inIndexSlot, frameId, inDataHash, d.get_count(), data->AccessBoundingBoxes().ObjectSpaceBBox(),
+        {cycX, cycY, cycZ}, neiRad);
 
-                     if (ptIdx >= nPtIdx) continue; // we only every construct edges from small to large indices
+    if (tree == nullptr) {
+        std::vector<float> positions(3 * d.get_count());
+        for (size_t i = 0; i < d.get_count(); ++i) {
+            const float *pos = d.get_position(i);
+            std::copy(pos, pos + 3, positions.begin() + 3 * i);
+        }
 
-                    vislib::math::ShallowPoint<float, 3> nPtPos(const_cast<float*>(d.get_position(nPtIdx)));
-                    for (vislib::math::Point<float, 3>& pt : testPoss) {
-                        float sqDist = pt.SquareDistance(nPtPos);
-                        if (sqDist < neiRadSq) {
+        auto localTree = std::make_shared<PeriodicKDTree>();
+        localTree->build(std::move(positions), data->AccessBoundingBoxes().ObjectSpaceBBox(), {cycX, cycY, cycZ}, neiRad);
+        tree = localTree;
 
-                            #pragma omp critical
-                            {
-                                edges.push_back(static_cast<index_t>(ptIdx));
-                                edges.push_back(static_cast<index_t>(nPtIdx));
-                            }
+        end = high_resolution_clock::now();
+        vislib::sys::Log::DefaultLog.WriteInfo("PNhG search tree constructed in %u ms", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+        start = end;
+    }
 
-                            break;
-                        }
-                    }
+    // collect edges per thread, in order of the particles
+    int maxThreads = omp_get_max_threads();
+    std::vector<std::vector<index_t> > edgesMT(maxThreads);
+    int64_t ptCnt = static_cast<int64_t>(d.get_count());
+
+    #pragma omp parallel num_threads(maxThreads)
+    {
+        std::vector<index_t>& threadEdges = edgesMT[omp_get_thread_num()];
+        PeriodicKDTree::matches_t matches;
+        std::vector<size_t> neighbors;
+
+        #pragma omp for schedule(static)
+        for (int64_t ptIdx = 0; ptIdx < ptCnt; ++ptIdx) {
+            tree->radiusSearch(tree->getPosition(static_cast<size_t>(ptIdx)), neiRadSq, matches);
+
+            neighbors.clear();
+            for (auto const& match : matches) {
+                // we only every construct edges from small to large indices
+                if (match.first > static_cast<size_t>(ptIdx)) neighbors.push_back(match.first);
+            }
+            std::sort(neighbors.begin(), neighbors.end());
 
-                }
+            for (size_t nPtIdx : neighbors) {
+                threadEdges.push_back(static_cast<index_t>(ptIdx));
+                threadEdges.push_back(static_cast<index_t>(nPtIdx));
             }
         }
-
     }
 
+    size_t edgeCnt = 0;
+    for (auto const& threadEdges : edgesMT) edgeCnt += threadEdges.size();
+    edges.reserve(edgeCnt);
+    for (auto const& threadEdges : edgesMT) edges.insert(edges.end(), threadEdges.begin(), threadEdges.end());
+
     end = high_resolution_clock::now();
     vislib::sys::Log::DefaultLog.WriteInfo("PNhG edges computed in %u ms", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
     start = end;
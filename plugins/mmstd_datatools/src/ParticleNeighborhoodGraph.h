@@ -54,6 +54,7 @@ namespace datatools {
 
         core::CalleeSlot outGraphDataSlot;
         core::CallerSlot inParticleDataSlot;
+        core::CallerSlot inIndexSlot;
         core::param::ParamSlot radiusSlot;
         core::param::ParamSlot autoRadiusSlot;
         core::param::ParamSlot autoRadiusSamplesSlot;
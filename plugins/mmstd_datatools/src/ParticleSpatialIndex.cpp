@@ -0,0 +1,226 @@
+/*
+ * ParticleSpatialIndex.cpp
+ *
+ * Copyright (C) 2019 by MegaMol team
+ * Alle Rechte vorbehalten.
+ */
+
+#include "stdafx.h"
+#include "ParticleSpatialIndex.h"
+#include "mmcore/moldyn/MultiParticleDataCall.h"
+#include "mmcore/param/BoolParam.h"
+#include "mmcore/param/FloatParam.h"
+#include "mmstd_datatools/SpatialIndexDataCall.h"
+#include "vislib/sys/Log.h"
+#include <algorithm>
+#include <vector>
+
+using namespace megamol;
+using namespace megamol::stdplugin;
+
+
+/*
+ * datatools::ParticleSpatialIndex::FetchIndex
+ */
+std::shared_ptr<const datatools::PeriodicKDTree> datatools::ParticleSpatialIndex::FetchIndex(
+    megamol::core::CallerSlot& slot, unsigned int frameID, size_t dataHash, size_t count,
+    vislib::math::Cuboid<float> const& bbox, std::array<bool, 3> const& cyclic, float queryRadius) {
+
+    SpatialIndexDataCall *sidc = slot.CallAs<SpatialIndexDataCall>();
+    if (sidc == nullptr) return nullptr;
+
+    sidc->SetFrameID(frameID);
+    if (!(*sidc)(SpatialIndexDataCall::GET_DATA)) return nullptr;
+
+    auto const& index = sidc->GetIndex();
+    if (index == nullptr || sidc->FrameID() != frameID || sidc->GetSourceDataHash() != dataHash) {
+        vislib::sys::Log::DefaultLog.WriteWarn("ParticleSpatialIndex: connected index was built for other data, ignoring it");
+        return nullptr;
+    }
+    if (index->getCount() != count || index->getCyclic() != cyclic || !(index->getBBox() == bbox)) {
+        vislib::sys::Log::DefaultLog.WriteWarn("ParticleSpatialIndex: connected index does not match particle "
+            "selection, bounding box, or cyclic boundary conditions, ignoring it");
+        return nullptr;
+    }
+    if ((cyclic[0] || cyclic[1] || cyclic[2]) && queryRadius > index->getGhostWidth()) {
+        vislib::sys::Log::DefaultLog.WriteWarn("ParticleSpatialIndex: query radius %f exceeds the ghost width %f "
+            "of the connected index, queries will be slower; consider increasing its ghostWidth",
+            queryRadius, index->getGhostWidth());
+    }
+
+    return index;
+}
+
+
+/*
+ * datatools::ParticleSpatialIndex::ParticleSpatialIndex
+ */
+datatools::ParticleSpatialIndex::ParticleSpatialIndex(void)
+        : cyclXSlot("cyclX", "Considers cyclic boundary conditions in X direction"),
+        cyclYSlot("cyclY", "Considers cyclic boundary conditions in Y direction"),
+        cyclZSlot("cyclZ", "Considers cyclic boundary conditions in Z direction"),
+        ghostWidthSlot("ghostWidth", "Width of the particle layers replicated at cyclic boundaries; "
+            "queries within this radius need a single tree traversal"),
+        outIndexSlot("outIndex", "Provides the spatial index"),
+        inDataSlot("inData", "Takes the particle data"),
+        index(), inDataHash(0), outDataHash(0), frameID(0) {
+
+    this->cyclXSlot.SetParameter(new core::param::BoolParam(true));
+    this->MakeSlotAvailable(&this->cyclXSlot);
+
+    this->cyclYSlot.SetParameter(new core::param::BoolParam(true));
+    this->MakeSlotAvailable(&this->cyclYSlot);
+
+    this->cyclZSlot.SetParameter(new core::param::BoolParam(true));
+    this->MakeSlotAvailable(&this->cyclZSlot);
+
+    this->ghostWidthSlot.SetParameter(new core::param::FloatParam(2.0f, 0.0f));
+    this->MakeSlotAvailable(&this->ghostWidthSlot);
+
+    this->outIndexSlot.SetCallback(SpatialIndexDataCall::ClassName(),
+        SpatialIndexDataCall::FunctionName(SpatialIndexDataCall::GET_DATA), &ParticleSpatialIndex::getDataCallback);
+    this->outIndexSlot.SetCallback(SpatialIndexDataCall::ClassName(),
+        SpatialIndexDataCall::FunctionName(SpatialIndexDataCall::GET_EXTENT), &ParticleSpatialIndex::getExtentCallback);
+    this->MakeSlotAvailable(&this->outIndexSlot);
+
+    this->inDataSlot.SetCompatibleCall<megamol::core::moldyn::MultiParticleDataCallDescription>();
+    this->MakeSlotAvailable(&this->inDataSlot);
+}
+
+
+/*
+ * datatools::ParticleSpatialIndex::~ParticleSpatialIndex
+ */
+datatools::ParticleSpatialIndex::~ParticleSpatialIndex(void) {
+    this->Release();
+}
+
+
+/*
+ * datatools::ParticleSpatialIndex::create
+ */
+bool datatools::ParticleSpatialIndex::create(void) {
+    return true;
+}
+
+
+/*
+ * datatools::ParticleSpatialIndex::release
+ */
+void datatools::ParticleSpatialIndex::release(void) {
+    this->index.reset();
+}
+
+
+/*
+ * datatools::ParticleSpatialIndex::getDataCallback
+ */
+bool datatools::ParticleSpatialIndex::getDataCallback(megamol::core::Call& c) {
+    using megamol::core::moldyn::MultiParticleDataCall;
+    using megamol::core::moldyn::SimpleSphericalParticles;
+
+    SpatialIndexDataCall *outSidc = dynamic_cast<SpatialIndexDataCall*>(&c);
+    if (outSidc == nullptr) return false;
+
+    MultiParticleDataCall *inMpdc = this->inDataSlot.CallAs<MultiParticleDataCall>();
+    if (inMpdc == nullptr) return false;
+
+    unsigned int time = outSidc->FrameID();
+
+    inMpdc->SetFrameID(time, true);
+    if (!(*inMpdc)(1) || !(*inMpdc)(0)) {
+        vislib::sys::Log::DefaultLog.WriteError("ParticleSpatialIndex: could not get frame (%u)", time);
+        return false;
+    }
+
+    if (this->index == nullptr || this->frameID != inMpdc->FrameID() || this->inDataHash != inMpdc->DataHash()
+            || this->cyclXSlot.IsDirty() || this->cyclYSlot.IsDirty() || this->cyclZSlot.IsDirty()
+            || this->ghostWidthSlot.IsDirty()) {
+
+        // same particle addressing as simplePointcloud: all lists with float positions
+        unsigned int plc = inMpdc->GetParticleListCount();
+        size_t totalParts = 0;
+        for (unsigned int pli = 0; pli < plc; pli++) {
+            auto& pl = inMpdc->AccessParticles(pli);
+            if ((pl.GetVertexDataType() == SimpleSphericalParticles::VERTDATA_FLOAT_XYZ)
+                || (pl.GetVertexDataType() == SimpleSphericalParticles::VERTDATA_FLOAT_XYZR)) {
+                totalParts += static_cast<size_t>(pl.GetCount());
+            }
+        }
+
+        std::vector<float> positions;
+        positions.reserve(3 * totalParts);
+        for (unsigned int pli = 0; pli < plc; pli++) {
+            auto& pl = inMpdc->AccessParticles(pli);
+            unsigned int vert_stride = 0;
+            if (pl.GetVertexDataType() == SimpleSphericalParticles::VERTDATA_FLOAT_XYZ) vert_stride = 12;
+            else if (pl.GetVertexDataType() == SimpleSphericalParticles::VERTDATA_FLOAT_XYZR) vert_stride = 16;
+            else continue;
+            vert_stride = std::max<unsigned int>(vert_stride, pl.GetVertexDataStride());
+            const unsigned char *vert = static_cast<const unsigned char*>(pl.GetVertexData());
+
+            for (UINT64 part_i = 0; part_i < pl.GetCount(); ++part_i) {
+                const float *pos = reinterpret_cast<const float*>(vert + part_i * vert_stride);
+                positions.insert(positions.end(), pos, pos + 3);
+            }
+        }
+
+        std::array<bool, 3> const cyclic = {
+            this->cyclXSlot.Param<core::param::BoolParam>()->Value(),
+            this->cyclYSlot.Param<core::param::BoolParam>()->Value(),
+            this->cyclZSlot.Param<core::param::BoolParam>()->Value()};
+
+        vislib::sys::Log::DefaultLog.WriteInfo("ParticleSpatialIndex: building index over %u particles...",
+            static_cast<unsigned int>(totalParts));
+
+        // never modify an index which might still be used downstream, but replace it
+        auto newIndex = std::make_shared<PeriodicKDTree>();
+        newIndex->build(std::move(positions), inMpdc->AccessBoundingBoxes().ObjectSpaceBBox(), cyclic,
+            this->ghostWidthSlot.Param<core::param::FloatParam>()->Value());
+        this->index = newIndex;
+
+        this->frameID = inMpdc->FrameID();
+        this->inDataHash = inMpdc->DataHash();
+        ++this->outDataHash;
+
+        this->cyclXSlot.ResetDirty();
+        this->cyclYSlot.ResetDirty();
+        this->cyclZSlot.ResetDirty();
+        this->ghostWidthSlot.ResetDirty();
+    }
+
+    inMpdc->Unlock();
+
+    outSidc->SetFrameID(this->frameID);
+    outSidc->SetFrameCount(inMpdc->FrameCount());
+    outSidc->SetDataHash(this->outDataHash);
+    outSidc->SetIndex(this->index, this->inDataHash);
+
+    return true;
+}
+
+
+/*
+ * datatools::ParticleSpatialIndex::getExtentCallback
+ */
+bool datatools::ParticleSpatialIndex::getExtentCallback(megamol::core::Call& c) {
+    using megamol::core::moldyn::MultiParticleDataCall;
+
+    SpatialIndexDataCall *outSidc = dynamic_cast<SpatialIndexDataCall*>(&c);
+    if (outSidc == nullptr) return false;
+
+    MultiParticleDataCall *inMpdc = this->inDataSlot.CallAs<MultiParticleDataCall>();
+    if (inMpdc == nullptr) return false;
+
+    inMpdc->SetFrameID(outSidc->FrameID(), true);
+    if (!(*inMpdc)(1)) {
+        vislib::sys::Log::DefaultLog.WriteError("ParticleSpatialIndex: could not get frame extents (%u)", outSidc->FrameID());
+        return false;
+    }
+    inMpdc->Unlock();
+
+    outSidc->SetFrameCount(inMpdc->FrameCount());
+    outSidc->SetDataHash(this->outDataHash);
+
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+ * ParticleSpatialIndex.h
+ *
+ * Copyright (C) 2019 by MegaMol team
+ * Alle Rechte vorbehalten.
+ */
+
+#ifndef MMSTD_DATATOOLS_PARTICLESPATIALINDEX_H_INCLUDED
+#define MMSTD_DATATOOLS_PARTICLESPATIALINDEX_H_INCLUDED
+#pragma once
+
+#include "mmcore/param/ParamSlot.h"
+#include "mmcore/CalleeSlot.h"
+#include "mmcore/CallerSlot.h"
+#include "mmcore/Module.h"
+#include "PeriodicKDTree.h"
+#include <array>
+#include <memory>
+
+namespace megamol {
+namespace stdplugin {
+namespace datatools {
+
+    /**
+     * Module building a spatial index over particle data once per frame and data hash,
+     * and sharing it with downstream modules through a SpatialIndexDataCall
+     */
+    class ParticleSpatialIndex : public megamol::core::Module {
+    public:
+
+        /** Return module class name */
+        static const char *ClassName(void) {
+            return "ParticleSpatialIndex";
+        }
+
+        /** Return module class description */
+        static const char *Description(void) {
+            return "Builds a spatial index over particles, which can be shared by multiple modules.";
+        }
+
+        /** Module is always available */
+        static bool IsAvailable(void) {
+            return true;
+        }
+
+        /**
+         * Fetch the index from a provider connected to the given slot, if it was built
+         * for the given particle data, periodic box, and cyclic boundary conditions.
+         *
+         * @param slot      Caller slot for a SpatialIndexDataCall
+         * @param frameID   Frame of the particle data
+         * @param dataHash  Data hash of the particle data
+         * @param count     Number of particles the caller expects to be indexed
+         * @param bbox      Periodic box the caller expects
+         * @param cyclic    Cyclic boundary conditions per axis the caller expects
+         * @param queryRadius Radius the caller will query; a warning is issued if it exceeds the
+         *                  ghost width of the index, as queries then need multiple traversals
+         *
+         * @return The shared index, or nullptr if none is connected or it does not match
+         */
+        static std::shared_ptr<const PeriodicKDTree> FetchIndex(megamol::core::CallerSlot& slot,
+            unsigned int frameID, size_t dataHash, size_t count, vislib::math::Cuboid<float> const& bbox,
+            std::array<bool, 3> const& cyclic, float queryRadius);
+
+        /** Ctor */
+        ParticleSpatialIndex(void);
+
+        /** Dtor */
+        virtual ~ParticleSpatialIndex(void);
+
+    protected:
+
+        /** Lazy initialization of the module */
+        virtual bool create(void);
+
+        /** Resource release */
+        virtual void release(void);
+
+    private:
+
+        bool getDataCallback(megamol::core::Call& c);
+
+        bool getExtentCallback(megamol::core::Call& c);
+
+        core::param::ParamSlot cyclXSlot;
+        core::param::ParamSlot cyclYSlot;
+        core::param::ParamSlot cyclZSlot;
+        core::param::ParamSlot ghostWidthSlot;
+
+        /** The slot providing access to the index */
+        megamol::core::CalleeSlot outIndexSlot;
+
+        /** The slot accessing the original data */
+        megamol::core::CallerSlot inDataSlot;
+
+        /** The shared index, replaced (not modified) on changes */
+        std::shared_ptr<const PeriodicKDTree> index;
+
+        size_t inDataHash;
+        size_t outDataHash;
+        unsigned int frameID;
+
+    };
+
+} /* end namespace datatools */
+} /* end namespace stdplugin */
+} /* end namespace megamol */
+
+#endif /* MMSTD_DATATOOLS_PARTICLESPATIALINDEX_H_INCLUDED */
@@ -11,6 +11,7 @@
 #include <cassert>
 #include <cfloat>
 #include <cfenv>
+#include <cmath>
 #include <cstdint>
 #include <limits>
 #include <omp.h>
@@ -18,6 +19,8 @@
 #include "mmcore/param/EnumParam.h"
 #include "mmcore/param/FloatParam.h"
 #include "mmcore/param/IntParam.h"
+#include "ParticleSpatialIndex.h"
+#include "mmstd_datatools/SpatialIndexDataCall.h"
 #include "vislib/sys/ConsoleProgressBar.h"
 #include "vislib/sys/Log.h"
 
@@ -51,10 +54,12 @@ datatools::ParticleThermodyn::ParticleThermodyn(void)
     , newColors()
     , allParts()
     , maxDist(0.0f)
-    , particleTree(nullptr)
+    , particleTree()
+    , localTree()
     , myPts(nullptr)
     , outDataSlot("outData", "Provides intensities based on a local particle metric")
-    , inDataSlot("inData", "Takes the directional particle data") {
+    , inDataSlot("inData", "Takes the directional particle data")
+    , inIndexSlot("inIndex", "Optionally takes a shared spatial index of the particle data") {
 
     this->cyclXSlot.SetParameter(new core::param::BoolParam(true));
     this->MakeSlotAvailable(&this->cyclXSlot);
@@ -117,6 +122,9 @@ datatools::ParticleThermodyn::ParticleThermodyn(void)
 
     this->inDataSlot.SetCompatibleCall<megamol::core::moldyn::MultiParticleDataCallDescription>();
     this->MakeSlotAvailable(&this->inDataSlot);
+
+    this->inIndexSlot.SetCompatibleCall<SpatialIndexDataCallDescription>();
+    this->MakeSlotAvailable(&this->inIndexSlot);
 }
 
 
@@ -166,6 +174,28 @@ bool datatools::ParticleThermodyn::assertData(core::moldyn::MultiParticleDataCal
     const auto theMetrics = this->metricsSlot.Param<core::param::EnumParam>()->Value();
     size_t allpartcnt = 0;
 
+    bool const cycl_x = this->cyclXSlot.Param<megamol::core::param::BoolParam>()->Value();
+    bool const cycl_y = this->cyclYSlot.Param<megamol::core::param::BoolParam>()->Value();
+    bool const cycl_z = this->cyclZSlot.Param<megamol::core::param::BoolParam>()->Value();
+
+    // slack added to the squared search radius
+    const float eps = std::sqrt(std::numeric_limits<float>::epsilon());
+
+    // the ghost layers of the search structure should cover the neighborhoods of most particles
+    auto getGhostWidth = [&](size_t numParticles) -> float {
+        if (theSearchType == searchTypeEnum::RADIUS) {
+            // must cover the actual query radius, so single queries suffice
+            return std::sqrt(theSquaredRadius + eps);
+        }
+        auto const& box = in->AccessBoundingBoxes().ObjectSpaceBBox();
+        if (numParticles == 0 || box.Volume() <= 0.0f) {
+            return 0.0f;
+        }
+        // radius of a sphere containing the requested number of neighbors at average density, plus some slack
+        return 1.5f * std::cbrt(3.0f * static_cast<float>(theNumber) * box.Volume() /
+                                (4.0f * 3.14159265f * static_cast<float>(numParticles)));
+    };
+
     if (this->lastTime != time || this->datahash != in->DataHash()) {
         in->SetFrameID(time, true);
 
@@ -220,11 +250,9 @@ bool datatools::ParticleThermodyn::assertData(core::moldyn::MultiParticleDataCal
         assert(allpartcnt == totalParts);
         this->myPts = std::make_shared<simplePointcloud>(in, allParts);
 
-        vislib::sys::Log::DefaultLog.WriteInfo("ParticleThermodyn: building acceleration structure...");
-        particleTree = std::make_shared<my_kd_tree_t>(
-            3 /* dim */, *myPts, nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */));
-        particleTree->buildIndex();
-        vislib::sys::Log::DefaultLog.WriteInfo("ParticleThermodyn: done.");
+        // the acceleration structure is shared by a provider or built on demand
+        this->particleTree.reset();
+        this->localTree.reset();
 
         this->datahash = in->DataHash();
         this->lastTime = time;
@@ -239,12 +267,32 @@ bool datatools::ParticleThermodyn::assertData(core::moldyn::MultiParticleDataCal
         ++myHash;
 
         // final computation
-        bool cycl_x = this->cyclXSlot.Param<megamol::core::param::BoolParam>()->Value();
-        bool cycl_y = this->cyclYSlot.Param<megamol::core::param::BoolParam>()->Value();
-        bool cycl_z = this->cyclZSlot.Param<megamol::core::param::BoolParam>()->Value();
         auto bbox = in->AccessBoundingBoxes().ObjectSpaceBBox();
         // bbox.EnforcePositiveSize(); // paranoia
-        auto bbox_cntr = bbox.CalcCenter();
+
+        this->particleTree = ParticleSpatialIndex::FetchIndex(
+            this->inIndexSlot, time, in->DataHash(), this->newColors.size(), bbox, {cycl_x, cycl_y, cycl_z},
+            getGhostWidth(this->newColors.size()));
+
+        if (this->particleTree == nullptr) {
+            if (this->localTree == nullptr) {
+                std::vector<float> positions(3 * this->newColors.size());
+                for (size_t part_i = 0; part_i < this->newColors.size(); ++part_i) {
+                    const float* pos = this->myPts->get_position(part_i);
+                    std::copy(pos, pos + 3, positions.begin() + 3 * part_i);
+                }
+
+                vislib::sys::Log::DefaultLog.WriteInfo("ParticleThermodyn: building acceleration structure...");
+                this->localTree = std::make_shared<PeriodicKDTree>();
+                this->localTree->build(
+                    std::move(positions), bbox, {cycl_x, cycl_y, cycl_z}, getGhostWidth(this->newColors.size()));
+                vislib::sys::Log::DefaultLog.WriteInfo("ParticleThermodyn: done.");
+            } else if (this->localTree->ensurePeriodicity(
+                           bbox, {cycl_x, cycl_y, cycl_z}, getGhostWidth(this->localTree->getCount()))) {
+                vislib::sys::Log::DefaultLog.WriteInfo("ParticleThermodyn: rebuilt acceleration structure.");
+            }
+            this->particleTree = this->localTree;
+        }
 
         vislib::sys::ConsoleProgressBar cpb;
         const int progressDivider = 100;
@@ -269,23 +317,14 @@ bool datatools::ParticleThermodyn::assertData(core::moldyn::MultiParticleDataCal
             std::vector<float> metricMin(num_thr, FLT_MAX);
             std::vector<float> metricMax(num_thr, 0.0f);
 
-            float eps = sqrt(std::numeric_limits<float>::epsilon());
             bool findExtremes = this->findExtremesSlot.Param<megamol::core::param::BoolParam>()->Value();
             float extremeVal = this->extremeValueSlot.Param<megamol::core::param::FloatParam>()->Value();
 
 #pragma omp parallel num_threads(num_thr)
             //#pragma omp parallel num_threads(1)
             {
-                float theVertex[3];
-                std::vector<std::pair<size_t, float>> ret_matches;
-                std::vector<std::pair<size_t, float>> ret_localMatches;
-                std::vector<size_t> ret_index(theNumber);
-                std::vector<float> out_dist_sqr(theNumber);
-                nanoflann::KNNResultSet<float> resultSet(theNumber);
-                nanoflann::SearchParams params;
-                params.sorted = false;
+                PeriodicKDTree::matches_t ret_matches;
                 ret_matches.reserve(100);
-                ret_localMatches.reserve(100);
                 int threadIdx = omp_get_thread_num();
 
                 INT64 part_cnt = pl.GetCount();
@@ -294,68 +333,30 @@ bool datatools::ParticleThermodyn::assertData(core::moldyn::MultiParticleDataCal
 
                     INT64 myIndex = part_i + allpartcnt;
                     ret_matches.clear();
-                    const float* vertexBase = this->myPts->get_position(myIndex);
+                    const float* vertexBase = this->particleTree->getPosition(myIndex);
                     // const float *velocityBase = this->myPts->get_velocity(myIndex);
 
-                    for (int x_s = 0; x_s < (cycl_x ? 2 : 1); ++x_s) {
-                        for (int y_s = 0; y_s < (cycl_y ? 2 : 1); ++y_s) {
-                            for (int z_s = 0; z_s < (cycl_z ? 2 : 1); ++z_s) {
-
-                                theVertex[0] = vertexBase[0];
-                                theVertex[1] = vertexBase[1];
-                                theVertex[2] = vertexBase[2];
-                                if (x_s > 0)
-                                    theVertex[0] =
-                                        theVertex[0] + ((theVertex[0] > bbox_cntr.X()) ? -bbox.Width() : bbox.Width());
-                                if (y_s > 0)
-                                    theVertex[1] = theVertex[1] +
-                                                   ((theVertex[1] > bbox_cntr.Y()) ? -bbox.Height() : bbox.Height());
-                                if (z_s > 0)
-                                    theVertex[2] =
-                                        theVertex[2] + ((theVertex[2] > bbox_cntr.Z()) ? -bbox.Depth() : bbox.Depth());
-
-                                if (theSearchType == searchTypeEnum::RADIUS) {
-                                    // the documentation says the parameter radius for L2 is squared
-                                    // caution: the criterion is < radius, not <= !!!!
-                                    particleTree->radiusSearch(
-                                        theVertex, theSquaredRadius + eps, ret_localMatches, params);
-                                    if (remove_self) {
-                                        ret_localMatches.erase(
-                                            std::remove_if(ret_localMatches.begin(), ret_localMatches.end(),
-                                                [&](decltype(ret_localMatches)::value_type& elem) {
-                                                    return elem.first == myIndex;
-                                                }),
-                                            ret_localMatches.end());
-                                    }
-                                    ret_matches.insert(
-                                        ret_matches.end(), ret_localMatches.begin(), ret_localMatches.end());
-                                } else {
-                                    resultSet.init(ret_index.data(), out_dist_sqr.data());
-                                    particleTree->findNeighbors(resultSet, theVertex, params);
-                                    for (size_t i = 0; i < resultSet.size(); ++i) {
-                                        if (!remove_self || ret_index[i] != myIndex) {
-                                            ret_matches.push_back(
-                                                std::pair<size_t, float>(ret_index[i], out_dist_sqr[i]));
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                    // one query covers all periodic images, and yields every neighbor once
+                    if (theSearchType == searchTypeEnum::RADIUS) {
+                        // caution: the criterion is < radius, not <= !!!!
+                        particleTree->radiusSearch(vertexBase, theSquaredRadius + eps, ret_matches);
+                    } else {
+                        particleTree->knnSearch(vertexBase, theNumber, ret_matches);
+                    }
+                    if (remove_self) {
+                        ret_matches.erase(std::remove_if(ret_matches.begin(), ret_matches.end(),
+                                              [&](decltype(ret_matches)::value_type& elem) {
+                                                  return elem.first == myIndex;
+                                              }),
+                            ret_matches.end());
                     }
-
-                    // no neighbor should count twice!
-                    ret_matches.erase(unique(ret_matches.begin(), ret_matches.end()), ret_matches.end());
 
                     size_t num_matches = 0;
                     if (theSearchType == searchTypeEnum::RADIUS) {
                         maxDist = theRadius;
                         num_matches = ret_matches.size();
                     } else {
-                        // find overall closest! we did search around periodic boundary conditions, so there will be
-                        // huge distances!
-                        sort(ret_matches.begin(), ret_matches.end(),
-                            [](const decltype(ret_matches)::value_type& left,
-                                const decltype(ret_matches)::value_type& right) { return left.second < right.second; });
+                        // the matches are sorted by distance, and
                         // the furthest is theNumber closest or the last one if fewer.
                         num_matches = ret_matches.size() >= theNumber ? theNumber : ret_matches.size();
                         // the documentation says the returned distances are squares as well
@@ -14,9 +14,9 @@
 #include "mmcore/CallerSlot.h"
 #include "mmcore/Module.h"
 #include "mmcore/moldyn/MultiParticleDataCall.h"
+#include "PeriodicKDTree.h"
 #include "PointcloudHelpers.h"
 #include <vector>
-#include <nanoflann.hpp>
 #include <Eigen/Eigenvalues>
 
 namespace megamol {
@@ -123,13 +123,9 @@ namespace datatools {
 
         Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> eigensolver;
 
-        typedef nanoflann::KDTreeSingleIndexAdaptor<
-            nanoflann::L2_Simple_Adaptor<float, simplePointcloud>,
-            simplePointcloud,
-            3 /* dim */
-        > my_kd_tree_t;
-
-        std::shared_ptr<my_kd_tree_t> particleTree;
+        /** Acceleration structure, either shared by a provider or the local one */
+        std::shared_ptr<const PeriodicKDTree> particleTree;
+        std::shared_ptr<PeriodicKDTree> localTree;
         std::shared_ptr<simplePointcloud> myPts;
 
         /** The slot providing access to the manipulated data */
@@ -138,6 +134,9 @@ namespace datatools {
         /** The slot accessing the original data */
         megamol::core::CallerSlot inDataSlot;
 
+        /** The slot accessing a shared spatial index of the original data */
+        megamol::core::CallerSlot inIndexSlot;
+
     };
 
 } /* end namespace datatools */
@@ -7,9 +7,13 @@
 #include "stdafx.h"
 #include "ParticlesToDensity.h"
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <fstream>
+#include <utility>
+#include <vector>
 #include "mmcore/misc/VolumetricDataCall.h"
 #include "mmcore/param/BoolParam.h"
 #include "mmcore/param/EnumParam.h"
@@ -25,6 +29,74 @@
 using namespace megamol;
 using namespace megamol::stdplugin;
 
+namespace {
+
+/**
+ * Radial basis function exp(-1 / (1 - q)), tabulated over the squared relative distance q in [0, 1)
+ * and linearly interpolated
+ */
+class TabulatedBump {
+public:
+    TabulatedBump() : table(resolution + 2, 0.0f) {
+        for (int i = 0; i < resolution; ++i) {
+            table[i] = std::exp(-1.0f / (1.0f - static_cast<float>(i) / static_cast<float>(resolution)));
+        }
+    }
+
+    inline float operator()(float const q) const {
+        // Also rejects NaN, resulting from zero radii
+        if (!(q < 1.0f)) return 0.0f;
+
+        float const pos = q * static_cast<float>(resolution);
+        int const idx = static_cast<int>(pos);
+        float const t = pos - static_cast<float>(idx);
+
+        return table[idx] + t * (table[idx + 1] - table[idx]);
+    }
+
+private:
+    static const int resolution = 4096;
+
+    std::vector<float> table;
+};
+
+/** Edge length of the bricks, each of which is splatted into by a single thread */
+const int brickSize = 16;
+
+/**
+ * Voxels along one axis covered by the filter of a particle
+ */
+struct AxisVoxels {
+    /** Voxel index before and after applying the cyclic boundary conditions */
+    std::vector<std::pair<int, int>> voxels;
+
+    /** Bricks containing the wrapped voxel indices */
+    std::vector<int> bricks;
+
+    void compute(int const center, int const filterSize, int const res, bool const cyclic) {
+        voxels.clear();
+        bricks.clear();
+
+        for (int h = center - filterSize; h <= center + filterSize; ++h) {
+            if (cyclic) {
+                int const wrapped = h % res;
+                voxels.emplace_back(h, wrapped < 0 ? wrapped + res : wrapped);
+            } else if (h >= 0 && h < res) {
+                voxels.emplace_back(h, h);
+            }
+        }
+
+        for (auto const& voxel : voxels) {
+            bricks.push_back(voxel.second / brickSize);
+        }
+
+        std::sort(bricks.begin(), bricks.end());
+        bricks.erase(std::unique(bricks.begin(), bricks.end()), bricks.end());
+    }
+};
+
+} // namespace
+
 /*
  * datatools::ParticlesToDensity::create
  */
@@ -181,7 +253,7 @@ bool datatools::ParticlesToDensity::getDataCallback(megamol::core::Call& c) {
     }
 
     // TODO set data
-    outVol->SetData(this->vol[0].data());
+    outVol->SetData(this->vol.data());
     metadata.Components = 1;
     metadata.GridType = core::misc::GridType_t::CARTESIAN;
     metadata.Resolution[0] = static_cast<size_t>(this->xResSlot.Param<core::param::IntParam>()->Value());
@@ -244,12 +316,7 @@ bool datatools::ParticlesToDensity::createVolumeCPU(class megamol::core::moldyn:
     auto const sy = this->yResSlot.Param<core::param::IntParam>()->Value();
     auto const sz = this->zResSlot.Param<core::param::IntParam>()->Value();
 
-    vol.resize(omp_get_max_threads());
-#pragma omp parallel for
-    for (int init = 0; init < omp_get_max_threads(); ++init) {
-        vol[init].resize(sx * sy * sz);
-        std::fill(vol[init].begin(), vol[init].end(), 0.0f);
-    }
+    vol.assign(static_cast<size_t>(sx) * sy * sz, 0.0f);
 
     // TODO: the whole code is wrong since we might not have the bounding box for the actual cyclic boundary conditions.
 
@@ -265,168 +332,183 @@ bool datatools::ParticlesToDensity::createVolumeCPU(class megamol::core::moldyn:
     auto const rangeOSx = c2->AccessBoundingBoxes().ObjectSpaceBBox().Width();
     auto const rangeOSy = c2->AccessBoundingBoxes().ObjectSpaceBBox().Height();
     auto const rangeOSz = c2->AccessBoundingBoxes().ObjectSpaceBBox().Depth();
-    auto const halfRangeOSx = c2->AccessBoundingBoxes().ObjectSpaceBBox().Width() * 0.5;
-    auto const halfRangeOSy = c2->AccessBoundingBoxes().ObjectSpaceBBox().Height() * 0.5;
-    auto const halfRangeOSz = c2->AccessBoundingBoxes().ObjectSpaceBBox().Depth() * 0.5;
-
 
     float const sliceDistX = rangeOSx / static_cast<float>(sx - 1);
     float const sliceDistY = rangeOSy / static_cast<float>(sy - 1);
     float const sliceDistZ = rangeOSz / static_cast<float>(sz - 1);
 
-    float const maxCellSize = std::max(sliceDistX, std::max(sliceDistY, sliceDistZ));
+    // The volume is split into bricks, and the particles are binned into all bricks their filter overlaps
+    int const numBricksX = (sx + brickSize - 1) / brickSize;
+    int const numBricksY = (sy + brickSize - 1) / brickSize;
+    int const numBricksZ = (sz + brickSize - 1) / brickSize;
+    int const numBricks = numBricksX * numBricksY * numBricksZ;
+
+    int const numThreads = omp_get_max_threads();
+
+    std::array<float, 3> const origin = {minOSx, minOSy, minOSz};
+    std::array<float, 3> const sliceDist = {sliceDistX, sliceDistY, sliceDistZ};
+    std::array<size_t, 3> const stride = {1, static_cast<size_t>(sx), static_cast<size_t>(sx) * sy};
+
+    std::vector<std::vector<size_t>> brickCounts(numThreads);
+    std::vector<size_t> brickOffsets(numBricks + 1);
+    std::vector<int64_t> brickParticles;
+
+    // https : // en.wikipedia.org/wiki/Radial_basis_function
+    TabulatedBump const bump;
+
+    auto const sigma = this->sigmaSlot.Param<core::param::FloatParam>()->Value();
+    bool const useIntensity = this->aggregatorSlot.Param<core::param::EnumParam>()->Value() == 1;
 
     for (unsigned int i = 0; i < c2->GetParticleListCount(); ++i) {
         megamol::core::moldyn::MultiParticleDataCall::Particles& parts = c2->AccessParticles(i);
-        const float globRad = parts.GetGlobalRadius();
-        const bool useGlobRad =
-            (parts.GetVertexDataType() ==
-                megamol::core::moldyn::MultiParticleDataCall::Particles::VERTDATA_FLOAT_XYZ) ||
-            (parts.GetVertexDataType() == megamol::core::moldyn::MultiParticleDataCall::Particles::VERTDATA_DOUBLE_XYZ);
         if (parts.GetVertexDataType() == megamol::core::moldyn::MultiParticleDataCall::Particles::VERTDATA_NONE) {
             continue;
         }
 
+        int64_t const count = static_cast<int64_t>(parts.GetCount());
+
         totalParticles += parts.GetCount();
 
-        // https : // en.wikipedia.org/wiki/Radial_basis_function
-        auto gauss = [](float const dist, float const epsilon) -> float {
-            if (dist >= epsilon) return 0.0f;
-            return std::exp(-1.0f / (1.0f - std::pow((1.0f / epsilon) * dist, 2.0f)));
-        };
-
-        auto const& parStore = parts.GetParticleStore();
-        auto const& xAcc = parStore.GetXAcc();
-        auto const& yAcc = parStore.GetYAcc();
-        auto const& zAcc = parStore.GetZAcc();
-        auto const& rAcc = parStore.GetRAcc();
-        auto const& iAcc = parStore.GetCRAcc();
-
-        auto const sigma = this->sigmaSlot.Param<core::param::FloatParam>()->Value();
-
-        std::function<void(int, int, int, int, float, float)> volOp;
-        switch (this->aggregatorSlot.Param<core::param::EnumParam>()->Value()) {
-        case 1: {
-            volOp = [this, &gauss, iAcc, sx, sy, sigma](int const pidx, int const x, int const y, int const z,
-                        float const dis, float const rad) -> void {
-                auto const val = iAcc->Get_f(pidx);
-                vol[omp_get_thread_num()][x + (y + z * sy) * sx] +=
-                    gauss(dis, sigma * rad) * val;
-            };
-        } break;
-        default:
-        case 0: {
-            volOp = [this, &gauss, sx, sy, sigma](int const pidx, int const x, int const y, int const z, float const dis,
-                        float const rad) -> void {
-                vol[omp_get_thread_num()][x + (y + z * sy) * sx] +=
-                    gauss(dis, sigma * rad);
-            };
-        }
+        // Intensities are converted in bulk, as they are looked up again for every brick of a particle
+        std::vector<float> intensities;
+        if (useIntensity) {
+            intensities.resize(count);
+            parts.GetParticleStore().GetCRAcc()->GetRange_f(0, count, intensities.data());
         }
 
-#if 0
-#    pragma omp parallel for collapse(4)
-        for (int z = 0; z < sz; ++z) {
-            for (int y = 0; y < sy; ++y) {
-                for (int x = 0; x < sx; ++x) {
-                    for (int64_t j = 0; j < parts.GetCount(); ++j) {
-                        auto const x_base = xAcc->Get_f(j);
-                        auto const y_base = yAcc->Get_f(j);
-                        auto const z_base = zAcc->Get_f(j);
-                        auto rad = globRad;
-                        if (!useGlobRad) rad = rAcc->Get_f(j);
-
-                        float x_diff = static_cast<float>(x) * sliceDistX + minOSx;
-                        x_diff = std::fabs(x_diff - x_base);
-                        if (cycl_x && x_diff > halfRangeOSx) x_diff -= rangeOSx;
-                        float y_diff = static_cast<float>(y) * sliceDistY + minOSy;
-                        y_diff = std::fabs(y_diff - y_base);
-                        if (cycl_y && y_diff > halfRangeOSy) y_diff -= rangeOSy;
-                        float z_diff = static_cast<float>(z) * sliceDistZ + minOSz;
-                        z_diff = std::fabs(z_diff - z_base);
-                        if (cycl_z && z_diff > halfRangeOSz) z_diff -= rangeOSz;
-                        float const dis = std::sqrt(x_diff * x_diff + y_diff * y_diff + z_diff * z_diff);
-
-                        volOp(j, x, y, z, dis, rad);
+        // Dispatch once on the vertex type, so that the positions are read without virtual calls
+        parts.VisitVertexData([&](auto const& xAcc, auto const& yAcc, auto const& zAcc, auto const& rAcc) {
+            // Get the voxels covered by the filter of a particle, per axis
+            auto getFootprint = [&](int64_t const j, std::array<AxisVoxels, 3>& footprint) {
+                auto const rad = rAcc.Get_f(j);
+
+                int const x = static_cast<int>((xAcc.Get_f(j) - minOSx) / sliceDistX);
+                int const y = static_cast<int>((yAcc.Get_f(j) - minOSy) / sliceDistY);
+                int const z = static_cast<int>((zAcc.Get_f(j) - minOSz) / sliceDistZ);
+
+                footprint[0].compute(x, static_cast<int>(std::ceil(rad / sliceDistX)), sx, cycl_x);
+                footprint[1].compute(y, static_cast<int>(std::ceil(rad / sliceDistY)), sy, cycl_y);
+                footprint[2].compute(z, static_cast<int>(std::ceil(rad / sliceDistZ)), sz, cycl_z);
+            };
+
+            // Bin particles into bricks: count per thread and brick, and then fill in the order of the particles
+#pragma omp parallel num_threads(numThreads)
+            {
+                int const tid = omp_get_thread_num();
+                int const numActiveThreads = omp_get_num_threads();
+                int64_t const begin = count * tid / numActiveThreads;
+                int64_t const end = count * (tid + 1) / numActiveThreads;
+
+                std::array<AxisVoxels, 3> footprint;
+
+                auto& counts = brickCounts[tid];
+                counts.assign(numBricks, 0);
+
+                for (int64_t j = begin; j < end; ++j) {
+                    getFootprint(j, footprint);
+
+                    for (auto const bz : footprint[2].bricks) {
+                        for (auto const by : footprint[1].bricks) {
+                            for (auto const bx : footprint[0].bricks) {
+                                ++counts[bx + (by + bz * numBricksY) * numBricksX];
+                            }
+                        }
                     }
                 }
-            }
-        }
-#endif
 
-#pragma omp parallel for
-        for (int64_t j = 0; j < parts.GetCount(); ++j) {
-            auto const x_base = xAcc->Get_f(j);
-            auto x = static_cast<int>((x_base - minOSx) / sliceDistX);
-            auto const y_base = yAcc->Get_f(j);
-            auto y = static_cast<int>((y_base - minOSy) / sliceDistY);
-            auto const z_base = zAcc->Get_f(j);
-            auto z = static_cast<int>((z_base - minOSz) / sliceDistZ);
-            auto rad = globRad;
-            if (!useGlobRad) rad = rAcc->Get_f(j);
-
-            int const filterSizeX = static_cast<int>(std::ceil(rad / sliceDistX));
-            int const filterSizeY = static_cast<int>(std::ceil(rad / sliceDistY));
-            int const filterSizeZ = static_cast<int>(std::ceil(rad / sliceDistZ));
-
-            for (int hz = z - filterSizeZ; hz <= z + filterSizeZ; ++hz) {
-                for (int hy = y - filterSizeY; hy <= y + filterSizeY; ++hy) {
-                    for (int hx = x - filterSizeX; hx <= x + filterSizeX; ++hx) {
-                        auto tmp_hx = hx;
-                        auto tmp_hy = hy;
-                        auto tmp_hz = hz;
-                        if (cycl_x) {
-                            tmp_hx = (hx + 2 * sx) % sx;
-                        } else {
-                            if (hx < 0 || hx > sx - 1) {
-                                continue;
-                            }
+#pragma omp barrier
+#pragma omp single
+                {
+                    size_t offset = 0;
+
+                    for (int b = 0; b < numBricks; ++b) {
+                        brickOffsets[b] = offset;
+
+                        for (int t = 0; t < numActiveThreads; ++t) {
+                            auto const num = brickCounts[t][b];
+                            brickCounts[t][b] = offset;
+                            offset += num;
                         }
-                        if (cycl_y) {
-                            tmp_hy = (hy + 2 * sy) % sy;
-                        } else {
-                            if (hy < 0 || hy > sy - 1) {
-                                continue;
+                    }
+
+                    brickOffsets[numBricks] = offset;
+                    brickParticles.resize(offset);
+                }
+
+                for (int64_t j = begin; j < end; ++j) {
+                    getFootprint(j, footprint);
+
+                    for (auto const bz : footprint[2].bricks) {
+                        for (auto const by : footprint[1].bricks) {
+                            for (auto const bx : footprint[0].bricks) {
+                                brickParticles[counts[bx + (by + bz * numBricksY) * numBricksX]++] = j;
                             }
                         }
-                        if (cycl_z) {
-                            tmp_hz = (hz + 2 * sz) % sz;
-                        } else {
-                            if (hz < 0 || hz > sz - 1) {
-                                continue;
+                    }
+                }
+            }
+
+            // Splat particles, with every brick being written by a single thread only
+#pragma omp parallel num_threads(numThreads)
+            {
+                std::array<AxisVoxels, 3> footprint;
+                std::array<std::vector<std::pair<float, size_t>>, 3> brickVoxels;
+
+#pragma omp for schedule(dynamic)
+                for (int b = 0; b < numBricks; ++b) {
+                    std::array<int, 3> const brick = {
+                        b % numBricksX, (b / numBricksX) % numBricksY, b / (numBricksX * numBricksY)};
+
+                    for (auto p = brickOffsets[b]; p < brickOffsets[b + 1]; ++p) {
+                        auto const j = brickParticles[p];
+
+                        getFootprint(j, footprint);
+
+                        auto const rad = rAcc.Get_f(j);
+
+                        float const epsilon = sigma * rad;
+                        float const rcpEpsilonSq = 1.0f / (epsilon * epsilon);
+                        float const val = useIntensity ? intensities[j] : 1.0f;
+
+                        // Squared distances along each axis, and the corresponding offsets into the volume
+                        std::array<float, 3> const pos = {xAcc.Get_f(j), yAcc.Get_f(j), zAcc.Get_f(j)};
+
+                        for (int axis = 0; axis < 3; ++axis) {
+                            brickVoxels[axis].clear();
+
+                            for (auto const& voxel : footprint[axis].voxels) {
+                                if (voxel.second / brickSize == brick[axis]) {
+                                    float const diff =
+                                        static_cast<float>(voxel.first) * sliceDist[axis] + origin[axis] - pos[axis];
+                                    brickVoxels[axis].emplace_back(diff * diff, voxel.second * stride[axis]);
+                                }
                             }
                         }
 
-                        float x_diff = static_cast<float>(hx) * sliceDistX + minOSx;
-                        x_diff = std::fabs(x_diff - x_base);
-                        // if (x_diff > halfRangeOSx) x_diff -= rangeOSx;
-                        float y_diff = static_cast<float>(hy) * sliceDistY + minOSy;
-                        y_diff = std::fabs(y_diff - y_base);
-                        // if (y_diff > halfRangeOSy) y_diff -= rangeOSy;
-                        float z_diff = static_cast<float>(hz) * sliceDistZ + minOSz;
-                        z_diff = std::fabs(z_diff - z_base);
-                        // if (z_diff > halfRangeOSz) z_diff -= rangeOSz;
-                        float const dis = std::sqrt(x_diff * x_diff + y_diff * y_diff + z_diff * z_diff);
-
-                        volOp(j, tmp_hx, tmp_hy, tmp_hz, dis, rad);
+                        for (auto const& vz : brickVoxels[2]) {
+                            for (auto const& vy : brickVoxels[1]) {
+                                float const distSqYZ = vy.first + vz.first;
+                                float* const row = vol.data() + vy.second + vz.second;
+
+                                for (auto const& vx : brickVoxels[0]) {
+                                    row[vx.second] += bump((vx.first + distSqYZ) * rcpEpsilonSq) * val;
+                                }
+                            }
+                        }
                     }
                 }
             }
-        }
-    }
-
-    for (int i = 1; i < omp_get_max_threads(); ++i) {
-        std::transform(vol[i].begin(), vol[i].end(), vol[0].begin(), vol[0].begin(), std::plus<>());
+        });
     }
 
-    maxDens = *std::max_element(vol[0].begin(), vol[0].end());
-    minDens = *std::min_element(vol[0].begin(), vol[0].end());
+    maxDens = *std::max_element(vol.begin(), vol.end());
+    minDens = *std::min_element(vol.begin(), vol.end());
     vislib::sys::Log::DefaultLog.WriteInfo("ParticlesToDensity: Captured density %f -> %f", minDens, maxDens);
 
     if (this->normalizeSlot.Param<core::param::BoolParam>()->Value()) {
         auto const rcpValRange = 1.0f / (maxDens - minDens);
         std::transform(
-            vol[0].begin(), vol[0].end(), vol[0].begin(), [this, rcpValRange](float const& a) { return (a - minDens) * rcpValRange; });
+            vol.begin(), vol.end(), vol.begin(), [this, rcpValRange](float const& a) { return (a - minDens) * rcpValRange; });
         minDens = 0.0f;
         maxDens = 1.0f;
     }
@@ -434,14 +516,11 @@ bool datatools::ParticlesToDensity::createVolumeCPU(class megamol::core::moldyn:
 //#define PTD_DEBUG_OUTPUT
 #ifdef PTD_DEBUG_OUTPUT
     std::ofstream raw_file{"bolla.raw", std::ios::binary};
-    raw_file.write(reinterpret_cast<char const*>(vol[0].data()), vol[0].size() * sizeof(float));
+    raw_file.write(reinterpret_cast<char const*>(vol.data()), vol.size() * sizeof(float));
     raw_file.close();
     vislib::sys::Log::DefaultLog.WriteInfo("ParticlesToDensity: Debug file written\n");
 #endif
 
-    // Cleanup
-    vol.resize(1);
-
     const auto endTime = std::chrono::high_resolution_clock::now();
     std::chrono::duration<float, std::milli> diffMillis = endTime - startTime;
     vislib::sys::Log::DefaultLog.WriteInfo(
@@ -108,7 +108,8 @@ private:
 
     core::param::ParamSlot sigmaSlot;
 
-    std::vector<std::vector<float>> vol;
+    /** Density volume, splatted into brick-wise by the threads */
+    std::vector<float> vol;
 
     size_t in_datahash = std::numeric_limits<size_t>::max();
     size_t datahash = 0;
@@ -0,0 +1,260 @@
+/*
+ * PeriodicKDTree.cpp
+ *
+ * Copyright (C) 2019 by MegaMol team
+ * Alle Rechte vorbehalten.
+ */
+
+#include "stdafx.h"
+#include "PeriodicKDTree.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace megamol;
+using namespace megamol::stdplugin;
+
+
+/*
+ * datatools::PeriodicKDTree::PeriodicKDTree
+ */
+datatools::PeriodicKDTree::PeriodicKDTree(void) : count(0), cyclic{false, false, false}, ghostWidth(0.0f) {
+    // intentionally empty
+}
+
+
+/*
+ * datatools::PeriodicKDTree::build
+ */
+void datatools::PeriodicKDTree::build(std::vector<float> positions, vislib::math::Cuboid<float> const& bbox,
+    std::array<bool, 3> const& cyclic, float ghostWidth) {
+    this->points.positions = std::move(positions);
+    this->count = this->points.positions.size() / 3;
+    this->bbox = bbox;
+    this->cyclic = cyclic;
+    this->ghostWidth = ghostWidth;
+
+    this->buildGhosts();
+}
+
+
+/*
+ * datatools::PeriodicKDTree::ensurePeriodicity
+ */
+bool datatools::PeriodicKDTree::ensurePeriodicity(
+    vislib::math::Cuboid<float> const& bbox, std::array<bool, 3> const& cyclic, float minGhostWidth) {
+    bool const anyCyclic = cyclic[0] || cyclic[1] || cyclic[2];
+
+    if (this->tree != nullptr && this->bbox == bbox && this->cyclic == cyclic &&
+        (!anyCyclic || this->ghostWidth >= minGhostWidth)) {
+        return false;
+    }
+
+    this->bbox = bbox;
+    this->cyclic = cyclic;
+    this->ghostWidth = std::max(minGhostWidth, 0.0f);
+
+    this->points.positions.resize(3 * this->count);
+    this->buildGhosts();
+
+    return true;
+}
+
+
+/*
+ * datatools::PeriodicKDTree::radiusSearch
+ */
+void datatools::PeriodicKDTree::radiusSearch(float const* pos, float squaredRadius, matches_t& matches) const {
+    nanoflann::SearchParams params;
+    params.sorted = false;
+
+    matches.clear();
+
+    if (this->tree == nullptr) return;
+
+    // Ghost layers are wide enough for a single query
+    if (squaredRadius <= this->ghostWidth * this->ghostWidth) {
+        this->tree->radiusSearch(pos, squaredRadius, matches, params);
+        this->resolveGhosts(matches, false);
+        return;
+    }
+
+    std::array<std::array<float, 3>, 8> mirrored;
+    auto const numMirrored = this->getMirroredPositions(pos, mirrored);
+
+    matches_t localMatches;
+
+    for (size_t m = 0; m < numMirrored; ++m) {
+        this->tree->radiusSearch(mirrored[m].data(), squaredRadius, localMatches, params);
+        matches.insert(matches.end(), localMatches.begin(), localMatches.end());
+    }
+
+    this->resolveGhosts(matches, numMirrored > 1);
+}
+
+
+/*
+ * datatools::PeriodicKDTree::knnSearch
+ */
+void datatools::PeriodicKDTree::knnSearch(float const* pos, size_t num, matches_t& matches) const {
+    nanoflann::SearchParams params;
+    params.sorted = false;
+
+    matches.clear();
+
+    if (this->tree == nullptr || num == 0) return;
+
+    std::vector<size_t> indices(num);
+    std::vector<float> distances(num);
+
+    auto findNeighbors = [&](float const* queryPos) {
+        nanoflann::KNNResultSet<float> resultSet(num);
+        resultSet.init(indices.data(), distances.data());
+        this->tree->findNeighbors(resultSet, queryPos, params);
+
+        for (size_t i = 0; i < resultSet.size(); ++i) {
+            matches.push_back(std::make_pair(indices[i], distances[i]));
+        }
+    };
+
+    auto sortAndTruncate = [&]() {
+        std::sort(matches.begin(), matches.end(),
+            [](matches_t::value_type const& lhs, matches_t::value_type const& rhs) { return lhs.second < rhs.second; });
+        if (matches.size() > num) matches.resize(num);
+    };
+
+    findNeighbors(pos);
+    this->resolveGhosts(matches, false);
+    sortAndTruncate();
+
+    // The result is complete if no particle was found twice, and all periodic images closer
+    // than the farthest neighbor are contained in the ghost layers
+    bool const anyCyclic = this->cyclic[0] || this->cyclic[1] || this->cyclic[2];
+
+    if (!anyCyclic || (matches.size() == std::min(num, this->count) &&
+                          matches.back().second <= this->ghostWidth * this->ghostWidth)) {
+        return;
+    }
+
+    std::array<std::array<float, 3>, 8> mirrored;
+    auto const numMirrored = this->getMirroredPositions(pos, mirrored);
+
+    matches.clear();
+
+    for (size_t m = 0; m < numMirrored; ++m) {
+        findNeighbors(mirrored[m].data());
+    }
+
+    this->resolveGhosts(matches, numMirrored > 1);
+    sortAndTruncate();
+}
+
+
+/*
+ * datatools::PeriodicKDTree::buildGhosts
+ */
+void datatools::PeriodicKDTree::buildGhosts(void) {
+    this->ghostOrigins.clear();
+
+    float const minCorner[3] = {this->bbox.Left(), this->bbox.Bottom(), this->bbox.Back()};
+    float const maxCorner[3] = {this->bbox.Right(), this->bbox.Top(), this->bbox.Front()};
+    float const size[3] = {this->bbox.Width(), this->bbox.Height(), this->bbox.Depth()};
+
+    if ((this->cyclic[0] || this->cyclic[1] || this->cyclic[2]) && this->ghostWidth > 0.0f) {
+        auto& positions = this->points.positions;
+
+        for (size_t i = 0; i < this->count; ++i) {
+            // Possible shifts per axis, the first being no shift at all
+            std::array<std::array<float, 3>, 3> shifts;
+            std::array<int, 3> numShifts;
+
+            for (int d = 0; d < 3; ++d) {
+                float const coord = positions[3 * i + d];
+
+                shifts[d][0] = 0.0f;
+                numShifts[d] = 1;
+
+                if (this->cyclic[d]) {
+                    if (coord - minCorner[d] < this->ghostWidth) shifts[d][numShifts[d]++] = size[d];
+                    if (maxCorner[d] - coord < this->ghostWidth) shifts[d][numShifts[d]++] = -size[d];
+                }
+            }
+
+            for (int sx = 0; sx < numShifts[0]; ++sx) {
+                for (int sy = 0; sy < numShifts[1]; ++sy) {
+                    for (int sz = 0; sz < numShifts[2]; ++sz) {
+                        if (sx == 0 && sy == 0 && sz == 0) continue;
+
+                        positions.push_back(positions[3 * i + 0] + shifts[0][sx]);
+                        positions.push_back(positions[3 * i + 1] + shifts[1][sy]);
+                        positions.push_back(positions[3 * i + 2] + shifts[2][sz]);
+
+                        this->ghostOrigins.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+
+    this->tree.reset();
+
+    // nanoflann cannot handle empty point sets
+    if (this->count == 0) return;
+
+    this->tree = std::unique_ptr<tree_t>(
+        new tree_t(3 /* dim */, this->points, nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */)));
+    this->tree->buildIndex();
+}
+
+
+/*
+ * datatools::PeriodicKDTree::getMirroredPositions
+ */
+size_t datatools::PeriodicKDTree::getMirroredPositions(
+    float const* pos, std::array<std::array<float, 3>, 8>& mirrored) const {
+    auto const center = this->bbox.CalcCenter();
+    float const size[3] = {this->bbox.Width(), this->bbox.Height(), this->bbox.Depth()};
+
+    size_t numMirrored = 0;
+
+    for (int x_s = 0; x_s < (this->cyclic[0] ? 2 : 1); ++x_s) {
+        for (int y_s = 0; y_s < (this->cyclic[1] ? 2 : 1); ++y_s) {
+            for (int z_s = 0; z_s < (this->cyclic[2] ? 2 : 1); ++z_s) {
+                auto& vertex = mirrored[numMirrored++];
+
+                vertex[0] = pos[0];
+                vertex[1] = pos[1];
+                vertex[2] = pos[2];
+                if (x_s > 0) vertex[0] += (vertex[0] > center.X()) ? -size[0] : size[0];
+                if (y_s > 0) vertex[1] += (vertex[1] > center.Y()) ? -size[1] : size[1];
+                if (z_s > 0) vertex[2] += (vertex[2] > center.Z()) ? -size[2] : size[2];
+            }
+        }
+    }
+
+    return numMirrored;
+}
+
+
+/*
+ * datatools::PeriodicKDTree::resolveGhosts
+ */
+void datatools::PeriodicKDTree::resolveGhosts(matches_t& matches, bool merged) const {
+    bool hasGhosts = false;
+
+    for (auto& match : matches) {
+        if (match.first >= this->count) {
+            match.first = this->ghostOrigins[match.first - this->count];
+            hasGhosts = true;
+        }
+    }
+
+    if (!hasGhosts && !merged) return;
+
+    // Sort by index and distance, and keep the closest image per particle
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end(),
+                      [](matches_t::value_type const& lhs, matches_t::value_type const& rhs) {
+                          return lhs.first == rhs.first;
+                      }),
+        matches.end());
+}
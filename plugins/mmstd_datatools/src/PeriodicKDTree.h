@@ -0,0 +1,167 @@
+/*
+ * PeriodicKDTree.h
+ *
+ * Copyright (C) 2019 by MegaMol team
+ * Alle Rechte vorbehalten.
+ */
+
+#ifndef MMSTD_DATATOOLS_PERIODICKDTREE_H_INCLUDED
+#define MMSTD_DATATOOLS_PERIODICKDTREE_H_INCLUDED
+#pragma once
+
+#include "vislib/math/Cuboid.h"
+#include <array>
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <nanoflann.hpp>
+
+namespace megamol {
+namespace stdplugin {
+namespace datatools {
+
+/**
+ * Neighbor search for particles with optional cyclic boundary conditions.
+ *
+ * Particles closer to a cyclic boundary than the ghost width are replicated once
+ * on the opposite side of the box, so that radius queries up to the ghost width and
+ * k-nearest-neighbor queries, whose k-th neighbor lies within the ghost width, are
+ * answered by a single tree traversal. Larger queries fall back to searching from
+ * the mirrored query positions. Results always refer to the original particles,
+ * each reported at most once with its minimum-image squared distance.
+ */
+class PeriodicKDTree {
+public:
+    /** Matches as pairs of particle index and squared distance */
+    typedef std::vector<std::pair<size_t, float>> matches_t;
+
+    PeriodicKDTree(void);
+
+    /**
+     * Build the search structure for the given particles.
+     *
+     * @param positions     Particle positions as consecutive xyz triplets
+     * @param bbox          Periodic box
+     * @param cyclic        Cyclic boundary conditions per axis
+     * @param ghostWidth    Width of the replicated layer at cyclic boundaries
+     */
+    void build(std::vector<float> positions, vislib::math::Cuboid<float> const& bbox,
+        std::array<bool, 3> const& cyclic, float ghostWidth);
+
+    /**
+     * Rebuild the ghost layers if the periodicity changed, or if they are narrower
+     * than the given width. The particles are not changed.
+     *
+     * @param bbox          Periodic box
+     * @param cyclic        Cyclic boundary conditions per axis
+     * @param minGhostWidth Minimum width of the replicated layer at cyclic boundaries
+     *
+     * @return True if the search structure was rebuilt
+     */
+    bool ensurePeriodicity(
+        vislib::math::Cuboid<float> const& bbox, std::array<bool, 3> const& cyclic, float minGhostWidth);
+
+    /**
+     * Find all particles closer than the radius; the matches are not sorted.
+     *
+     * @param pos           Query position
+     * @param squaredRadius Squared search radius
+     * @param matches       Matches
+     */
+    void radiusSearch(float const* pos, float squaredRadius, matches_t& matches) const;
+
+    /**
+     * Find the closest particles, sorted by increasing distance.
+     *
+     * @param pos           Query position
+     * @param num           Maximum number of neighbors
+     * @param matches       Matches
+     */
+    void knnSearch(float const* pos, size_t num, matches_t& matches) const;
+
+    /** Answer the number of (original) particles */
+    inline size_t getCount(void) const {
+        return this->count;
+    }
+
+    /** Answer the periodic box */
+    inline vislib::math::Cuboid<float> const& getBBox(void) const {
+        return this->bbox;
+    }
+
+    /** Answer the cyclic boundary conditions per axis */
+    inline std::array<bool, 3> const& getCyclic(void) const {
+        return this->cyclic;
+    }
+
+    /** Answer the width of the replicated layer at cyclic boundaries */
+    inline float getGhostWidth(void) const {
+        return this->ghostWidth;
+    }
+
+    /** Answer the position of the given (original) particle */
+    inline float const* getPosition(size_t index) const {
+        return &this->points.positions[3 * index];
+    }
+
+private:
+    /**
+     * Point set adaptor for nanoflann, containing the original particles followed by their ghosts
+     */
+    struct pointSet {
+        std::vector<float> positions;
+
+        inline size_t kdtree_get_point_count() const {
+            return positions.size() / 3;
+        }
+
+        inline float kdtree_get_pt(const size_t idx, int dim) const {
+            assert((dim >= 0) && (dim < 3));
+            return positions[3 * idx + dim];
+        }
+
+        template <class BBOX> bool kdtree_get_bbox(BBOX& /*bb*/) const {
+            return false;
+        }
+    };
+
+    typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<float, pointSet>, pointSet, 3 /* dim */>
+        tree_t;
+
+    /** Replicate particles close to cyclic boundaries, and build the tree */
+    void buildGhosts(void);
+
+    /** Get the query positions mirrored at the cyclic boundaries, including the original one */
+    size_t getMirroredPositions(float const* pos, std::array<std::array<float, 3>, 8>& mirrored) const;
+
+    /**
+     * Map matches to the original particles, keeping the smallest distance per particle
+     *
+     * @param matches       Matches
+     * @param merged        Matches of multiple queries, which may contain duplicates
+     */
+    void resolveGhosts(matches_t& matches, bool merged) const;
+
+    /** Particles and ghosts */
+    pointSet points;
+
+    /** Number of original particles */
+    size_t count;
+
+    /** Original particle for each ghost */
+    std::vector<size_t> ghostOrigins;
+
+    /** Periodicity */
+    vislib::math::Cuboid<float> bbox;
+    std::array<bool, 3> cyclic;
+    float ghostWidth;
+
+    std::unique_ptr<tree_t> tree;
+};
+
+} /* end namespace datatools */
+} /* end namespace stdplugin */
+} /* end namespace megamol */
+
+#endif /* MMSTD_DATATOOLS_PERIODICKDTREE_H_INCLUDED */
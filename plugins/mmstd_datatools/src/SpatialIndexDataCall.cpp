@@ -0,0 +1,18 @@
+#include "stdafx.h"
+#include "mmstd_datatools/SpatialIndexDataCall.h"
+
+using namespace megamol;
+using namespace megamol::stdplugin;
+using namespace megamol::stdplugin::datatools;
+
+SpatialIndexDataCall::SpatialIndexDataCall()
+        : index(), sourceDataHash(0), frameCnt(1), frameID(0) {
+    // intentionally empty
+}
+
+SpatialIndexDataCall::~SpatialIndexDataCall() {
+    index.reset(); // paranoia clean-up
+    sourceDataHash = 0;
+    frameCnt = 0;
+    frameID = 0;
+}